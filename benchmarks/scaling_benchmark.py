@@ -0,0 +1,257 @@
+#!/usr/bin/env python
+
+#The MIT License (MIT)
+#Copyright (c) 2016 Intel Corporation
+
+#Permission is hereby granted, free of charge, to any person obtaining a copy of 
+#this software and associated documentation files (the "Software"), to deal in 
+#the Software without restriction, including without limitation the rights to 
+#use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+#the Software, and to permit persons to whom the Software is furnished to do so, 
+#subject to the following conditions:
+
+#The above copyright notice and this permission notice shall be included in all 
+#copies or substantial portions of the Software.
+
+#THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+#IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+#FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+#COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+#IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+#CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+
+#End-to-end import/query scaling benchmark
+#For every cohort size, generates synthetic gVCFs with generate_synthetic_gvcfs, then for every
+#(#column partitions, #threads) combination creates a workspace with create_tiledb_workspace, loads the
+#cohort with vcf2tiledb (one MPI rank per partition) and runs point, range and combined gVCF queries
+#with gt_mpi_gather. Every run goes through genomicsdb_measure_process, which records wall clock time
+#and peak resident memory of all ranks. The scaling table is written as CSV and printed to stdout.
+
+import argparse
+import csv
+import glob
+import gzip
+import json
+import os
+import shutil
+import subprocess
+import sys
+
+query_attributes = [ "REF", "ALT", "BaseQRankSum", "MQ", "MQ0", "ClippingRankSum", "MQRankSum",
+        "ReadPosRankSum", "DP", "GT", "GQ", "SB", "AD", "PL", "MIN_DP" ]
+
+#gt_mpi_gather flags per query type
+query_types = [
+        ('point', '--print-calls'),
+        ('range', '--print-calls'),
+        ('combined_gvcf', '--produce-Broad-GVCF'),
+        ]
+
+table_columns = [ 'num_samples', 'num_partitions', 'num_threads', 'operation', 'wall_clock_time_s',
+        'cells', 'cells_per_s', 'peak_resident_MB', 'peak_resident_MB_per_rank', 'bytes_on_disk' ]
+
+def parse_int_list(value):
+    return [ int(x) for x in value.split(',') if x ]
+
+def get_directory_size(path):
+    total = 0
+    for root, dirs, files in os.walk(path):
+        for filename in files:
+            filepath = os.path.join(root, filename)
+            if(not os.path.islink(filepath)):
+                total += os.path.getsize(filepath)
+    return total
+
+def count_records(vcf_filenames):
+    num_records = 0
+    for filename in vcf_filenames:
+        with gzip.open(filename, 'rb') as fptr:
+            for line in fptr:
+                if(not line.startswith(b'#')):
+                    num_records += 1
+    return num_records
+
+def run_measured(args, label, cmd, env, stdout_filename):
+    measure_output = os.path.join(args.work_dir, 'measure.json')
+    full_cmd = [ os.path.join(args.bin_dir, 'genomicsdb_measure_process'), '-o', measure_output,
+            '-L', label, '--' ] + cmd
+    with open(stdout_filename, 'wb') as stdout_fptr:
+        retcode = subprocess.call(full_cmd, env=env, stdout=stdout_fptr)
+    if(retcode != 0):
+        sys.stderr.write('Command failed: '+' '.join(cmd)+'\n')
+        sys.exit(-1)
+    with open(measure_output, 'r') as fptr:
+        return json.load(fptr)
+
+def get_profiler_cells(profile_prefix):
+    num_cells = 0
+    for filename in glob.glob(profile_prefix+'.rank*.json'):
+        with open(filename, 'r') as fptr:
+            num_cells += json.load(fptr)['counters']['TileDB-cells']
+        os.remove(filename)
+    return num_cells
+
+def mpi_cmd(args, num_partitions, cmd):
+    if(num_partitions == 1 and not args.always_use_mpirun):
+        return cmd
+    return args.mpirun.split() + [ '-np', str(num_partitions) ] + cmd
+
+def get_partitions(contig_lengths, num_partitions):
+    total_length = sum(contig_lengths)
+    partition_size = (total_length+num_partitions-1)//num_partitions
+    return [ (i*partition_size, min((i+1)*partition_size, total_length)-1) for i in range(num_partitions) ]
+
+def create_loader_json(args, data_dir, ws_dir, partitions, num_threads):
+    loader_dict = {
+            "row_based_partitioning" : False,
+            "column_partitions" : [ { "begin": begin, "workspace": ws_dir, "array": "array%d"%(i) }
+                for i, (begin, end) in enumerate(partitions) ],
+            "callset_mapping_file" : os.path.join(data_dir, 'callset.json'),
+            "vid_mapping_file" : os.path.join(data_dir, 'vid.json'),
+            "vcf_header_filename" : os.path.join(data_dir, 'template_vcf_header.vcf'),
+            "reference_genome" : os.path.join(data_dir, 'reference.fa'),
+            "size_per_column_partition" : args.size_per_column_partition,
+            "treat_deletions_as_intervals" : True,
+            "num_parallel_vcf_files" : num_threads,
+            "do_ping_pong_buffering" : True,
+            "offload_vcf_output_processing" : True,
+            "discard_vcf_index" : True,
+            "produce_combined_vcf" : False,
+            "produce_tiledb_array" : True,
+            "delete_and_create_tiledb_array" : True,
+            "compress_tiledb_array" : True,
+            "segment_size" : args.segment_size,
+            "num_cells_per_tile" : args.num_cells_per_tile
+            }
+    filename = os.path.join(args.work_dir, 'loader.json')
+    with open(filename, 'w') as fptr:
+        json.dump(loader_dict, fptr, indent=4, separators=(',', ': '))
+    return filename
+
+def create_query_json(args, data_dir, ws_dir, partitions, query_type):
+    column_ranges = []
+    for begin, end in partitions:
+        if(query_type == 'point'):
+            column_ranges.append([ [ (begin+end)//2, (begin+end)//2 ] ])
+        elif(query_type == 'range'):
+            length = max((end-begin+1)*args.range_query_fraction, 1)
+            column_ranges.append([ [ begin, begin+int(length)-1 ] ])
+        else:
+            column_ranges.append([ [ begin, end ] ])
+    query_dict = {
+            "workspace" : ws_dir,
+            "array" : [ "array%d"%(i) for i in range(len(partitions)) ],
+            "query_column_ranges" : column_ranges,
+            "query_row_ranges" : [ [ [ 0, args.current_num_samples-1 ] ] for i in range(len(partitions)) ],
+            "vid_mapping_file" : os.path.join(data_dir, 'vid.json'),
+            "callset_mapping_file" : os.path.join(data_dir, 'callset.json'),
+            "vcf_header_filename" : os.path.join(data_dir, 'template_vcf_header.vcf'),
+            "reference_genome" : os.path.join(data_dir, 'reference.fa'),
+            "query_attributes" : query_attributes
+            }
+    filename = os.path.join(args.work_dir, 'query_'+query_type+'.json')
+    with open(filename, 'w') as fptr:
+        json.dump(query_dict, fptr, indent=4, separators=(',', ': '))
+    return filename
+
+def make_row(num_samples, num_partitions, num_threads, operation, measurement, cells, bytes_on_disk):
+    wall_clock_time = measurement['wall_clock_time_s']
+    return {
+            'num_samples': num_samples,
+            'num_partitions': num_partitions,
+            'num_threads': num_threads,
+            'operation': operation,
+            'wall_clock_time_s': '%.3f'%(wall_clock_time),
+            'cells': cells,
+            'cells_per_s': '%.1f'%(cells/wall_clock_time if wall_clock_time > 0 else 0.0),
+            'peak_resident_MB': '%.1f'%(measurement['peak_resident_bytes']/1048576.0),
+            'peak_resident_MB_per_rank': '%.1f'%(measurement['peak_resident_bytes_single_process']/1048576.0),
+            'bytes_on_disk': bytes_on_disk
+            }
+
+def print_table(rows):
+    widths = [ max(len(column), max([ len(str(row[column])) for row in rows ] + [ 0 ])) for column in table_columns ]
+    print('  '.join([ column.rjust(width) for column, width in zip(table_columns, widths) ]))
+    for row in rows:
+        print('  '.join([ str(row[column]).rjust(width) for column, width in zip(table_columns, widths) ]))
+
+def main():
+    parser = argparse.ArgumentParser(description='GenomicsDB import/query scaling benchmark')
+    parser.add_argument('--bin-dir', required=True, help='Directory containing the GenomicsDB executables')
+    parser.add_argument('--work-dir', required=True, help='Scratch directory for generated data and workspaces')
+    parser.add_argument('--num-samples', default='100,1000', type=parse_int_list)
+    parser.add_argument('--num-partitions', default='1,2', type=parse_int_list)
+    parser.add_argument('--num-threads', default='1,4', type=parse_int_list)
+    parser.add_argument('--contigs', default='1:1000000', help='<name>:<length>,.. passed to the generator')
+    parser.add_argument('--generator-args', default='', help='Additional arguments for generate_synthetic_gvcfs')
+    parser.add_argument('--mpirun', default='mpirun')
+    parser.add_argument('--always-use-mpirun', action='store_true')
+    parser.add_argument('--range-query-fraction', default=0.1, type=float)
+    parser.add_argument('--segment-size', default=10485760, type=int)
+    parser.add_argument('--size-per-column-partition', default=16384, type=int)
+    parser.add_argument('--num-cells-per-tile', default=1000, type=int)
+    parser.add_argument('--output', default='scaling_report.csv')
+    parser.add_argument('--keep-data', action='store_true')
+    args = parser.parse_args()
+    args.work_dir = os.path.abspath(args.work_dir)
+    if(not os.path.isdir(args.work_dir)):
+        os.makedirs(args.work_dir)
+    contig_lengths = [ int(x.split(':')[-1]) for x in args.contigs.split(',') ]
+    rows = []
+    for num_samples in args.num_samples:
+        args.current_num_samples = num_samples
+        data_dir = os.path.join(args.work_dir, 'data_%d'%(num_samples))
+        if(not os.path.isdir(data_dir)):
+            retcode = subprocess.call([ os.path.join(args.bin_dir, 'generate_synthetic_gvcfs'), '-o', data_dir,
+                '--num-samples', str(num_samples), '--contigs', args.contigs ] + args.generator_args.split())
+            if(retcode != 0):
+                sys.stderr.write('Synthetic gVCF generation failed\n')
+                sys.exit(-1)
+        with open(os.path.join(data_dir, 'callset.json'), 'r') as fptr:
+            vcf_filenames = [ info['filename'] for info in json.load(fptr)['callsets'].values() ]
+        num_input_records = count_records(vcf_filenames)
+        input_bytes = sum([ os.path.getsize(filename) for filename in vcf_filenames ])
+        rows.append({ 'num_samples': num_samples, 'num_partitions': '-', 'num_threads': '-',
+            'operation': 'input_gvcfs', 'wall_clock_time_s': '-', 'cells': num_input_records, 'cells_per_s': '-',
+            'peak_resident_MB': '-', 'peak_resident_MB_per_rank': '-', 'bytes_on_disk': input_bytes })
+        for num_partitions in args.num_partitions:
+            partitions = get_partitions(contig_lengths, num_partitions)
+            for num_threads in args.num_threads:
+                env = dict(os.environ)
+                env['OMP_NUM_THREADS'] = str(num_threads)
+                ws_dir = os.path.join(args.work_dir, 'ws')
+                shutil.rmtree(ws_dir, ignore_errors=True)
+                retcode = subprocess.call([ os.path.join(args.bin_dir, 'create_tiledb_workspace'), ws_dir ])
+                if(retcode != 0):
+                    sys.stderr.write('Workspace creation failed\n')
+                    sys.exit(-1)
+                loader_json = create_loader_json(args, data_dir, ws_dir, partitions, num_threads)
+                measurement = run_measured(args, 'load', mpi_cmd(args, num_partitions,
+                    [ os.path.join(args.bin_dir, 'vcf2tiledb'), loader_json ]), env, os.devnull)
+                bytes_on_disk = get_directory_size(ws_dir)
+                rows.append(make_row(num_samples, num_partitions, num_threads, 'load', measurement,
+                    num_input_records, bytes_on_disk))
+                for query_type, cmd_line_param in query_types:
+                    query_json = create_query_json(args, data_dir, ws_dir, partitions, query_type)
+                    profile_prefix = os.path.join(args.work_dir, 'profile_'+query_type)
+                    env[ 'GENOMICSDB_PROFILE' ] = profile_prefix
+                    measurement = run_measured(args, query_type, mpi_cmd(args, num_partitions,
+                        [ os.path.join(args.bin_dir, 'gt_mpi_gather'), '-l', loader_json, '-j', query_json ]
+                        + cmd_line_param.split()), env, os.devnull)
+                    del env[ 'GENOMICSDB_PROFILE' ]
+                    rows.append(make_row(num_samples, num_partitions, num_threads, query_type, measurement,
+                        get_profiler_cells(profile_prefix), bytes_on_disk))
+                sys.stderr.write('Done: %d samples, %d partitions, %d threads\n'%(num_samples, num_partitions,
+                    num_threads))
+        if(not args.keep_data):
+            shutil.rmtree(data_dir, ignore_errors=True)
+    shutil.rmtree(os.path.join(args.work_dir, 'ws'), ignore_errors=True)
+    with open(args.output, 'w') as fptr:
+        writer = csv.DictWriter(fptr, fieldnames=table_columns)
+        writer.writeheader()
+        for row in rows:
+            writer.writerow(row)
+    print_table(rows)
+
+if __name__ == '__main__':
+    main()
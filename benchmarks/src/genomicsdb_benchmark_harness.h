@@ -0,0 +1,378 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GENOMICSDB_BENCHMARK_HARNESS_H
+#define GENOMICSDB_BENCHMARK_HARNESS_H
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <functional>
+#include <regex>
+#include <chrono>
+#include <algorithm>
+#include <cmath>
+#include <ctime>
+#include <unistd.h>
+#include <assert.h>
+#include "timer.h"
+
+/*
+ * Minimal micro-benchmark harness modelled on Google benchmark - benchmark functions loop on
+ * keep_running() and the results are written in the same JSON layout as Google benchmark's
+ * --benchmark_out so that its compare.py tooling can track regressions between releases
+ */
+
+//Exceptions thrown
+class GenomicsDBBenchmarkException : public std::exception {
+  public:
+    GenomicsDBBenchmarkException(const std::string m="") : msg_("GenomicsDBBenchmarkException : "+m) { ; }
+    ~GenomicsDBBenchmarkException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+class GenomicsDBBenchmarkState
+{
+  public:
+    GenomicsDBBenchmarkState(const uint64_t max_iterations, const double min_time)
+    {
+      m_max_iterations = max_iterations;
+      m_min_time = min_time;
+      m_num_iterations = 0ull;
+      m_started = false;
+      m_paused = false;
+      m_use_manual_time = false;
+      m_manual_time = 0;
+      m_items_processed = 0ull;
+      m_bytes_processed = 0ull;
+    }
+    /*
+     * Returns true while the benchmark loop must execute one more iteration
+     */
+    inline bool keep_running()
+    {
+      if(!m_started)
+      {
+        m_started = true;
+        m_begin_time = std::chrono::steady_clock::now();
+        m_timer.start();
+        return true;
+      }
+      ++m_num_iterations;
+      if(m_max_iterations > 0ull)
+      {
+        if(m_num_iterations < m_max_iterations)
+          return true;
+      }
+      else
+        if(std::chrono::duration<double>(std::chrono::steady_clock::now() - m_begin_time).count() < m_min_time)
+          return true;
+      if(!m_paused)
+        m_timer.stop();
+      return false;
+    }
+    /*
+     * Setup work inside the loop which must not be measured
+     */
+    inline void pause_timing()
+    {
+      assert(!m_paused);
+      m_timer.stop();
+      m_paused = true;
+    }
+    inline void resume_timing()
+    {
+      assert(m_paused);
+      m_timer.start();
+      m_paused = false;
+    }
+    /*
+     * For benchmarks which measure a phase of a larger operation - the time reported is the
+     * sum of the values passed here rather than the time spent in the loop
+     */
+    void set_iteration_time(const double seconds)
+    {
+      m_use_manual_time = true;
+      m_manual_time += seconds;
+    }
+    void set_items_processed(const uint64_t val) { m_items_processed = val; }
+    void set_bytes_processed(const uint64_t val) { m_bytes_processed = val; }
+    void set_counter(const std::string& name, const double value)
+    {
+      for(auto& x : m_counters)
+        if(x.first == name)
+        {
+          x.second = value;
+          return;
+        }
+      m_counters.emplace_back(name, value);
+    }
+    void skip_with_error(const std::string& msg) { m_error_message = msg; }
+    //Accessors
+    uint64_t get_num_iterations() const { return m_num_iterations; }
+    //Wall clock time of all iterations in seconds
+    double get_real_time() const
+    {
+      return m_use_manual_time ? m_manual_time : m_timer.get_cumulative_wall_clock_time()/1e6;
+    }
+    double get_cpu_time() const { return m_timer.get_cumulative_cpu_time()/1e9; }
+    uint64_t get_items_processed() const { return m_items_processed; }
+    uint64_t get_bytes_processed() const { return m_bytes_processed; }
+    const std::vector<std::pair<std::string, double>>& get_counters() const { return m_counters; }
+    const std::string& get_error_message() const { return m_error_message; }
+  private:
+    uint64_t m_max_iterations;
+    double m_min_time;
+    uint64_t m_num_iterations;
+    bool m_started;
+    bool m_paused;
+    std::chrono::steady_clock::time_point m_begin_time;
+    //Wall clock and thread cpu time of the measured sections
+    Timer m_timer;
+    bool m_use_manual_time;
+    double m_manual_time;
+    uint64_t m_items_processed;
+    uint64_t m_bytes_processed;
+    std::vector<std::pair<std::string, double>> m_counters;
+    std::string m_error_message;
+};
+
+typedef std::function<void(GenomicsDBBenchmarkState&)> GenomicsDBBenchmarkFunction;
+
+class GenomicsDBBenchmarkRunner
+{
+  public:
+    GenomicsDBBenchmarkRunner()
+    {
+      m_max_iterations = 0ull;
+      m_min_time = 0.5;
+      m_num_repetitions = 1u;
+      m_filter = ".*";
+    }
+    void set_max_iterations(const uint64_t val) { m_max_iterations = val; }
+    void set_min_time(const double val) { m_min_time = val; }
+    void set_num_repetitions(const unsigned val) { m_num_repetitions = std::max(val, 1u); }
+    void set_filter(const std::string& filter) { m_filter = filter; }
+    void set_output_filename(const std::string& filename) { m_output_filename = filename; }
+    void add_context(const std::string& key, const std::string& value) { m_context.emplace_back(key, value); }
+    void add_benchmark(const std::string& name, GenomicsDBBenchmarkFunction function)
+    {
+      m_benchmarks.emplace_back(name, function);
+    }
+    /*
+     * Runs all benchmarks matching the filter, returns the number of benchmarks which failed
+     */
+    unsigned run(std::ostream& console=std::cout)
+    {
+      std::regex filter_regex(m_filter);
+      auto num_failed = 0u;
+      for(auto& benchmark : m_benchmarks)
+      {
+        if(!std::regex_search(benchmark.first, filter_regex))
+          continue;
+        std::vector<GenomicsDBBenchmarkState> repetitions;
+        for(auto i=0u;i<m_num_repetitions;++i)
+        {
+          repetitions.emplace_back(m_max_iterations, m_min_time);
+          auto& state = repetitions.back();
+          try
+          {
+            benchmark.second(state);
+          }
+          catch(const std::exception& e)
+          {
+            state.skip_with_error(e.what());
+          }
+          if(!state.get_error_message().empty())
+          {
+            console << std::left << std::setw(64) << benchmark.first << " ERROR: " << state.get_error_message() << "\n";
+            ++num_failed;
+            break;
+          }
+          add_result(benchmark.first, i, state, console);
+        }
+        if(repetitions.size() > 1u && repetitions.back().get_error_message().empty())
+          add_aggregates(benchmark.first, repetitions, console);
+      }
+      if(!m_output_filename.empty())
+        write_json(m_output_filename);
+      return num_failed;
+    }
+  private:
+    struct BenchmarkResult
+    {
+      std::string m_name;
+      std::string m_run_name;
+      std::string m_run_type;
+      std::string m_aggregate_name;
+      unsigned m_repetition_idx;
+      uint64_t m_num_iterations;
+      //nano-seconds per iteration
+      double m_real_time;
+      double m_cpu_time;
+      std::vector<std::pair<std::string, double>> m_counters;
+    };
+    void add_result(const std::string& name, const unsigned repetition_idx, const GenomicsDBBenchmarkState& state,
+        std::ostream& console)
+    {
+      BenchmarkResult result;
+      result.m_name = name;
+      result.m_run_name = name;
+      result.m_run_type = "iteration";
+      result.m_repetition_idx = repetition_idx;
+      auto num_iterations = std::max<uint64_t>(state.get_num_iterations(), 1ull);
+      result.m_num_iterations = num_iterations;
+      result.m_real_time = state.get_real_time()*1e9/num_iterations;
+      result.m_cpu_time = state.get_cpu_time()*1e9/num_iterations;
+      //Rates are computed over the measured time
+      auto real_time = state.get_real_time();
+      if(state.get_items_processed() > 0ull && real_time > 0)
+        result.m_counters.emplace_back("items_per_second", state.get_items_processed()/real_time);
+      if(state.get_bytes_processed() > 0ull && real_time > 0)
+        result.m_counters.emplace_back("bytes_per_second", state.get_bytes_processed()/real_time);
+      for(const auto& x : state.get_counters())
+        result.m_counters.push_back(x);
+      print_result(result, console);
+      m_results.push_back(result);
+    }
+    void add_aggregates(const std::string& name, const std::vector<GenomicsDBBenchmarkState>& repetitions,
+        std::ostream& console)
+    {
+      auto first_result_idx = m_results.size() - repetitions.size();
+      for(auto aggregate_name : { "mean", "median", "stddev" })
+      {
+        BenchmarkResult result = m_results[first_result_idx];
+        result.m_name = name + "_" + aggregate_name;
+        result.m_run_type = "aggregate";
+        result.m_aggregate_name = aggregate_name;
+        auto aggregate = [&](std::function<double(const BenchmarkResult&)> get) {
+          std::vector<double> values;
+          for(auto i=first_result_idx;i<first_result_idx+repetitions.size();++i)
+            values.push_back(get(m_results[i]));
+          return compute_aggregate(values, aggregate_name);
+        };
+        result.m_real_time = aggregate([](const BenchmarkResult& x) { return x.m_real_time; });
+        result.m_cpu_time = aggregate([](const BenchmarkResult& x) { return x.m_cpu_time; });
+        for(auto j=0u;j<result.m_counters.size();++j)
+          result.m_counters[j].second = aggregate([j](const BenchmarkResult& x) { return x.m_counters[j].second; });
+        print_result(result, console);
+        m_results.push_back(result);
+      }
+    }
+    static double compute_aggregate(std::vector<double>& values, const std::string& aggregate_name)
+    {
+      auto mean = 0.0;
+      for(auto x : values)
+        mean += x;
+      mean /= values.size();
+      if(aggregate_name == "mean")
+        return mean;
+      if(aggregate_name == "median")
+      {
+        std::sort(values.begin(), values.end());
+        auto mid = values.size()/2u;
+        return (values.size() % 2u) ? values[mid] : (values[mid-1u]+values[mid])/2;
+      }
+      auto sum_sq = 0.0;
+      for(auto x : values)
+        sum_sq += (x-mean)*(x-mean);
+      return (values.size() > 1u) ? sqrt(sum_sq/(values.size()-1u)) : 0.0;
+    }
+    static void print_result(const BenchmarkResult& result, std::ostream& console)
+    {
+      console << std::left << std::setw(64) << result.m_name << std::right << std::fixed << std::setprecision(0)
+        << std::setw(16) << result.m_real_time << " ns" << std::setw(16) << result.m_cpu_time << " ns"
+        << std::setw(12) << result.m_num_iterations;
+      for(const auto& x : result.m_counters)
+        console << " " << x.first << "=" << std::scientific << std::setprecision(4) << x.second;
+      console << std::defaultfloat << "\n";
+    }
+    static std::string escape_json(const std::string& str)
+    {
+      std::string result;
+      for(auto c : str)
+      {
+        if(c == '"' || c == '\\')
+          result.push_back('\\');
+        result.push_back(c);
+      }
+      return result;
+    }
+    void write_json(const std::string& filename) const
+    {
+      std::ofstream fptr(filename.c_str());
+      if(!fptr.is_open())
+        throw GenomicsDBBenchmarkException(std::string("Could not open benchmark output file ")+filename);
+      char hostname[256];
+      if(gethostname(hostname, sizeof(hostname)) != 0)
+        hostname[0] = '\0';
+      hostname[sizeof(hostname)-1u] = '\0';
+      char date[64];
+      auto now = time(0);
+      strftime(date, sizeof(date), "%Y-%m-%dT%H:%M:%S", localtime(&now));
+      fptr << std::setprecision(12);
+      fptr << "{\n  \"context\": {\n";
+      fptr << "    \"date\": \"" << date << "\",\n";
+      fptr << "    \"host_name\": \"" << escape_json(hostname) << "\",\n";
+      fptr << "    \"num_cpus\": " << sysconf(_SC_NPROCESSORS_ONLN);
+      for(const auto& x : m_context)
+        fptr << ",\n    \"" << escape_json(x.first) << "\": \"" << escape_json(x.second) << "\"";
+      fptr << "\n  },\n  \"benchmarks\": [";
+      for(auto i=0ull;i<m_results.size();++i)
+      {
+        const auto& result = m_results[i];
+        fptr << (i ? ",\n" : "\n") << "    {\n";
+        fptr << "      \"name\": \"" << escape_json(result.m_name) << "\",\n";
+        fptr << "      \"run_name\": \"" << escape_json(result.m_run_name) << "\",\n";
+        fptr << "      \"run_type\": \"" << result.m_run_type << "\",\n";
+        if(result.m_run_type == "aggregate")
+          fptr << "      \"aggregate_name\": \"" << result.m_aggregate_name << "\",\n";
+        else
+          fptr << "      \"repetition_index\": " << result.m_repetition_idx << ",\n";
+        fptr << "      \"iterations\": " << result.m_num_iterations << ",\n";
+        fptr << "      \"real_time\": " << result.m_real_time << ",\n";
+        fptr << "      \"cpu_time\": " << result.m_cpu_time << ",\n";
+        fptr << "      \"time_unit\": \"ns\"";
+        for(const auto& x : result.m_counters)
+          fptr << ",\n      \"" << escape_json(x.first) << "\": " << x.second;
+        fptr << "\n    }";
+      }
+      fptr << "\n  ]\n}\n";
+    }
+    uint64_t m_max_iterations;
+    double m_min_time;
+    unsigned m_num_repetitions;
+    std::string m_filter;
+    std::string m_output_filename;
+    std::vector<std::pair<std::string, std::string>> m_context;
+    std::vector<std::pair<std::string, GenomicsDBBenchmarkFunction>> m_benchmarks;
+    std::vector<BenchmarkResult> m_results;
+};
+
+#endif
@@ -0,0 +1,660 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <getopt.h>
+#include <random>
+#include <memory>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include "genomicsdb_benchmark_harness.h"
+#include "json_config.h"
+#include "query_variants.h"
+#include "variant_operations.h"
+#include "broad_combined_gvcf.h"
+#include "genotype_matrix.h"
+#include "tiledb_loader.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenomicsDBBenchmarkException(#X);
+
+enum GenomicsDBBenchmarksArgsEnum
+{
+  ARGS_IDX_BENCHMARK_FILTER=1000,
+  ARGS_IDX_BENCHMARK_REPETITIONS,
+  ARGS_IDX_BENCHMARK_MIN_TIME,
+  ARGS_IDX_BENCHMARK_ITERATIONS,
+  ARGS_IDX_BENCHMARK_OUT,
+  ARGS_IDX_LOAD_JSON,
+  ARGS_IDX_NUM_SAMPLES,
+  ARGS_IDX_NUM_ALLELES,
+  ARGS_IDX_MAX_VARIANTS,
+  ARGS_IDX_SEED,
+  ARGS_IDX_SEGMENT_SIZE,
+  ARGS_IDX_ARRAY_ROWS,
+  ARGS_IDX_QUERY_ROWS,
+  ARGS_IDX_SYNTHETIC_SAMPLES,
+  ARGS_IDX_SYNTHETIC_DIRECTORY,
+  ARGS_IDX_GENERATOR,
+  ARGS_IDX_VERSION
+};
+
+/*
+ * Synthetic remap benchmark - every sample has REF, one ALT allele picked at random from the merged
+ * ALT list and <NON_REF>, which is the common case while combining gVCFs
+ */
+void benchmark_remap_data_based_on_genotype(GenomicsDBBenchmarkState& state, const uint64_t num_samples,
+    const unsigned num_merged_alleles, const unsigned seed)
+{
+  VERIFY_OR_THROW(num_merged_alleles >= 3u);
+  std::mt19937 generator(seed);
+  std::uniform_int_distribution<unsigned> alt_allele_distribution(1u, num_merged_alleles-2u);
+  std::uniform_int_distribution<int> PL_distribution(0, 2000);
+  CombineAllelesLUT alleles_LUT(num_samples);
+  alleles_LUT.resize_luts_if_needed(num_samples, num_merged_alleles);
+  //3 input alleles - 6 genotypes
+  std::vector<std::vector<int>> input_PLs(num_samples, std::vector<int>(6u));
+  for(auto i=0ull;i<num_samples;++i)
+  {
+    alleles_LUT.add_input_merged_idx_pair(i, 0, 0);
+    alleles_LUT.add_input_merged_idx_pair(i, 1, alt_allele_distribution(generator));
+    alleles_LUT.add_input_merged_idx_pair(i, 2, num_merged_alleles-1u);
+    for(auto& val : input_PLs[i])
+      val = PL_distribution(generator);
+    input_PLs[i][0u] = 0;
+  }
+  auto num_merged_gts = (num_merged_alleles*(num_merged_alleles+1u))/2u;
+  RemappedMatrix<int> remapped_PLs;
+  remapped_PLs.resize(num_merged_gts, num_samples, bcf_int32_missing);
+  std::vector<uint64_t> num_calls_with_valid_data(num_merged_gts, 0ull);
+  auto num_calls_processed = 0ull;
+  while(state.keep_running())
+  {
+    std::fill(num_calls_with_valid_data.begin(), num_calls_with_valid_data.end(), 0ull);
+    for(auto i=0ull;i<num_samples;++i)
+      VariantOperations::remap_data_based_on_genotype<int>(input_PLs[i], i, alleles_LUT, num_merged_alleles, true,
+          remapped_PLs, num_calls_with_valid_data, bcf_int32_missing);
+    num_calls_processed += num_samples;
+  }
+  state.set_items_processed(num_calls_processed);
+}
+
+/*
+ * Query setup - sorting the queried rows and building the array row -> query row map. Rows are picked
+ * at random from an array with num_rows_in_array rows; small subsets use the sparse map
+ */
+void benchmark_row_map_setup(GenomicsDBBenchmarkState& state, const uint64_t num_rows_in_array,
+    const uint64_t num_rows_to_query, const unsigned seed)
+{
+  VERIFY_OR_THROW(num_rows_to_query <= num_rows_in_array);
+  std::mt19937_64 generator(seed);
+  std::vector<int64_t> all_rows(num_rows_in_array);
+  for(auto i=0ull;i<num_rows_in_array;++i)
+    all_rows[i] = i;
+  std::vector<int64_t> query_rows(num_rows_to_query);
+  for(auto i=0ull;i<num_rows_to_query;++i)
+  {
+    std::uniform_int_distribution<uint64_t> distribution(i, num_rows_in_array-1u);
+    std::swap(all_rows[i], all_rows[distribution(generator)]);
+    query_rows[i] = all_rows[i];
+  }
+  all_rows.clear();
+  VariantQueryConfig query_config;
+  query_config.set_num_rows_in_array(num_rows_in_array, 0u);
+  auto num_setups = 0ull;
+  while(state.keep_running())
+  {
+    query_config.set_rows_to_query(query_rows);
+    query_config.setup_array_row_idx_to_query_row_idx_map();
+    ++num_setups;
+  }
+  //Sanity check - every queried row must be found
+  for(auto row_idx : query_rows)
+    VERIFY_OR_THROW(query_config.is_queried_array_row_idx(row_idx));
+  state.set_items_processed(num_setups);
+  state.set_counter("sparse_row_map", query_config.uses_sparse_row_map() ? 1 : 0);
+}
+
+/*
+ * Stores copies of the Variants produced by scan_and_operate() so that the operators can be
+ * benchmarked in isolation from the TileDB scan
+ */
+class VariantCollectorOperator : public SingleVariantOperatorBase
+{
+  public:
+    VariantCollectorOperator(std::vector<Variant>& variants, const uint64_t max_num_variants)
+      : SingleVariantOperatorBase(), m_variants(&variants), m_max_num_variants(max_num_variants)
+    { }
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config)
+    {
+      if(m_variants->size() >= m_max_num_variants)
+        return;
+      m_variants->emplace_back(&query_config);
+      m_variants->back().copy_from_variant(variant);
+    }
+  private:
+    std::vector<Variant>* m_variants;
+    uint64_t m_max_num_variants;
+};
+
+/*
+ * Genotype matrix built from the Variants produced by scan_and_operate() - the generic path that
+ * GenomicsDBGenotypeMatrixQuery bypasses. A site is added wherever a call begins with a non-ref GT
+ */
+class GenotypeMatrixVariantOperator : public SingleVariantOperatorBase
+{
+  public:
+    GenotypeMatrixVariantOperator(GenotypeMatrix& matrix, const unsigned GT_query_idx)
+      : SingleVariantOperatorBase(), m_matrix(&matrix), m_GT_query_idx(GT_query_idx),
+      m_codes(matrix.get_num_samples())
+    { }
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config)
+    {
+      typedef GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_2BIT> Traits;
+      std::fill(m_codes.begin(), m_codes.end(), Traits::m_missing);
+      auto is_site = false;
+      for(auto iter=variant.begin();iter!=variant.end();++iter)
+      {
+        auto& curr_call = *iter;
+        auto& GT_field = curr_call.get_field(m_GT_query_idx);
+        if(!(GT_field.get() && GT_field->is_valid()))
+          continue;
+        auto& GT = curr_call.get_field<VariantFieldPrimitiveVectorData<int>>(m_GT_query_idx)->get();
+        auto num_non_ref_alleles = 0u;
+        auto is_missing = GT.empty();
+        for(auto allele : GT)
+        {
+          is_missing = is_missing || (allele < 0);
+          num_non_ref_alleles += (allele > 0) ? 1u : 0u;
+        }
+        auto code = is_missing ? Traits::m_missing : Traits::encode(GT.size(), num_non_ref_alleles);
+        if(curr_call.get_column_begin() == variant.get_column_begin())
+        {
+          m_codes[iter.get_call_idx_in_variant()] = code;
+          is_site = is_site || (code != Traits::m_missing && code != Traits::m_hom_ref);
+        }
+        else
+          if(code == Traits::m_hom_ref)
+            m_codes[iter.get_call_idx_in_variant()] = code;
+      }
+      if(!is_site)
+        return;
+      auto site_idx = m_matrix->add_site(variant.get_column_begin());
+      for(auto i=0ull;i<m_codes.size();++i)
+        m_matrix->set_genotype<GENOTYPE_MATRIX_ENCODING_2BIT>(site_idx, i, m_codes[i]);
+    }
+  private:
+    GenotypeMatrix* m_matrix;
+    unsigned m_GT_query_idx;
+    std::vector<uint8_t> m_codes;
+};
+
+/*
+ * Query side benchmarks - the query JSON must be usable for producing combined gVCFs
+ * (same requirements as gt_mpi_gather --produce-Broad-GVCF)
+ */
+class QueryBenchmarks
+{
+  public:
+    QueryBenchmarks(const std::string& query_json_file, const std::string& loader_json_file, const int rank,
+        const size_t segment_size, const uint64_t max_num_variants)
+      : m_vcf_adapter(1048576u, false), m_buffer(1048576u)
+    {
+      if(!loader_json_file.empty())
+      {
+        JSONLoaderConfig loader_config;
+        loader_config.read_from_file(loader_json_file, &m_id_mapper, rank);
+      }
+      m_scan_config.read_from_file(query_json_file, m_query_config, m_vcf_adapter, &m_id_mapper, "", rank);
+      VariantQueryProcessor::apply_process_wide_settings(static_cast<JSONBasicQueryConfig&>(m_scan_config), rank);
+      VariantQueryProcessor::initialize_auto_query_column_ranges(static_cast<JSONBasicQueryConfig&>(m_scan_config),
+          m_query_config, m_id_mapper, rank);
+      //Genotype matrix benchmarks query GT only
+      m_GT_query_config = m_query_config;
+      m_GT_query_config.clear_attributes_to_query();
+      m_GT_query_config.set_attributes_to_query(std::vector<std::string>{ "GT" });
+      m_storage_manager.reset(new VariantStorageManager(static_cast<JSONBasicQueryConfig&>(m_scan_config).get_workspace(rank),
+            segment_size));
+      m_query_processor.reset(new VariantQueryProcessor(m_storage_manager.get(),
+            static_cast<JSONBasicQueryConfig&>(m_scan_config).get_array_name(rank),
+            m_id_mapper));
+      m_query_processor->do_query_bookkeeping(m_query_processor->get_array_schema(), m_query_config, m_id_mapper, true);
+      m_query_processor->do_query_bookkeeping(m_query_processor->get_array_schema(), m_GT_query_config, m_id_mapper, false);
+      VERIFY_OR_THROW(m_query_config.get_num_column_intervals() > 0u);
+      m_vcf_adapter.set_buffer(m_buffer);
+      //Variants used by the operator benchmarks
+      VariantCollectorOperator collector(m_variants, max_num_variants);
+      for(auto i=0u;i<m_query_config.get_num_column_intervals();++i)
+        m_query_processor->scan_and_operate(m_query_processor->get_array_descriptor(), m_query_config, collector, i, true);
+      m_num_calls_in_variants = 0ull;
+      for(const auto& variant : m_variants)
+        m_num_calls_in_variants += variant.get_num_calls();
+    }
+    std::string get_suffix() const
+    {
+      return std::string("/samples:")+std::to_string(m_query_config.get_num_rows_to_query());
+    }
+    void register_benchmarks(GenomicsDBBenchmarkRunner& runner)
+    {
+      auto suffix = get_suffix();
+      runner.add_benchmark("VariantArrayCellIterator"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_cell_iterator(state); });
+      runner.add_benchmark("gt_get_column_interval"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_gt_get_column_interval(state); });
+      runner.add_benchmark("merge_alt_alleles"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_merge_alt_alleles(state); });
+      runner.add_benchmark("GA4GHOperator::operate"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_GA4GH_operator(state); });
+      runner.add_benchmark("BroadCombinedGVCFOperator::operate"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_broad_combined_gvcf_operator(state); });
+      runner.add_benchmark("GenotypeMatrix/scan_and_operate"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_genotype_matrix(state, false); });
+      runner.add_benchmark("GenotypeMatrix/GenotypeMatrixOperator"+suffix,
+          [this](GenomicsDBBenchmarkState& state) { benchmark_genotype_matrix(state, true); });
+    }
+    //Raw TileDB cell iteration over the first query interval
+    void benchmark_cell_iterator(GenomicsDBBenchmarkState& state)
+    {
+      auto column_interval = m_query_config.get_column_interval(0u);
+      std::vector<int64_t> query_range = { m_query_config.get_smallest_row_idx_in_array(),
+        static_cast<int64_t>(m_query_config.get_num_rows_in_array()+m_query_config.get_smallest_row_idx_in_array()-1),
+        column_interval.first, column_interval.second };
+      auto attribute_ids = m_query_config.get_query_attributes_schema_idxs();
+      auto num_cells = 0ull;
+      while(state.keep_running())
+      {
+        std::unique_ptr<VariantArrayCellIterator> iter(m_storage_manager->begin(m_query_processor->get_array_descriptor(),
+              &(query_range[0]), attribute_ids));
+        for(;!(iter->end());++(*iter))
+        {
+          auto& cell = **iter;
+          num_cells += (cell.get_begin_column() >= 0) ? 1u : 0u;
+        }
+      }
+      state.set_items_processed(num_cells);
+    }
+    //Dominated by gt_fill_row()/fill_field()
+    void benchmark_gt_get_column_interval(GenomicsDBBenchmarkState& state)
+    {
+      std::vector<Variant> variants;
+      auto num_variants = 0ull;
+      while(state.keep_running())
+      {
+        state.pause_timing();
+        variants.clear();
+        state.resume_timing();
+        m_query_processor->gt_get_column_interval(m_query_processor->get_array_descriptor(), m_query_config, 0u, variants);
+        num_variants += variants.size();
+      }
+      state.set_items_processed(num_variants);
+    }
+    //SingleVariantOperatorBase::operate - merge_reference_allele() and merge_alt_alleles()
+    void benchmark_merge_alt_alleles(GenomicsDBBenchmarkState& state)
+    {
+      VERIFY_OR_THROW(!m_variants.empty());
+      SingleVariantOperatorBase variant_operator;
+      auto num_calls = 0ull;
+      while(state.keep_running())
+      {
+        for(auto& variant : m_variants)
+          variant_operator.operate(variant, m_query_config);
+        num_calls += m_num_calls_in_variants;
+      }
+      state.set_items_processed(num_calls);
+    }
+    //merge_alt_alleles() followed by remap_data_based_on_alleles/genotype() for AD/PL
+    void benchmark_GA4GH_operator(GenomicsDBBenchmarkState& state)
+    {
+      VERIFY_OR_THROW(!m_variants.empty());
+      GA4GHOperator variant_operator(m_query_config, m_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
+      auto num_calls = 0ull;
+      while(state.keep_running())
+      {
+        for(auto& variant : m_variants)
+          variant_operator.operate(variant, m_query_config);
+        num_calls += m_num_calls_in_variants;
+      }
+      state.set_items_processed(num_calls);
+    }
+    //Full combined gVCF record creation and serialization - the operator modifies Variants, so work on copies
+    void benchmark_broad_combined_gvcf_operator(GenomicsDBBenchmarkState& state)
+    {
+      VERIFY_OR_THROW(!m_variants.empty());
+      BroadCombinedGVCFOperator variant_operator(m_vcf_adapter, m_id_mapper, m_query_config,
+          m_scan_config.get_max_diploid_alt_alleles_that_can_be_genotyped());
+      std::vector<Variant> variants;
+      for(auto i=0ull;i<m_variants.size();++i)
+        variants.emplace_back(&m_query_config);
+      auto num_calls = 0ull;
+      auto num_bytes = 0ull;
+      while(state.keep_running())
+      {
+        state.pause_timing();
+        for(auto i=0ull;i<m_variants.size();++i)
+          variants[i].copy_from_variant(m_variants[i]);
+        variant_operator.reset_contig_tracking();
+        m_buffer.m_num_valid_bytes = 0u;
+        state.resume_timing();
+        for(auto& variant : variants)
+        {
+          variant_operator.operate(variant, m_query_config);
+          if(variant_operator.overflow())
+          {
+            num_bytes += m_buffer.m_num_valid_bytes;
+            m_buffer.m_num_valid_bytes = 0u;
+          }
+        }
+        num_bytes += m_buffer.m_num_valid_bytes;
+        num_calls += m_num_calls_in_variants;
+      }
+      state.set_items_processed(num_calls);
+      state.set_bytes_processed(num_bytes);
+    }
+    //2 bit genotype matrix over all query intervals - GT only cell scan vs Variants from scan_and_operate()
+    void benchmark_genotype_matrix(GenomicsDBBenchmarkState& state, const bool use_fast_path)
+    {
+      GenotypeMatrix matrix(m_GT_query_config.get_num_rows_to_query(), GENOTYPE_MATRIX_ENCODING_2BIT);
+      GenotypeMatrixVariantOperator variant_operator(matrix,
+          m_GT_query_config.get_query_idx_for_known_field_enum(GVCF_GT_IDX));
+      auto num_sites = 0ull;
+      while(state.keep_running())
+      {
+        state.pause_timing();
+        matrix.clear();
+        state.resume_timing();
+        if(use_fast_path)
+          GenomicsDBGenotypeMatrixQuery::fill_matrix(*m_storage_manager, m_query_processor->get_array_descriptor(),
+              m_GT_query_config, matrix);
+        else
+          for(auto i=0u;i<m_GT_query_config.get_num_column_intervals();++i)
+            m_query_processor->scan_and_operate(m_query_processor->get_array_descriptor(), m_GT_query_config,
+                variant_operator, i, false);
+        num_sites += matrix.get_num_sites();
+      }
+      state.set_items_processed(num_sites);
+      state.set_counter("sites", matrix.get_num_sites());
+    }
+  private:
+    FileBasedVidMapper m_id_mapper;
+    VariantQueryConfig m_query_config;
+    VariantQueryConfig m_GT_query_config;
+    VCFSerializedBufferAdapter m_vcf_adapter;
+    RWBuffer m_buffer;
+    JSONVCFAdapterQueryConfig m_scan_config;
+    std::unique_ptr<VariantStorageManager> m_storage_manager;
+    std::unique_ptr<VariantQueryProcessor> m_query_processor;
+    std::vector<Variant> m_variants;
+    uint64_t m_num_calls_in_variants;
+};
+
+/*
+ * Loader benchmarks - each iteration re-creates the array specified in the loader JSON. The fetch phase
+ * of read_all() is VCF parsing + VCF2Binary::convert_record_to_binary(), the load phase is the column major
+ * merge feeding LoaderArrayWriter::operate()
+ */
+void benchmark_loader_phase(GenomicsDBBenchmarkState& state, const std::string& loader_json_file, const int rank,
+    const bool measure_fetch_phase)
+{
+  while(state.keep_running())
+  {
+    VCF2TileDBLoader loader(loader_json_file, rank);
+    std::unique_ptr<VCF2TileDBLoaderReadState> read_state(loader.construct_read_state_object());
+    loader.read_all(*read_state);
+    loader.finish_read_all(*read_state);
+    const auto& timer = measure_fetch_phase ? read_state->get_fetch_timer() : read_state->get_load_timer();
+    state.set_iteration_time(timer.get_cumulative_wall_clock_time()/1e6);
+    state.set_counter("read_all_seconds", read_state->get_time_in_read_all().get_cumulative_wall_clock_time()/1e6);
+  }
+}
+
+/*
+ * Synthetic cohort with num_samples samples produced by generate_synthetic_gvcfs in
+ * <directory>/samples_<num_samples> - re-used if it exists already. The array is loaded once here, so
+ * that the query benchmarks work even when the loader benchmarks are filtered out
+ */
+void prepare_synthetic_array(const std::string& generator, const std::string& directory, const uint64_t num_samples,
+    const unsigned seed, const int rank, std::string& loader_json_file, std::string& query_json_file)
+{
+  auto cohort_directory = directory+"/samples_"+std::to_string(num_samples);
+  auto workspace = cohort_directory+"/workspace";
+  loader_json_file = cohort_directory+"/loader.json";
+  query_json_file = cohort_directory+"/query.json";
+  struct stat stat_buffer;
+  if(stat(loader_json_file.c_str(), &stat_buffer) != 0)
+  {
+    if(mkdir(directory.c_str(), 0755) != 0 && errno != EEXIST)
+      throw GenomicsDBBenchmarkException(std::string("Could not create directory ")+directory+" : "+strerror(errno));
+    auto command = generator+" -o "+cohort_directory+" --num-samples "+std::to_string(num_samples)
+      +" --seed "+std::to_string(seed)+" --workspace "+workspace+" --array synthetic";
+    std::cerr << "Generating synthetic cohort : "<<command<<"\n";
+    if(system(command.c_str()) != 0)
+      throw GenomicsDBBenchmarkException(std::string("Command failed : ")+command);
+  }
+  if(stat((workspace+"/synthetic").c_str(), &stat_buffer) != 0)
+  {
+    VCF2TileDBLoader loader(loader_json_file, rank);
+    loader.read_all();
+  }
+}
+
+//generate_synthetic_gvcfs is installed in the same directory as this executable - else look it up in PATH
+std::string get_default_generator_path(const char* argv0)
+{
+  std::string path = argv0;
+  auto pos = path.find_last_of('/');
+  if(pos != std::string::npos)
+  {
+    path = path.substr(0u, pos+1u)+"generate_synthetic_gvcfs";
+    if(access(path.c_str(), X_OK) == 0)
+      return path;
+  }
+  return "generate_synthetic_gvcfs";
+}
+
+void register_loader_benchmarks(GenomicsDBBenchmarkRunner& runner, const std::string& load_json_file, const int rank)
+{
+  FileBasedVidMapper id_mapper;
+  JSONLoaderConfig loader_config;
+  loader_config.read_from_file(load_json_file, &id_mapper, rank);
+  auto suffix = std::string("/samples:")+std::to_string(id_mapper.get_num_callsets());
+  runner.add_benchmark("VCF2Binary::convert_record_to_binary"+suffix,
+      [load_json_file, rank](GenomicsDBBenchmarkState& state) {
+      benchmark_loader_phase(state, load_json_file, rank, true);
+      });
+  runner.add_benchmark("LoaderArrayWriter::operate"+suffix,
+      [load_json_file, rank](GenomicsDBBenchmarkState& state) {
+      benchmark_loader_phase(state, load_json_file, rank, false);
+      });
+}
+
+void parse_uint64_list(const char* str, std::vector<uint64_t>& values)
+{
+  values.clear();
+  std::stringstream ss(str);
+  std::string token;
+  while(std::getline(ss, token, ','))
+    if(!token.empty())
+      values.push_back(strtoull(token.c_str(), 0, 10));
+}
+
+int main(int argc, char** argv)
+{
+  static struct option long_options[] =
+  {
+    {"json-config",1,0,'j'},
+    {"loader-json-config",1,0,'l'},
+    {"rank",1,0,'r'},
+    {"load-json-config",1,0,ARGS_IDX_LOAD_JSON},
+    {"num-samples",1,0,ARGS_IDX_NUM_SAMPLES},
+    {"num-alleles",1,0,ARGS_IDX_NUM_ALLELES},
+    {"max-variants",1,0,ARGS_IDX_MAX_VARIANTS},
+    {"seed",1,0,ARGS_IDX_SEED},
+    {"segment-size",1,0,ARGS_IDX_SEGMENT_SIZE},
+    {"array-rows",1,0,ARGS_IDX_ARRAY_ROWS},
+    {"query-rows",1,0,ARGS_IDX_QUERY_ROWS},
+    {"synthetic-samples",1,0,ARGS_IDX_SYNTHETIC_SAMPLES},
+    {"synthetic-directory",1,0,ARGS_IDX_SYNTHETIC_DIRECTORY},
+    {"generator",1,0,ARGS_IDX_GENERATOR},
+    {"benchmark_filter",1,0,ARGS_IDX_BENCHMARK_FILTER},
+    {"benchmark_repetitions",1,0,ARGS_IDX_BENCHMARK_REPETITIONS},
+    {"benchmark_min_time",1,0,ARGS_IDX_BENCHMARK_MIN_TIME},
+    {"benchmark_iterations",1,0,ARGS_IDX_BENCHMARK_ITERATIONS},
+    {"benchmark_out",1,0,ARGS_IDX_BENCHMARK_OUT},
+    {"version",0,0,ARGS_IDX_VERSION},
+    {0,0,0,0},
+  };
+  std::string query_json_file;
+  std::string loader_json_file;
+  std::string load_json_file;
+  auto rank = 0;
+  std::vector<uint64_t> num_samples_vec = { 100u, 1000u, 10000u };
+  std::vector<uint64_t> num_array_rows_vec = { 1000u, 100000u, 10000000u };
+  std::vector<uint64_t> num_query_rows_vec = { 10u, 1000u, 50000u };
+  std::vector<uint64_t> num_synthetic_samples_vec;
+  std::string synthetic_directory = "genomicsdb_benchmark_inputs";
+  auto generator = get_default_generator_path(argv[0]);
+  auto num_merged_alleles = 4u;
+  auto max_num_variants = 100000ull;
+  auto seed = 0u;
+  size_t segment_size = 10u*1024u*1024u;
+  GenomicsDBBenchmarkRunner runner;
+  int c;
+  while((c=getopt_long(argc, argv, "j:l:r:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'j':
+        query_json_file = optarg;
+        break;
+      case 'l':
+        loader_json_file = optarg;
+        break;
+      case 'r':
+        rank = strtol(optarg, 0, 10);
+        break;
+      case ARGS_IDX_LOAD_JSON:
+        load_json_file = optarg;
+        break;
+      case ARGS_IDX_NUM_SAMPLES:
+        parse_uint64_list(optarg, num_samples_vec);
+        break;
+      case ARGS_IDX_NUM_ALLELES:
+        num_merged_alleles = strtoul(optarg, 0, 10);
+        break;
+      case ARGS_IDX_MAX_VARIANTS:
+        max_num_variants = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_SEED:
+        seed = strtoul(optarg, 0, 10);
+        break;
+      case ARGS_IDX_SEGMENT_SIZE:
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_ARRAY_ROWS:
+        parse_uint64_list(optarg, num_array_rows_vec);
+        break;
+      case ARGS_IDX_QUERY_ROWS:
+        parse_uint64_list(optarg, num_query_rows_vec);
+        break;
+      case ARGS_IDX_SYNTHETIC_SAMPLES:
+        parse_uint64_list(optarg, num_synthetic_samples_vec);
+        break;
+      case ARGS_IDX_SYNTHETIC_DIRECTORY:
+        synthetic_directory = optarg;
+        break;
+      case ARGS_IDX_GENERATOR:
+        generator = optarg;
+        break;
+      case ARGS_IDX_BENCHMARK_FILTER:
+        runner.set_filter(optarg);
+        break;
+      case ARGS_IDX_BENCHMARK_REPETITIONS:
+        runner.set_num_repetitions(strtoul(optarg, 0, 10));
+        break;
+      case ARGS_IDX_BENCHMARK_MIN_TIME:
+        runner.set_min_time(strtod(optarg, 0));
+        break;
+      case ARGS_IDX_BENCHMARK_ITERATIONS:
+        runner.set_max_iterations(strtoull(optarg, 0, 10));
+        break;
+      case ARGS_IDX_BENCHMARK_OUT:
+        runner.set_output_filename(optarg);
+        break;
+      case ARGS_IDX_VERSION:
+        std::cout << GENOMICSDB_VERSION <<"\n";
+        return 0;
+      default:
+        std::cerr << "Usage: "<<argv[0]<<" [ -j <query_json> [ -l <loader_json> ] ] [ --load-json-config <loader_json> ]\n"
+          << "\t[ --num-samples <n1,n2,..> ] [ --num-alleles <n> ] [ --max-variants <n> ] [ --seed <n> ]\n"
+          << "\t[ --array-rows <n1,n2,..> ] [ --query-rows <n1,n2,..> ]\n"
+          << "\t[ --synthetic-samples <n1,n2,..> [ --synthetic-directory <dir> ] [ --generator <generate_synthetic_gvcfs> ] ]\n"
+          << "\t[ --benchmark_filter <regex> ] [ --benchmark_repetitions <n> ] [ --benchmark_min_time <seconds> ]\n"
+          << "\t[ --benchmark_iterations <n> ] [ --benchmark_out <json_file> ]\n";
+        return -1;
+    }
+  }
+  runner.add_context("genomicsdb_version", GENOMICSDB_VERSION);
+  runner.add_context("seed", std::to_string(seed));
+  //Synthetic benchmarks
+  for(auto num_samples : num_samples_vec)
+    runner.add_benchmark(std::string("remap_data_based_on_genotype/samples:")+std::to_string(num_samples)
+        +"/alleles:"+std::to_string(num_merged_alleles),
+        [num_samples, num_merged_alleles, seed](GenomicsDBBenchmarkState& state) {
+        benchmark_remap_data_based_on_genotype(state, num_samples, num_merged_alleles, seed);
+        });
+  for(auto num_rows_in_array : num_array_rows_vec)
+    for(auto num_rows_to_query : num_query_rows_vec)
+      if(num_rows_to_query <= num_rows_in_array)
+        runner.add_benchmark(std::string("setup_array_row_idx_to_query_row_idx_map/array_rows:")
+            +std::to_string(num_rows_in_array)+"/query_rows:"+std::to_string(num_rows_to_query),
+            [num_rows_in_array, num_rows_to_query, seed](GenomicsDBBenchmarkState& state) {
+            benchmark_row_map_setup(state, num_rows_in_array, num_rows_to_query, seed);
+            });
+  //Query benchmarks over an existing array
+  std::vector<std::unique_ptr<QueryBenchmarks>> query_benchmarks;
+  if(!query_json_file.empty())
+  {
+    query_benchmarks.emplace_back(new QueryBenchmarks(query_json_file, loader_json_file, rank, segment_size, max_num_variants));
+    runner.add_context("query_json_config", query_json_file);
+    query_benchmarks.back()->register_benchmarks(runner);
+  }
+  //Loader benchmarks - the array in the loader JSON is overwritten
+  if(!load_json_file.empty())
+  {
+    runner.add_context("load_json_config", load_json_file);
+    register_loader_benchmarks(runner, load_json_file, rank);
+  }
+  //Loader and query benchmarks over generated cohorts
+  if(!num_synthetic_samples_vec.empty())
+    runner.add_context("synthetic_directory", synthetic_directory);
+  for(auto num_samples : num_synthetic_samples_vec)
+  {
+    std::string synthetic_loader_json_file, synthetic_query_json_file;
+    prepare_synthetic_array(generator, synthetic_directory, num_samples, seed, rank,
+        synthetic_loader_json_file, synthetic_query_json_file);
+    query_benchmarks.emplace_back(new QueryBenchmarks(synthetic_query_json_file, "", rank, segment_size, max_num_variants));
+    query_benchmarks.back()->register_benchmarks(runner);
+    register_loader_benchmarks(runner, synthetic_loader_json_file, rank);
+  }
+  auto num_failed = runner.run();
+  return (num_failed == 0u) ? 0 : -1;
+}
@@ -0,0 +1,185 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "headers.h"
+#include <getopt.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/wait.h>
+#include <sys/resource.h>
+#include "memory_measure.h"
+#include "timer.h"
+
+/*
+ * Runs a command (typically mpirun <tool> or a GenomicsDB tool directly) and reports its wall clock
+ * time and peak resident memory. The process tree rooted at the child is sampled periodically with
+ * read_off_process_memory_status() so that the memory of all MPI ranks is accounted for.
+ * A single JSON object is written to stdout or to the file passed with -o
+ */
+
+//Parent pid of a process from /proc/<pid>/stat - returns -1 if the process does not exist
+static pid_t get_parent_pid(const pid_t pid)
+{
+  std::ifstream fptr(("/proc/"+std::to_string(pid)+"/stat").c_str());
+  if(!fptr.is_open())
+    return -1;
+  std::string line;
+  std::getline(fptr, line);
+  //Executable name is within parentheses and may contain spaces
+  auto pos = line.rfind(')');
+  if(pos == std::string::npos || pos+4u >= line.length())
+    return -1;
+  //Skip ") <state> "
+  return strtol(line.c_str()+pos+4u, 0, 10);
+}
+
+static void get_descendants(const pid_t root_pid, std::vector<pid_t>& descendants)
+{
+  descendants.clear();
+  std::unordered_map<pid_t, std::vector<pid_t>> children;
+  auto dir = opendir("/proc");
+  if(dir == 0)
+    return;
+  struct dirent* entry = 0;
+  while((entry = readdir(dir)))
+  {
+    char* end = 0;
+    auto pid = strtol(entry->d_name, &end, 10);
+    if(*end != '\0' || pid <= 0)
+      continue;
+    auto parent_pid = get_parent_pid(pid);
+    if(parent_pid > 0)
+      children[parent_pid].push_back(pid);
+  }
+  closedir(dir);
+  descendants.push_back(root_pid);
+  for(auto i=0ull;i<descendants.size();++i)
+  {
+    auto iter = children.find(descendants[i]);
+    if(iter != children.end())
+      descendants.insert(descendants.end(), (*iter).second.begin(), (*iter).second.end());
+  }
+}
+
+int main(int argc, char** argv)
+{
+  static struct option long_options[] =
+  {
+    {"output",1,0,'o'},
+    {"sampling-interval",1,0,'i'},
+    {"label",1,0,'L'},
+    {0,0,0,0},
+  };
+  std::string output_filename;
+  std::string label;
+  auto sampling_interval_ms = 50u;
+  int c;
+  //'+' - stop at the first non-option so that the options of the command are not parsed
+  while((c=getopt_long(argc, argv, "+o:i:L:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'o':
+        output_filename = optarg;
+        break;
+      case 'i':
+        sampling_interval_ms = strtoul(optarg, 0, 10);
+        break;
+      case 'L':
+        label = optarg;
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        return -1;
+    }
+  }
+  if(optind >= argc)
+  {
+    std::cerr << "Usage: "<<argv[0]<<" [ -o <output_json> ] [ -i <sampling_interval_ms> ] [ -L <label> ] [--] <command> [ <args> ]\n";
+    return -1;
+  }
+  Timer timer;
+  timer.start();
+  auto child_pid = fork();
+  if(child_pid < 0)
+  {
+    perror("fork");
+    return -1;
+  }
+  if(child_pid == 0)
+  {
+    execvp(argv[optind], argv+optind);
+    perror(argv[optind]);
+    _exit(127);
+  }
+  auto peak_resident = 0ull;
+  auto peak_resident_single_process = 0ull;
+  auto max_num_processes = 1ull;
+  std::vector<pid_t> descendants;
+  int status = 0;
+  while(true)
+  {
+    auto pid = waitpid(child_pid, &status, WNOHANG);
+    if(pid == child_pid || pid < 0)
+      break;
+    get_descendants(child_pid, descendants);
+    auto total_resident = 0ull;
+    auto num_processes = 0ull;
+    for(auto curr_pid : descendants)
+    {
+      statm_t mem_result;
+      if(read_off_process_memory_status(mem_result, curr_pid))
+      {
+        total_resident += mem_result.resident;
+        peak_resident_single_process = std::max<unsigned long long>(peak_resident_single_process, mem_result.resident);
+        ++num_processes;
+      }
+    }
+    peak_resident = std::max(peak_resident, total_resident);
+    max_num_processes = std::max(max_num_processes, num_processes);
+    usleep(sampling_interval_ms*1000u);
+  }
+  timer.stop();
+  //High water mark of the largest descendant as seen by the kernel - catches spikes between samples
+  struct rusage usage;
+  getrusage(RUSAGE_CHILDREN, &usage);
+  auto max_rss = static_cast<unsigned long long>(usage.ru_maxrss)*1024ull;
+  auto exit_code = WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+  std::ofstream output_fptr;
+  if(!output_filename.empty())
+  {
+    output_fptr.open(output_filename.c_str());
+    if(!output_fptr.is_open())
+    {
+      std::cerr << "Could not open output file "<<output_filename<<"\n";
+      return -1;
+    }
+  }
+  std::ostream& fptr = output_filename.empty() ? std::cout : output_fptr;
+  fptr << std::fixed << std::setprecision(6);
+  fptr << "{ \"label\": \"" << label << "\", \"exit_code\": " << exit_code
+    << ", \"wall_clock_time_s\": " << timer.get_last_interval_wall_clock_time()/1000000.0
+    << ", \"peak_resident_bytes\": " << std::max(peak_resident, max_rss)
+    << ", \"peak_resident_bytes_single_process\": " << std::max(peak_resident_single_process, max_rss)
+    << ", \"max_num_processes\": " << max_num_processes << " }\n";
+  return exit_code;
+}
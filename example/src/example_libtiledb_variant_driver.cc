@@ -25,6 +25,7 @@
 #include <getopt.h>
 
 #include "libtiledb_variant.h"
+#include "variant_block_serialization.h"
 
 #ifdef USE_GPERFTOOLS
 #include "gperftools/profiler.h"
@@ -35,6 +36,7 @@ enum ArgsEnum
   ARGS_IDX_TEST_SINGLE_POSITIONS=1000,
   ARGS_IDX_TEST_UPDATE_ROWS,
   ARGS_IDX_TEST_BINARY_SERIALIZATION,
+  ARGS_IDX_TEST_BLOCK_SERIALIZATION,
   ARGS_IDX_NUM_ARGS
 };
 
@@ -48,6 +50,7 @@ int main(int argc, char *argv[]) {
         {"vid-mapping-file",1,0,'V'},
         {"output-format",1,0,'O'},
         {"test-binary-serialization",0,0,ARGS_IDX_TEST_BINARY_SERIALIZATION},
+        {"test-block-serialization",1,0,ARGS_IDX_TEST_BLOCK_SERIALIZATION},
         {0,0,0,0},
     };
     int c;
@@ -56,6 +59,9 @@ int main(int argc, char *argv[]) {
     bool test_single_positions = false;
     bool test_update_rows = false;
     bool test_binary_serialization = false;
+    //#variants per block, 0 - block serialization not tested
+    uint64_t num_variants_per_block = 0u;
+    auto block_compression = VARIANT_BLOCK_COMPRESSION_NONE;
     std::string vid_mapping_file = "";
     while((c=getopt_long(argc, argv, "V:p:O:", long_options, NULL)) >= 0)
     {
@@ -73,6 +79,12 @@ int main(int argc, char *argv[]) {
             case ARGS_IDX_TEST_BINARY_SERIALIZATION:
                 test_binary_serialization = true;
                 break;
+            case ARGS_IDX_TEST_BLOCK_SERIALIZATION:
+                //<#variants per block>[:zlib]
+                num_variants_per_block = strtoull(optarg, 0, 10);
+                if(std::string(optarg).find(":zlib") != std::string::npos)
+                    block_compression = VARIANT_BLOCK_COMPRESSION_ZLIB;
+                break;
             case ARGS_IDX_TEST_SINGLE_POSITIONS:
                 test_single_positions = true;
                 break;
@@ -196,6 +208,35 @@ int main(int argc, char *argv[]) {
             for(auto i=0ull;offset < serialized_length;++i)
                 qp.binary_deserialize(variants[i], query_config, buffer, offset);
         }
+        if(num_variants_per_block)
+        {
+            //Multiple blocks in one buffer
+            VariantBlockSerializer serializer(block_compression);
+            std::vector<uint8_t> buffer;
+            uint64_t offset = 0ull;
+            for(auto i=0ull;i<variants.size();i+=num_variants_per_block)
+                serializer.serialize(variants.data()+i, std::min<uint64_t>(num_variants_per_block, variants.size()-i),
+                    buffer, offset);
+            auto serialized_length = offset;
+            offset = 0ull;
+            auto num_variants = variants.size();
+            variants.clear();
+            variants.resize(num_variants);
+            VariantBlockDeserializer deserializer(qp, query_config);
+            auto num_deserialized_variants = 0ull;
+            while(offset < serialized_length)
+            {
+                deserializer.begin_block(buffer.data(), serialized_length, offset);
+                while(num_deserialized_variants < num_variants && deserializer.next(variants[num_deserialized_variants]))
+                    ++num_deserialized_variants;
+            }
+            if(num_deserialized_variants != num_variants)
+            {
+                std::cerr << "Block serialization round trip returned " << num_deserialized_variants
+                    << " variants instead of " << num_variants << "\n";
+                return -1;
+            }
+        }
         print_variants(variants, output_format, query_config, std::cout);
     }
 #ifdef USE_GPERFTOOLS
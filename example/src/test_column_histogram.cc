@@ -0,0 +1,163 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <mpi.h>
+
+#include "libtiledb_variant.h"
+#include "json_config.h"
+#include "variant_operations.h"
+
+/*
+ * Checks that the column histogram kept in the array metadata by the loader agrees with the
+ * histogram obtained by scanning the array. Bins of the metadata histogram that straddle two
+ * bins of the operator are spread, so per-bin counts are compared only when the operator bins are
+ * aligned to the stored bins - totals must always match
+ */
+
+static bool compare_histograms(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const ColumnCellHistogram& stored_histogram, const uint64_t begin, const uint64_t end, const uint64_t bin_size)
+{
+  ColumnHistogramOperator scan_op(begin, end, bin_size);
+  qp.iterate_over_cells(qp.get_array_descriptor(), query_config, scan_op, 0u);
+  ColumnHistogramOperator metadata_op(begin, end, bin_size);
+  if(!metadata_op.can_use_column_cell_histogram(stored_histogram, query_config))
+  {
+    std::cerr << "Stored histogram not usable with bin size " << bin_size << "\n";
+    return false;
+  }
+  metadata_op.add_column_cell_histogram(stored_histogram);
+  const auto& scan_counts = scan_op.get_bin_counts();
+  const auto& metadata_counts = metadata_op.get_bin_counts();
+  auto aligned = (bin_size%stored_histogram.get_bin_size() == 0u) && (begin%stored_histogram.get_bin_size() == 0u);
+  auto scan_total = 0ull;
+  auto metadata_total = 0ull;
+  auto num_mismatched_bins = 0ull;
+  for(auto i=0ull;i<scan_counts.size();++i)
+  {
+    scan_total += scan_counts[i];
+    metadata_total += metadata_counts[i];
+    if(aligned && scan_counts[i] != metadata_counts[i])
+      ++num_mismatched_bins;
+  }
+  std::cout << "Bin size " << bin_size << " #cells scan " << scan_total << " metadata " << metadata_total
+    << " mismatched bins " << num_mismatched_bins << "\n";
+  return scan_total > 0ull && scan_total == metadata_total && num_mismatched_bins == 0ull;
+}
+
+int main(int argc, char** argv)
+{
+  //MPI is used only to obtain the rank
+  MPI_Init(&argc, &argv);
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"loader-json-config",1,0,'l'},
+    {"json-config",1,0,'j'},
+    {"segment-size",1,0,'s'},
+    {0,0,0,0},
+  };
+  std::string loader_json_config_file;
+  std::string query_json_config_file;
+  size_t segment_size = 10u*1024u*1024u;
+  int c;
+  while((c=getopt_long(argc, argv, "l:j:s:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'l':
+        loader_json_config_file = optarg;
+        break;
+      case 'j':
+        query_json_config_file = optarg;
+        break;
+      case 's':
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        MPI_Finalize();
+        return -1;
+    }
+  }
+  if(query_json_config_file.empty())
+  {
+    std::cerr << "Usage: " << argv[0] << " [-l <loader.json>] -j <query.json> [-s <segment size>]\n";
+    MPI_Finalize();
+    return -1;
+  }
+  auto returnval = 0;
+  try
+  {
+    VariantQueryConfig query_config;
+    FileBasedVidMapper id_mapper;
+    JSONLoaderConfig loader_config;
+    JSONLoaderConfig* loader_config_ptr = 0;
+    if(!loader_json_config_file.empty())
+    {
+      loader_config.read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
+      loader_config_ptr = &loader_config;
+    }
+    JSONBasicQueryConfig range_query_config;
+    range_query_config.read_from_file(query_json_config_file, query_config, &id_mapper, my_world_mpi_rank, loader_config_ptr);
+    //Only cell begin positions are needed - END is always queried
+    query_config.clear_attributes_to_query();
+    query_config.set_attributes_to_query(std::vector<std::string>{ "END" });
+    VariantStorageManager sm(range_query_config.get_workspace(my_world_mpi_rank), segment_size);
+    VariantQueryProcessor qp(&sm, range_query_config.get_array_name(my_world_mpi_rank), id_mapper);
+    qp.do_query_bookkeeping(qp.get_array_schema(), query_config, id_mapper, false);
+    const auto& stored_histogram = sm.get_column_histogram(qp.get_array_descriptor());
+    if(stored_histogram.empty())
+      throw VariantQueryProcessorException("No column histogram in the array metadata");
+    auto stored_bin_size = stored_histogram.get_bin_size();
+    auto end = static_cast<uint64_t>(query_config.get_column_end(0u));
+    //Aligned and straddling bins
+    for(auto bin_size : { stored_bin_size, 2u*stored_bin_size, (3u*stored_bin_size)/2u })
+      if(!compare_histograms(qp, query_config, stored_histogram, 0ull, end, bin_size))
+        returnval = -1;
+    //Finer bins than the stored histogram and row subsets must fall back to a scan
+    ColumnHistogramOperator fine_op(0ull, end, std::max<uint64_t>(1ull, stored_bin_size/2u));
+    if(fine_op.can_use_column_cell_histogram(stored_histogram, query_config))
+    {
+      std::cerr << "Stored histogram used with bins finer than its own\n";
+      returnval = -1;
+    }
+    VariantQueryConfig row_subset_query_config;
+    row_subset_query_config.set_rows_to_query(std::vector<int64_t>{ 0 });
+    ColumnHistogramOperator row_subset_op(0ull, end, stored_bin_size);
+    if(row_subset_op.can_use_column_cell_histogram(stored_histogram, row_subset_query_config))
+    {
+      std::cerr << "Stored histogram used for a subset of rows\n";
+      returnval = -1;
+    }
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    returnval = -1;
+  }
+  MPI_Finalize();
+  return returnval;
+}
@@ -0,0 +1,195 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <mpi.h>
+
+#include "columnar_export.h"
+
+/*
+ * Runs a query through GenomicsDBColumnarQuery and prints every row of the exported record
+ * batches as JSON - { "columnar_calls": [ { "row": .., "interval": [ column, END ], "fields": { .. } } ] }
+ * Null entries are omitted and numeric fields are always printed as lists, as --print-calls does
+ */
+
+static inline bool is_valid(const ArrowArray* array, const int64_t idx)
+{
+  auto validity = reinterpret_cast<const uint8_t*>(array->buffers[0]);
+  return validity == 0 || (validity[idx >> 3] & (1u << (idx & 7)));
+}
+
+static void print_string(std::ostream& fptr, const ArrowArray* array, const int64_t idx)
+{
+  auto offsets = reinterpret_cast<const int32_t*>(array->buffers[1]);
+  auto data = reinterpret_cast<const char*>(array->buffers[2]);
+  fptr << '"';
+  for(auto i=offsets[idx];i<offsets[idx+1];++i)
+  {
+    if(data[i] == '"' || data[i] == '\\')
+      fptr << '\\';
+    fptr << data[i];
+  }
+  fptr << '"';
+}
+
+static void print_primitive(std::ostream& fptr, const ArrowArray* array, const char format, const int64_t idx)
+{
+  auto ptr = array->buffers[1];
+  switch(format)
+  {
+    case 'c': fptr << static_cast<int>(reinterpret_cast<const int8_t*>(ptr)[idx]); break;
+    case 'C': fptr << static_cast<unsigned>(reinterpret_cast<const uint8_t*>(ptr)[idx]); break;
+    case 's': fptr << reinterpret_cast<const int16_t*>(ptr)[idx]; break;
+    case 'S': fptr << reinterpret_cast<const uint16_t*>(ptr)[idx]; break;
+    case 'i': fptr << reinterpret_cast<const int32_t*>(ptr)[idx]; break;
+    case 'I': fptr << reinterpret_cast<const uint32_t*>(ptr)[idx]; break;
+    case 'l': fptr << reinterpret_cast<const int64_t*>(ptr)[idx]; break;
+    case 'L': fptr << reinterpret_cast<const uint64_t*>(ptr)[idx]; break;
+    case 'f': fptr << reinterpret_cast<const float*>(ptr)[idx]; break;
+    case 'g': fptr << reinterpret_cast<const double*>(ptr)[idx]; break;
+    default:
+      throw ColumnarExportException(std::string("Unknown format ")+format);
+  }
+}
+
+static void print_entry(std::ostream& fptr, const ArrowArray* array, const ArrowSchema* schema, const int64_t idx)
+{
+  std::string format = schema->format;
+  if(format == "u")
+    print_string(fptr, array, idx);
+  else if(format == "+l")
+  {
+    auto offsets = reinterpret_cast<const int32_t*>(array->buffers[1]);
+    auto child_array = array->children[0];
+    auto child_schema = schema->children[0];
+    fptr << "[ ";
+    for(auto i=offsets[idx];i<offsets[idx+1];++i)
+    {
+      if(i > offsets[idx])
+        fptr << ",";
+      print_entry(fptr, child_array, child_schema, i);
+    }
+    fptr << " ]";
+  }
+  else
+  {
+    fptr << "[ ";
+    print_primitive(fptr, array, format[0], idx);
+    fptr << " ]";
+  }
+}
+
+int main(int argc, char** argv)
+{
+  //MPI is used only to obtain the rank
+  MPI_Init(&argc, &argv);
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"loader-json-config",1,0,'l'},
+    {"json-config",1,0,'j'},
+    {"batch-size",1,0,'b'},
+    {"segment-size",1,0,'s'},
+    {0,0,0,0},
+  };
+  std::string loader_json_config_file;
+  std::string query_json_config_file;
+  int64_t batch_size = 1048576ll;
+  size_t segment_size = 10u*1024u*1024u;
+  int c;
+  while((c=getopt_long(argc, argv, "l:j:b:s:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'l':
+        loader_json_config_file = optarg;
+        break;
+      case 'j':
+        query_json_config_file = optarg;
+        break;
+      case 'b':
+        batch_size = strtoll(optarg, 0, 10);
+        break;
+      case 's':
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        MPI_Finalize();
+        return -1;
+    }
+  }
+  if(query_json_config_file.empty())
+  {
+    std::cerr << "Usage: " << argv[0] << " [-l <loader.json>] -j <query.json> [-b <rows per batch>] [-s <segment size>]\n";
+    MPI_Finalize();
+    return -1;
+  }
+  auto returnval = 0;
+  try
+  {
+    GenomicsDBColumnarQuery query(loader_json_config_file, query_json_config_file, my_world_mpi_rank,
+        batch_size, segment_size);
+    std::cout << "{\n\"columnar_calls\": [";
+    auto first_row = true;
+    ArrowArray batch;
+    ArrowSchema schema;
+    while(query.export_next_batch(&batch, &schema))
+    {
+      if(batch.length > batch_size)
+        throw ColumnarExportException("Batch with "+std::to_string(batch.length)+" rows exceeds the batch size");
+      //Columns 0-2 are row, column and END
+      auto row_values = reinterpret_cast<const int64_t*>(batch.children[0]->buffers[1]);
+      auto column_values = reinterpret_cast<const int64_t*>(batch.children[1]->buffers[1]);
+      auto END_values = reinterpret_cast<const int64_t*>(batch.children[2]->buffers[1]);
+      for(auto i=0ll;i<batch.length;++i)
+      {
+        std::cout << (first_row ? "\n" : ",\n") << "{ \"row\": " << row_values[i]
+          << ", \"interval\": [ " << column_values[i] << ", " << END_values[i] << " ], \"fields\": {";
+        first_row = false;
+        auto first_field = true;
+        for(auto j=3ll;j<batch.n_children;++j)
+        {
+          if(!is_valid(batch.children[j], i))
+            continue;
+          std::cout << (first_field ? " " : ", ") << "\"" << schema.children[j]->name << "\": ";
+          print_entry(std::cout, batch.children[j], schema.children[j], i);
+          first_field = false;
+        }
+        std::cout << " } }";
+      }
+      batch.release(&batch);
+      schema.release(&schema);
+    }
+    std::cout << "\n]\n}\n";
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    returnval = -1;
+  }
+  MPI_Finalize();
+  return returnval;
+}
@@ -0,0 +1,109 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include <getopt.h>
+#include <mpi.h>
+
+#include "genotype_matrix.h"
+
+/*
+ * Prints the genotype matrix of the query as JSON - one entry per site with the column and the
+ * code of every sample, samples identified by their array rows:
+ * { "sample_rows": [ .. ], "sites": [ [ column, [ code, .. ] ], .. ] }
+ */
+
+int main(int argc, char** argv)
+{
+  //MPI is used only to obtain the rank
+  MPI_Init(&argc, &argv);
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"loader-json-config",1,0,'l'},
+    {"json-config",1,0,'j'},
+    {"segment-size",1,0,'s'},
+    {"encoding-bits",1,0,'e'},
+    {0,0,0,0},
+  };
+  std::string loader_json_config_file;
+  std::string query_json_config_file;
+  size_t segment_size = 10u*1024u*1024u;
+  auto encoding = GENOTYPE_MATRIX_ENCODING_2BIT;
+  int c;
+  while((c=getopt_long(argc, argv, "l:j:s:e:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'l':
+        loader_json_config_file = optarg;
+        break;
+      case 'j':
+        query_json_config_file = optarg;
+        break;
+      case 's':
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      case 'e':
+        encoding = (strtoul(optarg, 0, 10) == 8u) ? GENOTYPE_MATRIX_ENCODING_8BIT : GENOTYPE_MATRIX_ENCODING_2BIT;
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        MPI_Finalize();
+        return -1;
+    }
+  }
+  if(query_json_config_file.empty())
+  {
+    std::cerr << "Usage: " << argv[0] << " [-l <loader.json>] -j <query.json> [-s <segment size>] [-e <2|8>]\n";
+    MPI_Finalize();
+    return -1;
+  }
+  auto returnval = 0;
+  try
+  {
+    GenomicsDBGenotypeMatrixQuery query(loader_json_config_file, query_json_config_file, my_world_mpi_rank,
+        encoding, false, segment_size);
+    const auto& matrix = query.get_matrix();
+    std::cout << "{\n    \"sample_rows\": [";
+    for(auto i=0ull;i<matrix.get_num_samples();++i)
+      std::cout << (i ? ", " : " ") << query.get_array_row_idx_for_sample(i);
+    std::cout << " ],\n    \"sites\": [";
+    for(auto site_idx=0ull;site_idx<matrix.get_num_sites();++site_idx)
+    {
+      std::cout << (site_idx ? ",\n" : "\n") << "        [ " << matrix.get_site_columns()[site_idx] << ", [";
+      for(auto i=0ull;i<matrix.get_num_samples();++i)
+        std::cout << (i ? ", " : " ") << static_cast<unsigned>(matrix.get_genotype(site_idx, i));
+      std::cout << " ] ]";
+    }
+    std::cout << "\n    ]\n}\n";
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    returnval = -1;
+  }
+  MPI_Finalize();
+  return returnval;
+}
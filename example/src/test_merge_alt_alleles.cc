@@ -0,0 +1,213 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <getopt.h>
+#include <mpi.h>
+
+#include "libtiledb_variant.h"
+#include "json_config.h"
+#include "variant_operations.h"
+
+/*
+ * Scans the queried intervals and checks, at every site, that the merged ALT list and allele
+ * mappings produced by merge_alt_alleles (re-used interned dictionary) are identical to those of
+ * the original implementation based on a per-site std::unordered_map
+ */
+
+//Original merge_alt_alleles - merged_idx[i][j] is the merged idx of allele j of the i-th call
+static void unordered_map_merge_alt_alleles(const Variant& variant, const VariantQueryConfig& query_config,
+    const std::string& merged_reference_allele, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists,
+    std::vector<std::vector<int64_t>>& merged_idx)
+{
+  // marking non_reference_allele as already seen will ensure it's not included in the middle
+  auto seen_alleles = std::unordered_map<std::string, int>{{g_vcf_NON_REF,-1}};
+  merged_alt_alleles.clear();
+  merged_idx.assign(variant.get_num_calls(), std::vector<int64_t>());
+  auto merged_reference_length = merged_reference_allele.length();
+  auto input_non_reference_allele_idx = std::vector<int>(variant.get_num_calls(), -1);
+  auto merged_allele_idx = 1u;
+  NON_REF_exists = false;
+  for(auto valid_calls_iter=variant.begin();valid_calls_iter != variant.end();++valid_calls_iter)
+  {
+    const auto& curr_valid_call = *valid_calls_iter;
+    auto curr_call_idx_in_variant = valid_calls_iter.get_call_idx_in_variant();
+    const auto& curr_reference =
+      get_known_field<VariantFieldString, true>(curr_valid_call, query_config, GVCF_REF_IDX)->get();
+    const auto& curr_allele_vector =
+      get_known_field<VariantFieldALTData, true>(curr_valid_call, query_config, GVCF_ALT_IDX)->get();
+    auto is_suffix_needed = (curr_reference.length() < merged_reference_length);
+    auto& curr_merged_idx = merged_idx[curr_call_idx_in_variant];
+    curr_merged_idx.assign(curr_allele_vector.size()+1u, -1);
+    curr_merged_idx[0] = 0;
+    auto input_allele_idx = 1u;
+    for(const auto& allele : curr_allele_vector)
+    {
+      if(IS_NON_REF_ALLELE(allele))
+      {
+        input_non_reference_allele_idx[curr_call_idx_in_variant] = input_allele_idx;
+        NON_REF_exists = true;
+      }
+      else
+      {
+        auto copy_allele = allele;
+        if(is_suffix_needed && !VariantUtils::is_symbolic_allele(allele))
+          copy_allele.append(merged_reference_allele, curr_reference.length(),
+              merged_reference_length-curr_reference.length());
+        const auto& iter_pos = seen_alleles.find(copy_allele);
+        if(iter_pos == seen_alleles.end())
+        {
+          seen_alleles[copy_allele] = merged_allele_idx;
+          curr_merged_idx[input_allele_idx] = merged_allele_idx;
+          merged_alt_alleles.push_back(copy_allele);
+          ++merged_allele_idx;
+        }
+        else
+          curr_merged_idx[input_allele_idx] = (*iter_pos).second;
+      }
+      ++input_allele_idx;
+    }
+  }
+  if(NON_REF_exists)
+  {
+    merged_alt_alleles.push_back(g_vcf_NON_REF);
+    for(auto i=0ull;i<merged_idx.size();++i)
+      if(input_non_reference_allele_idx[i] >= 0)
+        merged_idx[i][input_non_reference_allele_idx[i]] = merged_alt_alleles.size();
+  }
+}
+
+class MergeAltAllelesCheckOperator : public SingleVariantOperatorBase
+{
+  public:
+    MergeAltAllelesCheckOperator() : SingleVariantOperatorBase()
+    {
+      m_num_sites = 0ull;
+      m_num_mismatched_sites = 0ull;
+    }
+    virtual void operate(Variant& variant, const VariantQueryConfig& query_config)
+    {
+      SingleVariantOperatorBase::operate(variant, query_config);
+      unordered_map_merge_alt_alleles(variant, query_config, m_merged_reference_allele, m_expected_merged_alt_alleles,
+          m_expected_NON_REF_exists, m_expected_merged_idx);
+      auto match = (m_merged_alt_alleles == m_expected_merged_alt_alleles && m_NON_REF_exists == m_expected_NON_REF_exists);
+      for(auto i=0ull;match && i<m_expected_merged_idx.size();++i)
+        for(auto j=0ull;match && j<m_expected_merged_idx[i].size();++j)
+          match = (m_alleles_LUT.get_merged_idx_for_input(i, j) == m_expected_merged_idx[i][j]);
+      if(!match)
+      {
+        std::cerr << "merge_alt_alleles mismatch at column " << variant.get_column_begin() << " - merged ALT:";
+        for(const auto& allele : m_merged_alt_alleles)
+          std::cerr << " " << allele;
+        std::cerr << ", expected:";
+        for(const auto& allele : m_expected_merged_alt_alleles)
+          std::cerr << " " << allele;
+        std::cerr << "\n";
+        ++m_num_mismatched_sites;
+      }
+      ++m_num_sites;
+    }
+    uint64_t m_num_sites;
+    uint64_t m_num_mismatched_sites;
+  private:
+    std::vector<std::string> m_expected_merged_alt_alleles;
+    bool m_expected_NON_REF_exists;
+    std::vector<std::vector<int64_t>> m_expected_merged_idx;
+};
+
+int main(int argc, char** argv)
+{
+  //MPI is used only to obtain the rank
+  MPI_Init(&argc, &argv);
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"loader-json-config",1,0,'l'},
+    {"json-config",1,0,'j'},
+    {"segment-size",1,0,'s'},
+    {0,0,0,0},
+  };
+  std::string loader_json_config_file;
+  std::string query_json_config_file;
+  size_t segment_size = 10u*1024u*1024u;
+  int c;
+  while((c=getopt_long(argc, argv, "l:j:s:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'l':
+        loader_json_config_file = optarg;
+        break;
+      case 'j':
+        query_json_config_file = optarg;
+        break;
+      case 's':
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        MPI_Finalize();
+        return -1;
+    }
+  }
+  if(query_json_config_file.empty())
+  {
+    std::cerr << "Usage: " << argv[0] << " [-l <loader.json>] -j <query.json> [-s <segment size>]\n";
+    MPI_Finalize();
+    return -1;
+  }
+  auto returnval = 0;
+  try
+  {
+    VariantQueryConfig query_config;
+    FileBasedVidMapper id_mapper;
+    JSONLoaderConfig loader_config;
+    JSONLoaderConfig* loader_config_ptr = 0;
+    if(!loader_json_config_file.empty())
+    {
+      loader_config.read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
+      loader_config_ptr = &loader_config;
+    }
+    JSONBasicQueryConfig range_query_config;
+    range_query_config.read_from_file(query_json_config_file, query_config, &id_mapper, my_world_mpi_rank, loader_config_ptr);
+    VariantStorageManager sm(range_query_config.get_workspace(my_world_mpi_rank), segment_size);
+    VariantQueryProcessor qp(&sm, range_query_config.get_array_name(my_world_mpi_rank), id_mapper);
+    qp.do_query_bookkeeping(qp.get_array_schema(), query_config, id_mapper, true);
+    MergeAltAllelesCheckOperator check_operator;
+    for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+      qp.scan_and_operate(qp.get_array_descriptor(), query_config, check_operator, i);
+    std::cout << "Checked merge_alt_alleles at " << check_operator.m_num_sites << " sites, "
+      << check_operator.m_num_mismatched_sites << " mismatches\n";
+    if(check_operator.m_num_sites == 0ull || check_operator.m_num_mismatched_sites > 0ull)
+      returnval = -1;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    returnval = -1;
+  }
+  MPI_Finalize();
+  return returnval;
+}
@@ -0,0 +1,215 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <getopt.h>
+#include <mpi.h>
+
+#include "libtiledb_variant.h"
+#include "json_config.h"
+
+/*
+ * Runs the query through VariantQueryService from many threads at once - asynchronous requests
+ * (submit_query) and synchronous requests (query_column_range) - and checks that every result is
+ * identical to the result of the query run serially through a VariantQueryProcessor. Also checks
+ * that requests beyond the admission limit are rejected and that queries still succeed after
+ * close_idle_sessions(), including while requests are in flight
+ */
+
+static std::string variants_to_string(const std::vector<Variant>& variants, const VariantQueryConfig& query_config)
+{
+  std::stringstream stream;
+  for(const auto& variant : variants)
+    variant.print(stream, &query_config);
+  return stream.str();
+}
+
+//Synchronous request - all intervals of a private copy of query_config
+static std::string query_column_ranges(VariantQueryService& service, const std::string& workspace,
+    const std::string& array_name, const VariantQueryConfig& query_config, const VidMapper& vid_mapper)
+{
+  VariantQueryConfig curr_query_config(query_config);
+  std::vector<Variant> variants;
+  for(auto i=0u;i<curr_query_config.get_num_column_intervals();++i)
+    service.query_column_range(workspace, array_name, i, variants, curr_query_config, vid_mapper);
+  return variants_to_string(variants, curr_query_config);
+}
+
+int main(int argc, char** argv)
+{
+  //MPI is used only to obtain the rank
+  MPI_Init(&argc, &argv);
+  int my_world_mpi_rank = 0;
+  MPI_Comm_rank(MPI_COMM_WORLD, &my_world_mpi_rank);
+  static struct option long_options[] =
+  {
+    {"loader-json-config",1,0,'l'},
+    {"json-config",1,0,'j'},
+    {"segment-size",1,0,'s'},
+    {"num-requests",1,0,'n'},
+    {0,0,0,0},
+  };
+  std::string loader_json_config_file;
+  std::string query_json_config_file;
+  size_t segment_size = 10u*1024u*1024u;
+  auto num_requests = 16u;
+  int c;
+  while((c=getopt_long(argc, argv, "l:j:s:n:", long_options, NULL)) >= 0)
+  {
+    switch(c)
+    {
+      case 'l':
+        loader_json_config_file = optarg;
+        break;
+      case 'j':
+        query_json_config_file = optarg;
+        break;
+      case 's':
+        segment_size = strtoull(optarg, 0, 10);
+        break;
+      case 'n':
+        num_requests = strtoul(optarg, 0, 10);
+        break;
+      default:
+        std::cerr << "Unknown command line argument\n";
+        MPI_Finalize();
+        return -1;
+    }
+  }
+  if(query_json_config_file.empty() || num_requests == 0u)
+  {
+    std::cerr << "Usage: " << argv[0] << " [-l <loader.json>] -j <query.json> [-s <segment size>] [-n <#requests>]\n";
+    MPI_Finalize();
+    return -1;
+  }
+  auto returnval = 0;
+  try
+  {
+    VariantQueryConfig query_config;
+    FileBasedVidMapper id_mapper;
+    JSONLoaderConfig loader_config;
+    JSONLoaderConfig* loader_config_ptr = 0;
+    if(!loader_json_config_file.empty())
+    {
+      loader_config.read_from_file(loader_json_config_file, &id_mapper, my_world_mpi_rank);
+      loader_config_ptr = &loader_config;
+    }
+    JSONBasicQueryConfig range_query_config;
+    range_query_config.read_from_file(query_json_config_file, query_config, &id_mapper, my_world_mpi_rank, loader_config_ptr);
+    const auto& workspace = range_query_config.get_workspace(my_world_mpi_rank);
+    const auto& array_name = range_query_config.get_array_name(my_world_mpi_rank);
+    //Serial result
+    std::string serial_result;
+    {
+      VariantQueryConfig serial_query_config(query_config);
+      VariantStorageManager sm(workspace, segment_size);
+      VariantQueryProcessor qp(&sm, array_name, id_mapper);
+      qp.do_query_bookkeeping(qp.get_array_schema(), serial_query_config, id_mapper, true);
+      std::vector<Variant> variants;
+      for(auto i=0u;i<serial_query_config.get_num_column_intervals();++i)
+        qp.gt_get_column_interval(qp.get_array_descriptor(), serial_query_config, i, variants);
+      serial_result = variants_to_string(variants, serial_query_config);
+    }
+    auto num_mismatches = 0u;
+    //Concurrent requests - fewer sessions than requests, so sessions are shared over time
+    {
+      VariantQueryService service(2u, 2u*num_requests, 4u, segment_size);
+      std::vector<std::future<VariantQueryResult>> futures;
+      for(auto i=0u;i<num_requests;++i)
+        futures.push_back(service.submit_query(workspace, array_name, query_config, id_mapper));
+      std::vector<std::string> sync_results(num_requests);
+      std::vector<std::thread> threads;
+      for(auto i=0u;i<num_requests;++i)
+      {
+        threads.emplace_back([&, i]() {
+            sync_results[i] = query_column_ranges(service, workspace, array_name, query_config, id_mapper);
+            });
+        //Sessions in use while the pools are closed must not return to them
+        if(i == num_requests/2u)
+          service.close_idle_sessions(workspace);
+      }
+      for(auto& thread : threads)
+        thread.join();
+      for(auto& result_future : futures)
+      {
+        auto result = result_future.get();
+        if(variants_to_string(result.m_variants, *(result.m_query_config)) != serial_result)
+          ++num_mismatches;
+      }
+      for(const auto& result : sync_results)
+        if(result != serial_result)
+          ++num_mismatches;
+      //New sessions after all pools are closed
+      service.close_idle_sessions(workspace);
+      if(query_column_ranges(service, workspace, array_name, query_config, id_mapper) != serial_result)
+        ++num_mismatches;
+      if(service.get_num_pending_requests() != 0u || service.get_num_rejected_requests() != 0ull)
+      {
+        std::cerr << "Unexpected #pending/#rejected requests\n";
+        returnval = -1;
+      }
+    }
+    //Admission control - 1 running request, none queued. The first request opens the array, so
+    //requests submitted right after it are rejected
+    auto num_rejected = 0ull;
+    {
+      VariantQueryService service(1u, 0u, 1u, segment_size);
+      std::vector<std::future<VariantQueryResult>> futures;
+      for(auto i=0u;i<num_requests;++i)
+      {
+        try
+        {
+          futures.push_back(service.submit_query(workspace, array_name, query_config, id_mapper));
+        }
+        catch(const VariantQueryServiceException&)
+        {
+          ++num_rejected;
+        }
+      }
+      for(auto& result_future : futures)
+      {
+        auto result = result_future.get();
+        if(variants_to_string(result.m_variants, *(result.m_query_config)) != serial_result)
+          ++num_mismatches;
+      }
+      if(num_rejected == 0ull || num_rejected != service.get_num_rejected_requests()
+          || service.get_num_pending_requests() != 0u)
+      {
+        std::cerr << "Admission control check failed - " << num_rejected << " requests rejected\n";
+        returnval = -1;
+      }
+    }
+    std::cout << "Checked " << 2u*num_requests+1u << " concurrent requests, " << num_rejected
+      << " rejected requests, " << num_mismatches << " mismatches\n";
+    if(serial_result.empty() || num_mismatches > 0u)
+      returnval = -1;
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    returnval = -1;
+  }
+  MPI_Finalize();
+  return returnval;
+}
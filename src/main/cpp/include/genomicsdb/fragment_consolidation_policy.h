@@ -0,0 +1,79 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FRAGMENT_CONSOLIDATION_POLICY_H
+#define FRAGMENT_CONSOLIDATION_POLICY_H
+
+#include "headers.h"
+
+//Exceptions thrown
+class FragmentConsolidationPolicyException : public std::exception {
+  public:
+    FragmentConsolidationPolicyException(const std::string m="") : msg_("FragmentConsolidationPolicyException : "+m) { ; }
+    ~FragmentConsolidationPolicyException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * Every write session (load) adds a TileDB fragment to the array. #cells/#bytes of each fragment are
+ * kept in the array metadata, oldest first, so that incremental loads can decide when to consolidate
+ */
+struct VariantArrayFragmentInfo
+{
+  VariantArrayFragmentInfo(const uint64_t num_cells=0ull, const uint64_t num_bytes=0ull)
+    : m_num_cells(num_cells), m_num_bytes(num_bytes) { ; }
+  uint64_t m_num_cells;
+  uint64_t m_num_bytes;
+};
+
+/*
+ * Size tiered consolidation policy. Fragments fall into tiers by size - tier 0 holds fragments smaller
+ * than min_tier_size, tier i (i > 0) holds sizes in [min_tier_size*ratio^(i-1), min_tier_size*ratio^i).
+ * TileDB consolidation always merges all fragments into one, so the policy only decides when to
+ * consolidate:
+ *   - more than max_num_fragments fragments - bounds the #fragments a query touches
+ *   - a tier holds max_num_fragments_per_tier fragments whose total size is at least 1/ratio of the
+ *     largest fragment - the rewrite of the largest fragment is amortized over the new data
+ */
+class FragmentConsolidationPolicy
+{
+  public:
+    FragmentConsolidationPolicy(const unsigned max_num_fragments=16u, const unsigned max_num_fragments_per_tier=4u,
+        const uint64_t min_tier_size=64ull*1024ull*1024ull, const unsigned tier_size_ratio=4u);
+    unsigned get_tier(const uint64_t num_bytes) const;
+    bool needs_consolidation(const std::vector<VariantArrayFragmentInfo>& fragments) const;
+    inline unsigned get_max_num_fragments() const { return m_max_num_fragments; }
+    inline unsigned get_max_num_fragments_per_tier() const { return m_max_num_fragments_per_tier; }
+    inline uint64_t get_min_tier_size() const { return m_min_tier_size; }
+    inline unsigned get_tier_size_ratio() const { return m_tier_size_ratio; }
+  private:
+    unsigned m_max_num_fragments;
+    unsigned m_max_num_fragments_per_tier;
+    uint64_t m_min_tier_size;
+    unsigned m_tier_size_ratio;
+};
+
+#endif
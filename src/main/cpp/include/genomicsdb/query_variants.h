@@ -31,6 +31,15 @@
 #include "variant_operations.h"
 #include "variant_cell.h"
 #include "vid_mapper.h"
+#include <chrono>
+#include <memory>
+#include <mutex>
+#include <random>
+
+class JSONConfigBase;
+
+//Queried rows are fetched through at most these many TileDB subarrays
+#define MAX_NUM_ROW_RANGES_PER_QUERY_ITERATOR 16u
 
 enum GTSchemaVersionEnum
 {
@@ -63,77 +72,15 @@ class VariantQueryProcessorException : public std::exception {
     std::string msg_;
 };
 
-/* Structure to store profiling information */
-class GTProfileStats {
-  public:
-    enum GTStatIdx
-    {
-      GT_NUM_CELLS=0,   //total #cells traversed in the query, coord cells are accessed for every time
-      GT_NUM_CELLS_IN_LEFT_SWEEP,//total #cells traversed in the query left sweep, coord cells are accessed for every time
-      GT_NUM_VALID_CELLS_IN_QUERY,//#valid cells actually returned in query 
-      GT_NUM_ATTR_CELLS_ACCESSED,//#attribute cells accessed in the query
-      GT_NUM_PQ_FLUSHES_DUE_TO_OVERLAPPING_CELLS,//#times PQ gets flushed due to overlapping cells in the input
-      GT_NUM_OPERATOR_INVOCATIONS, //#times operator gets invoked
-      GT_NUM_STATS
-    };
-    GTProfileStats();
-    inline void update_stat(unsigned stat_idx, uint64_t value)
-    {
-      assert(stat_idx < m_stats_sum_vector.size());
-      m_stats_sum_vector[stat_idx] += value;
-      double v = value;
-      m_stats_sum_sq_vector[stat_idx] += (v*v);
-    }
-    inline void update_stat_from_tmp_counter(unsigned stat_idx)
-    {
-      assert(stat_idx < m_stats_tmp_count_vector.size());
-      update_stat(stat_idx, m_stats_tmp_count_vector[stat_idx]);
-      m_stats_tmp_count_vector[stat_idx] = 0;
-    }
-    inline void update_all_from_tmp_counters()
-    {
-      for(auto stat_idx=0u;stat_idx<GT_NUM_STATS;++stat_idx)
-      {
-        assert(stat_idx < m_stats_tmp_count_vector.size());
-        update_stat(stat_idx, m_stats_tmp_count_vector[stat_idx]);
-        m_stats_tmp_count_vector[stat_idx] = 0;
-      }
-    }
-    inline void increment_tmp_counter(unsigned stat_idx, uint64_t value=1u)
-    {
-      assert(stat_idx < m_stats_tmp_count_vector.size());
-      m_stats_tmp_count_vector[stat_idx] += value;
-    }
-    inline void reset_tmp_counter(unsigned stat_idx)
-    {
-      assert(stat_idx < m_stats_tmp_count_vector.size());
-      m_stats_tmp_count_vector[stat_idx] = 0;
-    }
-    void print_stats(std::ostream& fptr=std::cout) const;
-    void increment_num_queries() { ++m_num_queries; }
-  public:
-    Timer m_interval_sweep_timer;
-    Timer m_operator_timer;
-    Timer m_genomicsdb_cell_fill_timer;
-  private:
-    std::vector<uint64_t> m_stats_sum_vector;
-    std::vector<uint64_t> m_stats_tmp_count_vector;
-    std::vector<double> m_stats_sum_sq_vector;
-    std::vector<std::string> m_stats_name_vector;
-    uint64_t m_num_queries;
-};
-
 class VariantQueryProcessorScanState
 {
   friend class VariantQueryProcessor;
   public:
     VariantQueryProcessorScanState()
-      : m_stats()
     {
       reset();
     }
     VariantQueryProcessorScanState(VariantArrayCellIterator* iter, int64_t current_start_position)
-      : m_stats()
     {
       reset();
       m_iter = iter;
@@ -157,6 +104,17 @@ class VariantQueryProcessorScanState
       m_iter = 0;
       m_current_start_position = -1ll;
     }
+    /*
+     * Drops the state of a partially completed scan (iterator, pending calls) so that
+     * the object can be re-used for a different query
+     */
+    void discard()
+    {
+      if(m_iter)
+        delete m_iter;
+      m_end_pq = VariantCallEndPQ();
+      reset();
+    }
     /*
      * Set state
      */
@@ -178,7 +136,123 @@ class VariantQueryProcessorScanState
     uint64_t m_num_calls_with_deletions;
     VariantCallEndPQ m_end_pq;
     Variant m_variant;
-    GTProfileStats m_stats;
+};
+
+/*
+ * Live state of a paged GA4GH query - the forward iterator positioned at the first cell of the next
+ * page. Resuming from a cursor avoids repeating the left sweep and re-scanning the cells of earlier pages.
+ * Owners of the storage manager used by the iterator may sub-class this to keep it alive - such
+ * sub-classes must call discard() in their destructor
+ */
+class GA4GHPagingCursor
+{
+  friend class VariantQueryProcessor;
+  public:
+    GA4GHPagingCursor()
+    {
+      m_iter = 0;
+      discard();
+    }
+    virtual ~GA4GHPagingCursor()
+    {
+      discard();
+    }
+    //Delete copy and move constructors
+    GA4GHPagingCursor(const GA4GHPagingCursor& other) = delete;
+    GA4GHPagingCursor(GA4GHPagingCursor&& other) = delete;
+    void discard()
+    {
+      if(m_iter)
+        delete m_iter;
+      m_iter = 0;
+      m_column_interval_idx = UINT_MAX;
+      m_column_begin = m_column_end = -1ll;
+      m_last_column = 0ull;
+      m_num_handled_variants_in_last_column = 0u;
+      m_overflow_variants.clear();
+      m_query_all_rows = false;
+      m_rows.clear();
+      m_attributes.clear();
+    }
+    inline bool is_valid() const { return m_iter != 0; }
+    //Iterator buffers and saved query state - the storage manager/TileDB context of owners is not included
+    size_t get_size_in_bytes() const;
+  private:
+    //Cursor must belong to the same query (interval, rows and attributes) and to the page end described by paging_info
+    bool can_resume(const VariantQueryConfig& query_config, const unsigned column_interval_idx,
+        const GA4GHPagingInfo& paging_info) const;
+  private:
+    VariantArrayCellIterator* m_iter;
+    unsigned m_column_interval_idx;
+    int64_t m_column_begin;
+    int64_t m_column_end;
+    uint64_t m_last_column;
+    unsigned m_num_handled_variants_in_last_column;
+    //Variants beginning at m_last_column that did not fit in the previous page
+    std::vector<Variant> m_overflow_variants;
+    //Rows and attributes of the query the iterator was created for
+    bool m_query_all_rows;
+    std::vector<int64_t> m_rows;
+    std::vector<std::string> m_attributes;
+};
+
+//Cursors not used for this long are dropped - later pages fall back to re-scanning
+#define DEFAULT_GA4GH_PAGING_CURSOR_TTL_SECONDS 300u
+//Every cursor may keep an array open (storage manager, TileDB context) along with its iterator buffers
+#define DEFAULT_MAX_NUM_GA4GH_PAGING_CURSORS 64u
+#define DEFAULT_MAX_GA4GH_PAGING_CURSORS_SIZE (1024ull*1024ull*1024ull)
+
+/*
+ * Process wide table of live cursors keyed by the (opaque) cursor id embedded in GA4GH page tokens.
+ * A cursor is removed from the table while a page is being fetched with it, so it is never used by
+ * two requests at once. The least recently used cursors are dropped once the table holds more than
+ * max_num_cursors cursors (open arrays) or more than max_size bytes of cursor state.
+ * Settings can be changed through the "ga4gh_paging_cursors" entry of the query JSON
+ */
+class GA4GHPagingCursorTable
+{
+  public:
+    static GA4GHPagingCursorTable& get_instance();
+    //Delete copy and move constructors
+    GA4GHPagingCursorTable(const GA4GHPagingCursorTable& other) = delete;
+    GA4GHPagingCursorTable(GA4GHPagingCursorTable&& other) = delete;
+    /*
+     * Returns the id of the stored cursor - non-zero
+     */
+    uint64_t insert(std::shared_ptr<GA4GHPagingCursor> cursor);
+    /*
+     * Removes and returns the cursor, null if the cursor has expired or was never stored
+     */
+    std::shared_ptr<GA4GHPagingCursor> acquire(const uint64_t cursor_id);
+    void set_ttl(const unsigned seconds);
+    void set_max_num_cursors(const size_t max_num_cursors);
+    void set_max_size_in_bytes(const size_t max_size_in_bytes);
+    size_t size() const;
+    size_t get_size_in_bytes() const;
+    void clear();
+  private:
+    GA4GHPagingCursorTable();
+    //Caller must hold the lock
+    void evict_expired(const std::chrono::steady_clock::time_point now);
+    //Drops least recently used cursors until num_cursors more cursors of size_in_bytes fit
+    void evict_until_fits(const size_t num_cursors, const size_t size_in_bytes);
+  private:
+    struct Entry
+    {
+      std::shared_ptr<GA4GHPagingCursor> m_cursor;
+      std::chrono::steady_clock::time_point m_last_access_time;
+      size_t m_size_in_bytes;
+    };
+    typedef std::unordered_map<uint64_t, Entry> CursorMap;
+    void erase(CursorMap::iterator iter);
+    mutable std::mutex m_mutex;
+    std::chrono::seconds m_ttl;
+    size_t m_max_num_cursors;
+    size_t m_max_size_in_bytes;
+    size_t m_size_in_bytes;
+    //Ids are random so that tokens cannot be guessed
+    std::mt19937_64 m_cursor_id_generator;
+    CursorMap m_cursors;
 };
 
 /*
@@ -209,6 +283,17 @@ class VariantQueryProcessor {
         delete m_vid_mapper;
       m_vid_mapper = 0;
     }
+    /*
+     * JSON configs are only parsed - the process wide tile cache, GA4GH paging cursor table and
+     * runtime profiler are configured here. The profiler falls back to GENOMICSDB_PROFILE
+     */
+    static void apply_process_wide_settings(const JSONConfigBase& json_config, const int rank);
+    /*
+     * "query_column_ranges" : "auto" - splits the column domain into balanced ranges using the column
+     * histograms of the queried arrays and adds the range of this rank to query_config. No-op otherwise
+     */
+    static void initialize_auto_query_column_ranges(JSONConfigBase& json_config, VariantQueryConfig& query_config,
+        const VidMapper& vid_mapper, const int rank);
     void clear();
     /**
      * When querying, setup bookkeeping structures first 
@@ -217,11 +302,14 @@ class VariantQueryProcessor {
         VariantQueryConfig& query_config, const VidMapper& vid_mapper, const bool require_alleles) const;
     /*
      * Equivalent of gt_get_column, but for interval
+     * With paging, a valid cursor matching the page token in paging_info is resumed from. If the page ends
+     * in the middle of the interval, the scan state is stored in cursor (if not null) for the next page
      */
     void gt_get_column_interval(
         const int ad,
         const VariantQueryConfig& query_config, unsigned column_interval_idx,
-        std::vector<Variant>& variants, GA4GHPagingInfo* paging_info=0, GTProfileStats* stats=0) const;
+        std::vector<Variant>& variants, GA4GHPagingInfo* paging_info=0,
+        GA4GHPagingCursor* cursor=0) const;
     /*
      * Scans column interval, aligns intervals and runs operate
      */
@@ -236,25 +324,26 @@ class VariantQueryProcessor {
         const BufferVariantCell& cell,
         VariantCallEndPQ& end_pq, std::vector<VariantCall*>& tmp_pq_buffer,
         int64_t& current_start_position, int64_t& next_start_position,
-        uint64_t& num_calls_with_deletions, bool handle_spanning_deletions,
-        GTProfileStats* stats_ptr) const;
+        uint64_t& num_calls_with_deletions, bool handle_spanning_deletions) const;
     /** Called by scan_and_operate to handle all ranges for given set of cells */
     void handle_gvcf_ranges(VariantCallEndPQ& end_pq, 
         const VariantQueryConfig& queryConfig, Variant& variant,
         SingleVariantOperatorBase& variant_operator,
-        int64_t& current_start_position, int64_t next_start_position, bool is_last_call, uint64_t& num_calls_with_deletions,
-        GTProfileStats* stats_ptr) const;
+        int64_t& current_start_position, int64_t next_start_position, bool is_last_call, uint64_t& num_calls_with_deletions) const;
     //while scan breaks up the intervals, iterate does not
+    //With scan_state, iteration stops once the operator overflows and resumes from the next cell
+    //in the following call
     void iterate_over_cells(
         const int ad,
         const VariantQueryConfig& query_config, 
-        SingleCellOperatorBase& variant_operator, unsigned column_interval_idx) const;
+        SingleCellOperatorBase& variant_operator, unsigned column_interval_idx,
+        VariantQueryProcessorScanState* scan_state=0) const;
     /** Fills genotyping info for column col from the input array. */
     //Row ordering vector stores the query row idx in the order in which rows were filled by gt_get_column function
     //This is the reverse of the cell position order (as reverse iterators are used in gt_get_column)
     void gt_get_column(
         const int ad, const VariantQueryConfig& query_config, unsigned column_interval_idx,
-        Variant& variant, GTProfileStats* stats=0, std::vector<uint64_t>* query_row_idx_in_order=0) const;
+        Variant& variant, std::vector<uint64_t>* query_row_idx_in_order=0) const;
     /*
      * Create Variant from a buffer produced by the binary_serialize() functions
      * This is a member of VariantQueryProcessor because the Factory methods are already setup for 
@@ -262,6 +351,11 @@ class VariantQueryProcessor {
      */
     void binary_deserialize(Variant& variant, const VariantQueryConfig& query_config,
         const std::vector<uint8_t>& buffer, uint64_t& offset) const;
+    /*
+     * Create field query_idx from the data produced by VariantFieldBase::binary_serialize() at offset
+     */
+    void binary_deserialize_field(std::unique_ptr<VariantFieldBase>& field_ptr, const VariantQueryConfig& query_config,
+        const unsigned query_idx, const char* buffer, uint64_t& offset) const;
     /*
      * Function that, given an enum value from KnownVariantFieldsEnum
      * returns the schema idx for the given array 
@@ -309,19 +403,21 @@ class VariantQueryProcessor {
      */
     void gt_fill_row(
         Variant& variant, int64_t row, int64_t column, const VariantQueryConfig& query_config,
-        const BufferVariantCell& cell, GTProfileStats* stats
+        const BufferVariantCell& cell
 #ifdef DUPLICATE_CELL_AT_END
         , bool traverse_end_copies=false
 #endif
         ) const;
     /** 
-     * Initializes forward iterators for joint genotyping for column col. 
+     * Initializes forward iterators for joint genotyping for columns [column, end_column].
+     * Only the queried rows are fetched. end_column must be INT64_MAX if END copies of cells
+     * beyond the query interval are needed
      * Returns the number of attributes used in joint genotyping.
      */
     unsigned int gt_initialize_forward_iter(
         const int ad,
         const VariantQueryConfig& query_config, const int64_t column,
-        VariantArrayCellIterator*& forward_iter) const;
+        VariantArrayCellIterator*& forward_iter, const int64_t end_column=INT64_MAX) const;
     /*
      * Fill data from tile for attribute query_idx into curr_call
      * @param curr_call  VariantCall object in which data will be stored
@@ -607,6 +607,7 @@ class GA4GHPagingInfo
       m_num_handled_variants_in_last_column = 0u;
       m_num_variants_to_shift_left = 0u;
       m_num_variants_in_curr_page = 0u;
+      m_cursor_id = 0ull;
     }
     //Call at the start of new page
     void init_page_query();
@@ -651,6 +652,16 @@ class GA4GHPagingInfo
     }
     inline uint64_t get_last_column() const { return m_last_column_idx; }
     inline unsigned get_num_handled_variants_in_last_column()  const { return m_num_handled_variants_in_last_column; }
+    /*
+     * Server side cursor holding the scan state at the end of the last page, 0 if none
+     */
+    inline uint64_t get_cursor_id() const { return m_cursor_id; }
+    inline void set_cursor_id(const uint64_t cursor_id) { m_cursor_id = cursor_id; }
+    /*
+     * Page continues from a cursor - variants of the last column were completed in the previous page,
+     * so none are re-created and shifted out
+     */
+    inline void set_resumed_from_cursor() { m_num_handled_variants_in_last_column = 0u; }
     /*
      * End of query, no more pages
      */
@@ -673,6 +684,7 @@ class GA4GHPagingInfo
     unsigned m_num_handled_variants_in_last_column;     //#variants starting at the last column that were returned in the last page
     unsigned m_num_variants_to_shift_left;      //helps determine how many elements need to be removed from the head of the vector before returning
     unsigned m_num_variants_in_curr_page;
+    uint64_t m_cursor_id;
     //GA4GH string tokens
     std::string m_last_page_end_token;
 };
@@ -769,9 +781,13 @@ const VariantFieldTy* get_known_field(const VariantCall& curr_call, const Varian
 
 /*
  * Move call to variants vector - create new Variant if necessary
+ * If stop_inserting_new_variants is set, calls that do not belong to a Variant in variants are dropped - unless
+ * overflow_variants is specified, in which case such Variants are created in overflow_variants. overflow_variants
+ * must be used for all calls after stop_inserting_new_variants is set (variants.size() must not change)
  */
 bool move_call_to_variant_vector(const VariantQueryConfig& query_config, VariantCall& to_move_call,
-    std::vector<Variant>& variants, GA4GHCallInfoToVariantIdx& call_info_2_variant, bool stop_inserting_new_variants);
+    std::vector<Variant>& variants, GA4GHCallInfoToVariantIdx& call_info_2_variant, bool stop_inserting_new_variants,
+    std::vector<Variant>* overflow_variants=0);
 
 enum VariantOutputFormatEnum
 {
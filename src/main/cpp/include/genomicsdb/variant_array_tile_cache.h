@@ -0,0 +1,216 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VARIANT_ARRAY_TILE_CACHE_H
+#define VARIANT_ARRAY_TILE_CACHE_H
+
+#include "headers.h"
+#include <list>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+
+//Attribute idx used for the co-ordinates in cache keys
+#define TILE_CACHE_COORDS_ATTRIBUTE_IDX -1
+//Width of a cached tile in columns
+#define DEFAULT_TILE_CACHE_TILE_WIDTH 4096ll
+//Queries over less than 1/TILE_CACHE_MAX_ROW_AMPLIFICATION of the rows of an array bypass the cache
+#define TILE_CACHE_MAX_ROW_AMPLIFICATION 4ll
+
+/*
+ * Decoded (decompressed) data of a single attribute for all the cells of one column tile - the
+ * column interval [tile_idx*tile_width, (tile_idx+1)*tile_width-1] over all rows of the array.
+ * Cells are in column major order, identical for all attributes of the tile
+ * Tiles span all rows so that queries over different samples share them - a query over a few rows
+ * of a wide array reads and decodes the cells of all rows in the tile, unlike the uncached iterator
+ * which pushes the queried row ranges down to TileDB. The cache pays off for repeated/overlapping
+ * queries over most rows, not for one-off queries over small row ranges - such queries and tiles
+ * larger than the iterator memory budget bypass the cache (see VariantArrayCellIterator)
+ */
+class VariantArrayTile
+{
+  public:
+    VariantArrayTile(const bool is_variable_length=false)
+    {
+      m_is_variable_length = is_variable_length;
+      m_num_cells = 0ull;
+      m_next_column = INT64_MAX;
+      if(is_variable_length)
+        m_offsets.push_back(0ull);
+    }
+    inline void append(const void* ptr, const size_t size)
+    {
+      auto offset = m_data.size();
+      m_data.resize(offset+size);
+      if(size > 0u)
+        memcpy(m_data.data()+offset, ptr, size);
+      if(m_is_variable_length)
+        m_offsets.push_back(m_data.size());
+      ++m_num_cells;
+    }
+    inline uint64_t get_num_cells() const { return m_num_cells; }
+    //Fixed length fields - every cell has the same size
+    inline const uint8_t* get_cell_ptr(const uint64_t cell_idx, size_t& size) const
+    {
+      assert(cell_idx < m_num_cells);
+      if(m_is_variable_length)
+      {
+        size = m_offsets[cell_idx+1u]-m_offsets[cell_idx];
+        return m_data.data()+m_offsets[cell_idx];
+      }
+      size = m_data.size()/m_num_cells;
+      return m_data.data()+cell_idx*size;
+    }
+    inline size_t get_size_in_bytes() const
+    {
+      return sizeof(VariantArrayTile) + m_data.capacity() + m_offsets.capacity()*sizeof(size_t);
+    }
+    void shrink_to_fit()
+    {
+      m_data.shrink_to_fit();
+      m_offsets.shrink_to_fit();
+    }
+    /*
+     * Only set for co-ordinate tiles - first column after the tile with at least one cell,
+     * INT64_MAX if no such column exists. Lets iterators skip empty tiles
+     */
+    inline int64_t get_next_column() const { return m_next_column; }
+    inline void set_next_column(const int64_t column) { m_next_column = column; }
+  private:
+    bool m_is_variable_length;
+    uint64_t m_num_cells;
+    int64_t m_next_column;
+    std::vector<uint8_t> m_data;
+    //#cells+1 entries for variable length fields
+    std::vector<size_t> m_offsets;
+};
+
+/*
+ * Process wide LRU cache of decoded tiles keyed by (array path, fragment set id, tile width, attribute,
+ * tile idx) - shared by all iterators, so that overlapping queries (multiple column intervals, GA4GH
+ * pages, JNI sessions) do not re-read and re-decompress the same data. Disabled (capacity 0) by default.
+ * The fragment set id identifies the fragments of the array when an iterator is created - writes and
+ * consolidations by other processes change it, so tiles of an older version are never served.
+ * Tiles are handed out as shared pointers - evicting a tile does not invalidate iterators using it
+ */
+class VariantArrayTileCache
+{
+  public:
+    typedef std::shared_ptr<const VariantArrayTile> TilePtr;
+    static VariantArrayTileCache& get_instance();
+    //Delete copy and move constructors
+    VariantArrayTileCache(const VariantArrayTileCache& other) = delete;
+    VariantArrayTileCache(VariantArrayTileCache&& other) = delete;
+    /*
+     * Byte budget - 0 disables the cache and drops all cached tiles
+     */
+    void set_capacity(const size_t capacity);
+    inline size_t get_capacity() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_capacity;
+    }
+    inline bool is_enabled() const { return get_capacity() > 0u; }
+    /*
+     * Tile width in columns used by iterators created after the call - iterators keep the width they
+     * were created with, tiles of different widths are cached under different keys
+     */
+    void set_tile_width(const int64_t tile_width);
+    inline int64_t get_tile_width() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_tile_width;
+    }
+    /*
+     * Records the current fragment set of the array - tiles of all other fragment sets are dropped
+     * since they can never be served again
+     */
+    void set_fragment_set_id(const std::string& array_path, const uint64_t fragment_set_id);
+    /*
+     * Returns null on a miss
+     */
+    TilePtr get(const std::string& array_path, const uint64_t fragment_set_id, const int64_t tile_width,
+        const int attribute_idx, const int64_t tile_idx);
+    /*
+     * Tiles larger than the capacity are not cached
+     */
+    void put(const std::string& array_path, const uint64_t fragment_set_id, const int64_t tile_width,
+        const int attribute_idx, const int64_t tile_idx, TilePtr tile);
+    /*
+     * Drops all tiles of the array - must be called when the array is modified
+     */
+    void invalidate(const std::string& array_path);
+    void clear();
+    uint64_t get_num_hits() const;
+    uint64_t get_num_misses() const;
+    uint64_t get_num_evictions() const;
+    size_t get_size_in_bytes() const;
+    void reset_counters();
+  private:
+    VariantArrayTileCache();
+    struct Key
+    {
+      std::string m_array_path;
+      uint64_t m_fragment_set_id;
+      int64_t m_tile_width;
+      int m_attribute_idx;
+      int64_t m_tile_idx;
+      bool operator==(const Key& other) const
+      {
+        return m_tile_idx == other.m_tile_idx && m_attribute_idx == other.m_attribute_idx
+          && m_tile_width == other.m_tile_width && m_fragment_set_id == other.m_fragment_set_id
+          && m_array_path == other.m_array_path;
+      }
+    };
+    struct KeyHash
+    {
+      size_t operator()(const Key& key) const
+      {
+        auto hash_val = std::hash<std::string>()(key.m_array_path);
+        hash_val ^= std::hash<int64_t>()(key.m_tile_idx) + 0x9e3779b9 + (hash_val << 6) + (hash_val >> 2);
+        hash_val ^= std::hash<int>()(key.m_attribute_idx) + 0x9e3779b9 + (hash_val << 6) + (hash_val >> 2);
+        hash_val ^= std::hash<uint64_t>()(key.m_fragment_set_id) + 0x9e3779b9 + (hash_val << 6) + (hash_val >> 2);
+        hash_val ^= std::hash<int64_t>()(key.m_tile_width) + 0x9e3779b9 + (hash_val << 6) + (hash_val >> 2);
+        return hash_val;
+      }
+    };
+    typedef std::list<std::pair<Key, TilePtr>> LRUList;
+    //Caller must hold the lock
+    void evict_until_size(const size_t size);
+    void erase(LRUList::iterator iter);
+    void invalidate_unlocked(const std::string& array_path);
+  private:
+    mutable std::mutex m_mutex;
+    size_t m_capacity;
+    size_t m_size_in_bytes;
+    int64_t m_tile_width;
+    //Most recently used at the front
+    LRUList m_lru_list;
+    std::unordered_map<Key, LRUList::iterator, KeyHash> m_key_to_lru_iter;
+    //Latest fragment set seen for each array
+    std::unordered_map<std::string, uint64_t> m_array_path_to_fragment_set_id;
+    uint64_t m_num_hits;
+    uint64_t m_num_misses;
+    uint64_t m_num_evictions;
+};
+
+#endif
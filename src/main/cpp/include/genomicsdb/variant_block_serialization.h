@@ -0,0 +1,147 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VARIANT_BLOCK_SERIALIZATION_H
+#define VARIANT_BLOCK_SERIALIZATION_H
+
+#include "query_variants.h"
+#include <zlib.h>
+
+//Exceptions thrown
+class VariantBlockSerializationException : public std::exception {
+  public:
+    VariantBlockSerializationException(const std::string m="") : msg_("VariantBlockSerializationException : "+m) { ; }
+    ~VariantBlockSerializationException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+//"GDBV" - first 4 bytes of every block
+#define VARIANT_BLOCK_MAGIC 0x56424447u
+#define VARIANT_BLOCK_FORMAT_VERSION 2u
+//magic[uint32], version[uint8], compression[uint8], reserved[uint16], #variants, stored payload size, payload size[uint64]
+#define VARIANT_BLOCK_HEADER_SIZE 32u
+//Default #variants per block for callers that split their output into multiple blocks
+#define DEFAULT_NUM_VARIANTS_PER_BLOCK 1024u
+
+enum VariantBlockCompressionEnum
+{
+  VARIANT_BLOCK_COMPRESSION_NONE=0u,
+  VARIANT_BLOCK_COMPRESSION_ZLIB,
+  VARIANT_BLOCK_NUM_COMPRESSION_TYPES
+};
+
+/*
+ * Compact, versioned alternative to Variant::binary_serialize(). A block holds a batch of variants
+ * with the data laid out column wise in separate streams:
+ *   - variant headers - delta coded column begin, length, #calls, #common fields as varints
+ *   - call headers - row idx delta coded within the variant, column interval relative to the variant
+ *   - call flags - bitmap, 4 bits per call (valid, initialized, contains deletion, reference block)
+ *   - for every call field - validity bitmap over all calls and the data of valid fields
+ *   - common fields - validity bitmap, query idxs and data
+ * The data of every valid field is preceded by its size (varint), so truncated streams are detected
+ * before a field is decoded
+ * Grouping each field across calls puts similar values next to each other, so the optional zlib
+ * compression of the payload is far more effective than on the row wise format
+ */
+class VariantBlockSerializer
+{
+  public:
+    VariantBlockSerializer(const VariantBlockCompressionEnum compression=VARIANT_BLOCK_COMPRESSION_NONE,
+        const int compression_level=Z_DEFAULT_COMPRESSION);
+    /*
+     * Appends a block holding num_variants variants to buffer at offset - buffer is resized if needed
+     * Returns the size of the block in bytes
+     */
+    uint64_t serialize(const Variant* variants, const uint64_t num_variants,
+        std::vector<uint8_t>& buffer, uint64_t& offset);
+    uint64_t serialize(const std::vector<Variant>& variants, std::vector<uint8_t>& buffer, uint64_t& offset)
+    { return serialize(variants.data(), variants.size(), buffer, offset); }
+  private:
+    void append_bit(const unsigned stream_idx, const bool value);
+    //Size followed by the serialized field
+    void append_field(const unsigned stream_idx, const VariantFieldBase& field);
+  private:
+    VariantBlockCompressionEnum m_compression;
+    int m_compression_level;
+    //Re-used across calls to avoid re-allocations
+    std::vector<std::vector<uint8_t>> m_streams;
+    std::vector<uint64_t> m_stream_lengths;
+    std::vector<uint64_t> m_stream_num_bits;
+    std::vector<uint8_t> m_field_buffer;
+    std::vector<uint8_t> m_payload;
+};
+
+/*
+ * Streaming deserializer - variants are decoded one at a time, so a consumer can process a block
+ * without materializing all its variants
+ */
+class VariantBlockDeserializer
+{
+  public:
+    VariantBlockDeserializer(const VariantQueryProcessor& query_processor, const VariantQueryConfig& query_config);
+    /*
+     * Whether the bytes at offset begin a block
+     */
+    static bool is_block(const uint8_t* buffer, const uint64_t size, const uint64_t offset);
+    /*
+     * Parses the block at offset and moves offset past the block. Returns #variants in the block
+     * The data of uncompressed blocks is not copied - buffer must remain valid until all the
+     * variants of the block are read
+     */
+    uint64_t begin_block(const uint8_t* buffer, const uint64_t size, uint64_t& offset);
+    uint64_t begin_block(const std::vector<uint8_t>& buffer, uint64_t& offset)
+    { return begin_block(buffer.data(), buffer.size(), offset); }
+    /*
+     * Decodes the next variant of the current block into variant (which may be re-used across calls)
+     * Returns false once the block is exhausted
+     */
+    bool next(Variant& variant);
+    inline uint64_t get_num_remaining_variants() const { return m_num_remaining_variants; }
+  private:
+    struct StreamCursor
+    {
+      const uint8_t* m_ptr;
+      uint64_t m_size;
+      uint64_t m_offset;
+      uint64_t m_num_bits_read;
+    };
+    uint64_t read_varint(StreamCursor& cursor) const;
+    int64_t read_zigzag(StreamCursor& cursor) const;
+    bool read_bit(StreamCursor& cursor) const;
+    void read_field(std::unique_ptr<VariantFieldBase>& field_ptr, const unsigned query_idx,
+        StreamCursor& validity_cursor, StreamCursor& data_cursor) const;
+  private:
+    const VariantQueryProcessor* m_query_processor;
+    const VariantQueryConfig* m_query_config;
+    uint64_t m_num_remaining_variants;
+    unsigned m_num_call_fields;
+    int64_t m_last_column_begin;
+    std::vector<StreamCursor> m_cursors;
+    //Decompressed payload
+    std::vector<uint8_t> m_payload;
+};
+
+#endif
@@ -27,6 +27,14 @@
 #include "lut.h"
 #include "known_field_info.h"
 #include "vid_mapper.h"
+#include "variant_query_filter.h"
+
+/*
+ * If fewer than 1 in SPARSE_ROW_MAP_RATIO rows of the array are queried, the array row -> query row
+ * mapping is a binary search over the sorted queried rows instead of a vector sized to the array
+ * Default value, see VariantQueryConfig::set_sparse_row_map_ratio()
+ */
+#define SPARSE_ROW_MAP_RATIO 64ull
 
 //Out of bounds query exception
 class OutOfBoundsQueryException : public std::exception {
@@ -79,7 +87,10 @@ class VariantQueryConfig
       m_query_all_rows = true;
       m_num_rows_in_array = UNDEFINED_NUM_ROWS_VALUE;
       m_smallest_row_idx = 0;
+      m_use_sparse_row_map = false;
+      m_sparse_row_map_ratio = SPARSE_ROW_MAP_RATIO;
       m_first_normal_field_query_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+      m_variant_sites_only = false;
     }
     void clear()
     {
@@ -93,6 +104,15 @@ class VariantQueryConfig
      * Function that specifies which attributes to query from each cell
      */
     void set_attributes_to_query(const std::vector<std::string>& attributeNames);
+    /**
+     * Removes all attributes - must be called before bookkeeping is done
+     */
+    void clear_attributes_to_query()
+    {
+      assert(!m_done_bookkeeping);
+      m_query_attributes_info_vec.clear();
+      m_query_attribute_name_to_query_idx.clear();
+    }
     /**
      * Function used by query processor to add extra attributes to query
      */
@@ -257,6 +277,23 @@ class VariantQueryConfig
      */
     inline bool query_all_rows() const { return m_query_all_rows; }
     inline const std::vector<int64_t>& get_rows_to_query() const { return m_query_rows; }
+    /*
+     * True if the queried subset is small enough that no dense array row -> query row map is kept
+     */
+    inline bool uses_sparse_row_map() const { return !m_query_all_rows && m_use_sparse_row_map; }
+    /*
+     * The sparse map is used if fewer than 1 in ratio rows of the array are queried, 0 always uses
+     * the dense map. Takes effect the next time the map is built
+     */
+    void set_sparse_row_map_ratio(const uint64_t ratio) { m_sparse_row_map_ratio = ratio; }
+    inline uint64_t get_sparse_row_map_ratio() const { return m_sparse_row_map_ratio; }
+    /*
+     * Row ranges covering all queried rows - at most max_num_ranges ranges. Runs of consecutive rows
+     * form one range and the smallest gaps between runs are closed until the limit is met, so some
+     * unqueried rows may lie inside the ranges
+     * Pre-requisite: query bookkeeping should be done before calling this function
+     */
+    void get_query_row_ranges(std::vector<RowRange>& row_ranges, const unsigned max_num_ranges) const;
     /**
      * If all rows are queried, return m_num_rows_in_array (set by QueryProcessor)
      * Else return size of m_query_rows vector
@@ -290,6 +327,13 @@ class VariantQueryConfig
       assert(row_idx >= m_smallest_row_idx && (row_idx-m_smallest_row_idx) < static_cast<int64_t>(get_num_rows_in_array()));
       if(m_query_all_rows)
         return row_idx - m_smallest_row_idx;
+      if(m_use_sparse_row_map)
+      {
+        //Last entry <= row_idx - duplicate rows map to the last copy as in the dense map
+        auto iter = std::upper_bound(m_query_rows.begin(), m_query_rows.end(), row_idx);
+        return (iter != m_query_rows.begin() && *(iter-1) == row_idx)
+          ? static_cast<uint64_t>(iter-m_query_rows.begin()-1) : UNDEFINED_NUM_ROWS_VALUE;
+      }
       assert((row_idx-m_smallest_row_idx) < static_cast<int64_t>(m_array_row_idx_to_query_row_idx.size()));
       return m_array_row_idx_to_query_row_idx[row_idx-m_smallest_row_idx];
     }
@@ -311,6 +355,10 @@ class VariantQueryConfig
      * Function that sets the interval as the only interval to be queried
      */
     void set_column_interval_to_query(const int64_t colBegin, const int64_t colEnd);
+    /*
+     * Removes all column intervals - with no intervals, the whole array is scanned
+     */
+    void clear_column_intervals_to_query() { m_query_column_intervals.clear(); }
     /**
      * Returns number of ranges queried
      */
@@ -325,12 +373,42 @@ class VariantQueryConfig
     }
     inline uint64_t get_column_begin(unsigned idx) const { return get_column_interval(idx).first; }
     inline uint64_t get_column_end(unsigned idx) const { return get_column_interval(idx).second; }
+    /*
+     * Scans (scan_and_operate) only invoke operators on columns where at least one queried row has
+     * a call with a real ALT allele. Reference blocks overlapping such columns are still part of the
+     * Variant, so hom-ref samples are reported at the emitted sites
+     */
+    void set_variant_sites_only(const bool value) { m_variant_sites_only = value; }
+    inline bool variant_sites_only() const { return m_variant_sites_only; }
+    /*
+     * Filters are ANDed - cells that fail any filter are treated as absent by queries and scans
+     * Fields used in filters are added to the queried attributes during bookkeeping - like END, they
+     * are part of the query output even if the caller did not ask for them
+     */
+    void add_filter(const std::string& expression) { m_filters.emplace_back(expression); }
+    void clear_filters() { m_filters.clear(); }
+    inline bool has_filters() const { return !m_filters.empty(); }
+    std::vector<VariantQueryFilter>& get_filters() { return m_filters; }
+    const std::vector<VariantQueryFilter>& get_filters() const { return m_filters; }
+    inline bool passes_filters(const BufferVariantCell& cell) const
+    {
+      for(const auto& filter : m_filters)
+        if(!filter.evaluate(cell))
+          return false;
+      return true;
+    }
   private:
     /*
      * Function to invalid TileDB array row idx -> query row idx mapping
      * @param all_rows if true, invalidates all mappings, else invalidates mapping for rows in m_query_rows only
      */
     void invalidate_array_row_idx_to_query_row_idx_map(bool all_rows);
+    /*
+     * Drops out of bounds rows from m_query_rows, picks the sparse or dense mapping based on
+     * the fraction of queried rows and fills the dense map if needed. The dense map, if
+     * allocated with the right size, must contain only invalid entries
+     */
+    void fill_array_row_idx_to_query_row_idx_map();
     std::vector<VariantQueryFieldInfo> m_query_attributes_info_vec;
     //Map from query name to index in m_query_attributes_info_vec
     std::unordered_map<std::string, unsigned> m_query_attribute_name_to_query_idx;
@@ -346,11 +424,16 @@ class VariantQueryConfig
     std::vector<int64_t> m_query_rows;
     /*vector mapping array row_idx to query row idx*/
     std::vector<uint64_t> m_array_row_idx_to_query_row_idx;
+    /*m_array_row_idx_to_query_row_idx is unused, lookups search m_query_rows*/
+    bool m_use_sparse_row_map;
+    uint64_t m_sparse_row_map_ratio;
     /*Set by query processor*/
     uint64_t m_num_rows_in_array;
     int64_t m_smallest_row_idx;
     /*Column ranges to query*/
     std::vector<ColumnRange> m_query_column_intervals;
+    bool m_variant_sites_only;
+    std::vector<VariantQueryFilter> m_filters;
 };
 
 #endif
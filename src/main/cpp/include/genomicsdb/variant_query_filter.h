@@ -0,0 +1,114 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef VARIANT_QUERY_FILTER_H
+#define VARIANT_QUERY_FILTER_H
+
+#include "headers.h"
+#include "vid_mapper.h"
+#include <typeindex>
+
+class BufferVariantCell;
+
+//Exceptions thrown
+class VariantQueryFilterException : public std::exception {
+  public:
+    VariantQueryFilterException(const std::string m="") : msg_("VariantQueryFilterException : "+m) { ; }
+    ~VariantQueryFilterException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+enum VariantQueryFilterOperatorEnum
+{
+  VARIANT_QUERY_FILTER_EQ=0,
+  VARIANT_QUERY_FILTER_NE,
+  VARIANT_QUERY_FILTER_LT,
+  VARIANT_QUERY_FILTER_LE,
+  VARIANT_QUERY_FILTER_GT,
+  VARIANT_QUERY_FILTER_GE
+};
+
+/*
+ * Single comparison <field><op><value>, op is one of ==,!=,<,<=,>,>= - for example GQ>=20, DP>5, QUAL>30.
+ * Numeric fields compare their first element, cells where the field is missing never pass.
+ * FILTER supports == and != with a filter name - FILTER==PASS passes cells whose FILTER is empty or only
+ * PASS, FILTER==LowQual passes cells with LowQual in FILTER, FILTER!=LowQual the others.
+ * Filters are evaluated on the raw cell buffers before any field is materialized
+ */
+class VariantQueryFilter
+{
+  public:
+    VariantQueryFilter(const std::string& expression);
+    inline const std::string& get_expression() const { return m_expression; }
+    inline const std::string& get_field_name() const { return m_field_name; }
+    /*
+     * Called during query bookkeeping - query_idx and type of the field in the query
+     */
+    void bind(const unsigned query_idx, const std::type_index& type, const VidMapper& vid_mapper);
+    inline bool is_bound() const { return m_value_type != VALUE_TYPE_UNBOUND; }
+    bool evaluate(const BufferVariantCell& cell) const;
+  private:
+    enum ValueTypeEnum
+    {
+      VALUE_TYPE_UNBOUND=0,
+      VALUE_TYPE_INT32,
+      VALUE_TYPE_UINT32,
+      VALUE_TYPE_INT64,
+      VALUE_TYPE_UINT64,
+      VALUE_TYPE_FLOAT,
+      VALUE_TYPE_DOUBLE,
+      VALUE_TYPE_FILTER
+    };
+    template<class T>
+    bool evaluate_numeric(const BufferVariantCell& cell) const;
+    bool evaluate_FILTER(const BufferVariantCell& cell) const;
+    inline bool compare(const double value) const
+    {
+      switch(m_operator)
+      {
+        case VARIANT_QUERY_FILTER_EQ: return value == m_value;
+        case VARIANT_QUERY_FILTER_NE: return value != m_value;
+        case VARIANT_QUERY_FILTER_LT: return value < m_value;
+        case VARIANT_QUERY_FILTER_LE: return value <= m_value;
+        case VARIANT_QUERY_FILTER_GT: return value > m_value;
+        default: return value >= m_value;
+      }
+    }
+  private:
+    std::string m_expression;
+    std::string m_field_name;
+    std::string m_value_string;
+    VariantQueryFilterOperatorEnum m_operator;
+    double m_value;
+    ValueTypeEnum m_value_type;
+    unsigned m_query_idx;
+    //FILTER comparisons - global field idx of the filter name, -1 if not in the vid mapping
+    int m_FILTER_idx;
+    int m_PASS_idx;
+    bool m_is_PASS;
+};
+
+#endif
@@ -26,8 +26,14 @@
 #include "headers.h"
 #include "variant_array_schema.h"
 #include "variant_cell.h"
+#include "variant_array_tile_cache.h"
 #include "c_api.h"
 #include "timer.h"
+#include "genomicsdb_profiler.h"
+#include "histogram.h"
+#include "fragment_consolidation_policy.h"
+#include <memory>
+#include <mutex>
 
 //Exceptions thrown 
 class VariantStorageManagerException : public std::exception {
@@ -41,35 +47,125 @@ class VariantStorageManagerException : public std::exception {
     std::string msg_;
 };
 
+//When a query is split into several row ranges, each range gets a share of the memory budget but no less
+#define MIN_VARIANT_ARRAY_CELL_ITERATOR_BUFFER_SIZE (1024u*1024u)
+//No attribute buffer is smaller than this, unless the memory budget allows less per buffer
+#define MIN_ATTRIBUTE_BUFFER_SIZE (64u*1024u)
+//#elements assumed for variable length fields when no cells have been seen
+#define DEFAULT_NUM_ELEMENTS_IN_VARIABLE_LENGTH_FIELD 4u
+//Sizes observed by iterators are preferred over the metadata once these many cells are seen
+#define MIN_NUM_OBSERVED_CELLS_FOR_CELL_SIZE 1024u
+
+/*
+ * #cells and #bytes per attribute (schema idx). The loader keeps the totals in the array metadata and
+ * iterators accumulate what they read, so that buffers can be sized from the data actually stored/queried
+ */
+class VariantArrayCellSizeStatistics
+{
+  public:
+    VariantArrayCellSizeStatistics(const size_t num_attributes=0u)
+      : m_num_cells(num_attributes, 0ull), m_num_bytes(num_attributes, 0ull) { ; }
+    VariantArrayCellSizeStatistics(const VariantArrayCellSizeStatistics& other)
+      : m_num_cells(other.m_num_cells), m_num_bytes(other.m_num_bytes) { ; }
+    VariantArrayCellSizeStatistics& operator=(const VariantArrayCellSizeStatistics& other)
+    {
+      m_num_cells = other.m_num_cells;
+      m_num_bytes = other.m_num_bytes;
+      return *this;
+    }
+    void clear(const size_t num_attributes)
+    {
+      m_num_cells.assign(num_attributes, 0ull);
+      m_num_bytes.assign(num_attributes, 0ull);
+    }
+    size_t get_num_attributes() const { return m_num_cells.size(); }
+    //Not thread-safe - used by the loader
+    inline void add_cell_field(const int schema_idx, const size_t num_bytes)
+    {
+      assert(static_cast<size_t>(schema_idx) < m_num_cells.size());
+      ++(m_num_cells[schema_idx]);
+      m_num_bytes[schema_idx] += num_bytes;
+    }
+    void add(const int schema_idx, const uint64_t num_cells, const uint64_t num_bytes);
+    //Thread-safe - counts are indexed by position in schema_idxs
+    void merge(const std::vector<int>& schema_idxs, const std::vector<uint64_t>& num_cells,
+        const std::vector<uint64_t>& num_bytes);
+    uint64_t get_num_cells(const int schema_idx) const;
+    uint64_t get_num_bytes(const int schema_idx) const;
+    /*
+     * Splits memory_budget among the buffers of attribute_ids in the layout used by TileDB - for every
+     * attribute the offsets buffer (variable length fields only) followed by the data buffer, coords last.
+     * Each buffer gets a share proportional to its expected #bytes per cell, so that all buffers fill up
+     * at the same rate. Expected sizes come from observed (if it has seen enough cells), else stored,
+     * else from the schema
+     */
+    static void compute_buffer_sizes(const VariantArraySchema& schema, const std::vector<int>& attribute_ids,
+        const size_t memory_budget, std::vector<size_t>& buffer_sizes,
+        const VariantArrayCellSizeStatistics* stored, const VariantArrayCellSizeStatistics* observed=0);
+  private:
+    mutable std::mutex m_mutex;
+    std::vector<uint64_t> m_num_cells;
+    std::vector<uint64_t> m_num_bytes;
+};
+
 class VariantArrayCellIterator
 {
   public:
+    /*
+     * range points to num_ranges subarrays of 4 elements each - [row_begin, row_end, column_begin, column_end].
+     * Subarrays must not overlap. Cells from all subarrays are returned in column major order
+     * memory_budget is split among all buffers based on the cell sizes in stored/observed. Sizes of the cells
+     * read are added to observed when the iterator is destroyed
+     * With use_tile_cache, cells are served from tiles in the process wide VariantArrayTileCache, tiles
+     * missing from the cache are read through TileDB and added to the cache. Tiles hold all rows of the
+     * array, so the row ranges only filter cells after they are read. A tile whose decoded cells exceed
+     * memory_budget is not cached - the iterator reads the remaining columns directly through TileDB
+     */
     VariantArrayCellIterator(TileDB_CTX* tiledb_ctx, const VariantArraySchema& variant_array_schema,
-        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size);
+        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t memory_budget,
+        const unsigned num_ranges=1u, const VariantArrayCellSizeStatistics* stored_cell_sizes=0,
+        std::shared_ptr<VariantArrayCellSizeStatistics> observed_cell_sizes=nullptr,
+        const bool use_tile_cache=false);
     ~VariantArrayCellIterator()
     {
-      if(m_tiledb_array_iterator)
-        tiledb_array_iterator_finalize(m_tiledb_array_iterator);
+      if(m_observed_cell_sizes)
+        m_observed_cell_sizes->merge(m_attribute_ids, m_num_cells_read, m_num_bytes_read);
+      for(auto tiledb_array_iterator : m_tiledb_array_iterators)
+        tiledb_array_iterator_finalize(tiledb_array_iterator);
+      m_tiledb_array_iterators.clear();
       m_tiledb_array_iterator = 0;
-#ifdef DO_PROFILING
-      m_tiledb_timer.print("TileDB iterator", std::cerr);
-      m_tiledb_to_buffer_cell_timer.print("TileDB to buffer cell", std::cerr);
-#endif
     }
     //Delete copy and move constructors
     VariantArrayCellIterator(const VariantArrayCellIterator& other) = delete;
     VariantArrayCellIterator(VariantArrayCellIterator&& other) = delete;
+    //Memory held by the iterator's buffers - tiles from the tile cache are not counted
+    inline size_t get_buffer_size_in_bytes() const
+    {
+      auto size = 0ull;
+      for(const auto& buffer : m_buffers)
+        size += buffer.capacity();
+      return size;
+    }
     inline bool end() const {
-      return tiledb_array_iterator_end(m_tiledb_array_iterator);
+      if(m_use_tile_cache)
+        return m_tiles.empty();
+      return (m_tiledb_array_iterator == 0) || tiledb_array_iterator_end(m_tiledb_array_iterator);
     }
     inline const VariantArrayCellIterator& operator++()
     {
-#ifdef DO_PROFILING
-      m_tiledb_timer.start();
-#endif
+      ProfilerSpan span(PROFILER_SPAN_TILEDB_ITERATOR_NEXT);
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_TILEDB_CELLS);
+      if(m_use_tile_cache)
+      {
+        ++m_cell_idx_in_tile;
+        seek_to_valid_cached_cell();
+        return *this;
+      }
       auto status = tiledb_array_iterator_next(m_tiledb_array_iterator);
       if(status != TILEDB_OK)
         throw VariantStorageManagerException("VariantArrayCellIterator increment failed");
+      if(m_tiledb_array_iterators.size() > 1u)
+        select_next_iterator();
 #ifdef DEBUG
       if(!end())
       {
@@ -85,40 +181,76 @@ class VariantArrayCellIterator
         m_last_row = coords_ptr[0];
         m_last_column = coords_ptr[1];
       }
-#endif
-#ifdef DO_PROFILING
-      m_tiledb_timer.stop();
 #endif
       return *this;
     }
     const BufferVariantCell& operator*();
+  private:
+    //Points m_tiledb_array_iterator to the iterator with the smallest (column, row), null if all are done
+    void select_next_iterator();
+    //Direct TileDB mode - one TileDB iterator per subarray sharing memory_budget
+    void initialize_tiledb_iterators(const int64_t* range, const unsigned num_ranges, const size_t memory_budget,
+        const VariantArrayCellSizeStatistics* stored_cell_sizes);
+    /*
+     * Tile cache mode - fetches the tiles of all queried attributes and co-ordinates into m_tiles.
+     * Switches to direct TileDB mode if the tiles do not fit in the memory budget
+     */
+    void load_tile(const int64_t tile_idx);
+    /*
+     * Reads the attributes at query_idxs and co-ordinates for a tile through TileDB into tiles. With
+     * find_next_column, the read continues past the tile to find the next column with cells.
+     * Returns false (and clears tiles) once the tiles exceed m_memory_budget
+     */
+    bool read_tile(const int64_t tile_idx, const std::vector<int>& query_idxs, const bool find_next_column,
+        std::vector<std::shared_ptr<VariantArrayTile>>& tiles);
+    //Drops the tile cache and reads the queried ranges from column tile_idx*m_tile_width onwards through TileDB
+    void switch_to_tiledb_iterators(const int64_t tile_idx);
+    //Moves forward from the current cell to the first cell within the queried ranges, clears m_tiles at the end
+    void seek_to_valid_cached_cell();
   private:
     unsigned m_num_queried_attributes;
     TileDB_CTX* m_tiledb_ctx;
     const VariantArraySchema* m_variant_array_schema;
     BufferVariantCell m_cell;
-    //The actual TileDB array iterator
+    //The actual TileDB array iterators - one per subarray
+    std::vector<TileDB_ArrayIterator*> m_tiledb_array_iterators;
+    //Iterator pointing to the current cell
     TileDB_ArrayIterator* m_tiledb_array_iterator;
-    //Buffers to hold data
+    //Buffers to hold data - buffers of all subarrays, subarray by subarray
     std::vector<std::vector<uint8_t>> m_buffers;
     //Pointers to buffers
     std::vector<const void*> m_buffer_pointers;
     //Buffer sizes
     std::vector<size_t> m_buffer_sizes;
+    //Cell sizes seen - per queried attribute
+    std::vector<int> m_attribute_ids;
+    std::vector<uint64_t> m_num_cells_read;
+    std::vector<uint64_t> m_num_bytes_read;
+    std::shared_ptr<VariantArrayCellSizeStatistics> m_observed_cell_sizes;
+    //Tile cache mode
+    bool m_use_tile_cache;
+    std::string m_array_path;
+    size_t m_memory_budget;
+    const VariantArrayCellSizeStatistics* m_stored_cell_sizes;
+    std::vector<int64_t> m_ranges;
+    int64_t m_max_column;
+    int64_t m_tile_width;
+    uint64_t m_fragment_set_id;
+    int64_t m_tile_idx;
+    uint64_t m_cell_idx_in_tile;
+    //One tile per queried attribute followed by the co-ordinates tile - empty once the iterator is done
+    std::vector<VariantArrayTileCache::TilePtr> m_tiles;
 #ifdef DEBUG
     int64_t m_last_row;
     int64_t m_last_column;
     uint64_t m_num_cells_iterated_over;
 #endif
-#ifdef DO_PROFILING
-    Timer m_tiledb_timer;
-    Timer m_tiledb_to_buffer_cell_timer;
-#endif
 };
 
 class VariantArrayInfo
 {
   public:
+    //Writers get buffer_size per buffer on average - split among attributes based on cell sizes
     VariantArrayInfo(int idx, int mode, const std::string& name, const VariantArraySchema& schema,
         TileDB_Array* tiledb_array, const std::string& metadata_filename,
         const size_t buffer_size=10u*1024u*1024u); //10MB buffer
@@ -142,6 +274,9 @@ class VariantArrayInfo
           throw VariantStorageManagerException("Error while writing to array "+m_name);
         memset(&(m_buffer_offsets[0]), 0, m_buffer_offsets.size()*sizeof(size_t));
       }
+      auto update_metadata = (m_num_cells_written > 0ull);
+      if(update_metadata)
+        m_fragments.emplace_back(m_num_cells_written, m_num_bytes_written);
       if(m_tiledb_array)
       {
         if(consolidate_tiledb_array)
@@ -149,11 +284,15 @@ class VariantArrayInfo
           auto status = tiledb_array_consolidate(m_tiledb_array);
           if(status != TILEDB_OK)
             throw VariantStorageManagerException("Error while consolidating TileDB array "+m_name);
+          merge_fragments();
+          update_metadata = true;
         }
         auto status = tiledb_array_finalize(m_tiledb_array);
         if(status != TILEDB_OK)
           throw VariantStorageManagerException("Error while finalizing TileDB array "+m_name);
       }
+      if(update_metadata)
+        write_statistics_to_metadata();
       m_tiledb_array = 0;
       m_name.clear();
       m_mode = -1;
@@ -165,9 +304,13 @@ class VariantArrayInfo
     }
     const VariantArraySchema& get_schema() const { return m_schema; }
     const std::string& get_array_name() const { return m_name; }
+    int get_mode() const { return m_mode; }
     void write_cell(const void* ptr);
-    //Read #valid rows from metadata if available, else set from schema (array domain)
-    void read_row_bounds_from_metadata();
+    /*
+     * Read #valid rows from metadata if available, else set from schema (array domain)
+     * Also reads the column histogram if present
+     */
+    void read_metadata();
     /*
      * Update #valid rows in the metadata
      */
@@ -178,7 +321,23 @@ class VariantArrayInfo
     {
       return (m_max_valid_row_idx_in_array - m_schema.dim_domains()[0].first + 1);
     }
+    //Histogram of #cells/#bytes per column bin - includes cells written through this object
+    const ColumnCellHistogram& get_column_histogram() const { return m_column_histogram; }
+    //Per attribute cell sizes from the metadata - includes cells written through this object
+    const VariantArrayCellSizeStatistics& get_stored_cell_sizes() const { return m_stored_cell_sizes; }
+    //Per attribute cell sizes seen by iterators over this array
+    std::shared_ptr<VariantArrayCellSizeStatistics> get_observed_cell_sizes() const { return m_observed_cell_sizes; }
+    //Fragments recorded in the metadata - the fragment being written is added when the array is closed
+    const std::vector<VariantArrayFragmentInfo>& get_fragments() const { return m_fragments; }
+    //Largest END-begin of the stored cells, -1 if unknown (array loaded before it was tracked)
+    int64_t get_max_interval_length() const { return m_max_interval_length; }
   private:
+    //Merges the histogram, cell sizes and fragments into the metadata - called when an array opened for writing is closed
+    void write_statistics_to_metadata();
+    //After consolidation, all fragments are replaced by a single fragment
+    void merge_fragments();
+    //Splits the write memory budget among buffers - buffers must be empty
+    void allocate_write_buffers();
     int m_idx;
     int m_mode;
     std::string m_name;
@@ -196,6 +355,14 @@ class VariantArrayInfo
     //Max valid row idx in array
     int64_t m_max_valid_row_idx_in_array;
     bool m_metadata_contains_max_valid_row_idx_in_array;
+    ColumnCellHistogram m_column_histogram;
+    uint64_t m_num_cells_written;
+    uint64_t m_num_bytes_written;
+    std::vector<VariantArrayFragmentInfo> m_fragments;
+    int64_t m_max_interval_length;
+    size_t m_write_memory_budget;
+    VariantArrayCellSizeStatistics m_stored_cell_sizes;
+    std::shared_ptr<VariantArrayCellSizeStatistics> m_observed_cell_sizes;
 #ifdef DEBUG
     int64_t m_last_row;
     int64_t m_last_column;
@@ -212,7 +379,14 @@ class VariantStorageManager
     VariantStorageManager(const std::string& workspace, const unsigned segment_size=10u*1024u*1024u);
     ~VariantStorageManager()
     {
+      //Arrays still open are closed here
+      std::vector<std::string> written_array_paths;
+      for(auto& array_info : m_open_arrays_info_vector)
+        if(array_info.get_mode() == TILEDB_ARRAY_WRITE || array_info.get_mode() == TILEDB_ARRAY_WRITE_UNSORTED)
+          written_array_paths.push_back(m_workspace+'/'+array_info.get_array_name());
       m_open_arrays_info_vector.clear();
+      for(const auto& array_path : written_array_paths)
+        VariantArrayTileCache::get_instance().invalidate(array_path);
       m_workspace.clear();
        /* Finalize context. */
       tiledb_ctx_finalize(m_tiledb_ctx);
@@ -229,7 +403,11 @@ class VariantStorageManager
     void close_array(const int ad, const bool consolidate_tiledb_array=false);
     int define_array(const VariantArraySchema* variant_array_schema, const size_t num_cells_per_tile=1000u);
     void delete_array(const std::string& array_name);
-    int define_metadata_schema(const VariantArraySchema* variant_array_schema);
+    /*
+     * Creates the metadata JSON. For a newly defined array, nothing is stored yet, so statistics
+     * that must cover every cell (max interval length) can be tracked from the first write
+     */
+    int define_metadata_schema(const VariantArraySchema* variant_array_schema, const bool is_new_array=false);
     /*
      * Load array schema
      */
@@ -240,6 +418,12 @@ class VariantStorageManager
      */
     VariantArrayCellIterator* begin(
         int ad, const int64_t* range, const std::vector<int>& attribute_ids) const ;
+    /*
+     * Single iterator over the union of several row ranges within [column_begin, column_end]
+     */
+    VariantArrayCellIterator* begin(
+        int ad, const std::vector<RowRange>& row_ranges, const int64_t column_begin, const int64_t column_end,
+        const std::vector<int>& attribute_ids) const ;
     /*
      * Write sorted cell
      */
@@ -252,10 +436,46 @@ class VariantStorageManager
      * Update row bounds in the metadata
      */
     void update_row_bounds_in_array(const int ad, const int64_t lb_row_idx, const int64_t max_valid_row_idx_in_array);
+    /*
+     * Column histogram of #cells/#bytes stored in the metadata - empty for arrays loaded before
+     * histograms were maintained
+     */
+    const ColumnCellHistogram& get_column_histogram(const int ad) const;
+    /*
+     * Largest END-begin over all cells of the array, -1 if unknown. Bounds how far beyond a queried
+     * interval the END copies of intervals overlapping it can lie
+     */
+    int64_t get_max_interval_length(const int ad) const;
+    /*
+     * Reads the column histogram from the metadata of an array that is not open - does not need a
+     * TileDB context. Returns false if the array has no histogram
+     */
+    static bool read_column_histogram(const std::string& workspace, const std::string& array_name,
+        ColumnCellHistogram& histogram);
+    /*
+     * Fragments of an array that is not open, as recorded in the metadata. Arrays loaded before fragments
+     * were tracked are reported as a single fragment. Returns false if nothing is known about the array
+     */
+    static bool read_fragments(const std::string& workspace, const std::string& array_name,
+        std::vector<VariantArrayFragmentInfo>& fragments);
+    /*
+     * Consolidates an array that is not open - unconditionally if policy is null, else only if the policy
+     * asks for it based on the fragments in the metadata. Returns true if the array was consolidated
+     */
+    bool consolidate_array(const std::string& array_name, const FragmentConsolidationPolicy* policy=0);
     /*
      * Return workspace path
      */
     const std::string& get_workspace() const { return m_workspace; }
+    /*
+     * Total size of the buffers of an iterator, split among attributes based on cell sizes.
+     * 0 (default) - segment size times the #buffers, i.e. the same total as equal sized buffers
+     */
+    void set_iterator_memory_budget(const size_t budget) { m_iterator_memory_budget = budget; }
+    size_t get_iterator_memory_budget(const std::vector<int>& attribute_ids, const int ad) const;
+  private:
+    //Whether iterators over the given ranges read through the tile cache
+    bool use_tile_cache(const int ad, const int64_t* ranges, const unsigned num_ranges) const;
   private:
     static const std::unordered_map<std::string, int> m_mode_string_to_int;
     //TileDB context
@@ -266,6 +486,7 @@ class VariantStorageManager
     std::vector<VariantArrayInfo> m_open_arrays_info_vector;
     //How much data to read/write in a given access
     size_t m_segment_size;
+    size_t m_iterator_memory_budget;
     //Metadata attribute name
     static std::vector<const char*> m_metadata_attributes;
 };
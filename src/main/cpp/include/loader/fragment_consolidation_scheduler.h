@@ -0,0 +1,92 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef FRAGMENT_CONSOLIDATION_SCHEDULER_H
+#define FRAGMENT_CONSOLIDATION_SCHEDULER_H
+
+#include "headers.h"
+#include "variant_storage_manager.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+/*
+ * Process wide background consolidation of arrays loaded incrementally. Requests are served in order
+ * by a single worker thread, each one consolidates the array only if its policy asks for it at the time
+ * the request runs. Pending requests are completed before the process exits - MPI programs must call
+ * wait() before MPI_Finalize() and check get_num_failed_consolidations() to report failures
+ */
+class FragmentConsolidationScheduler
+{
+  public:
+    static FragmentConsolidationScheduler& get_instance();
+    //Delete copy and move constructors
+    FragmentConsolidationScheduler(const FragmentConsolidationScheduler& other) = delete;
+    FragmentConsolidationScheduler(FragmentConsolidationScheduler&& other) = delete;
+    ~FragmentConsolidationScheduler();
+    /*
+     * No-op if a request for the same array is already pending
+     */
+    void schedule(const std::string& workspace, const std::string& array_name,
+        const FragmentConsolidationPolicy& policy);
+    /*
+     * Blocks till pending and running requests for the array are done - writers must call this before
+     * opening the array. Empty array_name waits for all requests
+     */
+    void wait(const std::string& workspace="", const std::string& array_name="");
+    uint64_t get_num_consolidations() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_num_consolidations;
+    }
+    uint64_t get_num_failed_consolidations() const
+    {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      return m_num_failed_consolidations;
+    }
+  private:
+    FragmentConsolidationScheduler();
+    struct ConsolidationRequest
+    {
+      std::string m_workspace;
+      std::string m_array_name;
+      FragmentConsolidationPolicy m_policy;
+    };
+    static std::string get_array_path(const std::string& workspace, const std::string& array_name)
+    { return workspace+'/'+array_name; }
+    bool is_pending_or_running(const std::string& array_path) const;
+    void worker_loop();
+  private:
+    mutable std::mutex m_mutex;
+    std::condition_variable m_request_available;
+    std::condition_variable m_request_done;
+    std::deque<ConsolidationRequest> m_requests;
+    //Path of the array being consolidated, empty if idle
+    std::string m_running_array_path;
+    bool m_stop;
+    uint64_t m_num_consolidations;
+    uint64_t m_num_failed_consolidations;
+    std::thread m_worker;
+};
+
+#endif
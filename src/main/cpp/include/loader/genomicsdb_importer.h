@@ -139,6 +139,26 @@ class GenomicsDBImporter
         data,
         num_bytes);
     }
+    /*
+     * Zero-copy write to buffer stream - data is parsed in place and must remain valid
+     * (and unmodified by the caller) till the stream shows up in get_exhausted_buffer_stream_identifiers()
+     */
+    void use_external_buffer_for_buffer_stream(
+      const int64_t buffer_stream_idx,
+      const unsigned partition_idx,
+      uint8_t* data,
+      const size_t num_bytes)
+    {
+      if(!m_is_loader_setup)
+        throw GenomicsDBImporterException(
+          "Cannot write data to buffer stream in the GenomicsDBImporter without calling setup_loader() first");
+      assert(m_loader_ptr);
+      m_loader_ptr->use_external_buffer_for_buffer_stream(
+        buffer_stream_idx,
+        partition_idx,
+        data,
+        num_bytes);
+    }
     /*
      * Import next batch of data into TileDB/GenomicsDB
      */
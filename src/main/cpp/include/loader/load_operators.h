@@ -28,6 +28,7 @@
 #include "broad_combined_gvcf.h" 
 #include "variant_storage_manager.h"
 #include "json_config.h"
+#include "column_partitioner.h"
 
 struct CellPointersColumnMajorCompare
 {
@@ -71,7 +72,9 @@ class LoaderOperatorBase
       m_last_end_position_for_row.resize(num_callsets, -1ll);
 #endif
       //Parse loader JSON
+      m_loader_json_config.set_compute_auto_column_partitions(true);
       m_loader_json_config.read_from_file(loader_config_file);
+      LoadBalancedColumnPartitioner::initialize_auto_column_partitions(m_loader_json_config);
       //Partitioning information
       m_row_partition = RowRange(0, m_loader_json_config.get_max_num_rows_in_array()-1);
       if(m_loader_json_config.is_partitioned_by_row())
@@ -247,9 +250,6 @@ class LoaderCombinedGVCFOperator : public LoaderOperatorBase
     //Deletions
     bool m_handle_spanning_deletions;
     uint64_t m_num_calls_with_deletions;
-    //Profiling stat
-    GTProfileStats m_stats;
-    GTProfileStats* m_stats_ptr;
 #ifdef DO_MEMORY_PROFILING
     size_t m_next_memory_limit;
 #endif
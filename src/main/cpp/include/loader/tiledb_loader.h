@@ -173,6 +173,11 @@ class VCF2TileDBConverter : public VCF2TileDBLoaderConverterBase
      * Write to buffer stream
      */
     void write_data_to_buffer_stream(const int64_t buffer_stream_idx, const unsigned partition_idx, const uint8_t* data, const size_t num_bytes);
+    /*
+     * Zero-copy variant of write_data_to_buffer_stream - the buffer stream parses records directly from data
+     * data must remain valid till the stream is reported as exhausted
+     */
+    void use_external_buffer_for_buffer_stream(const int64_t buffer_stream_idx, const unsigned partition_idx, uint8_t* data, const size_t num_bytes);
     //Print partitions of files - useful when splitting files into partitions
     /*
      * Print all included partitions
@@ -253,6 +258,11 @@ class VCF2TileDBLoaderReadState
             }));
     }
     bool is_done() const { return m_done; }
+    //Timers for the fetch (VCF2Binary) and load (operators) phases of read_all()
+    const Timer& get_fetch_timer() const { return m_fetch_timer; }
+    const Timer& get_load_timer() const { return m_load_timer; }
+    const Timer& get_flush_output_timer() const { return m_flush_output_timer; }
+    const Timer& get_time_in_read_all() const { return m_time_in_read_all; }
   private:
     bool m_done;
     size_t m_exchange_counter;
@@ -354,6 +364,12 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
 #ifdef HTSDIR
       return m_converter->write_data_to_buffer_stream(buffer_stream_idx, partition_idx, data, num_bytes);
 #endif   
+    }
+    void use_external_buffer_for_buffer_stream(const int64_t buffer_stream_idx, const unsigned partition_idx, uint8_t* data, const size_t num_bytes)
+    {
+#ifdef HTSDIR
+      return m_converter->use_external_buffer_for_buffer_stream(buffer_stream_idx, partition_idx, data, num_bytes);
+#endif
     }
     /*
      * Get the order value at which the given row idx appears
@@ -406,9 +422,11 @@ class VCF2TileDBLoader : public VCF2TileDBLoaderConverterBase
     static int create_tiledb_workspace(const char* workspace);
     static int create_tiledb_workspace(const std::string& workspace) { return create_tiledb_workspace(workspace.c_str()); }
     /*
-     * Consolidate TileDB array
+     * Consolidate TileDB array - unconditionally if policy is null, else only if the fragments
+     * recorded in the metadata call for it. Returns true if the array was consolidated
      */
-    static void consolidate_tiledb_array(const char* workspace, const char* array_name);
+    static bool consolidate_tiledb_array(const char* workspace, const char* array_name,
+        const FragmentConsolidationPolicy* policy=0);
   private:
     void common_constructor_initialization(
       const std::string& config_filename,
@@ -72,6 +72,7 @@ class BufferReaderBase : public virtual GenomicsDBImportReaderBase
       m_offset = 0;
       m_num_valid_bytes_in_buffer = 0;
       m_buffer.resize(buffer_size);
+      m_external_buffer_ptr = 0;
     }
     virtual ~BufferReaderBase() = default;
     size_t get_offset() const { return m_offset; }
@@ -81,6 +82,36 @@ class BufferReaderBase : public virtual GenomicsDBImportReaderBase
     void set_num_valid_bytes_in_buffer(const size_t val) { m_num_valid_bytes_in_buffer = val; }
     inline bool contains_unread_data() const { return m_offset < m_num_valid_bytes_in_buffer; }
     std::vector<uint8_t>& get_buffer() { return m_buffer; }
+    /*
+     * Pointer to the start of the memory region from which records are parsed
+     * Points to the external buffer, if one is set, else to m_buffer
+     */
+    inline uint8_t* get_read_buffer_pointer()
+    {
+      return m_external_buffer_ptr ? m_external_buffer_ptr : &(m_buffer[0]);
+    }
+    /*
+     * Zero-copy mode - records are parsed directly from memory owned by the caller
+     * The caller must keep the memory alive and unmodified till the reader reports that the
+     * buffer is exhausted (see release_external_buffer()). The parser may modify the contents
+     * of the buffer in place (VCF text lines are tokenized in place)
+     */
+    void set_external_buffer(uint8_t* src, const size_t num_bytes)
+    {
+      m_external_buffer_ptr = src;
+      m_offset = 0;
+      m_num_valid_bytes_in_buffer = src ? num_bytes : 0u;
+    }
+    /*
+     * Drop reference to external memory - called once all the data in the external buffer is consumed
+     * Offsets are left untouched, so the reader state is identical to that of an exhausted internal buffer
+     */
+    void release_external_buffer()
+    {
+      assert(!contains_unread_data());
+      m_external_buffer_ptr = 0;
+    }
+    bool uses_external_buffer() const { return m_external_buffer_ptr != 0; }
     /*
      * Returns number of bytes that could be copied
      */
@@ -88,6 +119,7 @@ class BufferReaderBase : public virtual GenomicsDBImportReaderBase
     {
       if(src == 0)
         return 0u;
+      assert(!uses_external_buffer());
       auto num_bytes_to_copy = std::min<size_t>(num_bytes, m_buffer.size()-m_num_valid_bytes_in_buffer);
       memcpy(&(m_buffer[m_num_valid_bytes_in_buffer]), src, num_bytes_to_copy);
       m_num_valid_bytes_in_buffer += num_bytes_to_copy;
@@ -101,6 +133,7 @@ class BufferReaderBase : public virtual GenomicsDBImportReaderBase
     {
       if(src == 0)
         return 0u;
+      assert(!uses_external_buffer());
       if(num_bytes <= (m_buffer.size()-m_num_valid_bytes_in_buffer))
       {
         memcpy(&(m_buffer[m_num_valid_bytes_in_buffer]), src, num_bytes);
@@ -131,6 +164,8 @@ class BufferReaderBase : public virtual GenomicsDBImportReaderBase
     size_t m_offset;
     size_t m_num_valid_bytes_in_buffer;
     std::vector<uint8_t> m_buffer;
+    //Memory owned by the caller - set in zero-copy mode only
+    uint8_t* m_external_buffer_ptr;
 };
 
 class File2TileDBBinaryColumnPartitionBase
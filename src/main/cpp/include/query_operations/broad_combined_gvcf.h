@@ -29,6 +29,7 @@
 #include "vcf_adapter.h"
 #include "vid_mapper.h"
 #include "timer.h"
+#include "genomicsdb_profiler.h"
 
 //known_field_enum, query_idx, VariantFieldTypeEnum, bcf_ht_type, vcf field name, INFO_field_combine_operation
 typedef std::tuple<unsigned, unsigned, VariantFieldTypeEnum, unsigned, std::string, int> INFO_tuple_type;
@@ -47,6 +48,73 @@ class BroadCombinedGVCFException : public std::exception {
     std::string msg_;
 };
 
+/*
+ * Combines the values of one INFO field (or QUAL) over all Calls in a Variant. One object is created
+ * per queried field when the operator is constructed - element type and combine operation are
+ * template parameters, so the per-site loop does not look them up or switch on them
+ */
+class INFOFieldCombineOperatorBase
+{
+  public:
+    INFOFieldCombineOperatorBase(const INFO_tuple_type& info_tuple, const VariantQueryConfig& query_config,
+        const unsigned GT_query_idx);
+    virtual ~INFOFieldCombineOperatorBase() = default;
+    virtual bool combine(const Variant& variant, const VariantQueryConfig& query_config,
+        void*& result_ptr, unsigned& num_result_elements) = 0;
+    inline const char* get_vcf_field_name() const { return m_vcf_field_name.c_str(); }
+    inline int get_bcf_ht_type() const { return m_bcf_ht_type; }
+    inline size_t get_element_size() const { return m_element_size; }
+    //Fields such as PL are skipped if the #alleles is above a certain threshold
+    inline bool is_genotype_dependent() const { return m_is_genotype_dependent; }
+    //Fields that were remapped must be read from the remapped variant
+    inline bool use_remapped_variant() const { return m_use_remapped_variant; }
+  protected:
+    unsigned m_query_idx;
+    int m_bcf_ht_type;
+    size_t m_element_size;
+    bool m_is_genotype_dependent;
+    bool m_use_remapped_variant;
+    std::string m_vcf_field_name;
+};
+
+template<class DataType, int VCFFieldCombineOperation>
+class INFOFieldCombineOperator : public INFOFieldCombineOperatorBase
+{
+  public:
+    INFOFieldCombineOperator(const INFO_tuple_type& info_tuple, const VariantQueryConfig& query_config,
+        const unsigned GT_query_idx, VariantFieldHandlerBase* handler)
+      : INFOFieldCombineOperatorBase(info_tuple, query_config, GT_query_idx),
+      m_handler(static_cast<VariantFieldHandler<DataType>*>(handler))
+    { }
+    //Switch on a template parameter and qualified (non-virtual) handler calls - resolved at compile time
+    virtual bool combine(const Variant& variant, const VariantQueryConfig& query_config,
+        void*& result_ptr, unsigned& num_result_elements)
+    {
+      auto num_valid_input_elements = 0u;
+      switch(VCFFieldCombineOperation)
+      {
+        case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_SUM:
+          return m_handler->VariantFieldHandler<DataType>::get_valid_sum(variant, query_config,
+              m_query_idx, result_ptr, num_valid_input_elements);
+        case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEAN:
+          return m_handler->VariantFieldHandler<DataType>::get_valid_mean(variant, query_config,
+              m_query_idx, result_ptr, num_valid_input_elements);
+        case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEDIAN:
+          return m_handler->VariantFieldHandler<DataType>::get_valid_median(variant, query_config,
+              m_query_idx, result_ptr, num_valid_input_elements);
+        case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_ELEMENT_WISE_SUM:
+          return m_handler->VariantFieldHandler<DataType>::compute_valid_element_wise_sum(variant, query_config,
+              m_query_idx, const_cast<const void**>(&result_ptr), num_result_elements);
+        case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_CONCATENATE:
+          return m_handler->VariantFieldHandler<DataType>::concatenate_field(variant, query_config,
+              m_query_idx, const_cast<const void**>(&result_ptr), num_result_elements);
+        default:
+          return false;
+      }
+    }
+  private:
+    VariantFieldHandler<DataType>* m_handler;
+};
 
 /*
  * Operator to produce the combined GVCF that Broad expects
@@ -61,21 +129,24 @@ class BroadCombinedGVCFOperator : public GA4GHOperator
     {
       bcf_destroy(m_bcf_out);
       clear();
-#ifdef DO_PROFILING
-      m_bcf_t_creation_timer.print("bcf_t creation time", std::cerr);
-#endif
     }
     void clear();
     void switch_contig();
+    /*
+     * Contigs are tracked in the forward direction only - must be called before the operator
+     * is re-used for a query that may begin at a smaller column
+     */
+    void reset_contig_tracking();
     virtual void operate(Variant& variant, const VariantQueryConfig& query_config);
     inline bool overflow() const { return m_vcf_adapter->overflow(); }
     bool handle_VCF_field_combine_operation(const Variant& variant,
-        const INFO_tuple_type& curr_tuple, void*& result_ptr, unsigned& num_result_elements);
+        INFOFieldCombineOperatorBase& combine_operator, void*& result_ptr, unsigned& num_result_elements);
     void handle_INFO_fields(const Variant& variant);
     void handle_FORMAT_fields(const Variant& variant);
     void handle_deletions(Variant& variant, const VariantQueryConfig& query_config);
     void merge_ID_field(const Variant& variant, const unsigned query_idx);
   private:
+    std::unique_ptr<INFOFieldCombineOperatorBase> create_INFO_field_combine_operator(const INFO_tuple_type& info_tuple);
     bool m_use_missing_values_not_vector_end;
     const VariantQueryConfig* m_query_config;
     VCFAdapter* m_vcf_adapter;
@@ -94,10 +165,14 @@ class BroadCombinedGVCFOperator : public GA4GHOperator
     bool m_should_add_GQ_field;
     //If QUAL combine operation is specified
     INFO_tuple_type m_vcf_qual_tuple;
+    //Null if no QUAL combine operation is specified
+    std::unique_ptr<INFOFieldCombineOperatorBase> m_QUAL_combine_operator;
     //ID VCF field - to avoid repeated dynamic reallocations
     std::string m_ID_value;
     //INFO fields enum vector
     std::vector<INFO_tuple_type> m_INFO_fields_vec;
+    //Combine operators - one per element of m_INFO_fields_vec, in the same order
+    std::vector<std::unique_ptr<INFOFieldCombineOperatorBase>> m_INFO_combine_operators;
     std::vector<FORMAT_tuple_type> m_FORMAT_fields_vec;
     //MIN_DP values
     std::vector<int> m_MIN_DP_vector;
@@ -111,8 +186,6 @@ class BroadCombinedGVCFOperator : public GA4GHOperator
     std::vector<int> m_spanning_deletion_remapped_GT;
     //Allowed bases
     static const std::unordered_set<char> m_legal_bases;
-    //For profiling
-    Timer m_bcf_t_creation_timer;
 };
 
 #endif //ifdef HTSDIR
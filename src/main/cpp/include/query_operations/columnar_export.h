@@ -0,0 +1,203 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COLUMNAR_EXPORT_H
+#define COLUMNAR_EXPORT_H
+
+#include "variant_operations.h"
+#include "variant_storage_manager.h"
+#include "query_variants.h"
+#include "vid_mapper.h"
+#include "arrow_c_data_interface.h"
+
+//Exceptions thrown
+class ColumnarExportException : public std::exception {
+  public:
+    ColumnarExportException(const std::string m="") : msg_("Columnar export exception : "+m) { ; }
+    ~ColumnarExportException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+enum ColumnarColumnKindEnum
+{
+  COLUMNAR_COLUMN_PRIMITIVE=0,
+  COLUMNAR_COLUMN_STRING,
+  COLUMNAR_COLUMN_LIST
+};
+
+/*
+ * Single column of a record batch. Buffers follow the Arrow columnar layout - LSB ordered
+ * validity bitmap, int32 offsets for strings and lists and contiguous values - so that
+ * they can be handed off through the Arrow C data interface without any copies
+ */
+class ColumnarColumn
+{
+  public:
+    //Primitive or string column
+    ColumnarColumn(const std::string& name, const std::string& format, const unsigned element_size=0u);
+    //List column - takes ownership of child
+    ColumnarColumn(const std::string& name, ColumnarColumn* child);
+    //Delete copy constructor
+    ColumnarColumn(const ColumnarColumn& other) = delete;
+    /*
+     * Returns a new empty column with the same name and type
+     */
+    ColumnarColumn* create_empty_copy() const;
+    void clear();
+    inline int64_t length() const { return m_length; }
+    inline int64_t null_count() const { return m_null_count; }
+    inline ColumnarColumnKindEnum kind() const { return m_kind; }
+    inline const std::string& name() const { return m_name; }
+    inline const std::string& format() const { return m_format; }
+    inline const ColumnarColumn* child() const { return m_child.get(); }
+    /*
+     * Append functions - each call adds one entry to the column
+     */
+    void append_null();
+    //Primitive column, ptr points to one element
+    void append_primitive(const void* ptr);
+    //String column
+    void append_string(const char* ptr, const size_t num_chars);
+    //List of primitives
+    void append_primitive_list(const void* ptr, const size_t num_elements);
+    //List of strings
+    void append_string_list(const std::vector<std::string>& values);
+    /*
+     * Pointers to Arrow buffers of this column (validity, offsets/values, values)
+     */
+    void get_buffers(std::vector<const void*>& buffers) const;
+  private:
+    void set_validity(const bool valid);
+    inline void append_offset(const size_t num_elements)
+    {
+      auto next_offset = static_cast<int64_t>(m_offsets.back()) + static_cast<int64_t>(num_elements);
+      if(next_offset > INT32_MAX)
+        throw ColumnarExportException(std::string("Column ")+m_name+" exceeds the capacity of 32-bit offsets - reduce the batch size");
+      m_offsets.push_back(static_cast<int32_t>(next_offset));
+    }
+  private:
+    ColumnarColumnKindEnum m_kind;
+    std::string m_name;
+    std::string m_format;
+    unsigned m_element_size;
+    int64_t m_length;
+    int64_t m_null_count;
+    std::vector<uint8_t> m_validity;
+    std::vector<int32_t> m_offsets;
+    std::vector<uint8_t> m_data;
+    std::unique_ptr<ColumnarColumn> m_child;
+};
+
+/*
+ * Record batch - set of columns of equal length
+ */
+class ColumnarBatch
+{
+  public:
+    ColumnarBatch() { m_num_rows = 0; }
+    //Delete copy constructor
+    ColumnarBatch(const ColumnarBatch& other) = delete;
+    int64_t m_num_rows;
+    std::vector<std::unique_ptr<ColumnarColumn>> m_columns;
+};
+
+/*
+ * Fills columnar record batches from VariantCall objects - one row per call. Columns are
+ * row (int64), column (int64), END (int64) followed by every queried field other than END.
+ * Single valued fields become primitive columns, multi-valued fields lists of primitives,
+ * char fields utf8 strings and ALT a list of utf8 strings. Invalid fields are null.
+ * Once max_num_rows_per_batch rows are filled, the batch is sealed and a new one started.
+ * Sealed batches are exported (moved, not copied) through the Arrow C data interface
+ */
+class ColumnarExportOperator : public SingleCellOperatorBase
+{
+  public:
+    ColumnarExportOperator(const VariantQueryConfig& query_config, const VariantArraySchema& schema,
+        const VidMapper& vid_mapper, const int64_t max_num_rows_per_batch=1048576ll);
+    virtual void operate(VariantCall& call, const VariantQueryConfig& query_config, const VariantArraySchema& schema);
+    /*
+     * Seals the partially filled batch (if not empty) - call once the query is complete
+     */
+    void finalize();
+    inline size_t get_num_completed_batches() const { return m_completed_batches.size(); }
+    //Scans pause once a batch is sealed so that batches are produced on demand
+    virtual bool overflow() const { return !m_completed_batches.empty(); }
+    inline int64_t get_max_num_rows_per_batch() const { return m_max_num_rows_per_batch; }
+    /*
+     * Moves the oldest completed batch into out_array as a struct array (one child per column)
+     * and describes it in out_schema. The consumer owns both structs after this call
+     * and must invoke their release callbacks. Returns false if no completed batch exists
+     */
+    bool export_next_batch(ArrowArray* out_array, ArrowSchema* out_schema);
+    /*
+     * Schema alone - valid even when no batches were produced
+     */
+    void export_schema(ArrowSchema* out_schema) const;
+  private:
+    void seal_current_batch();
+  private:
+    int64_t m_max_num_rows_per_batch;
+    //query idx for each column, UNDEFINED_ATTRIBUTE_IDX_VALUE for row, column, END
+    std::vector<unsigned> m_column_query_idx;
+    std::unique_ptr<ColumnarBatch> m_current_batch;
+    std::deque<std::shared_ptr<ColumnarBatch>> m_completed_batches;
+};
+
+/*
+ * C++ entry point - runs a query specified through JSON configuration files and
+ * produces record batches through ColumnarExportOperator. Batches are produced lazily - the
+ * scan is resumed from where it stopped each time a batch is requested, so at most one
+ * partially filled batch is held in memory
+ */
+class GenomicsDBColumnarQuery
+{
+  public:
+    GenomicsDBColumnarQuery(const std::string& loader_config_file, const std::string& query_config_file,
+        const int my_rank=0, const int64_t max_num_rows_per_batch=1048576ll, const size_t tiledb_segment_size=10485760u);
+    //Delete copy and move constructors
+    GenomicsDBColumnarQuery(const GenomicsDBColumnarQuery& other) = delete;
+    GenomicsDBColumnarQuery(GenomicsDBColumnarQuery&& other) = delete;
+    ~GenomicsDBColumnarQuery();
+    /*
+     * Scans till the next batch is complete and exports it - see ColumnarExportOperator::export_next_batch()
+     * Returns false once the query is exhausted
+     */
+    bool export_next_batch(ArrowArray* out_array, ArrowSchema* out_schema);
+    void export_schema(ArrowSchema* out_schema) const { m_operator->export_schema(out_schema); }
+    bool end() const { return m_done && m_operator->get_num_completed_batches() == 0u; }
+  private:
+    FileBasedVidMapper m_vid_mapper;
+    VariantQueryConfig m_query_config;
+    VariantStorageManager* m_storage_manager;
+    VariantQueryProcessor* m_query_processor;
+    ColumnarExportOperator* m_operator;
+    VariantQueryProcessorScanState m_scan_state;
+    unsigned m_column_interval_idx;
+    unsigned m_num_column_intervals;
+    bool m_done;
+};
+
+#endif
@@ -0,0 +1,257 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GENOTYPE_MATRIX_H
+#define GENOTYPE_MATRIX_H
+
+#include <memory>
+#include "variant_storage_manager.h"
+#include "query_variants.h"
+#include "vid_mapper.h"
+
+//Exceptions thrown
+class GenotypeMatrixException : public std::exception {
+  public:
+    GenotypeMatrixException(const std::string m="") : msg_("Genotype matrix exception : "+m) { ; }
+    ~GenotypeMatrixException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * 2 bit - 4 samples per byte, sample i in bits [2*(i%4), 2*(i%4)+1] of byte i/4
+ *   0: hom-ref, 1: het, 2: hom-alt (all alleles non-ref), 3: missing
+ * 8 bit - 1 byte per sample, #non-ref alleles (capped at 254), 255: missing
+ */
+enum GenotypeMatrixEncodingEnum
+{
+  GENOTYPE_MATRIX_ENCODING_2BIT=0,
+  GENOTYPE_MATRIX_ENCODING_8BIT
+};
+
+template<int Encoding>
+struct GenotypeMatrixEncodingTraits;
+
+template<>
+struct GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_2BIT>
+{
+  static const uint8_t m_hom_ref = 0u;
+  static const uint8_t m_missing = 3u;
+  static inline uint64_t get_num_bytes_per_site(const uint64_t num_samples) { return (num_samples+3u) >> 2u; }
+  static inline uint8_t encode(const unsigned num_alleles, const unsigned num_non_ref_alleles)
+  {
+    return (num_non_ref_alleles == 0u) ? 0u : ((num_non_ref_alleles == num_alleles) ? 2u : 1u);
+  }
+  //Site row is initialized with the missing value for all samples
+  static inline void set(uint8_t* site_ptr, const uint64_t sample_idx, const uint8_t code)
+  {
+    auto shift = (sample_idx & 3u) << 1u;
+    auto& byte = site_ptr[sample_idx >> 2u];
+    byte = (byte & ~(3u << shift)) | (code << shift);
+  }
+  static inline uint8_t get(const uint8_t* site_ptr, const uint64_t sample_idx)
+  {
+    return (site_ptr[sample_idx >> 2u] >> ((sample_idx & 3u) << 1u)) & 3u;
+  }
+};
+
+template<>
+struct GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_8BIT>
+{
+  static const uint8_t m_hom_ref = 0u;
+  static const uint8_t m_missing = 255u;
+  static inline uint64_t get_num_bytes_per_site(const uint64_t num_samples) { return num_samples; }
+  static inline uint8_t encode(const unsigned num_alleles, const unsigned num_non_ref_alleles)
+  {
+    return std::min<unsigned>(num_non_ref_alleles, 254u);
+  }
+  static inline void set(uint8_t* site_ptr, const uint64_t sample_idx, const uint8_t code)
+  {
+    site_ptr[sample_idx] = code;
+  }
+  static inline uint8_t get(const uint8_t* site_ptr, const uint64_t sample_idx)
+  {
+    return site_ptr[sample_idx];
+  }
+};
+
+/*
+ * Dense sample x site genotype matrix - site major, each site occupies get_num_bytes_per_site()
+ * bytes. Optional GQ and DP matrices (int32, bcf_int32_missing if unavailable) share the layout
+ * with one element per sample
+ */
+class GenotypeMatrix
+{
+  public:
+    GenotypeMatrix(const uint64_t num_samples, const GenotypeMatrixEncodingEnum encoding,
+        const bool store_GQ_DP=false);
+    void clear();
+    inline GenotypeMatrixEncodingEnum get_encoding() const { return m_encoding; }
+    inline uint64_t get_num_samples() const { return m_num_samples; }
+    inline uint64_t get_num_sites() const { return m_site_columns.size(); }
+    inline uint64_t get_num_bytes_per_site() const { return m_num_bytes_per_site; }
+    inline bool stores_GQ_DP() const { return m_store_GQ_DP; }
+    /*
+     * Appends a site with all samples missing, returns site idx
+     */
+    uint64_t add_site(const int64_t column);
+    template<int Encoding>
+    inline void set_genotype(const uint64_t site_idx, const uint64_t sample_idx, const uint8_t code)
+    {
+      assert(Encoding == m_encoding && site_idx < get_num_sites() && sample_idx < m_num_samples);
+      GenotypeMatrixEncodingTraits<Encoding>::set(&(m_genotypes[site_idx*m_num_bytes_per_site]), sample_idx, code);
+    }
+    inline void set_GQ_DP(const uint64_t site_idx, const uint64_t sample_idx, const int GQ, const int DP)
+    {
+      assert(m_store_GQ_DP && site_idx < get_num_sites() && sample_idx < m_num_samples);
+      m_GQ[site_idx*m_num_samples+sample_idx] = GQ;
+      m_DP[site_idx*m_num_samples+sample_idx] = DP;
+    }
+    /*
+     * Code as defined in GenotypeMatrixEncodingEnum
+     */
+    uint8_t get_genotype(const uint64_t site_idx, const uint64_t sample_idx) const;
+    const std::vector<int64_t>& get_site_columns() const { return m_site_columns; }
+    const std::vector<uint8_t>& get_genotypes() const { return m_genotypes; }
+    const std::vector<int>& get_GQ() const { return m_GQ; }
+    const std::vector<int>& get_DP() const { return m_DP; }
+  private:
+    GenotypeMatrixEncodingEnum m_encoding;
+    uint64_t m_num_samples;
+    uint64_t m_num_bytes_per_site;
+    bool m_store_GQ_DP;
+    std::vector<int64_t> m_site_columns;
+    std::vector<uint8_t> m_genotypes;
+    std::vector<int> m_GQ;
+    std::vector<int> m_DP;
+};
+
+/*
+ * GT only fast path - consumes TileDB cells directly without building Variant/VariantCall objects.
+ * Cells must be traversed in column major order over a single column interval. A site is emitted
+ * at every column where at least one sample has a cell beginning with a non-ref GT allele. At a
+ * site, samples whose cell begins at the site get their own GT, samples inside a hom-ref interval
+ * (reference block or hom-ref deletion) are hom-ref and all others are missing - including
+ * samples spanned by a variant interval (spanning deletions). Intervals overlapping the queried
+ * begin are found through their END copies (DUPLICATE_CELL_AT_END), so the scan continues past the
+ * queried end until every sample has been seen or no END copy can overlap the queried begin
+ */
+class GenotypeMatrixOperator
+{
+  public:
+    /*
+     * Query idxs are the positions of the fields in the attribute list passed to the iterator, GQ/DP
+     * idxs are ignored if the matrix does not store them
+     */
+    GenotypeMatrixOperator(const VariantQueryConfig& query_config, GenotypeMatrix& matrix,
+        const unsigned END_query_idx, const unsigned GT_query_idx,
+        const unsigned GQ_query_idx=UNDEFINED_ATTRIBUTE_IDX_VALUE, const unsigned DP_query_idx=UNDEFINED_ATTRIBUTE_IDX_VALUE);
+    /*
+     * Starts a new column interval [begin, end]
+     */
+    void reset(const int64_t begin, const int64_t end);
+    /*
+     * Returns false once no more cells are needed for the current interval
+     */
+    template<int Encoding>
+    bool operate(const BufferVariantCell& cell);
+    /*
+     * Must be called after the last cell of the interval
+     */
+    template<int Encoding>
+    void finalize();
+  private:
+    struct SampleState
+    {
+      int64_t m_begin;
+      int64_t m_end;
+      int m_GQ;
+      int m_DP;
+      uint8_t m_code;
+      bool m_is_hom_ref;
+      bool m_seen;
+    };
+    template<int Encoding>
+    void fill_state(const BufferVariantCell& cell, SampleState& state) const;
+    template<int Encoding>
+    void finalize_current_column();
+    //Sample was first seen through an END copy - interval begins before the queried begin
+    template<int Encoding>
+    void update_emitted_sites(const uint64_t sample_idx);
+  private:
+    const VariantQueryConfig* m_query_config;
+    GenotypeMatrix* m_matrix;
+    unsigned m_END_query_idx;
+    unsigned m_GT_query_idx;
+    unsigned m_GQ_query_idx;
+    unsigned m_DP_query_idx;
+    int64_t m_interval_begin;
+    int64_t m_interval_end;
+    uint64_t m_interval_first_site_idx;
+    uint64_t m_num_samples_seen;
+    int64_t m_current_column;
+    bool m_current_column_has_variant;
+    std::vector<SampleState> m_sample_states;
+};
+
+/*
+ * C++ entry point - runs the query specified through JSON configuration files fetching only
+ * END, GT and optionally GQ/DP. The attributes list of the query JSON is ignored
+ */
+class GenomicsDBGenotypeMatrixQuery
+{
+  public:
+    GenomicsDBGenotypeMatrixQuery(const std::string& loader_config_file, const std::string& query_config_file,
+        const int my_rank=0, const GenotypeMatrixEncodingEnum encoding=GENOTYPE_MATRIX_ENCODING_2BIT,
+        const bool fetch_GQ_DP=false, const size_t tiledb_segment_size=10485760u);
+    //Delete copy and move constructors
+    GenomicsDBGenotypeMatrixQuery(const GenomicsDBGenotypeMatrixQuery& other) = delete;
+    GenomicsDBGenotypeMatrixQuery(GenomicsDBGenotypeMatrixQuery&& other) = delete;
+    const GenotypeMatrix& get_matrix() const { return *m_matrix; }
+    /*
+     * Array row idx of each sample (column of the matrix)
+     */
+    int64_t get_array_row_idx_for_sample(const uint64_t sample_idx) const
+    { return m_query_config.get_array_row_idx_for_query_row_idx(sample_idx); }
+    /*
+     * Appends the sites of every column interval of the query (whole array if none) to matrix.
+     * Bookkeeping must be done on query_config, with GQ/DP queried if the matrix stores them
+     */
+    static void fill_matrix(const VariantStorageManager& storage_manager, const int ad,
+        const VariantQueryConfig& query_config, GenotypeMatrix& matrix);
+  private:
+    template<int Encoding>
+    static void scan_column_interval(const VariantStorageManager& storage_manager, const int ad,
+        const VariantQueryConfig& query_config, GenotypeMatrixOperator& matrix_operator,
+        const int64_t begin, const int64_t end);
+  private:
+    FileBasedVidMapper m_vid_mapper;
+    VariantQueryConfig m_query_config;
+    std::unique_ptr<VariantStorageManager> m_storage_manager;
+    std::unique_ptr<VariantQueryProcessor> m_query_processor;
+    std::unique_ptr<GenotypeMatrix> m_matrix;
+};
+
+#endif
@@ -25,6 +25,7 @@
 
 #include "variant.h"
 #include "lut.h"
+#include "histogram.h"
 
 class VariantOperationException : public std::exception {
   public:
@@ -86,6 +87,49 @@ class RemappedVariant : public RemappedDataWrapperBase
     unsigned m_queried_field_idx;
 };
 
+/*
+ * Dictionary of ALT alleles seen at a single site - maps allele strings to their idx in the merged
+ * ALT list. Re-used across sites: clear() only resets the slots used at the previous site, so no
+ * memory is allocated in the common case. Allele strings are not stored in the dictionary - slots hold
+ * precomputed hashes and the strings are compared against the merged ALT list itself.
+ * Single base A/C/G/T alleles bypass hashing altogether
+ */
+class InternedAlleleDictionary
+{
+  public:
+    InternedAlleleDictionary(const unsigned initial_num_slots=64u);
+    void clear();
+    /*
+     * Returns the merged allele idx (1-based, 0 is REF) of allele+suffix where suffix is
+     * [suffix_ptr, suffix_ptr+suffix_length). If allele+suffix is seen for the first time at this
+     * site, it's appended to merged_alt_alleles and inserted is set to true
+     */
+    unsigned get_or_insert(const std::string& allele, const char* suffix_ptr, const size_t suffix_length,
+        std::vector<std::string>& merged_alt_alleles, bool& inserted);
+  private:
+    static inline int get_SNP_code(const char base)
+    {
+      switch(base)
+      {
+        case 'A': return 0;
+        case 'C': return 1;
+        case 'G': return 2;
+        case 'T': return 3;
+        default: return -1;
+      }
+    }
+    static uint64_t hash(const std::string& allele, const char* suffix_ptr, const size_t suffix_length);
+    void grow();
+    //Open addressing with linear probing - #slots is a power of 2
+    std::vector<uint64_t> m_slot_hashes;
+    //Merged allele idx stored in each slot, 0 if empty
+    std::vector<unsigned> m_slot_merged_idx;
+    std::vector<unsigned> m_used_slots;
+    uint64_t m_slot_mask;
+    //Merged allele idx of A/C/G/T, 0 if not seen
+    unsigned m_SNP_merged_idx[4];
+};
+
 class VariantOperations
 {
   public:
@@ -101,6 +145,14 @@ class VariantOperations
         const VariantQueryConfig& query_config,
         const std::string& merged_reference_allele,
         CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists);
+    /*
+     * Same as above, re-uses the allele dictionary and the NON_REF idx vector across sites
+     */
+    static void merge_alt_alleles(const Variant& variant,
+        const VariantQueryConfig& query_config,
+        const std::string& merged_reference_allele,
+        CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists,
+        InternedAlleleDictionary& allele_dictionary, std::vector<int>& input_non_reference_allele_idx);
     /*
      * Remaps GT field of Calls in the combined Variant based on new allele order
      */
@@ -163,6 +215,9 @@ class SingleVariantOperatorBase
     //Merged reference allele and ALT alleles
     std::string m_merged_reference_allele;
     std::vector<std::string> m_merged_alt_alleles;
+    //Re-used across sites while merging ALT alleles
+    InternedAlleleDictionary m_allele_dictionary;
+    std::vector<int> m_input_non_reference_allele_idx;
     //Flag that determines if any allele re-ordering occurred and whether fields such
     //as PL/AD need to be re-ordered
     bool m_remapping_needed;
@@ -339,6 +394,11 @@ class VariantFieldHandler : public VariantFieldHandlerBase
     std::vector<DataType> m_element_wise_operations_result;
 };
 
+//Mean is undefined for strings
+template<>
+bool VariantFieldHandler<std::string>::get_valid_mean(const Variant& variant, const VariantQueryConfig& query_config,
+    unsigned query_idx, void* output_ptr, unsigned& num_valid_elements);
+
 /*
  * Copies info in Variant object into its result vector
  */
@@ -370,6 +430,11 @@ class SingleCellOperatorBase
   public:
     SingleCellOperatorBase() { ; }
     virtual void operate(VariantCall& call, const VariantQueryConfig& query_config, const VariantArraySchema& schema)  { ; }
+    /*
+     * Return true in child class if some output buffer used by the operator
+     * is full. Default implementation: return false
+     */
+    virtual bool overflow() const { return false; }
 };
 
 class ColumnHistogramOperator : public SingleCellOperatorBase
@@ -377,7 +442,28 @@ class ColumnHistogramOperator : public SingleCellOperatorBase
   public:
     ColumnHistogramOperator(uint64_t begin, uint64_t end, uint64_t bin_size);
     virtual void operate(VariantCall& call, const VariantQueryConfig& query_config, const VariantArraySchema& schema);
+    void add_cells(const uint64_t column, const uint64_t num_cells);
+    /*
+     * The histogram stored in the array metadata describes all rows of the array at its own bin
+     * size - it can replace a scan only if its bins are no wider than the bins of this operator and
+     * the query is not restricted to a subset of rows, columns or to cells passing filters
+     */
+    bool can_use_column_cell_histogram(const ColumnCellHistogram& histogram,
+        const VariantQueryConfig& query_config) const;
+    /*
+     * Fills bins from the histogram stored in the array metadata instead of scanning the array
+     * Stored bins are clipped to [begin, end] and their cells are spread uniformly over the columns
+     * they cover, so that a stored bin that straddles two bins of this operator is split between them
+     */
+    void add_column_cell_histogram(const ColumnCellHistogram& histogram);
     bool equi_partition_and_print_bins(uint64_t num_bins, std::ostream& fptr=std::cout) const; 
+    /*
+     * Merges consecutive bins into at most num_partitions column ranges with roughly equal #cells
+     * Returns false if num_partitions is not smaller than the number of bins
+     */
+    bool equi_partition_bins(uint64_t num_partitions, std::vector<ColumnRange>& column_ranges,
+        std::vector<uint64_t>& num_cells) const;
+    const std::vector<uint64_t>& get_bin_counts() const { return m_bin_counts_vector; }
   private:
     std::vector<uint64_t> m_bin_counts_vector;
     uint64_t m_begin_column;
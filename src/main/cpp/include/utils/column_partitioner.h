@@ -0,0 +1,89 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef COLUMN_PARTITIONER_H
+#define COLUMN_PARTITIONER_H
+
+#include "headers.h"
+#include "histogram.h"
+#include "vid_mapper.h"
+
+class JSONConfigBase;
+
+//Exceptions thrown
+class ColumnPartitionerException : public std::exception {
+  public:
+    ColumnPartitionerException(const std::string m="") : msg_("ColumnPartitionerException : "+m) { ; }
+    ~ColumnPartitionerException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+//Max #input VCFs whose indexes are sampled while estimating density
+#define DEFAULT_MAX_NUM_VCF_INDEXES_SAMPLED 32u
+
+/*
+ * Splits the column domain into partitions with roughly equal work. Work is estimated from the
+ * contig lengths in the VidMapper plus, if available, a density histogram - either sampled from the
+ * tabix indexes of the input VCFs (load time) or the histogram stored in the array metadata (query
+ * time). Partitions are contiguous and together cover the whole column domain, so every cell
+ * belongs to exactly one partition. The result is deterministic for a given set of inputs, so every
+ * MPI rank can compute it independently
+ */
+class LoadBalancedColumnPartitioner
+{
+  public:
+    LoadBalancedColumnPartitioner(const VidMapper& vid_mapper,
+        const uint64_t bin_size=DEFAULT_COLUMN_CELL_HISTOGRAM_BIN_SIZE);
+    /*
+     * Estimates #bytes per column bin from the index of every k-th file so that at most max_num_files
+     * indexes are read. Handles both tabix indexed .vcf.gz and CSI indexed BCF files - files
+     * without an index are skipped
+     * Returns the number of indexes sampled
+     */
+    unsigned add_density_from_vcf_indexes(const std::vector<std::string>& filenames,
+        const unsigned max_num_files=DEFAULT_MAX_NUM_VCF_INDEXES_SAMPLED);
+    //Uses #bytes per bin of the histogram maintained by the loader
+    void add_density_from_histogram(const ColumnCellHistogram& histogram);
+    bool has_density() const { return !m_density.empty(); }
+    /*
+     * Exactly num_partitions contiguous ranges - the first begins at 0 and the last ends at INT64_MAX-1
+     * Regions without any density information still carry a small weight proportional to their length
+     */
+    void partition(const unsigned num_partitions, std::vector<ColumnRange>& partitions) const;
+    /*
+     * "column_partitions" : "auto" in a loader JSON without partitions stored by a previous load -
+     * computes the partitions from the indexes of the input files and sets them in json_config
+     */
+    static void initialize_auto_column_partitions(JSONConfigBase& json_config);
+  private:
+    //Returns false if the file cannot be opened or has no index
+    bool add_density_from_vcf_index(const std::string& filename);
+    const VidMapper* m_vid_mapper;
+    uint64_t m_bin_size;
+    ColumnCellHistogram m_density;
+};
+
+#endif
@@ -0,0 +1,159 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef GENOMICSDB_PROFILER_H
+#define GENOMICSDB_PROFILER_H
+
+#include "headers.h"
+#include <atomic>
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#else
+#include <chrono>
+#endif
+
+class Timer;
+
+//Instrumented code regions - names are in g_profiler_span_names in genomicsdb_profiler.cc
+enum GenomicsDBProfilerSpanEnum
+{
+  PROFILER_SPAN_TILEDB_ITERATOR_INIT=0u,
+  PROFILER_SPAN_TILEDB_ITERATOR_NEXT,
+  PROFILER_SPAN_TILEDB_TO_BUFFER_CELL,
+  PROFILER_SPAN_BCF_T_CREATION,
+  PROFILER_SPAN_BCF_T_SERIALIZATION,
+  PROFILER_SPAN_BCF_GENERATOR,
+  PROFILER_SPAN_LOADER_FETCH,
+  PROFILER_SPAN_LOADER_COMBINE,
+  PROFILER_SPAN_LOADER_FLUSH_OUTPUT,
+  PROFILER_SPAN_LOADER_SINGLE_THREAD_PHASE,
+  PROFILER_SPAN_QUERY_LEFT_SWEEP,
+  PROFILER_SPAN_QUERY_CELL_FILL,
+  PROFILER_SPAN_QUERY_OPERATOR,
+  PROFILER_SPAN_GATHER_QUERY,
+  PROFILER_SPAN_GATHER_SERIALIZATION,
+  PROFILER_SPAN_GATHER_MPI,
+  PROFILER_SPAN_GATHER_DESERIALIZATION,
+  PROFILER_SPAN_GATHER_PRINT,
+  PROFILER_NUM_SPANS
+};
+
+//Counters - names are in g_profiler_counter_names in genomicsdb_profiler.cc
+enum GenomicsDBProfilerCounterEnum
+{
+  PROFILER_COUNTER_TILEDB_CELLS=0u,
+  PROFILER_COUNTER_BCF_RECORDS,
+  PROFILER_COUNTER_BCF_SERIALIZED_BYTES,
+  PROFILER_COUNTER_TILE_CACHE_HITS,
+  PROFILER_COUNTER_TILE_CACHE_MISSES,
+  PROFILER_COUNTER_TILE_CACHE_BYPASSES,
+  PROFILER_COUNTER_QUERY_CELLS,
+  PROFILER_COUNTER_QUERY_LEFT_SWEEP_CELLS,
+  PROFILER_COUNTER_QUERY_VALID_CELLS,
+  PROFILER_COUNTER_QUERY_ATTRIBUTE_CELLS,
+  PROFILER_COUNTER_QUERY_OPERATOR_INVOCATIONS,
+  PROFILER_COUNTER_QUERY_FILTERED_CELLS,
+  PROFILER_COUNTER_QUERY_SKIPPED_REFERENCE_INTERVALS,
+  PROFILER_COUNTER_GATHER_RECEIVED_BYTES,
+  PROFILER_NUM_COUNTERS
+};
+
+//Report formats - bitmask
+#define PROFILER_OUTPUT_JSON 1u
+#define PROFILER_OUTPUT_CSV 2u
+#define PROFILER_OUTPUT_TRACE 4u
+
+//Environment variables used to enable the profiler without changing JSON configs
+#define PROFILER_OUTPUT_PREFIX_ENV_VAR "GENOMICSDB_PROFILE"
+#define PROFILER_OUTPUT_FORMATS_ENV_VAR "GENOMICSDB_PROFILE_FORMATS"
+
+/*
+ * Low overhead instrumentation, always compiled in. When disabled, every probe costs a single
+ * relaxed atomic load. When enabled, spans are timed with the cycle counter (rdtsc on x86) and
+ * accumulated in per-thread counters - no locks on the hot path.
+ * A report per rank is written to <output_prefix>.rank<rank>.{json,csv,trace.json} at process exit
+ * (or when write_report() is called). The .trace.json file uses the Chrome trace event format
+ */
+class GenomicsDBProfiler
+{
+  public:
+    static inline bool is_enabled() { return m_enabled.load(std::memory_order_relaxed); }
+    /*
+     * formats - comma separated subset of json,csv,trace
+     * Subsequent calls are ignored once the profiler is enabled
+     */
+    static void enable(const std::string& output_prefix, const std::string& formats="json", const int rank=0);
+    //Enables the profiler if GENOMICSDB_PROFILE is set
+    static void enable_from_environment(const int rank=0);
+    static void write_report();
+    static inline uint64_t get_ticks()
+    {
+#if defined(__x86_64__) || defined(__i386__)
+      return __rdtsc();
+#else
+      return std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+    }
+    static void record_span(const unsigned span_idx, const uint64_t begin_ticks, const uint64_t end_ticks);
+    //For spans that do not map to a single block - begin_span() returns 0 if the profiler is disabled
+    static inline uint64_t begin_span() { return is_enabled() ? get_ticks() : 0ull; }
+    static inline void end_span(const unsigned span_idx, const uint64_t begin_ticks)
+    {
+      if(begin_ticks)
+        record_span(span_idx, begin_ticks, get_ticks());
+    }
+    static inline void increment_counter(const unsigned counter_idx, const uint64_t val=1u)
+    {
+      if(is_enabled())
+        add_to_counter(counter_idx, val);
+    }
+    //Cumulative and critical path times of existing Timer objects are included in the report
+    static void record_timer(const std::string& name, const Timer& timer);
+  private:
+    static void add_to_counter(const unsigned counter_idx, const uint64_t val);
+    static std::atomic<bool> m_enabled;
+};
+
+/*
+ * Scoped span - times the enclosing block if the profiler is enabled
+ */
+class ProfilerSpan
+{
+  public:
+    ProfilerSpan(const unsigned span_idx)
+      : m_span_idx(span_idx)
+    {
+      m_begin_ticks = GenomicsDBProfiler::is_enabled() ? GenomicsDBProfiler::get_ticks() : 0ull;
+    }
+    ~ProfilerSpan()
+    {
+      if(m_begin_ticks)
+        GenomicsDBProfiler::record_span(m_span_idx, m_begin_ticks, GenomicsDBProfiler::get_ticks());
+    }
+    ProfilerSpan(const ProfilerSpan& other) = delete;
+  private:
+    unsigned m_span_idx;
+    uint64_t m_begin_ticks;
+};
+
+#endif
@@ -24,7 +24,6 @@
 #define GT_COMMON_H
 
 #include "headers.h"
-#include "profiling.h"
 
 #include "vcf.h"
 
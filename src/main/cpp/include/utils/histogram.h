@@ -145,4 +145,95 @@ class UniformHistogram : public Histogram
     uint64_t m_size_of_bin;
 };
 
+//Default width of the bins of ColumnCellHistogram - in columns
+#define DEFAULT_COLUMN_CELL_HISTOGRAM_BIN_SIZE 100000ull
+
+/*
+ * Equi-width histogram of #cells and #bytes (uncompressed) per column bin of an array. Kept in the
+ * array metadata and updated incrementally on every load so that partitions can be planned without
+ * scanning the array or the input VCFs. Bins are sparse as the column domain spans all contigs
+ * Only cells at the begin column of an interval are counted, copies at END are not
+ */
+class ColumnCellHistogram
+{
+  public:
+    struct BinCounts
+    {
+      BinCounts() : m_num_cells(0ull), m_num_bytes(0ull) { ; }
+      uint64_t m_num_cells;
+      uint64_t m_num_bytes;
+    };
+    ColumnCellHistogram(const uint64_t bin_size=DEFAULT_COLUMN_CELL_HISTOGRAM_BIN_SIZE)
+    {
+      m_bin_size = bin_size;
+      reset_last_bin();
+    }
+    ColumnCellHistogram(const ColumnCellHistogram& other)
+      : m_bin_size(other.m_bin_size), m_bins(other.m_bins)
+    {
+      reset_last_bin();
+    }
+    ColumnCellHistogram(ColumnCellHistogram&& other)
+      : m_bin_size(other.m_bin_size), m_bins(std::move(other.m_bins))
+    {
+      reset_last_bin();
+      other.reset_last_bin();
+    }
+    ColumnCellHistogram& operator=(const ColumnCellHistogram& other)
+    {
+      m_bin_size = other.m_bin_size;
+      m_bins = other.m_bins;
+      reset_last_bin();
+      return *this;
+    }
+    void clear()
+    {
+      m_bins.clear();
+      reset_last_bin();
+    }
+    bool empty() const { return m_bins.empty(); }
+    uint64_t get_bin_size() const { return m_bin_size; }
+    //Bin size can be changed only if the histogram is empty
+    void set_bin_size(const uint64_t bin_size);
+    uint64_t get_lo(const uint64_t bin_idx) const { return bin_idx*m_bin_size; }
+    uint64_t get_hi(const uint64_t bin_idx) const { return (bin_idx+1u)*m_bin_size-1u; }
+    //Cells are added in column order while loading - avoid a map lookup per cell
+    inline void add_cell(const int64_t column, const uint64_t num_bytes)
+    {
+      assert(column >= 0);
+      auto bin_idx = static_cast<uint64_t>(column)/m_bin_size;
+      if(m_last_bin_counts == 0 || bin_idx != m_last_bin_idx)
+      {
+        m_last_bin_idx = bin_idx;
+        m_last_bin_counts = &(m_bins[bin_idx]);
+      }
+      ++(m_last_bin_counts->m_num_cells);
+      m_last_bin_counts->m_num_bytes += num_bytes;
+    }
+    void add_bin(const uint64_t bin_idx, const uint64_t num_cells, const uint64_t num_bytes);
+    void sum_up_histogram(const ColumnCellHistogram& other);
+    const std::map<uint64_t, BinCounts>& get_bins() const { return m_bins; }
+    uint64_t get_total_num_cells() const;
+    uint64_t get_total_num_bytes() const;
+    /*
+     * Merges consecutive bins into at most num_partitions column ranges with roughly equal #cells
+     * (or #bytes). Ranges are contiguous - the first range begins at the lowest non-empty bin and the
+     * last range ends at the highest non-empty bin. Returns false if the histogram is empty
+     */
+    bool equi_partition(const uint64_t num_partitions, std::vector<ColumnRange>& column_ranges,
+        std::vector<uint64_t>& counts, const bool balance_bytes=false) const;
+    void print(std::ostream& fptr=std::cout) const;
+  private:
+    void reset_last_bin()
+    {
+      m_last_bin_idx = 0ull;
+      m_last_bin_counts = 0;
+    }
+    uint64_t m_bin_size;
+    std::map<uint64_t, BinCounts> m_bins;
+    //Cached bin of the last cell added
+    uint64_t m_last_bin_idx;
+    BinCounts* m_last_bin_counts;
+};
+
 #endif
@@ -26,6 +26,7 @@
 #include "variant_query_config.h"
 #include "vcf_adapter.h"
 #include "vid_mapper.h"
+#include "fragment_consolidation_policy.h"
 
 #include "rapidjson/document.h"
 #include "rapidjson/reader.h"
@@ -58,6 +59,10 @@ class JSONConfigBase
       m_single_query_row_ranges_vector = false;
       m_row_partitions_specified = false;
       m_scan_whole_array = false;
+      m_auto_column_partitions = false;
+      m_compute_auto_column_partitions = false;
+      m_auto_query_column_ranges = false;
+      m_num_auto_column_partitions = 0u;
       //Lower and upper bounds of callset row idx to import in this invocation
       m_lb_callset_row_idx = 0;
       m_ub_callset_row_idx = INT64_MAX-1;
@@ -75,7 +80,52 @@ class JSONConfigBase
     void read_and_initialize_vid_and_callset_mapping_if_available(FileBasedVidMapper* id_mapper, const int rank);
     const std::vector<ColumnRange>& get_query_column_ranges(const int rank) const;
     const std::vector<RowRange>& get_query_row_ranges(const int rank) const;
+    /*
+     * With "column_partitions" : "auto", stores the computed partitions in the workspace so that later
+     * incremental loads and queries use the same partitions. No-op otherwise
+     */
+    void store_auto_column_partitions(const int rank) const;
+    /*
+     * Set by the loader before parsing: "column_partitions" : "auto" without partitions stored by a
+     * previous load is accepted only if this is set, all other parses require the stored partitions
+     */
+    inline void set_compute_auto_column_partitions(bool val) { m_compute_auto_column_partitions = val; }
+    /*
+     * "auto" partitions and query ranges are only recorded by the parser - they are computed from the
+     * input files or the arrays by the loader and the query processor and set here
+     */
+    inline bool needs_auto_column_partitions() const
+    { return m_auto_column_partitions && m_sorted_column_partitions.empty(); }
+    inline bool needs_auto_query_column_ranges() const
+    { return m_auto_query_column_ranges && m_column_ranges.empty(); }
+    inline unsigned get_num_auto_column_partitions() const { return m_num_auto_column_partitions; }
+    void set_auto_column_partitions(const std::vector<ColumnRange>& partitions);
+    void set_auto_query_column_ranges(const std::vector<ColumnRange>& ranges);
+    //Distinct (workspace, array) pairs of all ranks
+    void get_workspaces_and_arrays(std::set<std::pair<std::string, std::string>>& workspace_array_pairs) const;
+    inline const std::string& get_vid_mapping_filename() const { return m_vid_mapping_file; }
+    inline const std::string& get_callset_mapping_filename() const { return m_callset_mapping_file; }
+    inline RowRange get_row_bounds() const { return RowRange(m_lb_callset_row_idx, m_ub_callset_row_idx); }
+    //"profile" : "<output_prefix>" or { "output_prefix" : "..", "formats" : ".." } - empty if not specified
+    inline const std::string& get_profile_output_prefix() const { return m_profile_output_prefix; }
+    inline const std::string& get_profile_formats() const { return m_profile_formats; }
+    //"tile_cache" : <bytes> or { "size" : <bytes>, "tile_width" : <#columns> } - -1 and 0 if not specified
+    inline int64_t get_tile_cache_size() const { return m_tile_cache_size; }
+    inline int64_t get_tile_cache_tile_width() const { return m_tile_cache_tile_width; }
+    //"ga4gh_paging_cursors" : { "ttl" : <seconds>, "max_num_cursors" : <#>, "max_size" : <bytes> } - -1 if not specified
+    inline int64_t get_ga4gh_paging_cursor_ttl() const { return m_ga4gh_paging_cursor_ttl; }
+    inline int64_t get_ga4gh_max_num_paging_cursors() const { return m_ga4gh_max_num_paging_cursors; }
+    inline int64_t get_ga4gh_paging_cursors_max_size() const { return m_ga4gh_paging_cursors_max_size; }
+    /*
+     * Total buffer memory per TileDB array iterator, split among the queried attributes based on
+     * cell sizes - 0 if not specified in the JSON
+     */
+    inline size_t get_iterator_memory_budget() const { return m_iterator_memory_budget; }
   protected:
+    //"column_partitions" : "auto" - balanced partitions computed from contig lengths and data density
+    void initialize_auto_column_partitions();
+    //"query_column_ranges" : "auto" - column domain split into balanced ranges, one per rank
+    void initialize_auto_query_column_ranges();
     bool m_single_workspace_path;
     bool m_single_array_name;
     bool m_single_query_column_ranges_vector;
@@ -83,6 +133,10 @@ class JSONConfigBase
     bool m_single_query_row_ranges_vector;
     bool m_row_partitions_specified;
     bool m_scan_whole_array;
+    bool m_auto_column_partitions;
+    bool m_compute_auto_column_partitions;
+    bool m_auto_query_column_ranges;
+    unsigned m_num_auto_column_partitions;
     rapidjson::Document m_json;
     std::vector<std::string> m_workspaces;
     std::vector<std::string> m_array_names;
@@ -98,6 +152,16 @@ class JSONConfigBase
     std::string m_vid_mapping_file;
     //callset mapping file - if defined in upper level config file
     std::string m_callset_mapping_file;
+    //"iterator_memory_budget" : bytes
+    size_t m_iterator_memory_budget;
+    //Process wide settings - applied by the query processor and the loader
+    std::string m_profile_output_prefix;
+    std::string m_profile_formats;
+    int64_t m_tile_cache_size;
+    int64_t m_tile_cache_tile_width;
+    int64_t m_ga4gh_paging_cursor_ttl;
+    int64_t m_ga4gh_max_num_paging_cursors;
+    int64_t m_ga4gh_paging_cursors_max_size;
 };
 
 class JSONLoaderConfig;
@@ -134,14 +198,16 @@ class JSONLoaderConfig : public JSONConfigBase
     inline size_t get_segment_size() const { return m_segment_size; }
     inline size_t get_num_cells_per_tile() const { return m_num_cells_per_tile; }
     inline int64_t get_tiledb_compression_level() const { return m_tiledb_compression_level; }
-    inline const std::string& get_vid_mapping_filename() const { return m_vid_mapping_file; }
-    inline const std::string& get_callset_mapping_filename() const { return m_callset_mapping_file; }
-    inline RowRange get_row_bounds() const { return RowRange(m_lb_callset_row_idx, m_ub_callset_row_idx); }
     inline void set_vid_mapper_file_required(bool val) {
       m_vid_mapper_file_required = val;
     }
     inline bool fail_if_updating() const { return m_fail_if_updating; }
     inline bool consolidate_tiledb_array_after_load() const { return m_consolidate_tiledb_array_after_load; }
+    //Incremental loads - consolidate only when the policy asks for it
+    inline bool use_fragment_consolidation_policy() const { return m_use_fragment_consolidation_policy; }
+    inline const FragmentConsolidationPolicy& get_fragment_consolidation_policy() const
+    { return m_fragment_consolidation_policy; }
+    inline bool consolidate_in_background() const { return m_consolidate_in_background; }
   protected:
     bool m_standalone_converter_process;
     bool m_treat_deletions_as_intervals;
@@ -179,6 +245,10 @@ class JSONLoaderConfig : public JSONConfigBase
     bool m_fail_if_updating;
     //consolidate TileDB array after load - merges fragments
     bool m_consolidate_tiledb_array_after_load;
+    //size tiered consolidation for incremental loads
+    bool m_use_fragment_consolidation_policy;
+    FragmentConsolidationPolicy m_fragment_consolidation_policy;
+    bool m_consolidate_in_background;
 };
 
 #ifdef HTSDIR
@@ -22,7 +22,15 @@
 
 #include "query_variants.h"
 #include "vid_mapper.h"
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
 
+//Lazily created TileDB objects of a db_query_* call - not thread safe, see VariantQueryService
 class Factory {
   private:
     VariantStorageManager *sm;
@@ -51,9 +59,6 @@ class Factory {
         clear();
     }
 
-    //Stats struct
-    GTProfileStats stats;
-
     // Get functions that do lazy initialization of the Tile DB Objects
     VariantStorageManager *getStorageManager(std::string &workspace);
     VariantQueryProcessor *getVariantQueryProcessor(std::string &workspace, 
@@ -61,6 +66,135 @@ class Factory {
                                                     const VidMapper& vid_mapper);
 };
 
+/*
+ * Paging cursor that keeps the storage manager and query processor used by its iterator alive
+ * between pages of db_query_column_range()
+ */
+class FactoryPagingCursor : public GA4GHPagingCursor {
+  public:
+    FactoryPagingCursor(const std::string& workspace, const std::string& array_name)
+      : GA4GHPagingCursor(), m_workspace(workspace), m_array_name(array_name) { }
+    ~FactoryPagingCursor() {
+        //Iterator must be deleted before the storage manager
+        discard();
+    }
+    const std::string m_workspace;
+    const std::string m_array_name;
+    Factory m_factory;
+};
+
+//Exceptions thrown
+class VariantQueryServiceException : public std::exception {
+  public:
+    VariantQueryServiceException(const std::string m="") : msg_("VariantQueryServiceException : "+m) { ; }
+    ~VariantQueryServiceException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+/*
+ * Result of an asynchronous request - Variants may point to the query config, so both are returned
+ */
+struct VariantQueryResult {
+    std::shared_ptr<VariantQueryConfig> m_query_config;
+    std::vector<Variant> m_variants;
+};
+
+/*
+ * Thread safe query library for serving many simultaneous queries from one process.
+ * For every (workspace, array) a pool of up to max_sessions_per_array sessions is maintained - each session
+ * has its own storage manager (TileDB context) and query processor with the array open for reading. A
+ * request checks out a session for its duration, so sessions are never shared between threads, and
+ * returns it to the pool for re-use by later requests. Every request uses its own VariantQueryConfig.
+ * Admission control - at most max_sessions_per_array requests run per array, at most max_queued_requests
+ * more wait for a session or a worker thread. Requests beyond that are rejected with a
+ * VariantQueryServiceException instead of queuing without bound.
+ * The query processor of a pool is created with the VidMapper of the request that created the session
+ */
+class VariantQueryService {
+  public:
+    /*
+     * num_worker_threads - threads that run requests submitted through the asynchronous API, 0 for
+     * #cores. Synchronous requests run in the calling thread
+     */
+    VariantQueryService(const unsigned max_sessions_per_array=0u, const unsigned max_queued_requests=1024u,
+        const unsigned num_worker_threads=0u, const size_t segment_size=10u*1024u*1024u);
+    ~VariantQueryService();
+    //Delete copy and move constructors
+    VariantQueryService(const VariantQueryService& other) = delete;
+    VariantQueryService(VariantQueryService&& other) = delete;
+    /*
+     * Synchronous requests - equivalents of db_query_column and db_query_column_range
+     */
+    void query_column(const std::string& workspace, const std::string& array_name,
+        const uint64_t query_interval_idx, Variant& variant, VariantQueryConfig& query_config,
+        const VidMapper& vid_mapper);
+    void query_column_range(const std::string& workspace, const std::string& array_name,
+        const uint64_t query_interval_idx, std::vector<Variant>& variants, VariantQueryConfig& query_config,
+        const VidMapper& vid_mapper, GA4GHPagingInfo* paging_info=0);
+    /*
+     * Asynchronous request - runs all column intervals of query_config on a worker thread
+     * vid_mapper must remain valid until the result is available
+     */
+    std::future<VariantQueryResult> submit_query(const std::string& workspace, const std::string& array_name,
+        const VariantQueryConfig& query_config, const VidMapper& vid_mapper);
+    //#requests running or waiting
+    unsigned get_num_pending_requests() const;
+    uint64_t get_num_rejected_requests() const;
+    /*
+     * Closes idle sessions of all arrays in workspace - e.g. after the arrays are re-loaded. Sessions
+     * in use are closed when their requests complete instead of returning to the pool
+     */
+    void close_idle_sessions(const std::string& workspace);
+  private:
+    struct Session {
+        std::unique_ptr<VariantStorageManager> m_storage_manager;
+        std::unique_ptr<VariantQueryProcessor> m_query_processor;
+        //Generation of the pool when the session was created
+        uint64_t m_generation;
+    };
+    struct SessionPool {
+        SessionPool() : m_num_sessions(0u), m_generation(0ull) { }
+        std::vector<std::unique_ptr<Session>> m_idle_sessions;
+        unsigned m_num_sessions;
+        //Incremented by close_idle_sessions() - older sessions are not returned to the pool
+        uint64_t m_generation;
+        std::condition_variable m_session_available;
+    };
+    //Counts the request as pending, throws if the service is overloaded
+    void admit_request();
+    void finish_request();
+    //Blocks until a session for the array is available
+    std::unique_ptr<Session> acquire_session(const std::string& workspace, const std::string& array_name,
+        const VidMapper& vid_mapper);
+    void release_session(const std::string& workspace, const std::string& array_name, std::unique_ptr<Session> session);
+    void worker_loop();
+  private:
+    unsigned m_max_sessions_per_array;
+    unsigned m_max_pending_requests;
+    size_t m_segment_size;
+    mutable std::mutex m_mutex;
+    //Key - workspace + '/' + array name
+    std::unordered_map<std::string, SessionPool> m_session_pools;
+    unsigned m_num_pending_requests;
+    uint64_t m_num_rejected_requests;
+    //Asynchronous requests
+    bool m_stop_workers;
+    std::deque<std::function<void()>> m_tasks;
+    std::condition_variable m_task_available;
+    std::vector<std::thread> m_workers;
+};
+
+/*
+ * Single threaded query functions - every call opens the array with a new storage manager and query
+ * processor (kept in a paging cursor between pages). Query processors initialize static members on
+ * construction without locking, so these functions must not be called concurrently. Multi-threaded
+ * callers should use VariantQueryService (query_column/query_column_range/submit_query), which also
+ * re-uses open arrays across requests and bounds the #requests in flight
+ */
 extern "C" void db_query_column(std::string workspace, 
                                 std::string array_name, 
                                 uint64_t query_interval_idx, 
@@ -3,11 +3,14 @@
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <sys/types.h>
 
 typedef struct {
   unsigned long size,resident,share,text,lib,data,dt;
 } statm_t;
 
 void read_off_memory_status(statm_t& result, const size_t page_size=4096u);
+//For other processes - returns false if the process does not exist (any more) instead of aborting
+bool read_off_process_memory_status(statm_t& result, const pid_t pid, const size_t page_size=4096u);
 
 #endif
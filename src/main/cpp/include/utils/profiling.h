@@ -1,38 +0,0 @@
-/**
- * The MIT License (MIT)
- * Copyright (c) 2016 Intel Corporation
- *
- * Permission is hereby granted, free of charge, to any person obtaining a copy of 
- * this software and associated documentation files (the "Software"), to deal in 
- * the Software without restriction, including without limitation the rights to 
- * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
- * the Software, and to permit persons to whom the Software is furnished to do so, 
- * subject to the following conditions:
- *
- * The above copyright notice and this permission notice shall be included in all 
- * copies or substantial portions of the Software.
- *
- * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
- * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
- * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
- * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
- * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
- * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
-*/
-
-#ifndef PROFILING_H
-#define PROFILING_H
-
-#ifdef DO_PROFILING
-#include <vector>
-extern uint64_t g_num_disk_loads;
-extern uint64_t g_num_cached_loads;
-extern uint64_t g_coords_num_disk_loads;
-extern uint64_t g_coords_num_cached_loads;
-extern uint64_t g_total_num_tiles_loaded;
-extern std::vector<uint64_t> g_num_tiles_loaded;
-extern std::vector<uint64_t> g_num_segments_loaded;
-#endif
-
-
-#endif
@@ -116,6 +116,11 @@ class Timer
     }
     inline double get_last_interval_wall_clock_time() const { return m_last_interval_wall_clock_time; }
     inline double get_last_interval_cpu_time() const { return m_last_interval_cpu_time; }
+    inline double get_cumulative_wall_clock_time() const { return m_cumulative_wall_clock_time; }
+    inline double get_cumulative_cpu_time() const { return m_cumulative_cpu_time; }
+    inline double get_critical_path_wall_clock_time() const { return m_critical_path_wall_clock_time; }
+    inline double get_critical_path_cpu_time() const { return m_critical_path_cpu_time; }
+    inline uint64_t get_num_times_in_critical_path() const { return m_num_times_in_critical_path; }
     //Critical path updates
     inline void accumulate_critical_path_wall_clock_time(const double val)
     {
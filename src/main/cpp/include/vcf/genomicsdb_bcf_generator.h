@@ -28,6 +28,7 @@
 #include "variant_storage_manager.h"
 #include "query_variants.h"
 #include "timer.h"
+#include "genomicsdb_profiler.h"
 #include "genomicsdb_jni_exception.h"
 
 class GenomicsDBBCFGenerator
@@ -69,7 +70,21 @@ class GenomicsDBBCFGenerator
     size_t read_and_advance(uint8_t* dst, size_t offset, size_t n);
     uint8_t read_next_byte();
     inline bool end() const { return m_done; }
+    /*
+     * Re-targets the generator to a new set of intervals (contig, 1-based start, 1-based end)
+     * without re-parsing the JSON files or re-opening the TileDB array. Unread data from the
+     * previous query is discarded and the stream restarts with the VCF/BCF header, so the
+     * consumer sees exactly what a freshly constructed generator would produce.
+     * If contigs is empty, the whole array is scanned
+     */
+    void reset_query_intervals(const std::vector<std::string>& contigs,
+        const std::vector<int>& starts, const std::vector<int>& ends);
+    /*
+     * Same as above, but intervals are specified as TileDB column ranges
+     */
+    void reset_query_column_intervals(const std::vector<ColumnRange>& column_intervals);
   private:
+    void add_query_interval(const char* chr, const int start, const int end);
     void set_write_buffer();
     void reset_read_buffer();
     void produce_next_batch();
@@ -87,9 +102,6 @@ class GenomicsDBBCFGenerator
     //If using ping-pong buffering, then multiple buffers exist
     std::vector<RWBuffer> m_buffers;
     CircularBufferController m_buffer_control;
-#ifdef DO_PROFILING
-    Timer m_timer;
-#endif
 };
 
 #endif
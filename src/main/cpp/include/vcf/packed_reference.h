@@ -0,0 +1,120 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifndef PACKED_REFERENCE_H
+#define PACKED_REFERENCE_H
+
+#ifdef HTSDIR
+
+#include "headers.h"
+#include <unordered_map>
+
+//Exceptions thrown
+class PackedReferenceException : public std::exception {
+  public:
+    PackedReferenceException(const std::string m="") : msg_("PackedReferenceException : "+m) { ; }
+    ~PackedReferenceException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+#define PACKED_REFERENCE_MAGIC "GDBPKREF"
+#define PACKED_REFERENCE_VERSION 2u
+//Default name of the packed file is <reference_fasta><suffix>
+#define PACKED_REFERENCE_DEFAULT_SUFFIX ".gdbref"
+
+/*
+ * Read-only packed reference genome - produced once from a FASTA file (create_packed_reference tool)
+ * and mmap'd by readers, so the pages are shared by all threads and processes on a node.
+ * Contigs containing only A/C/G/T bases use 2 bits per base, other contigs use 4 bits per base (htslib nt16
+ * codes). Lower case (soft masked) bases are recorded in a 1 bit per base mask, if present, so that
+ * lookups return exactly the character returned by faidx.
+ * Since version 2, the size and modification time of the source FASTA file and its .fai index are stored,
+ * so that stale packed files can be detected (matches_source()).
+ * File layout (native byte order):
+ * magic[8] version[uint32] #contigs[uint32]
+ * fasta_size[uint64] fasta_mtime[int64] fai_size[uint64] fai_mtime[int64] (version >= 2)
+ * per contig: name_length[uint32] name length[uint64] data_offset[uint64] mask_offset[uint64, 0 if no mask] bits_per_base[uint32]
+ * data and masks at the specified offsets (8 byte aligned)
+ */
+class PackedReferenceGenome
+{
+  public:
+    PackedReferenceGenome();
+    ~PackedReferenceGenome() { close(); }
+    /*
+     * Returns false if the file does not exist or is not a packed reference. Throws
+     * PackedReferenceException for packed files with an unsupported version or a corrupt header
+     */
+    bool open(const std::string& filename);
+    /*
+     * Returns true if the packed file was produced from the current version of fasta_filename - sizes and
+     * modification times of the FASTA and .fai files as well as the contig names and lengths must match.
+     * Otherwise, mismatch_reason describes the difference
+     */
+    bool matches_source(const std::string& fasta_filename, std::string& mismatch_reason) const;
+    void close();
+    bool is_open() const { return m_mapped_ptr != 0; }
+    /*
+     * O(1) lookup - pos is 0-based. Returns 'N' for positions outside the contig,
+     * throws PackedReferenceException for unknown contigs
+     */
+    char get_reference_base_at_position(const char* contig, int pos);
+    static bool is_packed_reference_file(const std::string& filename);
+    //Produces packed file from FASTA file (must have .fai index or be indexable by htslib)
+    static void create(const std::string& fasta_filename, const std::string& output_filename);
+  private:
+    struct PackedContigInfo
+    {
+      uint64_t m_length;
+      uint64_t m_data_offset;
+      uint64_t m_mask_offset;
+      unsigned m_bits_per_base;
+    };
+    //Size and modification time of the source FASTA and .fai files - 0 for version 1 files
+    struct SourceFileInfo
+    {
+      uint64_t m_size;
+      int64_t m_mtime;
+    };
+    static bool get_source_file_info(const std::string& filename, SourceFileInfo& info);
+    //Reads version, source file info and contig table of the mapped file
+    void parse_header(const std::string& filename);
+  private:
+    unsigned m_version;
+    SourceFileInfo m_fasta_info;
+    SourceFileInfo m_fai_info;
+    std::unordered_map<std::string, unsigned> m_contig_name_to_idx;
+    std::vector<PackedContigInfo> m_contigs;
+    //Consecutive lookups are mostly on the same contig
+    std::string m_last_contig_name;
+    const PackedContigInfo* m_last_contig;
+    const uint8_t* m_mapped_ptr;
+    size_t m_mapped_size;
+};
+
+#endif //ifdef HTSDIR
+
+#endif
@@ -30,6 +30,8 @@
 #include "htslib/vcf.h"
 #include "htslib/faidx.h"
 #include "timer.h"
+#include "genomicsdb_profiler.h"
+#include "packed_reference.h"
 
 //Exceptions thrown
 class VCFAdapterException : public std::exception {
@@ -67,9 +69,15 @@ class ReferenceGenomeInfo
       if(m_reference_faidx)
         fai_destroy(m_reference_faidx);
     }
+    /*
+     * If reference_genome is a packed reference file or a packed file <reference_genome>.gdbref
+     * exists, the packed file is used for lookups instead of faidx
+     */
     void initialize(const std::string& reference_genome);
     char get_reference_base_at_position(const char* contig, int pos);
   private:
+    //mmap'd packed reference - O(1) lookups, no decompression
+    PackedReferenceGenome m_packed_reference;
     int m_reference_last_read_pos;
     int m_reference_num_bases_read;
     std::string m_reference_last_seq_read;
@@ -124,10 +132,6 @@ class VCFAdapter
     size_t m_combined_vcf_records_buffer_size_limit;
     //GATK CombineGVCF does not produce GT field by default - option to produce GT
     bool m_produce_GT_field;
-#ifdef DO_PROFILING
-    //Timer
-    Timer m_vcf_serialization_timer;
-#endif
 };
 
 class BufferedVCFAdapter : public VCFAdapter, public CircularBufferController
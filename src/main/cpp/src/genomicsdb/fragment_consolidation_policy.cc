@@ -0,0 +1,70 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "fragment_consolidation_policy.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw FragmentConsolidationPolicyException(#X);
+
+//FragmentConsolidationPolicy functions
+FragmentConsolidationPolicy::FragmentConsolidationPolicy(const unsigned max_num_fragments,
+    const unsigned max_num_fragments_per_tier, const uint64_t min_tier_size, const unsigned tier_size_ratio)
+  : m_max_num_fragments(max_num_fragments), m_max_num_fragments_per_tier(max_num_fragments_per_tier),
+  m_min_tier_size(min_tier_size), m_tier_size_ratio(tier_size_ratio)
+{
+  VERIFY_OR_THROW(m_max_num_fragments >= 1u && m_max_num_fragments_per_tier >= 2u
+      && m_min_tier_size > 0ull && m_tier_size_ratio >= 2u);
+}
+
+unsigned FragmentConsolidationPolicy::get_tier(const uint64_t num_bytes) const
+{
+  auto tier = 0u;
+  for(auto tier_end=m_min_tier_size;num_bytes >= tier_end;tier_end*=m_tier_size_ratio)
+  {
+    ++tier;
+    if(tier_end > UINT64_MAX/m_tier_size_ratio)
+      break;
+  }
+  return tier;
+}
+
+bool FragmentConsolidationPolicy::needs_consolidation(const std::vector<VariantArrayFragmentInfo>& fragments) const
+{
+  if(fragments.size() <= 1u)
+    return false;
+  if(fragments.size() > m_max_num_fragments)
+    return true;
+  auto max_fragment_size = 0ull;
+  //tier -> #fragments, #bytes
+  std::map<unsigned, std::pair<unsigned, uint64_t>> tiers;
+  for(const auto& fragment : fragments)
+  {
+    max_fragment_size = std::max<uint64_t>(max_fragment_size, fragment.m_num_bytes);
+    auto& curr_tier = tiers[get_tier(fragment.m_num_bytes)];
+    ++(curr_tier.first);
+    curr_tier.second += fragment.m_num_bytes;
+  }
+  for(const auto& tier : tiers)
+    if(tier.second.first >= m_max_num_fragments_per_tier
+        && tier.second.second >= max_fragment_size/m_tier_size_ratio)
+      return true;
+  return false;
+}
@@ -23,6 +23,8 @@
 #include "gt_common.h"
 #include "query_variants.h"
 #include "timer.h"
+#include "json_config.h"
+#include "column_partitioner.h"
 
 using namespace std;
 
@@ -68,47 +70,6 @@ Tile::const_iterator get_first_cell_after(const Tile& tile, uint64_t column)
 }
 #endif
 
-//Profiling functions
-GTProfileStats::GTProfileStats()
-{
-  m_num_queries = 0;
-  m_stats_sum_vector.resize(GTProfileStats::GT_NUM_STATS);
-  m_stats_sum_sq_vector.resize(GTProfileStats::GT_NUM_STATS);
-  m_stats_tmp_count_vector.resize(GTProfileStats::GT_NUM_STATS);
-  for(auto i=0u;i<m_stats_sum_sq_vector.size();++i)
-    m_stats_sum_sq_vector[i] = m_stats_sum_vector[i] = m_stats_tmp_count_vector[i] = 0;
-  m_stats_name_vector = std::vector<std::string>{
-    "GT_NUM_CELLS",   //total #cells traversed in the query, coord cells are accessed for every time
-      "GT_NUM_CELLS_IN_LEFT_SWEEP",//total #cells traversed in the query left sweep, coord cells are accessed for every time
-      "GT_NUM_VALID_CELLS_IN_QUERY",//#valid cells actually returned in query 
-      "GT_NUM_ATTR_CELLS_ACCESSED",//#attribute cells accessed in the query
-      "GT_NUM_PQ_FLUSHES_DUE_TO_OVERLAPPING_CELLS",//#times PQ gets flushed due to overlapping cells in the input
-      "GT_NUM_OPERATOR_INVOCATIONS" //#times operator gets invoked
-  };
-}
-
-void GTProfileStats::print_stats(std::ostream& fptr) const
-{
-  fptr << "stat_name,sum,sum_sq,mean,std-dev\n";
-  for(auto i=0u;i<GTProfileStats::GT_NUM_STATS;++i)
-  {
-    fptr << m_stats_name_vector[i];
-    fptr << "," << m_stats_sum_vector[i] << "," << std::setprecision(6) << m_stats_sum_sq_vector[i];
-    if(m_num_queries == 0)
-      fptr << ",*,*";
-    else
-    {
-      double mean = ((double)m_stats_sum_vector[i])/m_num_queries;
-      double std_dev = sqrt(abs((m_stats_sum_sq_vector[i]/m_num_queries) - (mean*mean)));
-      fptr << "," << std::setprecision(6) << mean << "," << std_dev;
-    }
-    fptr << "\n";
-  }
-  m_interval_sweep_timer.print("Sweep at query begin position", std::cerr);
-  m_operator_timer.print("Operator time", std::cerr);
-  m_genomicsdb_cell_fill_timer.print("GenomicsDB cell fill timer", std::cerr);
-}
-
 //Static members
 bool VariantQueryProcessor::m_are_static_members_initialized = false;
 unordered_map<type_index, shared_ptr<VariantFieldCreatorBase>> VariantQueryProcessor::m_type_index_to_creator;
@@ -283,15 +244,20 @@ void VariantQueryProcessor::obtain_TileDB_attribute_idxs(const VariantArraySchem
       throw UnknownQueryAttributeException("Invalid query attribute : "+queryConfig.get_query_attribute_name(i));
 }
 
+//True if at least one valid Call in the Variant has a real ALT allele
+static bool contains_non_reference_block_call(const Variant& variant)
+{
+  for(const auto& curr_call : variant)
+    if(!curr_call.is_reference_block())
+      return true;
+  return false;
+}
+
 void VariantQueryProcessor::handle_gvcf_ranges(VariantCallEndPQ& end_pq,
     const VariantQueryConfig& query_config, Variant& variant,
     SingleVariantOperatorBase& variant_operator,
-    int64_t& current_start_position, int64_t next_start_position, bool is_last_call, uint64_t& num_calls_with_deletions,
-    GTProfileStats* stats_ptr) const
+    int64_t& current_start_position, int64_t next_start_position, bool is_last_call, uint64_t& num_calls_with_deletions) const
 {
-#ifdef DO_PROFILING
-  assert(stats_ptr);
-#endif
   while(!end_pq.empty() && (current_start_position < next_start_position || is_last_call) && !(variant_operator.overflow()))
   {
     int64_t top_end_pq = end_pq.top()->get_column_end();
@@ -300,14 +266,16 @@ void VariantQueryProcessor::handle_gvcf_ranges(VariantCallEndPQ& end_pq,
     min_end_point = num_calls_with_deletions ? current_start_position : min_end_point;
     //Prepare variant for aligned column interval
     variant.set_column_interval(current_start_position, min_end_point);
-#ifdef DO_PROFILING
-    stats_ptr->m_operator_timer.start();
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_OPERATOR_INVOCATIONS, 1u);
-#endif
-    variant_operator.operate(variant, query_config);
-#ifdef DO_PROFILING
-    stats_ptr->m_operator_timer.stop();
-#endif
+    //Variant sites only - intervals covered only by reference blocks are not passed to the operator.
+    //Reference blocks stay in the PQ, so that hom-ref samples are part of the emitted sites
+    if(query_config.variant_sites_only() && !contains_non_reference_block_call(variant))
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_SKIPPED_REFERENCE_INTERVALS);
+    else
+    {
+      ProfilerSpan span(PROFILER_SPAN_QUERY_OPERATOR);
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_OPERATOR_INVOCATIONS);
+      variant_operator.operate(variant, query_config);
+    }
     //The following intervals have been completely processed
     while(!end_pq.empty() && static_cast<int64_t>(end_pq.top()->get_column_end()) == min_end_point)
     {
@@ -327,11 +295,6 @@ void VariantQueryProcessor::scan_and_operate(
     SingleVariantOperatorBase& variant_operator, unsigned column_interval_idx, bool handle_spanning_deletions,
     VariantQueryProcessorScanState* scan_state) const
 {
-  GTProfileStats* stats_ptr = 0;
-#ifdef DO_PROFILING
-  GTProfileStats stats;
-  stats_ptr = &stats;
-#endif
   assert(query_config.is_bookkeeping_done());
   //Priority queue of VariantCalls ordered by END positions
   VariantCallEndPQ local_end_pq;
@@ -355,9 +318,6 @@ void VariantQueryProcessor::scan_and_operate(
   {
     current_start_position = scan_state->m_current_start_position;
     forward_iter = scan_state->m_iter;
-#ifdef DO_PROFILING
-    stats_ptr = &(scan_state->m_stats);
-#endif
   }
   else //new scan
   {
@@ -369,11 +329,13 @@ void VariantQueryProcessor::scan_and_operate(
       //information is recorded in the Call
       //This part of the code accumulates such Calls, sets the current_start_position to query column interval begin
       //and lets the code in the for loop nest (forward scan) handle calling handle_gvcf_ranges()
-      gt_get_column(ad, query_config, column_interval_idx, variant, stats_ptr);
+      gt_get_column(ad, query_config, column_interval_idx, variant);
       //Insert valid calls produced by gt_get_column into the priority queue
-      for(Variant::valid_calls_iterator iter=variant.begin();iter != variant.end();++iter)
+      for(auto i=0ull;i<variant.get_num_calls();++i)
       {
-        auto& curr_call = *iter;
+        auto& curr_call = variant.get_call(i);
+        if(!curr_call.is_valid())
+          continue;
         end_pq.push(&curr_call);
         if(handle_spanning_deletions && curr_call.contains_deletion())
           ++num_calls_with_deletions;
@@ -386,8 +348,11 @@ void VariantQueryProcessor::scan_and_operate(
       //by gt_get_column(). Hence, must start from next column
       start_column = query_config.get_column_begin(column_interval_idx) + 1;
     }
-    //Initialize forward scan iterators
-    gt_initialize_forward_iter(ad, query_config, start_column, forward_iter);
+    //Initialize forward scan iterators - END copies are ignored by the forward scan, so cells
+    //beyond the interval are not needed
+    gt_initialize_forward_iter(ad, query_config, start_column, forward_iter,
+        (query_config.get_num_column_intervals() > 0u) ? static_cast<int64_t>(query_config.get_column_end(column_interval_idx))
+        : INT64_MAX);
   }
   //If uninitialized, store first column idx of forward scan in current_start_position
   if(current_start_position < 0 && !(forward_iter->end()))
@@ -404,10 +369,8 @@ void VariantQueryProcessor::scan_and_operate(
   for(;!(forward_iter->end()) && !end_loop && (scan_state == 0 || !(variant_operator.overflow()));++(*forward_iter))
   {
     auto& cell = **forward_iter;
-#ifdef DO_PROFILING
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_CELLS, 1u);
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_ATTR_CELLS_ACCESSED, query_config.get_num_queried_attributes());
-#endif
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_CELLS);
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_ATTRIBUTE_CELLS, query_config.get_num_queried_attributes());
 #ifdef DUPLICATE_CELL_AT_END
     //Ignore cell copies at END positions
     auto cell_column_value = cell.get_begin_column();
@@ -416,7 +379,7 @@ void VariantQueryProcessor::scan_and_operate(
       continue;
 #endif
     end_loop = scan_handle_cell(query_config, column_interval_idx, variant, variant_operator, cell,
-        end_pq, tmp_pq_buffer, current_start_position, next_start_position, num_calls_with_deletions, handle_spanning_deletions, stats_ptr);
+        end_pq, tmp_pq_buffer, current_start_position, next_start_position, num_calls_with_deletions, handle_spanning_deletions);
     //Do not increment the iterator if buffer overflows in the operator
     if(scan_state && variant_operator.overflow())
       break;
@@ -438,12 +401,9 @@ void VariantQueryProcessor::scan_and_operate(
     }
     //handle last interval
     handle_gvcf_ranges(end_pq, query_config, variant, variant_operator, current_start_position, next_start_position,
-        is_last_call, num_calls_with_deletions, stats_ptr);
+        is_last_call, num_calls_with_deletions);
     if(!variant_operator.overflow())
       delete forward_iter;
-#ifdef DO_PROFILING
-    stats_ptr->print_stats(std::cerr);
-#endif
     if(scan_state)
     {
       if(variant_operator.overflow()) //buffer full
@@ -468,8 +428,7 @@ bool VariantQueryProcessor::scan_handle_cell(const VariantQueryConfig& query_con
     const BufferVariantCell& cell,
     VariantCallEndPQ& end_pq, std::vector<VariantCall*>& tmp_pq_buffer,
     int64_t& current_start_position, int64_t& next_start_position,
-    uint64_t& num_calls_with_deletions, bool handle_spanning_deletions,
-    GTProfileStats* stats_ptr) const
+    uint64_t& num_calls_with_deletions, bool handle_spanning_deletions) const
 {
   //If only interval requested and end of interval crossed, then done
   if(query_config.get_num_column_intervals() > 0u &&
@@ -480,7 +439,7 @@ bool VariantQueryProcessor::scan_handle_cell(const VariantQueryConfig& query_con
     next_start_position = cell.get_begin_column();
     assert(cell.get_begin_column() > current_start_position);
     handle_gvcf_ranges(end_pq, query_config, variant, variant_operator, current_start_position,
-        next_start_position, false, num_calls_with_deletions, stats_ptr);
+        next_start_position, false, num_calls_with_deletions);
     assert(end_pq.empty() || static_cast<int64_t>(end_pq.top()->get_column_end()) >= next_start_position || variant_operator.overflow());  //invariant
     //Buffer overflow, don't process anymore
     if(variant_operator.overflow())
@@ -529,7 +488,7 @@ bool VariantQueryProcessor::scan_handle_cell(const VariantQueryConfig& query_con
       }
     }
     curr_call.reset_for_new_interval();
-    gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell, stats_ptr);
+    gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell);
     //When cells are duplicated at the END, then the VariantCall object need not be valid
     if(curr_call.is_valid())
     {
@@ -545,25 +504,24 @@ bool VariantQueryProcessor::scan_handle_cell(const VariantQueryConfig& query_con
 void VariantQueryProcessor::iterate_over_cells(
     const int ad,
     const VariantQueryConfig& query_config, 
-    SingleCellOperatorBase& variant_operator, unsigned column_interval_idx) const
+    SingleCellOperatorBase& variant_operator, unsigned column_interval_idx,
+    VariantQueryProcessorScanState* scan_state) const
 {
-  GTProfileStats stats;
-  GTProfileStats* stats_ptr = 0;
-#ifdef DO_PROFILING
-  stats_ptr = &stats;
-#endif
   assert(query_config.is_bookkeeping_done());
   //Rank of tile from which scan should start
   int64_t start_column = 0;
   //Scan only queried interval, not whole array
   if(query_config.get_num_column_intervals() > 0u)
     start_column = query_config.get_column_begin(column_interval_idx);
+  //Forward iterator - non-null when resuming a previous iteration
+  VariantArrayCellIterator* forward_iter = scan_state ? scan_state->m_iter : 0;
   //Find calls that intersect with begin query position
-  if(start_column > 0)
+  //Calls found here are all passed to the operator even if it overflows - at most one call per row
+  if(forward_iter == 0 && start_column > 0)
   {
     Variant interval_begin_variant(&query_config);
     interval_begin_variant.resize_based_on_query();
-    gt_get_column(ad, query_config, column_interval_idx, interval_begin_variant, stats_ptr,
+    gt_get_column(ad, query_config, column_interval_idx, interval_begin_variant,
 #ifdef DUPLICATE_CELL_AT_END
         0
 #else
@@ -583,12 +541,17 @@ void VariantQueryProcessor::iterate_over_cells(
     ++start_column;
   }
   //Initialize forward scan iterators
-  VariantArrayCellIterator* forward_iter = 0;
-  gt_initialize_forward_iter(ad, query_config, start_column, forward_iter);
+  if(forward_iter == 0)
+    gt_initialize_forward_iter(ad, query_config, start_column, forward_iter,
+        (query_config.get_num_column_intervals() > 0u) ? static_cast<int64_t>(query_config.get_column_end(column_interval_idx))
+        : INT64_MAX);
   //Variant object
-  Variant variant(&query_config);
+  Variant local_variant;
+  Variant& variant = scan_state ? scan_state->get_variant() : local_variant;
+  variant.set_query_config(&query_config);
   variant.resize_based_on_query();
-  for(;!(forward_iter->end());++(*forward_iter))
+  auto overflow = false;
+  for(;!(forward_iter->end()) && !overflow;++(*forward_iter))
   {
     auto& cell = **forward_iter;
     //If only interval requested and end of interval crossed, exit loop
@@ -599,18 +562,33 @@ void VariantQueryProcessor::iterate_over_cells(
     {
       auto& curr_call = variant.get_call(query_config.get_query_row_idx_for_array_row_idx(cell.get_row()));
       curr_call.reset_for_new_interval();
-      gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell, stats_ptr);
+      gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell);
       //When cells are duplicated at the END, then the VariantCall object need not be valid
       if(curr_call.is_valid())
         variant_operator.operate(curr_call, query_config, get_array_schema());
+      //Current cell is fully handled, the loop increment moves past it before exiting
+      overflow = (scan_state && variant_operator.overflow());
+    }
+  }
+  if(overflow && !(forward_iter->end()))
+    scan_state->set_scan_state(forward_iter, start_column, 0ull);
+  else
+  {
+    delete forward_iter;
+    if(scan_state)
+    {
+      scan_state->invalidate();
+      scan_state->m_done = true;
     }
   }
-  delete forward_iter;
 }
 
 void VariantQueryProcessor::do_query_bookkeeping(const VariantArraySchema& array_schema,
     VariantQueryConfig& query_config, const VidMapper& vid_mapper, const bool alleles_required) const
 {
+  //Fields used in filters must be fetched
+  for(const auto& filter : query_config.get_filters())
+    query_config.add_attribute_to_query(filter.get_field_name(), UNDEFINED_ATTRIBUTE_IDX_VALUE);
   obtain_TileDB_attribute_idxs(array_schema, query_config);
   //Add END as a query attribute by default
   unsigned END_schema_idx = 
@@ -681,6 +659,15 @@ void VariantQueryProcessor::do_query_bookkeeping(const VariantArraySchema& array
       assert(g_known_variant_field_names[known_variant_field_enum] == query_config.get_query_attribute_name(i));
     }
   }
+  //Bind filters to the query idxs and types of their fields
+  for(auto& filter : query_config.get_filters())
+  {
+    auto query_idx = 0u;
+    if(!query_config.get_query_idx_for_name(filter.get_field_name(), query_idx))
+      throw VariantQueryProcessorException("Field "+filter.get_field_name()+" of filter "+filter.get_expression()
+          +" is not queried");
+    filter.bind(query_idx, array_schema.type(query_config.get_schema_idx_for_query_idx(query_idx)), vid_mapper);
+  }
   //Set number of rows in the array
   auto& dim_domains = array_schema.dim_domains();
   uint64_t row_num = m_storage_manager ? m_storage_manager->get_num_valid_rows_in_array(m_ad) :   //may read from array metadata
@@ -708,16 +695,214 @@ void VariantQueryProcessor::do_query_bookkeeping(const VariantArraySchema& array
   query_config.set_done_bookkeeping(true);
 }
 
+//GA4GHPagingCursor functions
+bool GA4GHPagingCursor::can_resume(const VariantQueryConfig& query_config, const unsigned column_interval_idx,
+    const GA4GHPagingInfo& paging_info) const
+{
+  if(!(is_valid() && m_column_interval_idx == column_interval_idx
+    && m_column_begin == query_config.get_column_begin(column_interval_idx)
+    && m_column_end == query_config.get_column_end(column_interval_idx)
+    && m_last_column == paging_info.get_last_column()
+    && m_num_handled_variants_in_last_column == paging_info.get_num_handled_variants_in_last_column()))
+    return false;
+  //Page token reused with a different set of rows or attributes
+  if(m_query_all_rows != query_config.query_all_rows()
+      || (!m_query_all_rows && m_rows != query_config.get_rows_to_query())
+      || m_attributes.size() != query_config.get_num_queried_attributes())
+    return false;
+  for(auto i=0u;i<m_attributes.size();++i)
+    if(m_attributes[i] != query_config.get_query_attribute_name(i))
+      return false;
+  return true;
+}
+
+size_t GA4GHPagingCursor::get_size_in_bytes() const
+{
+  auto size = sizeof(GA4GHPagingCursor) + m_rows.capacity()*sizeof(int64_t)
+    + m_overflow_variants.capacity()*sizeof(Variant);
+  if(m_iter)
+    size += m_iter->get_buffer_size_in_bytes();
+  for(const auto& variant : m_overflow_variants)
+    size += variant.get_num_calls()*sizeof(VariantCall);
+  for(const auto& attribute : m_attributes)
+    size += attribute.capacity();
+  return size;
+}
+
+//GA4GHPagingCursorTable functions
+GA4GHPagingCursorTable& GA4GHPagingCursorTable::get_instance()
+{
+  static GA4GHPagingCursorTable table;
+  return table;
+}
+
+GA4GHPagingCursorTable::GA4GHPagingCursorTable()
+  : m_ttl(DEFAULT_GA4GH_PAGING_CURSOR_TTL_SECONDS), m_max_num_cursors(DEFAULT_MAX_NUM_GA4GH_PAGING_CURSORS),
+  m_max_size_in_bytes(DEFAULT_MAX_GA4GH_PAGING_CURSORS_SIZE), m_size_in_bytes(0u),
+  m_cursor_id_generator(std::random_device()())
+{ }
+
+uint64_t GA4GHPagingCursorTable::insert(std::shared_ptr<GA4GHPagingCursor> cursor)
+{
+  assert(cursor);
+  auto now = std::chrono::steady_clock::now();
+  auto cursor_size = cursor->get_size_in_bytes();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  evict_expired(now);
+  evict_until_fits(1u, cursor_size);
+  auto cursor_id = 0ull;
+  while(cursor_id == 0ull || m_cursors.find(cursor_id) != m_cursors.end())
+    cursor_id = m_cursor_id_generator();
+  m_cursors[cursor_id] = Entry{cursor, now, cursor_size};
+  m_size_in_bytes += cursor_size;
+  return cursor_id;
+}
+
+std::shared_ptr<GA4GHPagingCursor> GA4GHPagingCursorTable::acquire(const uint64_t cursor_id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  evict_expired(std::chrono::steady_clock::now());
+  auto iter = m_cursors.find(cursor_id);
+  if(iter == m_cursors.end())
+    return nullptr;
+  auto cursor = std::move((*iter).second.m_cursor);
+  erase(iter);
+  return cursor;
+}
+
+void GA4GHPagingCursorTable::erase(CursorMap::iterator iter)
+{
+  m_size_in_bytes -= (*iter).second.m_size_in_bytes;
+  m_cursors.erase(iter);
+}
+
+void GA4GHPagingCursorTable::evict_expired(const std::chrono::steady_clock::time_point now)
+{
+  for(auto iter=m_cursors.begin();iter!=m_cursors.end();)
+  {
+    auto curr_iter = iter++;
+    if(now - (*curr_iter).second.m_last_access_time > m_ttl)
+      erase(curr_iter);
+  }
+}
+
+void GA4GHPagingCursorTable::evict_until_fits(const size_t num_cursors, const size_t size_in_bytes)
+{
+  while(!m_cursors.empty() && (m_cursors.size()+num_cursors > m_max_num_cursors
+        || m_size_in_bytes+size_in_bytes > m_max_size_in_bytes))
+  {
+    auto oldest_iter = m_cursors.begin();
+    for(auto iter=m_cursors.begin();iter!=m_cursors.end();++iter)
+      if((*iter).second.m_last_access_time < (*oldest_iter).second.m_last_access_time)
+        oldest_iter = iter;
+    erase(oldest_iter);
+  }
+}
+
+void GA4GHPagingCursorTable::set_ttl(const unsigned seconds)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_ttl = std::chrono::seconds(seconds);
+  evict_expired(std::chrono::steady_clock::now());
+}
+
+void GA4GHPagingCursorTable::set_max_num_cursors(const size_t max_num_cursors)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_max_num_cursors = std::max<size_t>(max_num_cursors, 1u);
+  evict_until_fits(0u, 0u);
+}
+
+void GA4GHPagingCursorTable::set_max_size_in_bytes(const size_t max_size_in_bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_max_size_in_bytes = max_size_in_bytes;
+  evict_until_fits(0u, 0u);
+}
+
+size_t GA4GHPagingCursorTable::size() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_cursors.size();
+}
+
+size_t GA4GHPagingCursorTable::get_size_in_bytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size_in_bytes;
+}
+
+void GA4GHPagingCursorTable::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_cursors.clear();
+  m_size_in_bytes = 0u;
+}
+
+void VariantQueryProcessor::apply_process_wide_settings(const JSONConfigBase& json_config, const int rank)
+{
+  if(!json_config.get_profile_output_prefix().empty())
+    GenomicsDBProfiler::enable(json_config.get_profile_output_prefix(), json_config.get_profile_formats(), rank);
+  else
+    GenomicsDBProfiler::enable_from_environment(rank);
+  auto& tile_cache = VariantArrayTileCache::get_instance();
+  if(json_config.get_tile_cache_tile_width() > 0)
+    tile_cache.set_tile_width(json_config.get_tile_cache_tile_width());
+  if(json_config.get_tile_cache_size() >= 0)
+    tile_cache.set_capacity(json_config.get_tile_cache_size());
+  auto& cursor_table = GA4GHPagingCursorTable::get_instance();
+  if(json_config.get_ga4gh_paging_cursor_ttl() >= 0)
+    cursor_table.set_ttl(json_config.get_ga4gh_paging_cursor_ttl());
+  if(json_config.get_ga4gh_max_num_paging_cursors() > 0)
+    cursor_table.set_max_num_cursors(json_config.get_ga4gh_max_num_paging_cursors());
+  if(json_config.get_ga4gh_paging_cursors_max_size() >= 0)
+    cursor_table.set_max_size_in_bytes(json_config.get_ga4gh_paging_cursors_max_size());
+}
+
+void VariantQueryProcessor::initialize_auto_query_column_ranges(JSONConfigBase& json_config,
+    VariantQueryConfig& query_config, const VidMapper& vid_mapper, const int rank)
+{
+  if(!json_config.needs_auto_query_column_ranges())
+    return;
+  if(!vid_mapper.is_initialized())
+    throw VariantQueryProcessorException("\"query_column_ranges\" : \"auto\" requires a valid vid_mapping_file");
+  //Density from the histograms of all the queried arrays - every rank computes identical ranges
+  LoadBalancedColumnPartitioner partitioner(vid_mapper);
+  std::set<std::pair<std::string, std::string>> queried_arrays;
+  json_config.get_workspaces_and_arrays(queried_arrays);
+  ColumnCellHistogram histogram;
+  for(const auto& workspace_array_pair : queried_arrays)
+    if(VariantStorageManager::read_column_histogram(workspace_array_pair.first, workspace_array_pair.second, histogram))
+      partitioner.add_density_from_histogram(histogram);
+  std::vector<ColumnRange> ranges;
+  partitioner.partition(json_config.get_num_auto_column_partitions(), ranges);
+  json_config.set_auto_query_column_ranges(ranges);
+  for(const auto& range : json_config.get_query_column_ranges(rank))
+    query_config.add_column_interval_to_query(range.first, range.second);
+}
+
 void VariantQueryProcessor::gt_get_column_interval(
     const int ad,
     const VariantQueryConfig& query_config, unsigned column_interval_idx,
-    vector<Variant>& variants, GA4GHPagingInfo* paging_info, GTProfileStats* stats_ptr) const {
-#ifdef DO_PROFILING
-  assert(stats_ptr);
-#endif
+    vector<Variant>& variants, GA4GHPagingInfo* paging_info,
+    GA4GHPagingCursor* cursor) const {
   if(paging_info)
     paging_info->init_page_query();
+  //Overflow variants of the cursor are added to this page - they must be re-arranged along with the rest
   uint64_t start_variant_idx = variants.size();
+  //Continue from the cell at which the previous page stopped
+  VariantArrayCellIterator* resumed_forward_iter = 0;
+  if(cursor && paging_info && cursor->can_resume(query_config, column_interval_idx, *paging_info))
+  {
+    resumed_forward_iter = cursor->m_iter;
+    cursor->m_iter = 0;
+    paging_info->set_resumed_from_cursor();
+    //Variants in the last column of the previous page that did not fit in it
+    for(auto& variant : cursor->m_overflow_variants)
+      variants.push_back(std::move(variant));
+  }
+  if(cursor)
+    cursor->discard();
   //Will be used later in the function to produce Variants with one CallSet
   VariantQueryConfig subset_query_config(query_config);
   vector<int64_t> subset_rows = vector<int64_t>(1u, query_config.get_smallest_row_idx_in_array());
@@ -732,7 +917,8 @@ void VariantQueryProcessor::gt_get_column_interval(
   //as the start of the query, the left sweep operation should be repeated. However, if the continuation is beyond
   //the start of the query, skip the left sweep operation (as all variants accessed by the left sweep would have
   //been returned in a previous page)
-  if(paging_info == 0 || paging_info->get_last_column() <= query_config.get_column_begin(column_interval_idx))
+  if(resumed_forward_iter == 0
+      && (paging_info == 0 || paging_info->get_last_column() <= query_config.get_column_begin(column_interval_idx)))
   {
     Variant interval_begin_variant(&query_config);
     interval_begin_variant.resize_based_on_query();
@@ -744,7 +930,7 @@ void VariantQueryProcessor::gt_get_column_interval(
 #if VERBOSE>0
     std::cerr << "[query_variants:gt_get_column_interval] Getting " << query_config.get_num_rows_to_query() << " rows" << std::endl;
 #endif
-    gt_get_column(ad, query_config, column_interval_idx, interval_begin_variant, stats_ptr,
+    gt_get_column(ad, query_config, column_interval_idx, interval_begin_variant,
 #ifdef DUPLICATE_CELL_AT_END
         0
 #else
@@ -757,9 +943,9 @@ void VariantQueryProcessor::gt_get_column_interval(
         call_info_2_variant, paging_info);
   }
   //If this is not a single position query and paging limit is not hit, need to fetch more cells
-  if((query_config.get_column_end(column_interval_idx) >
+  if(resumed_forward_iter || ((query_config.get_column_end(column_interval_idx) >
         query_config.get_column_begin(column_interval_idx)) && 
-      !(paging_info && paging_info->is_page_limit_hit(variants.size())))
+      !(paging_info && paging_info->is_page_limit_hit(variants.size()))))
   {
     //Get the iterator to the first cell that has column > query_column_start. All cells with column == query_column_start
     //(or intersecting) would have been handled by gt_get_column(). Hence, must start from next column
@@ -767,8 +953,11 @@ void VariantQueryProcessor::gt_get_column_interval(
     //If paging, continue at the last column that was handled in the previous page
     start_column_forward_sweep = paging_info ? std::max<uint64_t>(paging_info->get_last_column(), start_column_forward_sweep) 
       : start_column_forward_sweep;
-    VariantArrayCellIterator* forward_iter = 0;
-    gt_initialize_forward_iter(ad, query_config, query_config.get_column_interval(column_interval_idx).first+1, forward_iter);
+    //Cells in columns before start_column_forward_sweep are handled_previously() - no need to scan them
+    VariantArrayCellIterator* forward_iter = resumed_forward_iter;
+    if(forward_iter == 0)
+      gt_initialize_forward_iter(ad, query_config, start_column_forward_sweep, forward_iter,
+          query_config.get_column_end(column_interval_idx));
     //Used to store single call variants  - one variant per cell
     //Multiple variants could be merged later on
     Variant tmp_variant(&subset_query_config);
@@ -790,11 +979,9 @@ void VariantQueryProcessor::gt_get_column_interval(
     bool stop_inserting_new_variants = false;
     for(;!(forward_iter->end());++(*forward_iter))
     {
-#ifdef DO_PROFILING
-      stats_ptr->update_stat(GTProfileStats::GT_NUM_CELLS, 1u);
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_CELLS);
       //FIXME: in the current implementation, every *iter accesses every attribute
-      stats_ptr->update_stat(GTProfileStats::GT_NUM_ATTR_CELLS_ACCESSED, query_config.get_num_queried_attributes());
-#endif
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_ATTRIBUTE_CELLS, query_config.get_num_queried_attributes());
       auto& cell = **forward_iter;
       curr_row_idx = cell.get_row();
       curr_column_idx = cell.get_begin_column();
@@ -814,14 +1001,17 @@ void VariantQueryProcessor::gt_get_column_interval(
         tmp_variant.reset_for_new_interval();
         tmp_variant.get_call(0u).set_row_idx(curr_row_idx); //set row idx
         tmp_variant.set_column_interval(curr_column_idx, curr_column_idx);
-        gt_fill_row(tmp_variant, curr_row_idx, curr_column_idx, subset_query_config, cell, stats_ptr);
+        gt_fill_row(tmp_variant, curr_row_idx, curr_column_idx, subset_query_config, cell);
         assert(tmp_variant.get_num_calls() == 1u);      //exactly 1 call
         //When cells are duplicated at the END, then the VariantCall object need not be valid
         if(tmp_variant.get_call(0).is_valid())
         {
           //Move call to variants vector, creating new Variant if necessary
+          //With a cursor, Variants in the page's last column that do not fit in the page are kept for the next page
           auto newly_inserted = move_call_to_variant_vector(subset_query_config, tmp_variant.get_call(0), variants, call_info_2_variant,
-              stop_inserting_new_variants);
+              stop_inserting_new_variants,
+              (cursor && stop_inserting_new_variants && curr_column_idx == paging_info->get_last_column())
+              ? &(cursor->m_overflow_variants) : 0);
           //Check if page limit hit
           PAGE_END_CHECK_LOGIC
         }
@@ -831,7 +1021,24 @@ void VariantQueryProcessor::gt_get_column_interval(
 #if VERBOSE>0
     std::cerr << "[query_variants:gt_get_column_interval] Fetching columns complete " << std::endl;
 #endif
-    delete forward_iter;
+    //Page ended in the forward sweep - iterator points to the first cell of the next page
+    if(cursor && paging_info && paging_info->is_page_limit_hit(variants.size()))
+    {
+      cursor->m_iter = forward_iter;
+      cursor->m_column_interval_idx = column_interval_idx;
+      cursor->m_column_begin = query_config.get_column_begin(column_interval_idx);
+      cursor->m_column_end = query_config.get_column_end(column_interval_idx);
+      cursor->m_last_column = paging_info->get_last_column();
+      cursor->m_num_handled_variants_in_last_column = paging_info->get_num_handled_variants_in_last_column();
+      cursor->m_query_all_rows = query_config.query_all_rows();
+      if(!cursor->m_query_all_rows)
+        cursor->m_rows = query_config.get_rows_to_query();
+      cursor->m_attributes.resize(query_config.get_num_queried_attributes());
+      for(auto i=0u;i<query_config.get_num_queried_attributes();++i)
+        cursor->m_attributes[i] = query_config.get_query_attribute_name(i);
+    }
+    else
+      delete forward_iter;
   }
   if(paging_info)
   {
@@ -848,17 +1055,17 @@ void VariantQueryProcessor::gt_get_column_interval(
   for(auto i=start_variant_idx;i<variants.size();++i)
     if(variants[i].get_num_calls() > 1u) //possible re-arrangement of PL/AD/GT fields needed
     {
-#ifdef DO_PROFILING
-      stats_ptr->m_operator_timer.start();
-#endif
+      ProfilerSpan span(PROFILER_SPAN_QUERY_OPERATOR);
+      GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_OPERATOR_INVOCATIONS);
       variant_operator.operate(variants[i], query_config);
       variant_operator.copy_back_remapped_fields(variants[i]); //copy back fields that have been remapped
-#ifdef DO_PROFILING
-      stats_ptr->m_operator_timer.stop();
-#endif
     }
   if(paging_info)
+  {
+    //Owner of the cursor sets the cursor id once the cursor is stored
+    paging_info->set_cursor_id(0ull);
     paging_info->serialize_page_end(m_array_schema->array_name());
+  }
 #if VERBOSE>0
   std::cerr << "[query_variants:gt_get_column_interval] query complete " << std::endl;
 #endif
@@ -867,11 +1074,8 @@ void VariantQueryProcessor::gt_get_column_interval(
 void VariantQueryProcessor::gt_get_column(
     const int ad,
     const VariantQueryConfig& query_config, unsigned column_interval_idx,
-    Variant& variant, GTProfileStats* stats_ptr, std::vector<uint64_t>* query_row_idx_in_order) const {
-#ifdef DO_PROFILING
-  assert(stats_ptr);
-  stats_ptr->m_interval_sweep_timer.start();
-#endif
+    Variant& variant, std::vector<uint64_t>* query_row_idx_in_order) const {
+  ProfilerSpan span(PROFILER_SPAN_QUERY_LEFT_SWEEP);
   //New interval starts
   variant.reset_for_new_interval();
 
@@ -897,12 +1101,10 @@ void VariantQueryProcessor::gt_get_column(
   uint64_t num_valid_rows = 0;
   // Fill the genotyping column
   while(!(cell_iter->end()) && filled_rows < query_config.get_num_rows_to_query()) {
-#ifdef DO_PROFILING
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_CELLS, 1u);
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_CELLS_IN_LEFT_SWEEP, 1u);
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_CELLS);
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_LEFT_SWEEP_CELLS);
     //FIXME: in the current implementation, every *iter accesses every attribute
-    stats_ptr->update_stat(GTProfileStats::GT_NUM_ATTR_CELLS_ACCESSED, query_config.get_num_queried_attributes());
-#endif
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_ATTRIBUTE_CELLS, query_config.get_num_queried_attributes());
     auto& cell = **cell_iter;
 #ifdef DUPLICATE_CELL_AT_END
     // If next cell is not on the left of col, and
@@ -920,7 +1122,7 @@ void VariantQueryProcessor::gt_get_column(
       auto& curr_call = variant.get_call(curr_query_row_idx);
       if(!(curr_call.is_initialized()))
       {
-        gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell, stats_ptr
+        gt_fill_row(variant, cell.get_row(), cell.get_begin_column(), query_config, cell
 #ifdef DUPLICATE_CELL_AT_END
             , true
 #endif
@@ -949,10 +1151,6 @@ void VariantQueryProcessor::gt_get_column(
   if(query_row_idx_in_order)
     query_row_idx_in_order->resize(num_valid_rows);
 #endif
-
-#ifdef DO_PROFILING
-  stats_ptr->m_interval_sweep_timer.stop();
-#endif
 }
 
 void VariantQueryProcessor::fill_field_prep(std::unique_ptr<VariantFieldBase>& field_ptr,
@@ -999,13 +1197,8 @@ void VariantQueryProcessor::binary_deserialize(Variant& variant, const VariantQu
       auto is_valid_field = *(reinterpret_cast<const bool*>(&(buffer[offset])));
       offset += sizeof(bool);
       if(is_valid_field)
-      {
-        auto& field_ptr = curr_call.get_field(j); 
-        unsigned length_descriptor = BCF_VL_FIXED;
-        unsigned num_elements = 1u;
-        fill_field_prep(field_ptr, query_config, j, length_descriptor, num_elements);
-        field_ptr->binary_deserialize(reinterpret_cast<const char*>(&(buffer[0])), offset, length_descriptor, num_elements);
-      }
+        binary_deserialize_field(curr_call.get_field(j), query_config, j,
+            reinterpret_cast<const char*>(&(buffer[0])), offset);
     }
   }
   //Common fields in the Variant object
@@ -1019,28 +1212,29 @@ void VariantQueryProcessor::binary_deserialize(Variant& variant, const VariantQu
     offset += sizeof(unsigned);
     variant.set_query_idx_for_common_field(i, query_idx);
     if(is_valid_field)
-    {
-      std::unique_ptr<VariantFieldBase>& field_ptr = variant.get_common_field(i); 
-      unsigned length_descriptor = BCF_VL_FIXED;
-      unsigned num_elements = 1u;
-      fill_field_prep(field_ptr, query_config, query_idx, length_descriptor, num_elements);
-      field_ptr->binary_deserialize(reinterpret_cast<const char*>(&(buffer[0])), offset, length_descriptor, num_elements);
-    }
+      binary_deserialize_field(variant.get_common_field(i), query_config, query_idx,
+          reinterpret_cast<const char*>(&(buffer[0])), offset);
   }
 }
 
+void VariantQueryProcessor::binary_deserialize_field(std::unique_ptr<VariantFieldBase>& field_ptr,
+    const VariantQueryConfig& query_config, const unsigned query_idx, const char* buffer, uint64_t& offset) const
+{
+  unsigned length_descriptor = BCF_VL_FIXED;
+  unsigned num_elements = 1u;
+  fill_field_prep(field_ptr, query_config, query_idx, length_descriptor, num_elements);
+  field_ptr->binary_deserialize(buffer, offset, length_descriptor, num_elements);
+}
+
 void VariantQueryProcessor::gt_fill_row(
     Variant& variant, int64_t row, int64_t column,
     const VariantQueryConfig& query_config,
-    const BufferVariantCell& cell, GTProfileStats* stats_ptr
+    const BufferVariantCell& cell
 #ifdef DUPLICATE_CELL_AT_END
     , bool traverse_end_copies
 #endif
     ) const {
-#ifdef DO_PROFILING
-  assert(stats_ptr);
-  stats_ptr->m_genomicsdb_cell_fill_timer.start();
-#endif
+  ProfilerSpan span(PROFILER_SPAN_QUERY_CELL_FILL);
 #if VERBOSE>1
   std::cerr << "[query_variants:gt_fill_row] Fill Row " << row << " column " << column << std::endl;
 #endif
@@ -1078,10 +1272,15 @@ void VariantQueryProcessor::gt_fill_row(
     curr_call.mark_valid(false);
     return;
   }
+  //Filters are evaluated on the raw cell - a filtered cell is treated as absent
+  if(query_config.has_filters() && !query_config.passes_filters(cell))
+  {
+    curr_call.mark_valid(false);
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_FILTERED_CELLS);
+    return;
+  }
   curr_call.mark_valid(true);   //contains valid data for this query
-#ifdef DO_PROFILING
-  stats_ptr->update_stat(GTProfileStats::GT_NUM_VALID_CELLS_IN_QUERY, 1u);
-#endif
+  GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_QUERY_VALID_CELLS);
 #ifdef DUPLICATE_CELL_AT_END
   if(column > END_v)
     std::swap(column, END_v);
@@ -1129,24 +1328,21 @@ void VariantQueryProcessor::gt_fill_row(
     curr_call.set_contains_deletion(has_deletion);
     curr_call.set_is_reference_block(VariantUtils::is_reference_block(REF_field_ptr->get(), ALT_field_ptr->get()));
   }
-#ifdef DO_PROFILING
-  stats_ptr->m_genomicsdb_cell_fill_timer.stop();
-#endif
 }
 
 inline
 unsigned int VariantQueryProcessor::gt_initialize_forward_iter(
     const int ad,
     const VariantQueryConfig& query_config, const int64_t column,
-    VariantArrayCellIterator*& forward_iter) const {
+    VariantArrayCellIterator*& forward_iter, const int64_t end_column) const {
   assert(query_config.is_bookkeeping_done());
   //Num attributes in query
   unsigned num_queried_attributes = query_config.get_num_queried_attributes();
-  //Assign forward iterator
-  vector<int64_t> query_range = { query_config.get_smallest_row_idx_in_array(),
-    static_cast<int64_t>(query_config.get_num_rows_in_array()+query_config.get_smallest_row_idx_in_array()-1),
-    column, INT64_MAX };
-  forward_iter = get_storage_manager()->begin(ad, &(query_range[0]), query_config.get_query_attributes_schema_idxs());
+  //Assign forward iterator - only tiles overlapping the queried rows and columns are read
+  vector<RowRange> row_ranges;
+  query_config.get_query_row_ranges(row_ranges, MAX_NUM_ROW_RANGES_PER_QUERY_ITERATOR);
+  forward_iter = get_storage_manager()->begin(ad, row_ranges, column, std::max(column, end_column),
+      query_config.get_query_attributes_schema_idxs());
   return num_queried_attributes - 1;
 }
 
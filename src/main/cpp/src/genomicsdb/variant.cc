@@ -87,6 +87,7 @@ void GA4GHPagingInfo::init_page_query()
   m_num_handled_variants_in_last_column = 0u;
   m_num_variants_to_shift_left = 0u;
   m_num_variants_in_curr_page = 0u;
+  m_cursor_id = 0ull;
   deserialize_page_end();
 }
 
@@ -141,6 +142,13 @@ void GA4GHPagingInfo::serialize_page_end(const std::string& array_name)
       + std::to_string(m_last_row_idx) + "_" 
       + std::to_string(m_last_column_idx) + "_"
       + std::to_string(m_num_handled_variants_in_last_column);
+  //Optional suffix #<cursor id in hex> - the position is still encoded for expired cursors
+  if(!is_query_completed() && m_cursor_id)
+  {
+    std::stringstream ss;
+    ss << '#' << std::hex << m_cursor_id;
+    m_last_page_end_token += ss.str();
+  }
 }
 
 void GA4GHPagingInfo::deserialize_page_end()
@@ -149,9 +157,20 @@ void GA4GHPagingInfo::deserialize_page_end()
   {
     m_last_column_idx = m_last_row_idx = 0ull;
     m_num_handled_variants_in_last_column = 0u;
+    m_cursor_id = 0ull;
     return;
   }
-  char* dup_string = strdup(m_last_page_end_token.c_str());
+  //Cursor id
+  auto position_token = m_last_page_end_token;
+  auto cursor_separator_pos = position_token.find_last_of('#');
+  m_cursor_id = 0ull;
+  if(cursor_separator_pos != std::string::npos && cursor_separator_pos+1u < position_token.length()
+      && position_token.find_first_not_of("0123456789abcdef", cursor_separator_pos+1u) == std::string::npos)
+  {
+    m_cursor_id = strtoull(position_token.c_str()+cursor_separator_pos+1u, 0, 16);
+    position_token.resize(cursor_separator_pos);
+  }
+  char* dup_string = strdup(position_token.c_str());
   std::string row_string = "";
   std::string column_string = "";
   std::string num_handled_variants_string = "";
@@ -921,8 +940,23 @@ void Variant::binary_deserialize_header(const std::vector<uint8_t>& buffer, uint
 }
 
 bool move_call_to_variant_vector(const VariantQueryConfig& query_config, VariantCall& to_move_call,
-    std::vector<Variant>& variants, GA4GHCallInfoToVariantIdx& call_info_2_variant, bool stop_inserting_new_variants)
+    std::vector<Variant>& variants, GA4GHCallInfoToVariantIdx& call_info_2_variant, bool stop_inserting_new_variants,
+    std::vector<Variant>* overflow_variants)
 {
+  if(stop_inserting_new_variants && overflow_variants)
+  {
+    //Indexes beyond variants.size() refer to overflow_variants
+    uint64_t variant_idx = variants.size() + overflow_variants->size();
+    bool newly_inserted = call_info_2_variant.find_or_insert(query_config, to_move_call, variant_idx);
+    if(newly_inserted)
+      overflow_variants->emplace_back(Variant());
+    assert(variant_idx < variants.size() + overflow_variants->size());
+    Variant& curr_variant = (variant_idx < variants.size()) ? variants[variant_idx]
+      : (*overflow_variants)[variant_idx-variants.size()];
+    curr_variant.set_column_interval(to_move_call.get_column_begin(), to_move_call.get_column_end());
+    curr_variant.add_call(std::move(to_move_call));
+    return newly_inserted;
+  }
   uint64_t variant_idx = variants.size();
   bool newly_inserted = call_info_2_variant.find_or_insert(query_config, to_move_call, variant_idx);
   if(newly_inserted && !stop_inserting_new_variants)
@@ -0,0 +1,178 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "variant_array_tile_cache.h"
+#include "genomicsdb_profiler.h"
+
+VariantArrayTileCache& VariantArrayTileCache::get_instance()
+{
+  static VariantArrayTileCache cache;
+  return cache;
+}
+
+VariantArrayTileCache::VariantArrayTileCache()
+{
+  m_capacity = 0u;
+  m_size_in_bytes = 0u;
+  m_tile_width = DEFAULT_TILE_CACHE_TILE_WIDTH;
+  m_num_hits = 0ull;
+  m_num_misses = 0ull;
+  m_num_evictions = 0ull;
+}
+
+void VariantArrayTileCache::set_capacity(const size_t capacity)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_capacity = capacity;
+  evict_until_size(capacity);
+}
+
+void VariantArrayTileCache::set_tile_width(const int64_t tile_width)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_tile_width = std::max<int64_t>(tile_width, 1ll);
+}
+
+void VariantArrayTileCache::set_fragment_set_id(const std::string& array_path, const uint64_t fragment_set_id)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto iter = m_array_path_to_fragment_set_id.find(array_path);
+  if(iter != m_array_path_to_fragment_set_id.end() && (*iter).second == fragment_set_id)
+    return;
+  invalidate_unlocked(array_path);
+  m_array_path_to_fragment_set_id[array_path] = fragment_set_id;
+}
+
+VariantArrayTileCache::TilePtr VariantArrayTileCache::get(const std::string& array_path, const uint64_t fragment_set_id,
+    const int64_t tile_width, const int attribute_idx, const int64_t tile_idx)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto map_iter = m_key_to_lru_iter.find(Key{array_path, fragment_set_id, tile_width, attribute_idx, tile_idx});
+  if(map_iter == m_key_to_lru_iter.end())
+  {
+    ++m_num_misses;
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_TILE_CACHE_MISSES);
+    return nullptr;
+  }
+  ++m_num_hits;
+  GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_TILE_CACHE_HITS);
+  auto lru_iter = (*map_iter).second;
+  m_lru_list.splice(m_lru_list.begin(), m_lru_list, lru_iter);
+  return (*lru_iter).second;
+}
+
+void VariantArrayTileCache::put(const std::string& array_path, const uint64_t fragment_set_id, const int64_t tile_width,
+    const int attribute_idx, const int64_t tile_idx, TilePtr tile)
+{
+  assert(tile);
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto tile_size = tile->get_size_in_bytes();
+  if(tile_size > m_capacity)
+    return;
+  //Iterator created before the array was modified - its tiles can never be served again
+  auto fragment_set_iter = m_array_path_to_fragment_set_id.find(array_path);
+  if(fragment_set_iter != m_array_path_to_fragment_set_id.end() && (*fragment_set_iter).second != fragment_set_id)
+    return;
+  Key key{array_path, fragment_set_id, tile_width, attribute_idx, tile_idx};
+  //Another iterator may have loaded the same tile concurrently
+  auto map_iter = m_key_to_lru_iter.find(key);
+  if(map_iter != m_key_to_lru_iter.end())
+    erase((*map_iter).second);
+  evict_until_size(m_capacity-tile_size);
+  m_lru_list.emplace_front(key, tile);
+  m_key_to_lru_iter[key] = m_lru_list.begin();
+  m_size_in_bytes += tile_size;
+}
+
+void VariantArrayTileCache::invalidate(const std::string& array_path)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  invalidate_unlocked(array_path);
+  m_array_path_to_fragment_set_id.erase(array_path);
+}
+
+void VariantArrayTileCache::invalidate_unlocked(const std::string& array_path)
+{
+  for(auto lru_iter=m_lru_list.begin();lru_iter!=m_lru_list.end();)
+  {
+    auto curr_iter = lru_iter++;
+    if((*curr_iter).first.m_array_path == array_path)
+      erase(curr_iter);
+  }
+}
+
+void VariantArrayTileCache::clear()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lru_list.clear();
+  m_key_to_lru_iter.clear();
+  m_array_path_to_fragment_set_id.clear();
+  m_size_in_bytes = 0u;
+}
+
+void VariantArrayTileCache::evict_until_size(const size_t size)
+{
+  while(m_size_in_bytes > size && !m_lru_list.empty())
+  {
+    erase(std::prev(m_lru_list.end()));
+    ++m_num_evictions;
+  }
+}
+
+void VariantArrayTileCache::erase(LRUList::iterator lru_iter)
+{
+  m_size_in_bytes -= (*lru_iter).second->get_size_in_bytes();
+  m_key_to_lru_iter.erase((*lru_iter).first);
+  m_lru_list.erase(lru_iter);
+}
+
+uint64_t VariantArrayTileCache::get_num_hits() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_hits;
+}
+
+uint64_t VariantArrayTileCache::get_num_misses() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_misses;
+}
+
+uint64_t VariantArrayTileCache::get_num_evictions() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_num_evictions;
+}
+
+size_t VariantArrayTileCache::get_size_in_bytes() const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_size_in_bytes;
+}
+
+void VariantArrayTileCache::reset_counters()
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_num_hits = 0ull;
+  m_num_misses = 0ull;
+  m_num_evictions = 0ull;
+}
@@ -0,0 +1,397 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "variant_block_serialization.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw VariantBlockSerializationException(#X);
+
+//Fixed streams, followed by 2 streams (validity, data) per call field
+enum VariantBlockStreamEnum
+{
+  VARIANT_BLOCK_STREAM_VARIANT_HEADERS=0u,
+  VARIANT_BLOCK_STREAM_CALL_HEADERS,
+  VARIANT_BLOCK_STREAM_CALL_FLAGS,
+  VARIANT_BLOCK_STREAM_COMMON_FIELD_VALIDITY,
+  VARIANT_BLOCK_STREAM_COMMON_FIELD_QUERY_IDXS,
+  VARIANT_BLOCK_STREAM_COMMON_FIELD_DATA,
+  VARIANT_BLOCK_NUM_FIXED_STREAMS
+};
+
+static inline unsigned get_call_field_validity_stream_idx(const unsigned field_idx)
+{
+  return VARIANT_BLOCK_NUM_FIXED_STREAMS + 2u*field_idx;
+}
+
+static inline unsigned get_call_field_data_stream_idx(const unsigned field_idx)
+{
+  return VARIANT_BLOCK_NUM_FIXED_STREAMS + 2u*field_idx + 1u;
+}
+
+static inline void write_varint(std::vector<uint8_t>& buffer, uint64_t& offset, uint64_t value)
+{
+  //At most 10 bytes for 64-bit values
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, 10u);
+  while(value >= 0x80u)
+  {
+    buffer[offset++] = static_cast<uint8_t>(value | 0x80u);
+    value >>= 7u;
+  }
+  buffer[offset++] = static_cast<uint8_t>(value);
+}
+
+static inline void write_zigzag(std::vector<uint8_t>& buffer, uint64_t& offset, const int64_t value)
+{
+  write_varint(buffer, offset, (static_cast<uint64_t>(value) << 1u) ^ static_cast<uint64_t>(value >> 63));
+}
+
+template<class T>
+static inline void write_fixed(std::vector<uint8_t>& buffer, uint64_t& offset, const T value)
+{
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, sizeof(T));
+  memcpy(&(buffer[offset]), &value, sizeof(T));
+  offset += sizeof(T);
+}
+
+template<class T>
+static inline T read_fixed(const uint8_t* buffer, uint64_t& offset)
+{
+  T value;
+  memcpy(&value, buffer+offset, sizeof(T));
+  offset += sizeof(T);
+  return value;
+}
+
+//VariantBlockSerializer functions
+VariantBlockSerializer::VariantBlockSerializer(const VariantBlockCompressionEnum compression,
+    const int compression_level)
+{
+  VERIFY_OR_THROW(compression < VARIANT_BLOCK_NUM_COMPRESSION_TYPES);
+  m_compression = compression;
+  m_compression_level = compression_level;
+}
+
+void VariantBlockSerializer::append_bit(const unsigned stream_idx, const bool value)
+{
+  auto& num_bits = m_stream_num_bits[stream_idx];
+  auto& stream = m_streams[stream_idx];
+  auto& length = m_stream_lengths[stream_idx];
+  if((num_bits & 7u) == 0u)
+  {
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(stream, length, 1u);
+    stream[length++] = 0u;
+  }
+  if(value)
+    stream[length-1u] |= (1u << (num_bits & 7u));
+  ++num_bits;
+}
+
+void VariantBlockSerializer::append_field(const unsigned stream_idx, const VariantFieldBase& field)
+{
+  uint64_t field_length = 0ull;
+  field.binary_serialize(m_field_buffer, field_length);
+  auto& stream = m_streams[stream_idx];
+  auto& length = m_stream_lengths[stream_idx];
+  write_varint(stream, length, field_length);
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(stream, length, field_length);
+  if(field_length > 0ull)
+    memcpy(&(stream[length]), &(m_field_buffer[0]), field_length);
+  length += field_length;
+}
+
+uint64_t VariantBlockSerializer::serialize(const Variant* variants, const uint64_t num_variants,
+    std::vector<uint8_t>& buffer, uint64_t& offset)
+{
+  auto num_call_fields = 0u;
+  for(auto i=0ull;i<num_variants;++i)
+    for(auto j=0ull;j<variants[i].get_num_calls();++j)
+      num_call_fields = std::max(num_call_fields, variants[i].get_call(j).get_num_fields());
+  auto num_streams = get_call_field_validity_stream_idx(num_call_fields);
+  m_streams.resize(num_streams);
+  m_stream_lengths.assign(num_streams, 0ull);
+  m_stream_num_bits.assign(num_streams, 0ull);
+  auto& variant_headers = m_streams[VARIANT_BLOCK_STREAM_VARIANT_HEADERS];
+  auto& variant_headers_length = m_stream_lengths[VARIANT_BLOCK_STREAM_VARIANT_HEADERS];
+  auto& call_headers = m_streams[VARIANT_BLOCK_STREAM_CALL_HEADERS];
+  auto& call_headers_length = m_stream_lengths[VARIANT_BLOCK_STREAM_CALL_HEADERS];
+  auto last_column_begin = 0ll;
+  for(auto i=0ull;i<num_variants;++i)
+  {
+    const auto& variant = variants[i];
+    auto column_begin = static_cast<int64_t>(variant.get_column_begin());
+    //Variants are mostly sorted by column - small deltas
+    write_zigzag(variant_headers, variant_headers_length, column_begin-last_column_begin);
+    write_zigzag(variant_headers, variant_headers_length,
+        static_cast<int64_t>(variant.get_column_end())-column_begin);
+    write_varint(variant_headers, variant_headers_length, variant.get_num_calls());
+    write_varint(variant_headers, variant_headers_length, variant.get_num_common_fields());
+    last_column_begin = column_begin;
+    //All calls including invalid ones, as in Variant::binary_serialize()
+    auto last_row_idx = 0ll;
+    for(auto k=0ull;k<variant.get_num_calls();++k)
+    {
+      const auto& curr_call = variant.get_call(k);
+      auto row_idx = static_cast<int64_t>(curr_call.get_row_idx());
+      auto call_column_begin = static_cast<int64_t>(curr_call.get_column_begin());
+      write_zigzag(call_headers, call_headers_length, row_idx-last_row_idx);
+      write_zigzag(call_headers, call_headers_length, call_column_begin-column_begin);
+      write_zigzag(call_headers, call_headers_length,
+          static_cast<int64_t>(curr_call.get_column_end())-call_column_begin);
+      write_varint(call_headers, call_headers_length, curr_call.get_num_fields());
+      last_row_idx = row_idx;
+      append_bit(VARIANT_BLOCK_STREAM_CALL_FLAGS, curr_call.is_valid());
+      append_bit(VARIANT_BLOCK_STREAM_CALL_FLAGS, curr_call.is_initialized());
+      append_bit(VARIANT_BLOCK_STREAM_CALL_FLAGS, curr_call.contains_deletion());
+      append_bit(VARIANT_BLOCK_STREAM_CALL_FLAGS, curr_call.is_reference_block());
+      //Fields - missing fields of calls with fewer fields are invalid
+      for(auto j=0u;j<num_call_fields;++j)
+      {
+        auto is_valid_field = (j < curr_call.get_num_fields() && curr_call.get_field(j).get()
+            && curr_call.get_field(j)->is_valid());
+        append_bit(get_call_field_validity_stream_idx(j), is_valid_field);
+        if(is_valid_field)
+          append_field(get_call_field_data_stream_idx(j), *(curr_call.get_field(j)));
+      }
+    }
+    //Common fields
+    for(auto j=0u;j<variant.get_num_common_fields();++j)
+    {
+      const auto& curr_field = variant.get_common_field(j);
+      auto is_valid_field = (curr_field.get() && curr_field->is_valid());
+      append_bit(VARIANT_BLOCK_STREAM_COMMON_FIELD_VALIDITY, is_valid_field);
+      write_varint(m_streams[VARIANT_BLOCK_STREAM_COMMON_FIELD_QUERY_IDXS],
+          m_stream_lengths[VARIANT_BLOCK_STREAM_COMMON_FIELD_QUERY_IDXS], variant.get_query_idx_for_common_field(j));
+      if(is_valid_field)
+        append_field(VARIANT_BLOCK_STREAM_COMMON_FIELD_DATA, *curr_field);
+    }
+  }
+  //Payload - #call fields, followed by the size and contents of every stream
+  uint64_t payload_length = 0ull;
+  write_varint(m_payload, payload_length, num_call_fields);
+  for(auto i=0u;i<num_streams;++i)
+  {
+    auto length = m_stream_lengths[i];
+    write_varint(m_payload, payload_length, length);
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(m_payload, payload_length, length);
+    if(length > 0ull)
+      memcpy(&(m_payload[payload_length]), &(m_streams[i][0]), length);
+    payload_length += length;
+  }
+  //Header
+  auto block_begin = offset;
+  RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, offset, VARIANT_BLOCK_HEADER_SIZE+payload_length);
+  auto compression = static_cast<uint8_t>(VARIANT_BLOCK_COMPRESSION_NONE);
+  uint64_t stored_payload_length = payload_length;
+  auto payload_begin = block_begin + VARIANT_BLOCK_HEADER_SIZE;
+  if(m_compression == VARIANT_BLOCK_COMPRESSION_ZLIB && payload_length > 0ull)
+  {
+    uLongf compressed_length = compressBound(payload_length);
+    RESIZE_BINARY_SERIALIZATION_BUFFER_IF_NEEDED(buffer, payload_begin, compressed_length);
+    auto status = compress2(&(buffer[payload_begin]), &compressed_length, &(m_payload[0]), payload_length,
+        m_compression_level);
+    if(status != Z_OK)
+      throw VariantBlockSerializationException(std::string("zlib compression failed with status ")
+          +std::to_string(status));
+    //Incompressible payloads are stored as is
+    if(compressed_length < payload_length)
+    {
+      compression = VARIANT_BLOCK_COMPRESSION_ZLIB;
+      stored_payload_length = compressed_length;
+    }
+  }
+  if(compression == VARIANT_BLOCK_COMPRESSION_NONE && payload_length > 0ull)
+    memcpy(&(buffer[payload_begin]), &(m_payload[0]), payload_length);
+  write_fixed<uint32_t>(buffer, offset, VARIANT_BLOCK_MAGIC);
+  write_fixed<uint8_t>(buffer, offset, VARIANT_BLOCK_FORMAT_VERSION);
+  write_fixed<uint8_t>(buffer, offset, compression);
+  write_fixed<uint16_t>(buffer, offset, 0u);
+  write_fixed<uint64_t>(buffer, offset, num_variants);
+  write_fixed<uint64_t>(buffer, offset, stored_payload_length);
+  write_fixed<uint64_t>(buffer, offset, payload_length);
+  assert(offset == payload_begin);
+  offset += stored_payload_length;
+  return offset - block_begin;
+}
+
+//VariantBlockDeserializer functions
+VariantBlockDeserializer::VariantBlockDeserializer(const VariantQueryProcessor& query_processor,
+    const VariantQueryConfig& query_config)
+{
+  m_query_processor = &query_processor;
+  m_query_config = &query_config;
+  m_num_remaining_variants = 0ull;
+  m_num_call_fields = 0u;
+  m_last_column_begin = 0ll;
+}
+
+bool VariantBlockDeserializer::is_block(const uint8_t* buffer, const uint64_t size, const uint64_t offset)
+{
+  if(offset + VARIANT_BLOCK_HEADER_SIZE > size)
+    return false;
+  auto read_offset = offset;
+  return (read_fixed<uint32_t>(buffer, read_offset) == VARIANT_BLOCK_MAGIC);
+}
+
+uint64_t VariantBlockDeserializer::begin_block(const uint8_t* buffer, const uint64_t size, uint64_t& offset)
+{
+  if(!is_block(buffer, size, offset))
+    throw VariantBlockSerializationException(std::string("No variant block at offset ")+std::to_string(offset));
+  offset += sizeof(uint32_t);
+  auto version = read_fixed<uint8_t>(buffer, offset);
+  if(version != VARIANT_BLOCK_FORMAT_VERSION)
+    throw VariantBlockSerializationException(std::string("Unsupported variant block format version ")
+        +std::to_string(version));
+  auto compression = read_fixed<uint8_t>(buffer, offset);
+  VERIFY_OR_THROW(compression < VARIANT_BLOCK_NUM_COMPRESSION_TYPES);
+  read_fixed<uint16_t>(buffer, offset);
+  auto num_variants = read_fixed<uint64_t>(buffer, offset);
+  auto stored_payload_length = read_fixed<uint64_t>(buffer, offset);
+  auto payload_length = read_fixed<uint64_t>(buffer, offset);
+  VERIFY_OR_THROW(offset + stored_payload_length <= size && "Truncated variant block");
+  const uint8_t* payload = buffer + offset;
+  if(compression == VARIANT_BLOCK_COMPRESSION_ZLIB)
+  {
+    m_payload.resize(payload_length);
+    uLongf uncompressed_length = payload_length;
+    auto status = uncompress(m_payload.data(), &uncompressed_length, payload, stored_payload_length);
+    if(status != Z_OK || uncompressed_length != payload_length)
+      throw VariantBlockSerializationException(std::string("zlib decompression failed with status ")
+          +std::to_string(status));
+    payload = m_payload.data();
+  }
+  else
+    VERIFY_OR_THROW(stored_payload_length == payload_length);
+  offset += stored_payload_length;
+  //Stream table
+  StreamCursor payload_cursor = { payload, payload_length, 0ull, 0ull };
+  m_num_call_fields = read_varint(payload_cursor);
+  if(m_num_call_fields > m_query_config->get_num_queried_attributes())
+    throw VariantBlockSerializationException(std::string("Variant block has ")+std::to_string(m_num_call_fields)
+        +" call fields, query has only "+std::to_string(m_query_config->get_num_queried_attributes()));
+  m_cursors.resize(get_call_field_validity_stream_idx(m_num_call_fields));
+  for(auto& cursor : m_cursors)
+  {
+    auto length = read_varint(payload_cursor);
+    VERIFY_OR_THROW(payload_cursor.m_offset + length <= payload_length && "Truncated variant block stream");
+    cursor = { payload + payload_cursor.m_offset, length, 0ull, 0ull };
+    payload_cursor.m_offset += length;
+  }
+  m_num_remaining_variants = num_variants;
+  m_last_column_begin = 0ll;
+  return num_variants;
+}
+
+uint64_t VariantBlockDeserializer::read_varint(StreamCursor& cursor) const
+{
+  uint64_t value = 0ull;
+  for(auto shift=0u;shift<64u;shift+=7u)
+  {
+    VERIFY_OR_THROW(cursor.m_offset < cursor.m_size && "Truncated variant block stream");
+    auto byte = cursor.m_ptr[cursor.m_offset++];
+    value |= (static_cast<uint64_t>(byte & 0x7Fu) << shift);
+    if((byte & 0x80u) == 0u)
+      return value;
+  }
+  throw VariantBlockSerializationException("Malformed varint in variant block");
+}
+
+int64_t VariantBlockDeserializer::read_zigzag(StreamCursor& cursor) const
+{
+  auto value = read_varint(cursor);
+  return static_cast<int64_t>(value >> 1u) ^ -static_cast<int64_t>(value & 1u);
+}
+
+bool VariantBlockDeserializer::read_bit(StreamCursor& cursor) const
+{
+  auto byte_idx = cursor.m_num_bits_read >> 3u;
+  VERIFY_OR_THROW(byte_idx < cursor.m_size && "Truncated variant block bitmap");
+  auto value = (cursor.m_ptr[byte_idx] >> (cursor.m_num_bits_read & 7u)) & 1u;
+  ++(cursor.m_num_bits_read);
+  return value;
+}
+
+void VariantBlockDeserializer::read_field(std::unique_ptr<VariantFieldBase>& field_ptr, const unsigned query_idx,
+    StreamCursor& validity_cursor, StreamCursor& data_cursor) const
+{
+  if(read_bit(validity_cursor))
+  {
+    auto field_length = read_varint(data_cursor);
+    VERIFY_OR_THROW(field_length <= data_cursor.m_size - data_cursor.m_offset && "Truncated variant block field data");
+    auto field_end = data_cursor.m_offset + field_length;
+    m_query_processor->binary_deserialize_field(field_ptr, *m_query_config, query_idx,
+        reinterpret_cast<const char*>(data_cursor.m_ptr), data_cursor.m_offset);
+    VERIFY_OR_THROW(data_cursor.m_offset == field_end && "Malformed variant block field data");
+  }
+  else
+    if(field_ptr.get())    //variant objects may be re-used
+      field_ptr->set_valid(false);
+}
+
+bool VariantBlockDeserializer::next(Variant& variant)
+{
+  if(m_num_remaining_variants == 0ull)
+    return false;
+  --m_num_remaining_variants;
+  auto& variant_headers = m_cursors[VARIANT_BLOCK_STREAM_VARIANT_HEADERS];
+  auto column_begin = m_last_column_begin + read_zigzag(variant_headers);
+  auto column_end = column_begin + read_zigzag(variant_headers);
+  auto num_calls = read_varint(variant_headers);
+  auto num_common_fields = read_varint(variant_headers);
+  m_last_column_begin = column_begin;
+  variant.set_column_interval(column_begin, column_end);
+  auto num_queried_attributes = m_query_config->get_num_queried_attributes();
+  variant.resize(num_calls, num_queried_attributes);
+  variant.resize_common_fields(num_common_fields);
+  //Calls
+  auto& call_headers = m_cursors[VARIANT_BLOCK_STREAM_CALL_HEADERS];
+  auto& call_flags = m_cursors[VARIANT_BLOCK_STREAM_CALL_FLAGS];
+  auto last_row_idx = 0ll;
+  for(auto k=0ull;k<num_calls;++k)
+  {
+    auto& curr_call = variant.get_call(k);
+    auto row_idx = last_row_idx + read_zigzag(call_headers);
+    auto call_column_begin = column_begin + read_zigzag(call_headers);
+    auto call_column_end = call_column_begin + read_zigzag(call_headers);
+    read_varint(call_headers);  //#fields - calls are resized to the #queried attributes
+    last_row_idx = row_idx;
+    curr_call.set_row_idx(row_idx);
+    curr_call.set_column_interval(call_column_begin, call_column_end);
+    curr_call.mark_valid(read_bit(call_flags));
+    curr_call.mark_initialized(read_bit(call_flags));
+    curr_call.set_contains_deletion(read_bit(call_flags));
+    curr_call.set_is_reference_block(read_bit(call_flags));
+    for(auto j=0u;j<m_num_call_fields;++j)
+      read_field(curr_call.get_field(j), j, m_cursors[get_call_field_validity_stream_idx(j)],
+          m_cursors[get_call_field_data_stream_idx(j)]);
+    for(auto j=m_num_call_fields;j<num_queried_attributes;++j)
+      if(curr_call.get_field(j).get())
+        curr_call.get_field(j)->set_valid(false);
+  }
+  //Common fields
+  for(auto j=0u;j<num_common_fields;++j)
+  {
+    auto query_idx = read_varint(m_cursors[VARIANT_BLOCK_STREAM_COMMON_FIELD_QUERY_IDXS]);
+    variant.set_query_idx_for_common_field(j, query_idx);
+    read_field(variant.get_common_field(j), query_idx, m_cursors[VARIANT_BLOCK_STREAM_COMMON_FIELD_VALIDITY],
+        m_cursors[VARIANT_BLOCK_STREAM_COMMON_FIELD_DATA]);
+  }
+  return true;
+}
@@ -68,8 +68,47 @@ void VariantQueryConfig::set_column_interval_to_query(const int64_t colBegin, co
   m_query_column_intervals[0] = make_pair(colBegin, colEnd);
 }
 
+void VariantQueryConfig::get_query_row_ranges(std::vector<RowRange>& row_ranges, const unsigned max_num_ranges) const
+{
+  assert(max_num_ranges > 0u);
+  row_ranges.clear();
+  if(m_query_all_rows)
+  {
+    row_ranges.emplace_back(m_smallest_row_idx, m_smallest_row_idx+static_cast<int64_t>(get_num_rows_in_array())-1);
+    return;
+  }
+  //m_query_rows is sorted
+  for(auto row_idx : m_query_rows)
+    if(row_ranges.empty() || row_idx > row_ranges.back().second+1)
+      row_ranges.emplace_back(row_idx, row_idx);
+    else
+      row_ranges.back().second = std::max(row_ranges.back().second, row_idx);
+  if(row_ranges.size() <= max_num_ranges)
+    return;
+  //Keep the (max_num_ranges-1) largest gaps between runs, close the rest
+  std::vector<std::pair<int64_t, size_t>> gaps(row_ranges.size()-1u);
+  for(auto i=0ull;i<gaps.size();++i)
+    gaps[i] = std::make_pair(row_ranges[i+1u].first-row_ranges[i].second, i);
+  std::nth_element(gaps.begin(), gaps.begin()+(max_num_ranges-1u), gaps.end(),
+      [](const std::pair<int64_t, size_t>& a, const std::pair<int64_t, size_t>& b) { return a.first > b.first; });
+  std::vector<bool> split_after(row_ranges.size(), false);
+  for(auto i=0u;i+1u<max_num_ranges;++i)
+    split_after[gaps[i].second] = true;
+  auto num_merged_ranges = 0ull;
+  for(auto i=0ull;i<row_ranges.size();++i)
+  {
+    if(i == 0u || split_after[i-1u])
+      row_ranges[num_merged_ranges++] = row_ranges[i];
+    else
+      row_ranges[num_merged_ranges-1u].second = row_ranges[i].second;
+  }
+  row_ranges.resize(num_merged_ranges);
+}
+
 void VariantQueryConfig::invalidate_array_row_idx_to_query_row_idx_map(bool all_rows)
 {
+  if(m_use_sparse_row_map)  //no map to invalidate
+    return;
   if(all_rows)
     for(auto i=0ull;i<get_num_rows_in_array();++i)
       m_array_row_idx_to_query_row_idx[i] = UNDEFINED_NUM_ROWS_VALUE;
@@ -82,28 +121,35 @@ void VariantQueryConfig::invalidate_array_row_idx_to_query_row_idx_map(bool all_
     }
 }
 
-void VariantQueryConfig::setup_array_row_idx_to_query_row_idx_map()
+void VariantQueryConfig::fill_array_row_idx_to_query_row_idx_map()
 {
-  if(m_query_all_rows)  //if querying all rows, don't even bother setting up map
-    return;
-  m_array_row_idx_to_query_row_idx.resize(get_num_rows_in_array());
-  invalidate_array_row_idx_to_query_row_idx_map(true);
   //Some queried row idxs may be out of bounds - ignore them
-  //This is done by creating a tmp_vector
-  std::vector<int64_t> tmp_vector(m_query_rows.size());
-  auto valid_rows_idx = 0ull;
-  for(auto i=0ull;i<m_query_rows.size();++i)
+  //m_query_rows is sorted, so the rows within bounds are contiguous
+  auto begin_iter = std::lower_bound(m_query_rows.begin(), m_query_rows.end(), m_smallest_row_idx);
+  auto end_iter = std::lower_bound(begin_iter, m_query_rows.end(),
+      static_cast<int64_t>(get_num_rows_in_array()+m_smallest_row_idx));
+  m_query_rows.erase(end_iter, m_query_rows.end());
+  m_query_rows.erase(m_query_rows.begin(), begin_iter);
+  m_use_sparse_row_map = (m_sparse_row_map_ratio > 0u
+      && m_query_rows.size()*m_sparse_row_map_ratio < get_num_rows_in_array());
+  if(m_use_sparse_row_map)
   {
-    //Within bounds
-    if(get_array_row_idx_for_query_row_idx(i) >= m_smallest_row_idx &&
-        get_array_row_idx_for_query_row_idx(i) < static_cast<int64_t>(get_num_rows_in_array()+m_smallest_row_idx))
-    {
-      m_array_row_idx_to_query_row_idx[m_query_rows[i]-m_smallest_row_idx] = valid_rows_idx;
-      tmp_vector[valid_rows_idx++] = m_query_rows[i];
-    }
+    std::vector<uint64_t>().swap(m_array_row_idx_to_query_row_idx); //free memory
+    return;
   }
-  tmp_vector.resize(valid_rows_idx);
-  m_query_rows = std::move(tmp_vector);
+  if(m_array_row_idx_to_query_row_idx.size() != get_num_rows_in_array())
+    m_array_row_idx_to_query_row_idx.assign(get_num_rows_in_array(), UNDEFINED_NUM_ROWS_VALUE);
+  for(auto i=0ull;i<m_query_rows.size();++i)
+    m_array_row_idx_to_query_row_idx[m_query_rows[i]-m_smallest_row_idx] = i;
+}
+
+void VariantQueryConfig::setup_array_row_idx_to_query_row_idx_map()
+{
+  if(m_query_all_rows)  //if querying all rows, don't even bother setting up map
+    return;
+  //Force re-initialization of the dense map
+  m_array_row_idx_to_query_row_idx.clear();
+  fill_array_row_idx_to_query_row_idx_map();
 }
 
 void VariantQueryConfig::update_rows_to_query(const std::vector<int64_t>& rows)
@@ -111,32 +157,10 @@ void VariantQueryConfig::update_rows_to_query(const std::vector<int64_t>& rows)
   assert(is_bookkeeping_done());
   //invalidate old queried rows, if a subset of rows were being queried earlier
   if(!m_query_all_rows)
-  {
-    invalidate_array_row_idx_to_query_row_idx_map(false); 
-    set_rows_to_query(rows);
-  }
-  else
-  {
-    set_rows_to_query(rows);
-    setup_array_row_idx_to_query_row_idx_map();
-  }
-  //setup mapping for newly querid rows
-  //Some queried row idxs may be out of bounds - ignore them
-  //This is done by creating a tmp_vector
-  std::vector<int64_t> tmp_vector(m_query_rows.size());
-  auto valid_rows_idx = 0ull;
-  for(auto i=0ull;i<m_query_rows.size();++i)
-  {
-    //Within bounds
-    if(get_array_row_idx_for_query_row_idx(i) >= m_smallest_row_idx &&
-        get_array_row_idx_for_query_row_idx(i) < static_cast<int64_t>(get_num_rows_in_array()+m_smallest_row_idx))
-    {
-      m_array_row_idx_to_query_row_idx[m_query_rows[i]-m_smallest_row_idx] = valid_rows_idx;
-      tmp_vector[valid_rows_idx++] = m_query_rows[i];
-    }
-  }
-  tmp_vector.resize(valid_rows_idx);
-  m_query_rows = std::move(tmp_vector);
+    invalidate_array_row_idx_to_query_row_idx_map(false);
+  set_rows_to_query(rows);
+  //setup mapping for newly queried rows
+  fill_array_row_idx_to_query_row_idx_map();
 }
 
 void VariantQueryConfig::update_rows_to_query_to_all_rows()
@@ -0,0 +1,172 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "variant_query_filter.h"
+#include "variant_cell.h"
+#include "vcf.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw VariantQueryFilterException(#X);
+
+static std::string trim(const std::string& str)
+{
+  auto begin = str.find_first_not_of(" \t");
+  if(begin == std::string::npos)
+    return "";
+  auto end = str.find_last_not_of(" \t");
+  return str.substr(begin, end-begin+1u);
+}
+
+VariantQueryFilter::VariantQueryFilter(const std::string& expression)
+{
+  m_expression = expression;
+  m_value = 0;
+  m_value_type = VALUE_TYPE_UNBOUND;
+  m_query_idx = UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  m_FILTER_idx = -1;
+  m_PASS_idx = -1;
+  m_is_PASS = false;
+  auto op_begin = expression.find_first_of("=!<>");
+  if(op_begin == std::string::npos)
+    throw VariantQueryFilterException("No comparison operator in filter "+expression);
+  auto op_end = op_begin+1u;
+  if(op_end < expression.length() && expression[op_end] == '=')
+    ++op_end;
+  auto op = expression.substr(op_begin, op_end-op_begin);
+  if(op == "==" || op == "=")
+    m_operator = VARIANT_QUERY_FILTER_EQ;
+  else if(op == "!=")
+    m_operator = VARIANT_QUERY_FILTER_NE;
+  else if(op == "<")
+    m_operator = VARIANT_QUERY_FILTER_LT;
+  else if(op == "<=")
+    m_operator = VARIANT_QUERY_FILTER_LE;
+  else if(op == ">")
+    m_operator = VARIANT_QUERY_FILTER_GT;
+  else if(op == ">=")
+    m_operator = VARIANT_QUERY_FILTER_GE;
+  else
+    throw VariantQueryFilterException("Unknown comparison operator "+op+" in filter "+expression);
+  m_field_name = trim(expression.substr(0u, op_begin));
+  m_value_string = trim(expression.substr(op_end));
+  if(m_field_name.empty() || m_value_string.empty())
+    throw VariantQueryFilterException("Missing field name or value in filter "+expression);
+  if(m_field_name == "FILTER")
+  {
+    if(m_operator != VARIANT_QUERY_FILTER_EQ && m_operator != VARIANT_QUERY_FILTER_NE)
+      throw VariantQueryFilterException("Only == and != can be used with FILTER in filter "+expression);
+    m_is_PASS = (m_value_string == "PASS");
+  }
+  else
+  {
+    char* endptr = 0;
+    m_value = strtod(m_value_string.c_str(), &endptr);
+    if(endptr == m_value_string.c_str() || *endptr != '\0')
+      throw VariantQueryFilterException("Non-numeric value in filter "+expression);
+  }
+}
+
+void VariantQueryFilter::bind(const unsigned query_idx, const std::type_index& type, const VidMapper& vid_mapper)
+{
+  m_query_idx = query_idx;
+  if(m_field_name == "FILTER")
+  {
+    VERIFY_OR_THROW(type == std::type_index(typeid(int)) && "FILTER field must be an int field");
+    m_value_type = VALUE_TYPE_FILTER;
+    //Filter names missing from the vid mapping get idx -1 and never occur in cells
+    vid_mapper.get_global_field_idx(m_value_string, m_FILTER_idx);
+    vid_mapper.get_global_field_idx("PASS", m_PASS_idx);
+    return;
+  }
+  if(type == std::type_index(typeid(int)))
+    m_value_type = VALUE_TYPE_INT32;
+  else if(type == std::type_index(typeid(unsigned)))
+    m_value_type = VALUE_TYPE_UINT32;
+  else if(type == std::type_index(typeid(int64_t)))
+    m_value_type = VALUE_TYPE_INT64;
+  else if(type == std::type_index(typeid(uint64_t)))
+    m_value_type = VALUE_TYPE_UINT64;
+  else if(type == std::type_index(typeid(float)))
+    m_value_type = VALUE_TYPE_FLOAT;
+  else if(type == std::type_index(typeid(double)))
+    m_value_type = VALUE_TYPE_DOUBLE;
+  else
+    throw VariantQueryFilterException("Field "+m_field_name+" in filter "+m_expression+" is not numeric");
+}
+
+template<class T>
+bool VariantQueryFilter::evaluate_numeric(const BufferVariantCell& cell) const
+{
+  if(cell.get_field_length(m_query_idx) <= 0)
+    return false;
+  auto value = *(cell.get_field_ptr_for_query_idx<T>(m_query_idx));
+  if(is_tiledb_missing_value<T>(value))
+    return false;
+  return compare(static_cast<double>(value));
+}
+
+bool VariantQueryFilter::evaluate_FILTER(const BufferVariantCell& cell) const
+{
+  auto length = cell.get_field_length(m_query_idx);
+  auto ptr = cell.get_field_ptr_for_query_idx<int>(m_query_idx);
+  auto found = false;
+  if(m_is_PASS)
+  {
+    //Empty FILTER or only PASS entries
+    found = true;
+    for(auto i=0;i<length;++i)
+      if(!is_tiledb_missing_value<int>(ptr[i]) && ptr[i] != m_PASS_idx)
+      {
+        found = false;
+        break;
+      }
+  }
+  else if(m_FILTER_idx >= 0)
+  {
+    for(auto i=0;i<length && !found;++i)
+      found = (ptr[i] == m_FILTER_idx);
+  }
+  return (m_operator == VARIANT_QUERY_FILTER_EQ) ? found : !found;
+}
+
+bool VariantQueryFilter::evaluate(const BufferVariantCell& cell) const
+{
+  assert(is_bound());
+  switch(m_value_type)
+  {
+    case VALUE_TYPE_INT32:
+      return evaluate_numeric<int>(cell);
+    case VALUE_TYPE_UINT32:
+      return evaluate_numeric<unsigned>(cell);
+    case VALUE_TYPE_INT64:
+      return evaluate_numeric<int64_t>(cell);
+    case VALUE_TYPE_UINT64:
+      return evaluate_numeric<uint64_t>(cell);
+    case VALUE_TYPE_FLOAT:
+      return evaluate_numeric<float>(cell);
+    case VALUE_TYPE_DOUBLE:
+      return evaluate_numeric<double>(cell);
+    case VALUE_TYPE_FILTER:
+      return evaluate_FILTER(cell);
+    default:
+      throw VariantQueryFilterException("Filter "+m_expression+" used before query bookkeeping");
+  }
+}
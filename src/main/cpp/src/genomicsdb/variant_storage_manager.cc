@@ -23,6 +23,10 @@
 #include "variant_storage_manager.h"
 #include "variant_field_data.h"
 #include <sys/stat.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <atomic>
+#include <cmath>
 #include "json_config.h"
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw VariantStorageManagerException(#X);
@@ -39,36 +43,181 @@ std::vector<const char*> VariantStorageManager::m_metadata_attributes = std::vec
 //ceil(buffer_size/field_size)*field_size
 #define GET_ALIGNED_BUFFER_SIZE(buffer_size, field_size) ((((buffer_size)+(field_size)-1u)/(field_size))*(field_size))
 
+//VariantArrayCellSizeStatistics functions
+void VariantArrayCellSizeStatistics::add(const int schema_idx, const uint64_t num_cells, const uint64_t num_bytes)
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  if(static_cast<size_t>(schema_idx) >= m_num_cells.size())
+  {
+    m_num_cells.resize(schema_idx+1u, 0ull);
+    m_num_bytes.resize(schema_idx+1u, 0ull);
+  }
+  m_num_cells[schema_idx] += num_cells;
+  m_num_bytes[schema_idx] += num_bytes;
+}
+
+void VariantArrayCellSizeStatistics::merge(const std::vector<int>& schema_idxs, const std::vector<uint64_t>& num_cells,
+    const std::vector<uint64_t>& num_bytes)
+{
+  assert(schema_idxs.size() == num_cells.size() && schema_idxs.size() == num_bytes.size());
+  for(auto i=0ull;i<schema_idxs.size();++i)
+    if(num_cells[i] > 0ull)
+      add(schema_idxs[i], num_cells[i], num_bytes[i]);
+}
+
+uint64_t VariantArrayCellSizeStatistics::get_num_cells(const int schema_idx) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return (static_cast<size_t>(schema_idx) < m_num_cells.size()) ? m_num_cells[schema_idx] : 0ull;
+}
+
+uint64_t VariantArrayCellSizeStatistics::get_num_bytes(const int schema_idx) const
+{
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return (static_cast<size_t>(schema_idx) < m_num_bytes.size()) ? m_num_bytes[schema_idx] : 0ull;
+}
+
+void VariantArrayCellSizeStatistics::compute_buffer_sizes(const VariantArraySchema& schema,
+    const std::vector<int>& attribute_ids, const size_t memory_budget, std::vector<size_t>& buffer_sizes,
+    const VariantArrayCellSizeStatistics* stored, const VariantArrayCellSizeStatistics* observed)
+{
+  //Expected #bytes per cell of each buffer
+  std::vector<double> bytes_per_cell;
+  for(auto schema_idx : attribute_ids)
+  {
+    auto element_size = schema.element_size(schema_idx);
+    if(schema.is_variable_length_field(schema_idx))
+    {
+      auto average_size = -1.0;
+      if(observed && observed->get_num_cells(schema_idx) >= MIN_NUM_OBSERVED_CELLS_FOR_CELL_SIZE)
+        average_size = static_cast<double>(observed->get_num_bytes(schema_idx))/observed->get_num_cells(schema_idx);
+      else
+        if(stored && stored->get_num_cells(schema_idx) > 0ull)
+          average_size = static_cast<double>(stored->get_num_bytes(schema_idx))/stored->get_num_cells(schema_idx);
+      if(average_size < 0)
+        average_size = element_size*DEFAULT_NUM_ELEMENTS_IN_VARIABLE_LENGTH_FIELD;
+      //Offsets
+      bytes_per_cell.push_back(sizeof(size_t));
+      bytes_per_cell.push_back(std::max<double>(average_size, element_size));
+    }
+    else
+      bytes_per_cell.push_back(element_size*schema.val_num(schema_idx));
+  }
+  //Co-ordinates
+  bytes_per_cell.push_back(schema.dim_size_in_bytes());
+  auto total_bytes_per_cell = 0.0;
+  for(auto val : bytes_per_cell)
+    total_bytes_per_cell += val;
+  buffer_sizes.resize(bytes_per_cell.size());
+  //Small budgets (tests, memory constrained writers) are honoured - every buffer gets at least an equal share
+  auto min_buffer_size = std::min<size_t>(MIN_ATTRIBUTE_BUFFER_SIZE, std::max<size_t>(1u, memory_budget/bytes_per_cell.size()));
+  for(auto i=0ull;i<bytes_per_cell.size();++i)
+    buffer_sizes[i] = std::max<size_t>(min_buffer_size,
+        static_cast<size_t>(memory_budget*(bytes_per_cell[i]/total_bytes_per_cell)));
+}
+
+//Identifies the fragments of the array - TileDB creates a new fragment directory for every write and
+//consolidation, while fragments being written are hidden ('.' prefix) until they are finalized
+static uint64_t get_fragment_set_id(const std::string& array_path)
+{
+  std::vector<std::string> entries;
+  auto* dir = opendir(array_path.c_str());
+  if(dir == 0)
+    return 0ull;
+  for(auto* entry=readdir(dir);entry;entry=readdir(dir))
+    if(entry->d_name[0] != '.')
+      entries.emplace_back(entry->d_name);
+  closedir(dir);
+  std::sort(entries.begin(), entries.end());
+  std::string all_entries;
+  for(const auto& entry : entries)
+    all_entries.append(entry).push_back('/');
+  return std::hash<std::string>()(all_entries);
+}
+
 //VariantArrayCellIterator functions
 VariantArrayCellIterator::VariantArrayCellIterator(TileDB_CTX* tiledb_ctx, const VariantArraySchema& variant_array_schema,
-        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t buffer_size)
+        const std::string& array_path, const int64_t* range, const std::vector<int>& attribute_ids, const size_t memory_budget,
+        const unsigned num_ranges, const VariantArrayCellSizeStatistics* stored_cell_sizes,
+        std::shared_ptr<VariantArrayCellSizeStatistics> observed_cell_sizes, const bool use_tile_cache)
   : m_num_queried_attributes(attribute_ids.size()), m_tiledb_ctx(tiledb_ctx),
-  m_variant_array_schema(&variant_array_schema), m_cell(variant_array_schema, attribute_ids)
-#ifdef DO_PROFILING
-  , m_tiledb_timer()
-  , m_tiledb_to_buffer_cell_timer()
-#endif
+  m_variant_array_schema(&variant_array_schema), m_cell(variant_array_schema, attribute_ids),
+  m_attribute_ids(attribute_ids), m_num_cells_read(attribute_ids.size(), 0ull), m_num_bytes_read(attribute_ids.size(), 0ull),
+  m_observed_cell_sizes(observed_cell_sizes), m_use_tile_cache(use_tile_cache)
 {
+  ProfilerSpan span(PROFILER_SPAN_TILEDB_ITERATOR_INIT);
+  m_tiledb_array_iterator = 0;
   m_buffers.clear();
-  std::vector<const char*> attribute_names(attribute_ids.size()+1u);  //+1 for the COORDS
-  for(auto i=0ull;i<attribute_ids.size();++i)
+#ifdef DEBUG
+  m_last_row = -1;
+  m_last_column = -1;
+  m_num_cells_iterated_over = 0ull;
+#endif
+  m_array_path = array_path;
+  if(use_tile_cache)
   {
-    //Buffer size must be resized to be a multiple of the field size
-    auto curr_buffer_size = buffer_size;
-    attribute_names[i] = variant_array_schema.attribute_name(attribute_ids[i]).c_str();
-    //For varible length attributes, need extra buffer for maintaining offsets
-    if(variant_array_schema.is_variable_length_field(attribute_ids[i]))
+    //Tiles are read lazily
+    m_memory_budget = memory_budget;
+    m_stored_cell_sizes = stored_cell_sizes;
+    m_ranges.assign(range, range+4u*num_ranges);
+    //Fixed for the lifetime of the iterator - the cache width may be changed by later queries
+    m_tile_width = VariantArrayTileCache::get_instance().get_tile_width();
+    m_fragment_set_id = get_fragment_set_id(array_path);
+    VariantArrayTileCache::get_instance().set_fragment_set_id(array_path, m_fragment_set_id);
+    if(num_ranges == 0u)
+      return;
+    auto min_column = INT64_MAX;
+    m_max_column = INT64_MIN;
+    for(auto r=0u;r<num_ranges;++r)
     {
-      curr_buffer_size = GET_ALIGNED_BUFFER_SIZE(buffer_size, sizeof(size_t));
-      m_buffers.emplace_back(curr_buffer_size);
+      min_column = std::min(min_column, range[4u*r+2u]);
+      m_max_column = std::max(m_max_column, range[4u*r+3u]);
     }
-    else
-      curr_buffer_size = GET_ALIGNED_BUFFER_SIZE(buffer_size, m_cell.get_field_size_in_bytes(i));
-    m_buffers.emplace_back(curr_buffer_size);
+    min_column = std::max(min_column, variant_array_schema.dim_domains()[1].first);
+    m_max_column = std::min(m_max_column, variant_array_schema.dim_domains()[1].second);
+    if(min_column > m_max_column)
+      return;
+    load_tile(min_column/m_tile_width);
+    m_cell_idx_in_tile = 0ull;
+    seek_to_valid_cached_cell();
+    return;
+  }
+  initialize_tiledb_iterators(range, num_ranges, memory_budget, stored_cell_sizes);
+}
+
+void VariantArrayCellIterator::initialize_tiledb_iterators(const int64_t* range, const unsigned num_ranges,
+    const size_t memory_budget, const VariantArrayCellSizeStatistics* stored_cell_sizes)
+{
+  //Subarrays share the memory budget
+  auto range_memory_budget = (num_ranges > 1u)
+    ? std::max<size_t>(memory_budget/num_ranges, std::min<size_t>(memory_budget, MIN_VARIANT_ARRAY_CELL_ITERATOR_BUFFER_SIZE))
+    : memory_budget;
+  std::vector<size_t> buffer_sizes;
+  VariantArrayCellSizeStatistics::compute_buffer_sizes(*m_variant_array_schema, m_attribute_ids, range_memory_budget,
+      buffer_sizes, stored_cell_sizes, m_observed_cell_sizes.get());
+  std::vector<const char*> attribute_names(m_attribute_ids.size()+1u);  //+1 for the COORDS
+  for(auto r=0u;r<num_ranges;++r)
+  {
+    auto buffer_idx = 0u;
+    for(auto i=0ull;i<m_attribute_ids.size();++i)
+    {
+      attribute_names[i] = m_variant_array_schema->attribute_name(m_attribute_ids[i]).c_str();
+      //For varible length attributes, need extra buffer for maintaining offsets
+      if(m_variant_array_schema->is_variable_length_field(m_attribute_ids[i]))
+      {
+        m_buffers.emplace_back(GET_ALIGNED_BUFFER_SIZE(buffer_sizes[buffer_idx], sizeof(size_t)));
+        ++buffer_idx;
+        m_buffers.emplace_back(buffer_sizes[buffer_idx]);
+      }
+      else
+        //Buffer size must be resized to be a multiple of the field size
+        m_buffers.emplace_back(GET_ALIGNED_BUFFER_SIZE(buffer_sizes[buffer_idx], m_cell.get_field_size_in_bytes(i)));
+      ++buffer_idx;
+    }
+    //Co-ordinates
+    attribute_names[m_attribute_ids.size()] = TILEDB_COORDS;
+    m_buffers.emplace_back(GET_ALIGNED_BUFFER_SIZE(buffer_sizes[buffer_idx], m_variant_array_schema->dim_size_in_bytes()));
   }
-  //Co-ordinates
-  attribute_names[attribute_ids.size()] = TILEDB_COORDS;
-  m_buffers.emplace_back(GET_ALIGNED_BUFFER_SIZE(buffer_size, variant_array_schema.dim_size_in_bytes()));
   //Initialize pointers to buffers
   m_buffer_pointers.resize(m_buffers.size());
   m_buffer_sizes.resize(m_buffers.size());
@@ -77,34 +226,229 @@ VariantArrayCellIterator::VariantArrayCellIterator(TileDB_CTX* tiledb_ctx, const
     m_buffer_pointers[i] = reinterpret_cast<void*>(&(m_buffers[i][0]));
     m_buffer_sizes[i] = m_buffers[i].size();
   }
-  /* Initialize the array in READ mode. */
-  auto status = tiledb_array_iterator_init(
-      tiledb_ctx, 
-      &m_tiledb_array_iterator,
-      array_path.c_str(),
-      reinterpret_cast<const void*>(range), // range, 
-      &(attribute_names[0]),           
-      attribute_names.size(),
-      const_cast<void**>(&(m_buffer_pointers[0])),
-      &(m_buffer_sizes[0]));      
-  VERIFY_OR_THROW(status == TILEDB_OK && "Error while initializing TileDB iterator");
-#ifdef DEBUG
-  m_last_row = -1;
-  m_last_column = -1;
-  m_num_cells_iterated_over = 0ull;
-#endif
-#ifdef DO_PROFILING
-  m_tiledb_timer.stop();
-#endif
+  auto num_buffers_per_range = (num_ranges > 0u) ? m_buffers.size()/num_ranges : 0u;
+  m_tiledb_array_iterators.resize(num_ranges, 0);
+  for(auto r=0u;r<num_ranges;++r)
+  {
+    /* Initialize the array in READ mode. */
+    auto status = tiledb_array_iterator_init(
+        m_tiledb_ctx,
+        &(m_tiledb_array_iterators[r]),
+        m_array_path.c_str(),
+        reinterpret_cast<const void*>(range+4u*r), // range,
+        &(attribute_names[0]),
+        attribute_names.size(),
+        const_cast<void**>(&(m_buffer_pointers[r*num_buffers_per_range])),
+        &(m_buffer_sizes[r*num_buffers_per_range]));
+    VERIFY_OR_THROW(status == TILEDB_OK && "Error while initializing TileDB iterator");
+  }
+  if(num_ranges == 1u)
+    m_tiledb_array_iterator = m_tiledb_array_iterators[0u];
+  else
+    select_next_iterator();
+}
+
+void VariantArrayCellIterator::select_next_iterator()
+{
+  //Few subarrays per query - a linear scan is cheaper than maintaining a heap
+  m_tiledb_array_iterator = 0;
+  int64_t min_row = 0;
+  int64_t min_column = 0;
+  const uint8_t* field_ptr = 0;
+  size_t field_size = 0u;
+  for(auto tiledb_array_iterator : m_tiledb_array_iterators)
+  {
+    if(tiledb_array_iterator_end(tiledb_array_iterator))
+      continue;
+    auto status = tiledb_array_iterator_get_value(tiledb_array_iterator, m_num_queried_attributes,
+        reinterpret_cast<const void**>(&field_ptr), &field_size);
+    VERIFY_OR_THROW(status == TILEDB_OK);
+    auto coords_ptr = reinterpret_cast<const int64_t*>(field_ptr);
+    if(m_tiledb_array_iterator == 0 || coords_ptr[1] < min_column
+        || (coords_ptr[1] == min_column && coords_ptr[0] < min_row))
+    {
+      m_tiledb_array_iterator = tiledb_array_iterator;
+      min_row = coords_ptr[0];
+      min_column = coords_ptr[1];
+    }
+  }
+}
+
+void VariantArrayCellIterator::load_tile(const int64_t tile_idx)
+{
+  auto& cache = VariantArrayTileCache::get_instance();
+  m_tile_idx = tile_idx;
+  m_tiles.resize(m_num_queried_attributes+1u);
+  std::vector<int> missing_query_idxs;
+  for(auto i=0u;i<m_num_queried_attributes;++i)
+  {
+    m_tiles[i] = cache.get(m_array_path, m_fragment_set_id, m_tile_width, m_attribute_ids[i], tile_idx);
+    if(!m_tiles[i])
+      missing_query_idxs.push_back(i);
+  }
+  auto& coords_tile = m_tiles[m_num_queried_attributes];
+  coords_tile = cache.get(m_array_path, m_fragment_set_id, m_tile_width, TILE_CACHE_COORDS_ATTRIBUTE_IDX, tile_idx);
+  if(missing_query_idxs.empty() && coords_tile)
+    return;
+  std::vector<std::shared_ptr<VariantArrayTile>> tiles;
+  if(!read_tile(tile_idx, missing_query_idxs, !coords_tile, tiles))
+  {
+    switch_to_tiledb_iterators(tile_idx);
+    return;
+  }
+  //Array modified after this iterator was created - the tiles just read are newer than the fragment set
+  //in the key, so all tiles are re-read and none are cached
+  auto is_stale = false;
+  for(const auto& tile : m_tiles)
+    is_stale = is_stale || (tile && tile->get_num_cells() != tiles.back()->get_num_cells());
+  if(is_stale)
+  {
+    missing_query_idxs.resize(m_num_queried_attributes);
+    for(auto i=0u;i<m_num_queried_attributes;++i)
+      missing_query_idxs[i] = i;
+    coords_tile = nullptr;
+    if(!read_tile(tile_idx, missing_query_idxs, true, tiles))
+    {
+      switch_to_tiledb_iterators(tile_idx);
+      return;
+    }
+  }
+  for(auto i=0ull;i<missing_query_idxs.size();++i)
+  {
+    auto query_idx = missing_query_idxs[i];
+    tiles[i]->shrink_to_fit();
+    m_tiles[query_idx] = tiles[i];
+    if(!is_stale)
+      cache.put(m_array_path, m_fragment_set_id, m_tile_width, m_attribute_ids[query_idx], tile_idx, m_tiles[query_idx]);
+  }
+  if(!coords_tile)
+  {
+    tiles.back()->shrink_to_fit();
+    coords_tile = tiles.back();
+    if(!is_stale)
+      cache.put(m_array_path, m_fragment_set_id, m_tile_width, TILE_CACHE_COORDS_ATTRIBUTE_IDX, tile_idx, coords_tile);
+  }
+}
+
+void VariantArrayCellIterator::switch_to_tiledb_iterators(const int64_t tile_idx)
+{
+  GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_TILE_CACHE_BYPASSES);
+  m_tiles.clear();
+  m_use_tile_cache = false;
+  //Cells in columns before the tile have been consumed already
+  auto tile_begin = tile_idx*m_tile_width;
+  std::vector<int64_t> ranges;
+  for(auto r=0ull;r<m_ranges.size()/4u;++r)
+  {
+    if(m_ranges[4u*r+3u] < tile_begin)
+      continue;
+    ranges.insert(ranges.end(), m_ranges.begin()+4u*r, m_ranges.begin()+4u*(r+1u));
+    ranges[ranges.size()-2u] = std::max(ranges[ranges.size()-2u], tile_begin);
+  }
+  m_ranges.clear();
+  if(!ranges.empty())
+    initialize_tiledb_iterators(&(ranges[0]), ranges.size()/4u, m_memory_budget, m_stored_cell_sizes);
+}
+
+bool VariantArrayCellIterator::read_tile(const int64_t tile_idx, const std::vector<int>& query_idxs,
+    const bool find_next_column, std::vector<std::shared_ptr<VariantArrayTile>>& tiles)
+{
+  auto tile_begin = tile_idx*m_tile_width;
+  auto tile_end = tile_begin+m_tile_width-1;
+  const auto& dim_domains = m_variant_array_schema->dim_domains();
+  //All rows - tiles are shared by queries over different samples, at the cost of reading rows outside
+  //the queried row ranges (see VariantArrayTile)
+  int64_t range[] = { dim_domains[0].first, dim_domains[0].second, tile_begin,
+    find_next_column ? dim_domains[1].second : std::min(tile_end, dim_domains[1].second) };
+  std::vector<int> attribute_ids(query_idxs.size());
+  for(auto i=0ull;i<query_idxs.size();++i)
+    attribute_ids[i] = m_attribute_ids[query_idxs[i]];
+  tiles.clear();
+  for(auto schema_idx : attribute_ids)
+    tiles.emplace_back(std::make_shared<VariantArrayTile>(m_variant_array_schema->is_variable_length_field(schema_idx)));
+  tiles.emplace_back(std::make_shared<VariantArrayTile>(false));
+  VariantArrayCellIterator tiledb_iter(m_tiledb_ctx, *m_variant_array_schema, m_array_path, range, attribute_ids,
+      m_memory_budget, 1u, m_stored_cell_sizes);
+  //Decoded tiles are bounded by the iterator memory budget
+  auto num_bytes = 0ull;
+  for(;!(tiledb_iter.end());++tiledb_iter)
+  {
+    auto& cell = *tiledb_iter;
+    if(cell.get_begin_column() > tile_end)
+    {
+      tiles.back()->set_next_column(cell.get_begin_column());
+      break;
+    }
+    for(auto i=0ull;i<attribute_ids.size();++i)
+    {
+      tiles[i]->append(cell.get_field_ptr_for_query_idx(i), cell.get_field_size_in_bytes(i));
+      num_bytes += cell.get_field_size_in_bytes(i);
+    }
+    int64_t coords[] = { cell.get_row(), cell.get_begin_column() };
+    tiles.back()->append(coords, sizeof(coords));
+    num_bytes += sizeof(coords);
+    if(num_bytes > m_memory_budget)
+    {
+      tiles.clear();
+      return false;
+    }
+  }
+  return true;
+}
+
+void VariantArrayCellIterator::seek_to_valid_cached_cell()
+{
+  auto num_ranges = m_ranges.size()/4u;
+  while(!m_tiles.empty())
+  {
+    const auto& coords_tile = *(m_tiles[m_num_queried_attributes]);
+    if(m_cell_idx_in_tile >= coords_tile.get_num_cells())
+    {
+      //Skip empty tiles - INT64_MAX if there are no more cells in the array
+      auto next_column = coords_tile.get_next_column();
+      if(next_column > m_max_column)
+      {
+        m_tiles.clear();
+        return;
+      }
+      load_tile(std::max(m_tile_idx+1, next_column/m_tile_width));
+      m_cell_idx_in_tile = 0ull;
+      continue;
+    }
+    size_t size = 0u;
+    auto coords_ptr = reinterpret_cast<const int64_t*>(coords_tile.get_cell_ptr(m_cell_idx_in_tile, size));
+    for(auto r=0ull;r<num_ranges;++r)
+    {
+      auto range_ptr = &(m_ranges[4u*r]);
+      if(coords_ptr[0] >= range_ptr[0] && coords_ptr[0] <= range_ptr[1]
+          && coords_ptr[1] >= range_ptr[2] && coords_ptr[1] <= range_ptr[3])
+        return;
+    }
+    ++m_cell_idx_in_tile;
+  }
 }
 
 const BufferVariantCell& VariantArrayCellIterator::operator*()
 {
-#ifdef DO_PROFILING
-  m_tiledb_to_buffer_cell_timer.start();
-#endif
+  ProfilerSpan span(PROFILER_SPAN_TILEDB_TO_BUFFER_CELL);
   const uint8_t* field_ptr = 0;
   size_t field_size = 0u;
+  if(m_use_tile_cache)
+  {
+    assert(!m_tiles.empty());
+    for(auto i=0u;i<m_num_queried_attributes;++i)
+    {
+      field_ptr = m_tiles[i]->get_cell_ptr(m_cell_idx_in_tile, field_size);
+      m_cell.set_field_ptr_for_query_idx(i, field_ptr);
+      m_cell.set_field_size_in_bytes(i, field_size);
+      ++(m_num_cells_read[i]);
+      m_num_bytes_read[i] += field_size;
+    }
+    auto coords_ptr = reinterpret_cast<const int64_t*>(
+        m_tiles[m_num_queried_attributes]->get_cell_ptr(m_cell_idx_in_tile, field_size));
+    m_cell.set_coordinates(coords_ptr[0], coords_ptr[1]);
+    return m_cell;
+  }
   for(auto i=0u;i<m_num_queried_attributes;++i)
   {
     auto status = tiledb_array_iterator_get_value(m_tiledb_array_iterator, i,
@@ -112,6 +456,8 @@ const BufferVariantCell& VariantArrayCellIterator::operator*()
     VERIFY_OR_THROW(status == TILEDB_OK);
     m_cell.set_field_ptr_for_query_idx(i, field_ptr);
     m_cell.set_field_size_in_bytes(i, field_size);
+    ++(m_num_cells_read[i]);
+    m_num_bytes_read[i] += field_size;
   }
   //Co-ordinates
   auto status = tiledb_array_iterator_get_value(m_tiledb_array_iterator, m_num_queried_attributes,
@@ -120,9 +466,6 @@ const BufferVariantCell& VariantArrayCellIterator::operator*()
   assert(field_size == m_variant_array_schema->dim_size_in_bytes());
   auto coords_ptr = reinterpret_cast<const int64_t*>(field_ptr);
   m_cell.set_coordinates(coords_ptr[0], coords_ptr[1]);
-#ifdef DO_PROFILING
-  m_tiledb_to_buffer_cell_timer.stop();
-#endif
   return m_cell;
 }
 
@@ -133,29 +476,23 @@ VariantArrayInfo::VariantArrayInfo(int idx, int mode, const std::string& name,
 : m_idx(idx), m_mode(mode), m_name(name), m_schema(schema), m_cell(m_schema), m_tiledb_array(tiledb_array),
   m_metadata_filename(metadata_filename)
 {
+  m_num_cells_written = 0ull;
+  m_num_bytes_written = 0ull;
+  m_observed_cell_sizes = std::make_shared<VariantArrayCellSizeStatistics>(schema.attribute_num());
+  //Cell sizes from the metadata are needed to size the write buffers
+  read_metadata();
   //If writing, allocate buffers
   if(mode == TILEDB_ARRAY_WRITE || mode == TILEDB_ARRAY_WRITE_UNSORTED)
   {
-    m_buffers.clear();
+    //Same total as buffer_size for every buffer
+    auto num_buffers = 1ull; //co-ordinates
     for(auto i=0ull;i<schema.attribute_num();++i)
-    {
-      //For varible length attributes, need extra buffer for maintaining offsets
-      if(m_schema.is_variable_length_field(i))
-        m_buffers.emplace_back(buffer_size);
-      m_buffers.emplace_back(buffer_size);
-    }
-    //Co-ordinates
-    m_buffers.emplace_back(buffer_size);
-    //Initialize pointers to buffers
-    m_buffer_pointers.resize(m_buffers.size());
-    m_buffer_offsets.resize(m_buffers.size());
-    for(auto i=0ull;i<m_buffers.size();++i)
-    {
-      m_buffer_pointers[i] = reinterpret_cast<void*>(&(m_buffers[i][0]));
-      m_buffer_offsets[i] = 0ull; //will be modified during a write
-    }
+      num_buffers += m_schema.is_variable_length_field(i) ? 2u : 1u;
+    m_write_memory_budget = buffer_size*num_buffers;
+    allocate_write_buffers();
   }
-  read_row_bounds_from_metadata();
+  else
+    m_write_memory_budget = 0u;
 #ifdef DEBUG
   m_last_row = m_last_column = -1;
 #endif
@@ -182,12 +519,62 @@ VariantArrayInfo::VariantArrayInfo(VariantArrayInfo&& other)
     m_buffer_pointers[i] = reinterpret_cast<void*>(&(m_buffers[i][0]));
   m_metadata_contains_max_valid_row_idx_in_array = other.m_metadata_contains_max_valid_row_idx_in_array;
   m_max_valid_row_idx_in_array = other.m_max_valid_row_idx_in_array;
+  m_column_histogram = std::move(other.m_column_histogram);
+  m_num_cells_written = other.m_num_cells_written;
+  other.m_num_cells_written = 0ull;
+  m_num_bytes_written = other.m_num_bytes_written;
+  other.m_num_bytes_written = 0ull;
+  m_fragments = std::move(other.m_fragments);
+  m_max_interval_length = other.m_max_interval_length;
+  m_write_memory_budget = other.m_write_memory_budget;
+  m_stored_cell_sizes = other.m_stored_cell_sizes;
+  m_observed_cell_sizes = std::move(other.m_observed_cell_sizes);
 #ifdef DEBUG
   m_last_row = other.m_last_row;
   m_last_column = other.m_last_column;
 #endif
 }
 
+//Buffers are re-sized only if the split changes substantially - re-allocation is not free
+#define WRITE_BUFFER_RESIZE_THRESHOLD 0.25
+
+void VariantArrayInfo::allocate_write_buffers()
+{
+  std::vector<int> attribute_ids(m_schema.attribute_num());
+  for(auto i=0ull;i<attribute_ids.size();++i)
+    attribute_ids[i] = i;
+  std::vector<size_t> buffer_sizes;
+  VariantArrayCellSizeStatistics::compute_buffer_sizes(m_schema, attribute_ids, m_write_memory_budget, buffer_sizes,
+      &m_stored_cell_sizes);
+  if(m_buffers.size() == buffer_sizes.size())
+  {
+    assert(m_buffer_offsets.size() == m_buffers.size());
+    auto resize_needed = false;
+    for(auto i=0ull;i<m_buffers.size() && !resize_needed;++i)
+    {
+      assert(m_buffer_offsets[i] == 0ull);
+      resize_needed = (fabs(static_cast<double>(buffer_sizes[i])-m_buffers[i].size())
+          > WRITE_BUFFER_RESIZE_THRESHOLD*m_buffers[i].size());
+    }
+    if(!resize_needed)
+      return;
+  }
+  m_buffers.resize(buffer_sizes.size());
+  for(auto i=0ull;i<m_buffers.size();++i)
+  {
+    m_buffers[i].resize(buffer_sizes[i]);
+    m_buffers[i].shrink_to_fit();
+  }
+  //Initialize pointers to buffers
+  m_buffer_pointers.resize(m_buffers.size());
+  m_buffer_offsets.resize(m_buffers.size());
+  for(auto i=0ull;i<m_buffers.size();++i)
+  {
+    m_buffer_pointers[i] = reinterpret_cast<void*>(&(m_buffers[i][0]));
+    m_buffer_offsets[i] = 0ull; //will be modified during a write
+  }
+}
+
 void VariantArrayInfo::write_cell(const void* ptr)
 {
   m_cell.set_cell(ptr);
@@ -226,11 +613,38 @@ void VariantArrayInfo::write_cell(const void* ptr)
   //write to array and reset sizes
   if(overflow)
   {
-    auto status = tiledb_array_write(m_tiledb_array, const_cast<const void**>(&(m_buffer_pointers[0])), &(m_buffer_offsets[0]));
-    VERIFY_OR_THROW(status == TILEDB_OK);
-    memset(&(m_buffer_offsets[0]), 0, m_buffer_offsets.size()*sizeof(size_t));
+    //Buffers may be empty if the cell alone is larger than a buffer
+    if(m_buffer_offsets[coords_buffer_idx] > 0ull)
+    {
+      auto status = tiledb_array_write(m_tiledb_array, const_cast<const void**>(&(m_buffer_pointers[0])), &(m_buffer_offsets[0]));
+      VERIFY_OR_THROW(status == TILEDB_OK);
+      memset(&(m_buffer_offsets[0]), 0, m_buffer_offsets.size()*sizeof(size_t));
+    }
+    //Cell sizes seen so far may call for a different split
+    allocate_write_buffers();
+    //A single cell larger than its buffer - offsets, field or co-ordinates
+    auto grow_buffer = [this](const size_t idx, const size_t num_bytes) {
+      if(num_bytes > m_buffers[idx].size())
+      {
+        m_buffers[idx].resize(num_bytes);
+        m_buffer_pointers[idx] = reinterpret_cast<void*>(&(m_buffers[idx][0]));
+      }
+    };
+    buffer_idx = 0ull;
+    for(auto i=0ull;i<m_schema.attribute_num();++i)
+    {
+      if(m_schema.is_variable_length_field(i))
+      {
+        grow_buffer(buffer_idx, sizeof(size_t));
+        ++buffer_idx;
+      }
+      grow_buffer(buffer_idx, m_cell.get_field_size_in_bytes(i));
+      ++buffer_idx;
+    }
+    grow_buffer(coords_buffer_idx, coords_size);
   }
   buffer_idx = 0;
+  auto cell_size_in_bytes = coords_size;
   for(auto i=0ull;i<m_schema.attribute_num();++i)
   {
     assert(buffer_idx < m_buffer_pointers.size());
@@ -248,6 +662,8 @@ void VariantArrayInfo::write_cell(const void* ptr)
     assert(m_buffer_offsets[buffer_idx]+field_size <= m_buffers[buffer_idx].size());
     memcpy(&(m_buffers[buffer_idx][m_buffer_offsets[buffer_idx]]), m_cell.get_field_ptr_for_query_idx<void>(i), field_size);
     m_buffer_offsets[buffer_idx] += field_size;
+    cell_size_in_bytes += field_size;
+    m_stored_cell_sizes.add_cell_field(i, field_size);
     ++buffer_idx;
   }
   //Co-ordinates
@@ -255,32 +671,225 @@ void VariantArrayInfo::write_cell(const void* ptr)
   assert(m_buffer_offsets[coords_buffer_idx]+coords_size <= m_buffers[coords_buffer_idx].size());
   memcpy(&(m_buffers[coords_buffer_idx][m_buffer_offsets[coords_buffer_idx]]), ptr, coords_size);
   m_buffer_offsets[coords_buffer_idx] += coords_size;
+  //END copies of intervals are not counted - the histogram matches #cells returned by a scan
+  assert(m_schema.attribute_name(0u) == "END");
+  auto END_v = *(m_cell.get_field_ptr_for_query_idx<int64_t>(0u));
+  if(END_v >= m_cell.get_begin_column())
+  {
+    m_column_histogram.add_cell(m_cell.get_begin_column(), cell_size_in_bytes);
+    if(m_max_interval_length >= 0)
+      m_max_interval_length = std::max<int64_t>(m_max_interval_length, END_v-m_cell.get_begin_column());
+  }
+  ++m_num_cells_written;
+  m_num_bytes_written += cell_size_in_bytes;
+}
+
+//Metadata JSON is shared by the row bounds and the column histogram - updates must preserve other members
+static bool read_metadata_json(const std::string& metadata_filename, rapidjson::Document& json_doc)
+{
+  json_doc.SetObject();
+  if(metadata_filename.empty())
+    return false;
+  std::ifstream ifs(metadata_filename.c_str());
+  if(!ifs.is_open())
+    return false;
+  std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  json_doc.Parse(str.c_str());
+  if(json_doc.HasParseError() || !json_doc.IsObject())
+    throw VariantStorageManagerException(std::string("Syntax error in corrupted JSON metadata file ")+metadata_filename);
+  return true;
+}
+
+//Unique suffix of temporary metadata files within the process
+static std::atomic<uint64_t> g_metadata_tmp_file_idx(0ull);
+
+/*
+ * Readers may open the array while the metadata is re-written (e.g. by background consolidation) -
+ * the JSON is written to a temporary file in the same directory and renamed over the old file, so
+ * readers see either the old or the new metadata, never a partially written file
+ */
+static void write_metadata_json(const std::string& metadata_filename, const rapidjson::Document& json_doc)
+{
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  json_doc.Accept(writer);
+  auto tmp_filename = metadata_filename+".tmp."+std::to_string(getpid())+'.'
+    +std::to_string(g_metadata_tmp_file_idx++);
+  auto* fptr = fopen(tmp_filename.c_str(), "w");
+  if(fptr == 0)
+    throw VariantStorageManagerException(std::string("Could not open metadata file ")+tmp_filename+" for writing");
+  auto length = strlen(buffer.GetString());
+  auto is_written = (fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, length, fptr) == length);
+  is_written = (fclose(fptr) == 0) && is_written;
+  if(!is_written || rename(tmp_filename.c_str(), metadata_filename.c_str()) != 0)
+  {
+    remove(tmp_filename.c_str());
+    throw VariantStorageManagerException(std::string("Could not write metadata file ")+metadata_filename);
+  }
+}
+
+static void set_metadata_member(rapidjson::Document& json_doc, const char* name, rapidjson::Value& value)
+{
+  if(json_doc.HasMember(name))
+    json_doc[name] = value;
+  else
+    json_doc.AddMember(rapidjson::Value(name, json_doc.GetAllocator()).Move(), value, json_doc.GetAllocator());
+}
+
+//"column_histogram" : { "bin_size": <columns>, "bins": [ [ bin_idx, #cells, #bytes ], .. ] }
+static void read_column_histogram_from_metadata(const rapidjson::Document& json_doc, ColumnCellHistogram& histogram)
+{
+  if(!json_doc.HasMember("column_histogram") || !json_doc["column_histogram"].IsObject())
+    return;
+  const auto& histogram_dict = json_doc["column_histogram"];
+  VERIFY_OR_THROW(histogram_dict.HasMember("bin_size") && histogram_dict["bin_size"].IsUint64()
+      && histogram_dict.HasMember("bins") && histogram_dict["bins"].IsArray());
+  histogram.set_bin_size(histogram_dict["bin_size"].GetUint64());
+  const auto& bins = histogram_dict["bins"];
+  for(rapidjson::SizeType i=0u;i<bins.Size();++i)
+  {
+    const auto& bin = bins[i];
+    VERIFY_OR_THROW(bin.IsArray() && bin.Size() == 3u);
+    histogram.add_bin(bin[0u].GetUint64(), bin[1u].GetUint64(), bin[2u].GetUint64());
+  }
+}
+
+//"cell_sizes" : { "<attribute>" : [ #cells, #bytes ], .. }
+static void read_cell_sizes_from_metadata(const rapidjson::Document& json_doc, const VariantArraySchema& schema,
+    VariantArrayCellSizeStatistics& cell_sizes)
+{
+  if(!json_doc.HasMember("cell_sizes") || !json_doc["cell_sizes"].IsObject())
+    return;
+  const auto& cell_sizes_dict = json_doc["cell_sizes"];
+  for(auto i=0ull;i<schema.attribute_num();++i)
+  {
+    const auto& name = schema.attribute_name(i);
+    if(!cell_sizes_dict.HasMember(name.c_str()))
+      continue;
+    const auto& counts = cell_sizes_dict[name.c_str()];
+    VERIFY_OR_THROW(counts.IsArray() && counts.Size() == 2u);
+    cell_sizes.add(i, counts[0u].GetUint64(), counts[1u].GetUint64());
+  }
+}
+
+//"fragments" : [ [ #cells, #bytes ], .. ] - oldest first
+static void read_fragments_from_metadata(const rapidjson::Document& json_doc,
+    std::vector<VariantArrayFragmentInfo>& fragments)
+{
+  fragments.clear();
+  if(json_doc.HasMember("fragments") && json_doc["fragments"].IsArray())
+  {
+    const auto& fragments_list = json_doc["fragments"];
+    for(rapidjson::SizeType i=0u;i<fragments_list.Size();++i)
+    {
+      const auto& fragment = fragments_list[i];
+      VERIFY_OR_THROW(fragment.IsArray() && fragment.Size() == 2u);
+      fragments.emplace_back(fragment[0u].GetUint64(), fragment[1u].GetUint64());
+    }
+    return;
+  }
+  //Loaded before fragments were tracked - whatever was stored counts as a single fragment
+  if(!json_doc.HasMember("cell_sizes") || !json_doc["cell_sizes"].IsObject())
+    return;
+  VariantArrayFragmentInfo fragment;
+  const auto& cell_sizes_dict = json_doc["cell_sizes"];
+  for(auto iter=cell_sizes_dict.MemberBegin();iter!=cell_sizes_dict.MemberEnd();++iter)
+  {
+    const auto& counts = (*iter).value;
+    VERIFY_OR_THROW(counts.IsArray() && counts.Size() == 2u);
+    fragment.m_num_cells = std::max<uint64_t>(fragment.m_num_cells, counts[0u].GetUint64());
+    fragment.m_num_bytes += counts[1u].GetUint64();
+  }
+  if(fragment.m_num_cells > 0ull)
+    fragments.push_back(fragment);
 }
 
-void VariantArrayInfo::read_row_bounds_from_metadata()
+void VariantArrayInfo::read_metadata()
 {
   //Compute value from array schema
   m_metadata_contains_max_valid_row_idx_in_array = false;
   const auto& dim_domains = m_schema.dim_domains();
   m_max_valid_row_idx_in_array = dim_domains[0].second;
+  m_column_histogram.clear();
+  m_stored_cell_sizes.clear(m_schema.attribute_num());
+  m_fragments.clear();
+  m_max_interval_length = -1ll;
   //Try reading from metadata
-  if(m_metadata_filename.length())
+  rapidjson::Document json_doc;
+  if(!read_metadata_json(m_metadata_filename, json_doc))
+    return;
+  //Present only if every cell of the array was seen while it was tracked
+  if(json_doc.HasMember("max_interval_length") && json_doc["max_interval_length"].IsInt64())
+    m_max_interval_length = json_doc["max_interval_length"].GetInt64();
+  if(json_doc.HasMember("max_valid_row_idx_in_array") && json_doc["max_valid_row_idx_in_array"].IsInt64())
   {
-    std::ifstream ifs(m_metadata_filename.c_str());
-    if(ifs.is_open())
-    {
-      rapidjson::Document json_doc;
-      std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
-      json_doc.Parse(str.c_str());
-      if(json_doc.HasParseError())
-        throw VariantStorageManagerException(std::string("Syntax error in corrupted JSON metadata file ")+m_metadata_filename);
-      if(json_doc.HasMember("max_valid_row_idx_in_array") && json_doc["max_valid_row_idx_in_array"].IsInt64())
-      {
-        m_max_valid_row_idx_in_array = json_doc["max_valid_row_idx_in_array"].GetInt64();
-        m_metadata_contains_max_valid_row_idx_in_array = true;
-      }
-    }
+    m_max_valid_row_idx_in_array = json_doc["max_valid_row_idx_in_array"].GetInt64();
+    m_metadata_contains_max_valid_row_idx_in_array = true;
+  }
+  read_column_histogram_from_metadata(json_doc, m_column_histogram);
+  read_cell_sizes_from_metadata(json_doc, m_schema, m_stored_cell_sizes);
+  read_fragments_from_metadata(json_doc, m_fragments);
+}
+
+void VariantArrayInfo::write_statistics_to_metadata()
+{
+  m_num_cells_written = 0ull;
+  m_num_bytes_written = 0ull;
+  if(m_metadata_filename.empty())
+    return;
+  rapidjson::Document json_doc;
+  read_metadata_json(m_metadata_filename, json_doc);
+  auto& allocator = json_doc.GetAllocator();
+  rapidjson::Value histogram_dict(rapidjson::kObjectType);
+  histogram_dict.AddMember("bin_size", m_column_histogram.get_bin_size(), allocator);
+  rapidjson::Value bins(rapidjson::kArrayType);
+  for(const auto& bin : m_column_histogram.get_bins())
+  {
+    rapidjson::Value curr_bin(rapidjson::kArrayType);
+    curr_bin.PushBack(bin.first, allocator);
+    curr_bin.PushBack(bin.second.m_num_cells, allocator);
+    curr_bin.PushBack(bin.second.m_num_bytes, allocator);
+    bins.PushBack(curr_bin, allocator);
+  }
+  histogram_dict.AddMember("bins", bins, allocator);
+  set_metadata_member(json_doc, "column_histogram", histogram_dict);
+  rapidjson::Value cell_sizes_dict(rapidjson::kObjectType);
+  for(auto i=0ull;i<m_schema.attribute_num();++i)
+  {
+    rapidjson::Value counts(rapidjson::kArrayType);
+    counts.PushBack(m_stored_cell_sizes.get_num_cells(i), allocator);
+    counts.PushBack(m_stored_cell_sizes.get_num_bytes(i), allocator);
+    cell_sizes_dict.AddMember(rapidjson::Value(m_schema.attribute_name(i).c_str(), allocator).Move(), counts, allocator);
+  }
+  set_metadata_member(json_doc, "cell_sizes", cell_sizes_dict);
+  rapidjson::Value fragments_list(rapidjson::kArrayType);
+  for(const auto& fragment : m_fragments)
+  {
+    rapidjson::Value curr_fragment(rapidjson::kArrayType);
+    curr_fragment.PushBack(fragment.m_num_cells, allocator);
+    curr_fragment.PushBack(fragment.m_num_bytes, allocator);
+    fragments_list.PushBack(curr_fragment, allocator);
+  }
+  set_metadata_member(json_doc, "fragments", fragments_list);
+  if(m_max_interval_length >= 0)
+  {
+    rapidjson::Value value(m_max_interval_length);
+    set_metadata_member(json_doc, "max_interval_length", value);
   }
+  write_metadata_json(m_metadata_filename, json_doc);
+}
+
+void VariantArrayInfo::merge_fragments()
+{
+  VariantArrayFragmentInfo merged_fragment;
+  for(const auto& fragment : m_fragments)
+  {
+    merged_fragment.m_num_cells += fragment.m_num_cells;
+    merged_fragment.m_num_bytes += fragment.m_num_bytes;
+  }
+  m_fragments.clear();
+  if(merged_fragment.m_num_cells > 0ull)
+    m_fragments.push_back(merged_fragment);
 }
 
 void VariantArrayInfo::update_row_bounds_in_array(TileDB_CTX* tiledb_ctx, const std::string& metadata_filename,
@@ -296,16 +905,13 @@ void VariantArrayInfo::update_row_bounds_in_array(TileDB_CTX* tiledb_ctx, const
   {
     m_max_valid_row_idx_in_array = max_valid_row_idx_in_array;
     rapidjson::Document json_doc;
-    json_doc.SetObject();
-    json_doc.AddMember("lb_row_idx", lb_row_idx, json_doc.GetAllocator());
-    json_doc.AddMember("max_valid_row_idx_in_array", max_valid_row_idx_in_array, json_doc.GetAllocator());
-    rapidjson::StringBuffer buffer;
-    rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-    json_doc.Accept(writer);
-    auto* fptr = fopen(metadata_filename.c_str(), "w");
-    VERIFY_OR_THROW(fptr);
-    fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, strlen(buffer.GetString()), fptr);
-    fclose(fptr);
+    read_metadata_json(metadata_filename, json_doc);
+    rapidjson::Value value;
+    value.SetInt64(lb_row_idx);
+    set_metadata_member(json_doc, "lb_row_idx", value);
+    value.SetInt64(max_valid_row_idx_in_array);
+    set_metadata_member(json_doc, "max_valid_row_idx_in_array", value);
+    write_metadata_json(metadata_filename, json_doc);
   }
 }
 
@@ -314,6 +920,7 @@ VariantStorageManager::VariantStorageManager(const std::string& workspace, const
 {
   m_workspace = workspace;
   m_segment_size = segment_size;
+  m_iterator_memory_budget = 0u;
   /*Initialize context with default params*/
   tiledb_ctx_init(&m_tiledb_ctx, NULL);
   //Create workspace if it does not exist
@@ -383,6 +990,9 @@ int VariantStorageManager::open_array(const std::string& array_name, const char*
         0, 0, 0);
     if(status == TILEDB_OK)
     {
+      //Cached tiles become stale once cells are written
+      if(mode_int == TILEDB_ARRAY_WRITE || mode_int == TILEDB_ARRAY_WRITE_UNSORTED)
+        VariantArrayTileCache::get_instance().invalidate(m_workspace+'/'+array_name);
       auto idx = m_open_arrays_info_vector.size();
       //Schema
       VariantArraySchema tmp_schema;
@@ -405,7 +1015,12 @@ void VariantStorageManager::close_array(const int ad, const bool consolidate_til
 {
   VERIFY_OR_THROW(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
       m_open_arrays_info_vector[ad].get_array_name().length());
+  auto mode = m_open_arrays_info_vector[ad].get_mode();
+  auto array_path = m_workspace+'/'+m_open_arrays_info_vector[ad].get_array_name();
   m_open_arrays_info_vector[ad].close_array(consolidate_tiledb_array);
+  //Buffered cells are flushed by close
+  if(mode == TILEDB_ARRAY_WRITE || mode == TILEDB_ARRAY_WRITE_UNSORTED || consolidate_tiledb_array)
+    VariantArrayTileCache::get_instance().invalidate(array_path);
 }
 
 int VariantStorageManager::define_array(const VariantArraySchema* variant_array_schema, const size_t num_cells_per_tile)
@@ -479,7 +1094,7 @@ int VariantStorageManager::define_array(const VariantArraySchema* variant_array_
   {
     status = tiledb_array_free_schema(&array_schema);
     if(status == TILEDB_OK)
-      status = define_metadata_schema(variant_array_schema);
+      status = define_metadata_schema(variant_array_schema, true);
   }
   return status;
 }
@@ -490,24 +1105,21 @@ void VariantStorageManager::delete_array(const std::string& array_name)
   if(array_exists)
   {
     remove(GET_METADATA_PATH(m_workspace, array_name).c_str());
+    VariantArrayTileCache::get_instance().invalidate(m_workspace+'/'+array_name);
     auto status = tiledb_delete(m_tiledb_ctx, (m_workspace+"/"+array_name).c_str());
     VERIFY_OR_THROW(status == TILEDB_OK);
   }
 }
 
 //Define metadata
-int VariantStorageManager::define_metadata_schema(const VariantArraySchema* variant_array_schema)
+int VariantStorageManager::define_metadata_schema(const VariantArraySchema* variant_array_schema, const bool is_new_array)
 {
-  auto* fptr = fopen(GET_METADATA_PATH(m_workspace, variant_array_schema->array_name()).c_str(), "w");
-  VERIFY_OR_THROW(fptr);
   //Create empty JSON
   rapidjson::Document d;
   d.SetObject();
-  rapidjson::StringBuffer buffer;
-  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
-  d.Accept(writer);
-  fwrite(buffer.GetString(), 1, strlen(buffer.GetString()), fptr);
-  fclose(fptr);
+  if(is_new_array)
+    d.AddMember("max_interval_length", static_cast<int64_t>(0), d.GetAllocator());
+  write_metadata_json(GET_METADATA_PATH(m_workspace, variant_array_schema->array_name()), d);
   return TILEDB_OK;
 }
 
@@ -575,7 +1187,60 @@ VariantArrayCellIterator* VariantStorageManager::begin(
       m_open_arrays_info_vector[ad].get_array_name().length());
   auto& curr_elem = m_open_arrays_info_vector[ad];
   return new VariantArrayCellIterator(m_tiledb_ctx, curr_elem.get_schema(), m_workspace+'/'+curr_elem.get_array_name(),
-      range, attribute_ids, m_segment_size);   
+      range, attribute_ids, get_iterator_memory_budget(attribute_ids, ad), 1u,
+      &(curr_elem.get_stored_cell_sizes()), curr_elem.get_observed_cell_sizes(),
+      use_tile_cache(ad, range, 1u));
+}
+
+bool VariantStorageManager::use_tile_cache(const int ad, const int64_t* ranges, const unsigned num_ranges) const
+{
+  if(!VariantArrayTileCache::get_instance().is_enabled())
+    return false;
+  //Tiles hold all rows - skip the cache if most of the rows read would be outside the queried row ranges
+  auto& curr_elem = m_open_arrays_info_vector[ad];
+  auto lb_row_idx = curr_elem.get_schema().dim_domains()[0].first;
+  auto num_rows_in_array = curr_elem.get_num_valid_rows_in_array();
+  auto num_queried_rows = 0ll;
+  for(auto r=0u;r<num_ranges;++r)
+  {
+    auto row_begin = std::max(ranges[4u*r], lb_row_idx);
+    auto row_end = std::min(ranges[4u*r+1u], lb_row_idx+num_rows_in_array-1);
+    if(row_end >= row_begin)
+      num_queried_rows += (row_end-row_begin+1);
+  }
+  return num_queried_rows*TILE_CACHE_MAX_ROW_AMPLIFICATION >= num_rows_in_array;
+}
+
+size_t VariantStorageManager::get_iterator_memory_budget(const std::vector<int>& attribute_ids, const int ad) const
+{
+  if(m_iterator_memory_budget > 0u)
+    return m_iterator_memory_budget;
+  auto& schema = m_open_arrays_info_vector[ad].get_schema();
+  auto num_buffers = 1ull; //co-ordinates
+  for(auto schema_idx : attribute_ids)
+    num_buffers += schema.is_variable_length_field(schema_idx) ? 2u : 1u;
+  return m_segment_size*num_buffers;
+}
+
+VariantArrayCellIterator* VariantStorageManager::begin(
+    int ad, const std::vector<RowRange>& row_ranges, const int64_t column_begin, const int64_t column_end,
+    const std::vector<int>& attribute_ids) const
+{
+  VERIFY_OR_THROW(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  auto& curr_elem = m_open_arrays_info_vector[ad];
+  std::vector<int64_t> ranges(4u*row_ranges.size());
+  for(auto i=0ull;i<row_ranges.size();++i)
+  {
+    ranges[4u*i] = row_ranges[i].first;
+    ranges[4u*i+1u] = row_ranges[i].second;
+    ranges[4u*i+2u] = column_begin;
+    ranges[4u*i+3u] = column_end;
+  }
+  return new VariantArrayCellIterator(m_tiledb_ctx, curr_elem.get_schema(), m_workspace+'/'+curr_elem.get_array_name(),
+      ranges.empty() ? 0 : &(ranges[0]), attribute_ids, get_iterator_memory_budget(attribute_ids, ad), row_ranges.size(),
+      &(curr_elem.get_stored_cell_sizes()), curr_elem.get_observed_cell_sizes(),
+      use_tile_cache(ad, ranges.empty() ? 0 : &(ranges[0]), row_ranges.size()));
 }
 
 void VariantStorageManager::write_cell_sorted(const int ad, const void* ptr)
@@ -599,3 +1264,56 @@ void VariantStorageManager::update_row_bounds_in_array(const int ad, const int64
   m_open_arrays_info_vector[ad].update_row_bounds_in_array(m_tiledb_ctx,
       GET_METADATA_PATH(m_workspace,m_open_arrays_info_vector[ad].get_array_name()), lb_row_idx, max_valid_row_idx_in_array);
 }
+
+const ColumnCellHistogram& VariantStorageManager::get_column_histogram(const int ad) const
+{
+  VERIFY_OR_THROW(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  return m_open_arrays_info_vector[ad].get_column_histogram();
+}
+
+int64_t VariantStorageManager::get_max_interval_length(const int ad) const
+{
+  VERIFY_OR_THROW(static_cast<size_t>(ad) < m_open_arrays_info_vector.size() &&
+      m_open_arrays_info_vector[ad].get_array_name().length());
+  return m_open_arrays_info_vector[ad].get_max_interval_length();
+}
+
+bool VariantStorageManager::read_column_histogram(const std::string& workspace, const std::string& array_name,
+    ColumnCellHistogram& histogram)
+{
+  histogram.clear();
+  rapidjson::Document json_doc;
+  if(!read_metadata_json(GET_METADATA_PATH(workspace, array_name), json_doc))
+    return false;
+  read_column_histogram_from_metadata(json_doc, histogram);
+  return !histogram.empty();
+}
+
+bool VariantStorageManager::read_fragments(const std::string& workspace, const std::string& array_name,
+    std::vector<VariantArrayFragmentInfo>& fragments)
+{
+  fragments.clear();
+  rapidjson::Document json_doc;
+  if(!read_metadata_json(GET_METADATA_PATH(workspace, array_name), json_doc))
+    return false;
+  read_fragments_from_metadata(json_doc, fragments);
+  return !fragments.empty();
+}
+
+bool VariantStorageManager::consolidate_array(const std::string& array_name, const FragmentConsolidationPolicy* policy)
+{
+  if(policy)
+  {
+    std::vector<VariantArrayFragmentInfo> fragments;
+    read_fragments(m_workspace, array_name, fragments);
+    if(!policy->needs_consolidation(fragments))
+      return false;
+  }
+  auto ad = open_array(array_name, "w");
+  if(ad < 0)
+    throw VariantStorageManagerException(std::string("Error opening array ")+array_name
+        +" in workspace "+m_workspace+" when trying to consolidate");
+  close_array(ad, true);
+  return true;
+}
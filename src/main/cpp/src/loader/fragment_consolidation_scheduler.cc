@@ -0,0 +1,121 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "fragment_consolidation_scheduler.h"
+
+FragmentConsolidationScheduler& FragmentConsolidationScheduler::get_instance()
+{
+  static FragmentConsolidationScheduler scheduler;
+  return scheduler;
+}
+
+FragmentConsolidationScheduler::FragmentConsolidationScheduler()
+{
+  //Consolidation invalidates cached tiles - the cache must outlive this object at exit
+  VariantArrayTileCache::get_instance();
+  m_stop = false;
+  m_num_consolidations = 0ull;
+  m_num_failed_consolidations = 0ull;
+}
+
+FragmentConsolidationScheduler::~FragmentConsolidationScheduler()
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stop = true;
+  }
+  m_request_available.notify_all();
+  if(m_worker.joinable())
+    m_worker.join();
+}
+
+void FragmentConsolidationScheduler::schedule(const std::string& workspace, const std::string& array_name,
+    const FragmentConsolidationPolicy& policy)
+{
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto array_path = get_array_path(workspace, array_name);
+    for(const auto& request : m_requests)
+      if(get_array_path(request.m_workspace, request.m_array_name) == array_path)
+        return;
+    m_requests.push_back(ConsolidationRequest{ workspace, array_name, policy });
+    //Worker is started by the first request
+    if(!m_worker.joinable())
+      m_worker = std::thread(&FragmentConsolidationScheduler::worker_loop, this);
+  }
+  m_request_available.notify_one();
+}
+
+bool FragmentConsolidationScheduler::is_pending_or_running(const std::string& array_path) const
+{
+  if(array_path.empty())
+    return !m_requests.empty() || !m_running_array_path.empty();
+  if(m_running_array_path == array_path)
+    return true;
+  for(const auto& request : m_requests)
+    if(get_array_path(request.m_workspace, request.m_array_name) == array_path)
+      return true;
+  return false;
+}
+
+void FragmentConsolidationScheduler::wait(const std::string& workspace, const std::string& array_name)
+{
+  auto array_path = array_name.empty() ? std::string("") : get_array_path(workspace, array_name);
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_request_done.wait(lock, [this, &array_path] { return !is_pending_or_running(array_path); });
+}
+
+void FragmentConsolidationScheduler::worker_loop()
+{
+  std::unique_lock<std::mutex> lock(m_mutex);
+  while(true)
+  {
+    //Pending requests are completed even if stop is set
+    m_request_available.wait(lock, [this] { return m_stop || !m_requests.empty(); });
+    if(m_requests.empty())
+      break;
+    auto request = std::move(m_requests.front());
+    m_requests.pop_front();
+    m_running_array_path = get_array_path(request.m_workspace, request.m_array_name);
+    lock.unlock();
+    auto consolidated = false;
+    auto failed = false;
+    try
+    {
+      VariantStorageManager storage_manager(request.m_workspace);
+      consolidated = storage_manager.consolidate_array(request.m_array_name, &(request.m_policy));
+    }
+    catch(const std::exception& e)
+    {
+      std::cerr << "[GenomicsDB::FragmentConsolidationScheduler] ERROR: consolidation of array "
+        << request.m_array_name << " in workspace " << request.m_workspace << " failed - " << e.what() << "\n";
+      failed = true;
+    }
+    lock.lock();
+    m_running_array_path.clear();
+    if(consolidated)
+      ++m_num_consolidations;
+    if(failed)
+      ++m_num_failed_consolidations;
+    m_request_done.notify_all();
+  }
+}
@@ -22,6 +22,7 @@
 
 #include "load_operators.h"
 #include "json_config.h"
+#include "fragment_consolidation_scheduler.h"
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw LoadOperatorException(#X);
 #define ONE_GB (1024ull*1024ull*1024ull)
@@ -137,6 +138,10 @@ LoaderArrayWriter::LoaderArrayWriter(
   //Storage manager
   size_t segment_size = m_loader_json_config.get_segment_size();
   m_storage_manager = new VariantStorageManager(workspace, segment_size);
+  //Workspace exists now - persist automatically computed column partitions for later loads/queries
+  m_loader_json_config.store_auto_column_partitions(rank);
+  //A background consolidation of this array may still be running
+  FragmentConsolidationScheduler::get_instance().wait(workspace, array_name);
   if(m_loader_json_config.delete_and_create_tiledb_array())
     m_storage_manager->delete_array(array_name);
   //Open array in write mode
@@ -307,7 +312,20 @@ void LoaderArrayWriter::finish(const int64_t column_interval_end)
     write_top_element_to_disk();
 #endif
   if(m_storage_manager && m_array_descriptor >= 0)
+  {
     m_storage_manager->close_array(m_array_descriptor, m_loader_json_config.consolidate_tiledb_array_after_load());
+    //Incremental loads - every load adds a fragment, the policy bounds the #fragments queries touch
+    if(!m_loader_json_config.consolidate_tiledb_array_after_load()
+        && m_loader_json_config.use_fragment_consolidation_policy())
+    {
+      const auto& policy = m_loader_json_config.get_fragment_consolidation_policy();
+      if(m_loader_json_config.consolidate_in_background())
+        FragmentConsolidationScheduler::get_instance().schedule(m_storage_manager->get_workspace(),
+            m_schema->array_name(), policy);
+      else
+        m_storage_manager->consolidate_array(m_schema->array_name(), &policy);
+    }
+  }
 }
 
 #ifdef HTSDIR
@@ -345,6 +363,7 @@ LoaderCombinedGVCFOperator::LoaderCombinedGVCFOperator(const VidMapper* id_mappe
     m_buffered_vcf_adapter = 0;
   }
   JSONVCFAdapterConfig vcf_adapter_config;
+  vcf_adapter_config.set_compute_auto_column_partitions(true);
   vcf_adapter_config.read_from_file(config_filename, *m_vcf_adapter, "", partition_idx);
   //Initialize operator
   if(vcf_adapter_config.get_determine_sites_with_max_alleles() > 0)
@@ -367,12 +386,6 @@ LoaderCombinedGVCFOperator::LoaderCombinedGVCFOperator(const VidMapper* id_mappe
   //Deletion flags
   m_num_calls_with_deletions = 0;
   m_handle_spanning_deletions = handle_spanning_deletions;
-  //Profiling
-#ifdef DO_PROFILING
-  m_stats_ptr = &m_stats;
-#else
-  m_stats_ptr = 0;
-#endif
 #ifdef DO_MEMORY_PROFILING
   m_next_memory_limit = ONE_GB;
 #endif
@@ -420,8 +433,7 @@ void LoaderCombinedGVCFOperator::operate(const void* cell_ptr)
       m_variant, *m_operator, *m_cell,
       m_end_pq, m_tmp_pq_vector,
       m_current_start_position, m_next_start_position,
-      m_num_calls_with_deletions, m_handle_spanning_deletions,
-      m_stats_ptr);
+      m_num_calls_with_deletions, m_handle_spanning_deletions);
 #ifdef DO_MEMORY_PROFILING
   statm_t mem_result;
   read_off_memory_status(mem_result);
@@ -450,7 +462,7 @@ void LoaderCombinedGVCFOperator::finish(const int64_t column_interval_end)
   while(operator_overflow)
   {
     m_query_processor->handle_gvcf_ranges(m_end_pq, m_query_config, m_variant, *m_operator,
-        m_current_start_position, m_next_start_position, column_interval_end == INT64_MAX, m_num_calls_with_deletions, m_stats_ptr);
+        m_current_start_position, m_next_start_position, column_interval_end == INT64_MAX, m_num_calls_with_deletions);
     operator_overflow = m_operator->overflow(); //must be queried before post_operate_sequential and flush_output() are called
 #ifdef DO_MEMORY_PROFILING
     statm_t mem_result;
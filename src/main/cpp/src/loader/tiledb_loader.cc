@@ -22,9 +22,11 @@
 
 #include "tiledb_loader.h"
 #include "timer.h"
+#include "genomicsdb_profiler.h"
 #include "vcf2binary.h"
 #include "tiledb_loader_text_file.h"
 #include "vid_mapper_pb.h"
+#include "fragment_consolidation_scheduler.h"
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw VCF2TileDBException(#X);
 
@@ -68,7 +70,10 @@ VCF2TileDBLoaderConverterBase::VCF2TileDBLoaderConverterBase(
 {
   clear();
   m_idx = idx;
+  set_compute_auto_column_partitions(true);
   JSONLoaderConfig::read_from_file(config_filename, 0, m_idx);
+  LoadBalancedColumnPartitioner::initialize_auto_column_partitions(*this);
+  VariantQueryProcessor::apply_process_wide_settings(*this, m_idx);
   //Override
   m_lb_callset_row_idx = std::max(lb_callset_row_idx, m_lb_callset_row_idx);
   m_ub_callset_row_idx = std::min(ub_callset_row_idx, m_ub_callset_row_idx);
@@ -396,12 +401,24 @@ void VCF2TileDBConverter::write_data_to_buffer_stream(const int64_t buffer_strea
   assert(static_cast<size_t>(local_file_idx) < m_file2binary_handlers.size());
   auto buffer_reader_ptr = dynamic_cast<BufferReaderBase*>(m_file2binary_handlers[local_file_idx]->get_base_reader_ptr(partition_idx));
   assert(buffer_reader_ptr);
+  //Switch back to the internal buffer if the stream was previously in zero-copy mode
+  buffer_reader_ptr->set_external_buffer(0, 0u);
   buffer_reader_ptr->reset_offset();
   buffer_reader_ptr->set_num_valid_bytes_in_buffer(0u);
   auto num_bytes_copied = buffer_reader_ptr->append_data_and_resize_if_needed(data, num_bytes);
   assert(num_bytes_copied == num_bytes);
 }
 
+void VCF2TileDBConverter::use_external_buffer_for_buffer_stream(const int64_t buffer_stream_idx, const unsigned partition_idx,
+    uint8_t* data, const size_t num_bytes)
+{
+  auto local_file_idx = m_vid_mapper->get_local_file_idx_for_buffer_stream_idx(m_idx, buffer_stream_idx);
+  assert(static_cast<size_t>(local_file_idx) < m_file2binary_handlers.size());
+  auto buffer_reader_ptr = dynamic_cast<BufferReaderBase*>(m_file2binary_handlers[local_file_idx]->get_base_reader_ptr(partition_idx));
+  assert(buffer_reader_ptr);
+  buffer_reader_ptr->set_external_buffer(data, num_bytes);
+}
+
 void VCF2TileDBConverter::dump_latest_buffer(unsigned exchange_idx, std::ostream& osptr) const
 {
   auto& curr_exchange = *(m_exchanges[exchange_idx]);
@@ -662,14 +679,13 @@ void VCF2TileDBLoader::finish_read_all(const VCF2TileDBLoaderReadState& read_sta
   auto& flush_output_timer = read_state.m_flush_output_timer;
   for(auto op : m_operators)
     op->finish(get_column_partition_end());
-#ifdef DO_PROFILING
-  fetch_timer.print_detail("Fetch from VCF", std::cerr);
-  load_timer.print_detail("Combining cells", std::cerr);
-  flush_output_timer.print_detail("Flush output", std::cerr);
-  read_state.m_sections_timer.print_detail("Sections time", std::cerr);
-  read_state.m_single_thread_phase_timer.print_detail("Time in single thread phase()", std::cerr);
-  read_state.m_time_in_read_all.print_detail("Time in read_all()", std::cerr);
-#endif
+  //Runtime profiler - recorded as part of the report written at exit
+  GenomicsDBProfiler::record_timer("Fetch from VCF", fetch_timer);
+  GenomicsDBProfiler::record_timer("Combining cells", load_timer);
+  GenomicsDBProfiler::record_timer("Flush output", flush_output_timer);
+  GenomicsDBProfiler::record_timer("Sections time", read_state.m_sections_timer);
+  GenomicsDBProfiler::record_timer("Time in single thread phase()", read_state.m_single_thread_phase_timer);
+  GenomicsDBProfiler::record_timer("Time in read_all()", read_state.m_time_in_read_all);
 }
 
 void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
@@ -694,12 +710,14 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
 #pragma omp single
     {
       single_thread_phase_timer.start();
+      auto single_thread_phase_begin_ticks = GenomicsDBProfiler::begin_span();
       fetch_exchange_counter = (exchange_counter+1u)%num_exchanges;
       load_exchange_counter = exchange_counter;
       //For row idx requested, reserve entries
       reserve_entries_in_circular_buffer(fetch_exchange_counter);
       for(auto op : m_operators)
         op->pre_operate_sequential();
+      GenomicsDBProfiler::end_span(PROFILER_SPAN_LOADER_SINGLE_THREAD_PHASE, single_thread_phase_begin_ticks);
       single_thread_phase_timer.stop();
       sections_timer.start();
     }
@@ -710,6 +728,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
         //#pragma omp critical
         //std::cerr << "Fetch thread id "<<omp_get_thread_num()<<" level "<<omp_get_active_level()<<"\n";
         fetch_timer.start();
+        ProfilerSpan span(PROFILER_SPAN_LOADER_FETCH);
         m_converter->read_next_batch(fetch_exchange_counter);
         if(!m_do_ping_pong_buffering)
           advance_write_idxs(fetch_exchange_counter);
@@ -720,6 +739,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
         //#pragma omp critical
         //std::cerr << "Load thread id "<<omp_get_thread_num()<<" level "<<omp_get_active_level()<<"\n";
         load_timer.start();
+        ProfilerSpan span(PROFILER_SPAN_LOADER_COMBINE);
 #ifdef PRODUCE_CSV_CELLS
         done = dump_latest_buffer(load_exchange_counter, std::cout);
 #endif
@@ -732,6 +752,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
       if(m_offload_vcf_output_processing)
       {
         flush_output_timer.start();
+        ProfilerSpan span(PROFILER_SPAN_LOADER_FLUSH_OUTPUT);
         for(auto op : m_operators)
           op->flush_output();
         flush_output_timer.stop();
@@ -741,6 +762,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
     {
       sections_timer.stop();
       single_thread_phase_timer.start();
+      auto single_thread_phase_begin_ticks = GenomicsDBProfiler::begin_span();
       if(m_do_ping_pong_buffering)
         advance_write_idxs(fetch_exchange_counter);
       for(auto op : m_operators)
@@ -759,6 +781,7 @@ void VCF2TileDBLoader::read_all(VCF2TileDBLoaderReadState& read_state)
         if(m_converter->is_some_buffer_stream_exhausted())
           exit_loop = true;
       }
+      GenomicsDBProfiler::end_span(PROFILER_SPAN_LOADER_SINGLE_THREAD_PHASE, single_thread_phase_begin_ticks);
       single_thread_phase_timer.stop();
       //Critical path update
       std::sort(read_state.m_timer_vec.begin(), read_state.m_timer_vec.end(), TimerCompareWallClockTime());
@@ -1070,12 +1093,14 @@ int VCF2TileDBLoader::create_tiledb_workspace(const char* workspace)
   return returnval;
 }
 
-void VCF2TileDBLoader::consolidate_tiledb_array(const char* workspace, const char* array_name)
+bool VCF2TileDBLoader::consolidate_tiledb_array(const char* workspace, const char* array_name,
+    const FragmentConsolidationPolicy* policy)
 {
+  //Background consolidation of the same array may be pending in this process
+  FragmentConsolidationScheduler::get_instance().wait(workspace, array_name);
   VariantStorageManager sm(workspace);
-  auto ad = sm.open_array(array_name, "w");
-  if(ad < 0)
+  if(!sm.check_if_TileDB_array_exists(array_name))
     throw VCF2TileDBException(std::string("Error opening array ")+array_name
         +" in workspace "+workspace+" when trying to consolidate");
-  sm.close_array(ad, true);
+  return sm.consolidate_array(array_name, policy);
 }
@@ -144,6 +144,11 @@ BroadCombinedGVCFOperator::BroadCombinedGVCFOperator(VCFAdapter& vcf_adapter, co
     std::get<1>(m_vcf_qual_tuple) = query_field_idx;
     std::get<5>(m_vcf_qual_tuple) = query_config.get_VCF_field_combine_operation_for_query_attribute_idx(query_field_idx);
   }
+  //Combine operators are resolved once for the whole query
+  for(const auto& info_tuple : m_INFO_fields_vec)
+    m_INFO_combine_operators.emplace_back(create_INFO_field_combine_operator(info_tuple));
+  if(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(m_vcf_qual_tuple) != VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_UNKNOWN_OPERATION)
+    m_QUAL_combine_operator = create_INFO_field_combine_operator(m_vcf_qual_tuple);
   //Add missing contig names to template header
   for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
   {
@@ -159,10 +164,7 @@ BroadCombinedGVCFOperator::BroadCombinedGVCFOperator(VCFAdapter& vcf_adapter, co
       bcf_hdr_sync(m_vcf_hdr);
     }
   }
-  //Get contig info for position 0, store curr contig in next_contig and call switch_contig function to do all the setup
-  auto curr_contig_flag = m_vid_mapper->get_next_contig_location(-1ll, m_next_contig_name, m_next_contig_begin_position);
-  assert(curr_contig_flag);
-  switch_contig();
+  reset_contig_tracking();
   //Add samples to template header
   std::string callset_name;
   for(auto i=0ull;i<query_config.get_num_rows_to_query();++i)
@@ -190,6 +192,8 @@ void BroadCombinedGVCFOperator::clear()
   m_next_contig_name.clear();
   m_alleles_pointer_buffer.clear();
   m_INFO_fields_vec.clear();
+  m_INFO_combine_operators.clear();
+  m_QUAL_combine_operator.reset();
   m_FORMAT_fields_vec.clear();
   m_MIN_DP_vector.clear();
   m_DP_FORMAT_vector.clear();
@@ -197,52 +201,98 @@ void BroadCombinedGVCFOperator::clear()
   m_spanning_deletion_remapped_GT.clear();
 }
 
-bool BroadCombinedGVCFOperator::handle_VCF_field_combine_operation(const Variant& variant,
-    const INFO_tuple_type& curr_tuple, void*& result_ptr, unsigned& num_result_elements)
+INFOFieldCombineOperatorBase::INFOFieldCombineOperatorBase(const INFO_tuple_type& info_tuple,
+    const VariantQueryConfig& query_config, const unsigned GT_query_idx)
 {
-  auto valid_result_found = false;
-  auto query_field_idx = BCF_INFO_GET_QUERY_FIELD_IDX(curr_tuple);
-  auto length_descriptor = m_query_config->get_length_descriptor_for_query_attribute_idx(query_field_idx);
-  //Fields such as PL are skipped if the #alleles is above a certain threshold
-  if(KnownFieldInfo::is_length_descriptor_genotype_dependent(length_descriptor)
-      && too_many_alt_alleles_for_genotype_length_fields(m_merged_alt_alleles.size()))
-    return false;
-  //Check if this is a field that was remapped - for remapped fields, we must use field objects from m_remapped_variant
-  //else we should use field objects from the original variant
-  auto& src_variant = (m_remapping_needed && (KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor) || query_field_idx == m_GT_query_idx))
-    ? m_remapped_variant : variant;
-  auto variant_type_enum = BCF_INFO_GET_VARIANT_FIELD_TYPE_ENUM(curr_tuple);
-  //valid field handler
-  assert(variant_type_enum < m_field_handlers.size() && m_field_handlers[variant_type_enum].get());
-  auto num_valid_input_elements = 0u;
-  switch(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(curr_tuple))
+  m_query_idx = BCF_INFO_GET_QUERY_FIELD_IDX(info_tuple);
+  m_bcf_ht_type = BCF_INFO_GET_BCF_HT_TYPE(info_tuple);
+  m_element_size = VariantFieldTypeUtil::size(BCF_INFO_GET_VARIANT_FIELD_TYPE_ENUM(info_tuple));
+  m_vcf_field_name = BCF_INFO_GET_VCF_FIELD_NAME(info_tuple);
+  auto length_descriptor = query_config.get_length_descriptor_for_query_attribute_idx(m_query_idx);
+  m_is_genotype_dependent = KnownFieldInfo::is_length_descriptor_genotype_dependent(length_descriptor);
+  m_use_remapped_variant = (KnownFieldInfo::is_length_descriptor_allele_dependent(length_descriptor)
+      || m_query_idx == GT_query_idx);
+}
+
+template<class DataType>
+static INFOFieldCombineOperatorBase* create_INFO_field_combine_operator_for_type(const INFO_tuple_type& info_tuple,
+    const VariantQueryConfig& query_config, const unsigned GT_query_idx, VariantFieldHandlerBase* handler)
+{
+  switch(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(info_tuple))
   {
     case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_SUM:
-      valid_result_found = m_field_handlers[variant_type_enum]->get_valid_sum(src_variant, *m_query_config,
-          query_field_idx, result_ptr, num_valid_input_elements);
-      break;
+      return new INFOFieldCombineOperator<DataType, VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_SUM>(
+          info_tuple, query_config, GT_query_idx, handler);
     case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEAN:
-      valid_result_found = m_field_handlers[variant_type_enum]->get_valid_mean(src_variant, *m_query_config,
-          query_field_idx, result_ptr, num_valid_input_elements);
-      break;
+      return new INFOFieldCombineOperator<DataType, VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEAN>(
+          info_tuple, query_config, GT_query_idx, handler);
     case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEDIAN:
-      valid_result_found = m_field_handlers[variant_type_enum]->get_valid_median(src_variant, *m_query_config,
-          query_field_idx, result_ptr, num_valid_input_elements);
-      break;
+      return new INFOFieldCombineOperator<DataType, VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_MEDIAN>(
+          info_tuple, query_config, GT_query_idx, handler);
     case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_ELEMENT_WISE_SUM:
-      valid_result_found = m_field_handlers[variant_type_enum]->compute_valid_element_wise_sum(src_variant, *m_query_config,
-          query_field_idx, const_cast<const void**>(&result_ptr), num_result_elements);
-      break;
+      return new INFOFieldCombineOperator<DataType, VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_ELEMENT_WISE_SUM>(
+          info_tuple, query_config, GT_query_idx, handler);
     case VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_CONCATENATE:
-      valid_result_found = m_field_handlers[variant_type_enum]->concatenate_field(src_variant, *m_query_config,
-          query_field_idx, const_cast<const void**>(&result_ptr), num_result_elements);
-      break;
+      return new INFOFieldCombineOperator<DataType, VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_CONCATENATE>(
+          info_tuple, query_config, GT_query_idx, handler);
     default:
       throw BroadCombinedGVCFException(std::string("Unknown VCF field combine operation ")
-          +std::to_string(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(curr_tuple)));
+          +std::to_string(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(info_tuple))
+          +" for field "+BCF_INFO_GET_VCF_FIELD_NAME(info_tuple));
+  }
+}
+
+std::unique_ptr<INFOFieldCombineOperatorBase> BroadCombinedGVCFOperator::create_INFO_field_combine_operator(
+    const INFO_tuple_type& info_tuple)
+{
+  auto variant_type_enum = BCF_INFO_GET_VARIANT_FIELD_TYPE_ENUM(info_tuple);
+  //valid field handler
+  assert(variant_type_enum < m_field_handlers.size() && m_field_handlers[variant_type_enum].get());
+  auto* handler = m_field_handlers[variant_type_enum].get();
+  INFOFieldCombineOperatorBase* combine_operator = 0;
+  switch(variant_type_enum)
+  {
+    case VARIANT_FIELD_INT:
+      combine_operator = create_INFO_field_combine_operator_for_type<int>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_UNSIGNED:
+      combine_operator = create_INFO_field_combine_operator_for_type<unsigned>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_INT64_T:
+      combine_operator = create_INFO_field_combine_operator_for_type<int64_t>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_UINT64_T:
+      combine_operator = create_INFO_field_combine_operator_for_type<uint64_t>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_FLOAT:
+      combine_operator = create_INFO_field_combine_operator_for_type<float>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_DOUBLE:
+      combine_operator = create_INFO_field_combine_operator_for_type<double>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    case VARIANT_FIELD_STRING:
+      combine_operator = create_INFO_field_combine_operator_for_type<std::string>(info_tuple, *m_query_config, m_GT_query_idx, handler);
       break;
+    case VARIANT_FIELD_CHAR:
+      combine_operator = create_INFO_field_combine_operator_for_type<char>(info_tuple, *m_query_config, m_GT_query_idx, handler);
+      break;
+    default:
+      throw BroadCombinedGVCFException(std::string("Unhandled type for INFO field ")+BCF_INFO_GET_VCF_FIELD_NAME(info_tuple));
   }
-  return valid_result_found;
+  return std::unique_ptr<INFOFieldCombineOperatorBase>(combine_operator);
+}
+
+bool BroadCombinedGVCFOperator::handle_VCF_field_combine_operation(const Variant& variant,
+    INFOFieldCombineOperatorBase& combine_operator, void*& result_ptr, unsigned& num_result_elements)
+{
+  //Fields such as PL are skipped if the #alleles is above a certain threshold
+  if(combine_operator.is_genotype_dependent()
+      && too_many_alt_alleles_for_genotype_length_fields(m_merged_alt_alleles.size()))
+    return false;
+  //Check if this is a field that was remapped - for remapped fields, we must use field objects from m_remapped_variant
+  //else we should use field objects from the original variant
+  auto& src_variant = (m_remapping_needed && combine_operator.use_remapped_variant()) ? m_remapped_variant : variant;
+  return combine_operator.combine(src_variant, *m_query_config, result_ptr, num_result_elements);
 }
 
 void BroadCombinedGVCFOperator::handle_INFO_fields(const Variant& variant)
@@ -254,19 +304,19 @@ void BroadCombinedGVCFOperator::handle_INFO_fields(const Variant& variant)
     bcf_update_info_int32(m_vcf_hdr, m_bcf_out, "END", &vcf_end_pos, 1);
     m_bcf_record_size += sizeof(int);
   }
-  for(auto i=0u;i<m_INFO_fields_vec.size();++i)
+  for(auto& combine_operator : m_INFO_combine_operators)
   {
-    auto& curr_tuple = m_INFO_fields_vec[i];
     //Just need a 4-byte value, the contents could be a float or int (determined by the templated median function)
     int32_t result = -1;
     void* result_ptr = reinterpret_cast<void*>(&result);
     //For element wise operations
     auto num_result_elements = 1u;
-    auto valid_result_found = handle_VCF_field_combine_operation(variant, curr_tuple, result_ptr, num_result_elements);
+    auto valid_result_found = handle_VCF_field_combine_operation(variant, *combine_operator, result_ptr, num_result_elements);
     if(valid_result_found)
     {
-      bcf_update_info(m_vcf_hdr, m_bcf_out, BCF_INFO_GET_VCF_FIELD_NAME(curr_tuple).c_str(), result_ptr, num_result_elements, BCF_INFO_GET_BCF_HT_TYPE(curr_tuple));
-      m_bcf_record_size += num_result_elements*VariantFieldTypeUtil::size(BCF_INFO_GET_VARIANT_FIELD_TYPE_ENUM(curr_tuple));
+      bcf_update_info(m_vcf_hdr, m_bcf_out, combine_operator->get_vcf_field_name(), result_ptr, num_result_elements,
+          combine_operator->get_bcf_ht_type());
+      m_bcf_record_size += num_result_elements*combine_operator->get_element_size();
     }
   }
 }
@@ -425,9 +475,7 @@ void BroadCombinedGVCFOperator::merge_ID_field(const Variant& variant, const uns
 
 void BroadCombinedGVCFOperator::operate(Variant& variant, const VariantQueryConfig& query_config)
 {
-#ifdef DO_PROFILING
-  m_bcf_t_creation_timer.start();
-#endif
+  auto bcf_t_creation_begin_ticks = GenomicsDBProfiler::begin_span();
   //Handle spanning deletions - change ALT alleles in calls with deletions to *, <NON_REF>
   handle_deletions(variant, query_config);
   GA4GHOperator::operate(variant, query_config);
@@ -469,12 +517,12 @@ void BroadCombinedGVCFOperator::operate(Variant& variant, const VariantQueryConf
   m_bcf_record_size += m_ID_value.length();
   //GATK combined GVCF does not care about QUAL value
   m_bcf_out->qual = get_bcf_missing_value<float>();
-  if(BCF_INFO_GET_VCF_FIELD_COMBINE_OPERATION(m_vcf_qual_tuple) != VCFFieldCombineOperationEnum::VCF_FIELD_COMBINE_OPERATION_UNKNOWN_OPERATION)
+  if(m_QUAL_combine_operator)
   {
     unsigned num_result_elements = 1u;
     auto qual_result = 1.0f;
     void* result_ptr = reinterpret_cast<void*>(&qual_result);
-    auto valid_result_found = handle_VCF_field_combine_operation(variant, m_vcf_qual_tuple, result_ptr, num_result_elements);
+    auto valid_result_found = handle_VCF_field_combine_operation(variant, *m_QUAL_combine_operator, result_ptr, num_result_elements);
     if(valid_result_found)
       m_bcf_out->qual = qual_result;
   }
@@ -508,9 +556,8 @@ void BroadCombinedGVCFOperator::operate(Variant& variant, const VariantQueryConf
   handle_INFO_fields(variant);
   //FORMAT fields
   handle_FORMAT_fields(variant);
-#ifdef DO_PROFILING
-  m_bcf_t_creation_timer.stop();
-#endif
+  GenomicsDBProfiler::end_span(PROFILER_SPAN_BCF_T_CREATION, bcf_t_creation_begin_ticks);
+  GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_BCF_RECORDS);
   m_vcf_adapter->handoff_output_bcf_line(m_bcf_out, m_bcf_record_size);
 }
 
@@ -522,6 +569,14 @@ void BroadCombinedGVCFOperator::switch_contig()
   m_vid_mapper->get_next_contig_location(m_next_contig_begin_position, m_next_contig_name, m_next_contig_begin_position);
 }
 
+void BroadCombinedGVCFOperator::reset_contig_tracking()
+{
+  //Get contig info for position 0, store curr contig in next_contig and call switch_contig function to do all the setup
+  auto curr_contig_flag = m_vid_mapper->get_next_contig_location(-1ll, m_next_contig_name, m_next_contig_begin_position);
+  assert(curr_contig_flag);
+  switch_contig();
+}
+
 //Modifies original Variant object
 void BroadCombinedGVCFOperator::handle_deletions(Variant& variant, const VariantQueryConfig& query_config)
 {
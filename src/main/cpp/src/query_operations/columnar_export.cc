@@ -0,0 +1,489 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "columnar_export.h"
+#include "json_config.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw ColumnarExportException(#X);
+
+//ColumnarColumn functions
+ColumnarColumn::ColumnarColumn(const std::string& name, const std::string& format, const unsigned element_size)
+  : m_name(name), m_format(format), m_element_size(element_size)
+{
+  m_kind = (format == "u") ? COLUMNAR_COLUMN_STRING : COLUMNAR_COLUMN_PRIMITIVE;
+  assert(m_kind == COLUMNAR_COLUMN_STRING || element_size > 0u);
+  clear();
+}
+
+ColumnarColumn::ColumnarColumn(const std::string& name, ColumnarColumn* child)
+  : m_name(name), m_format("+l"), m_element_size(0u), m_child(child)
+{
+  m_kind = COLUMNAR_COLUMN_LIST;
+  assert(child && child->kind() != COLUMNAR_COLUMN_LIST);
+  clear();
+}
+
+ColumnarColumn* ColumnarColumn::create_empty_copy() const
+{
+  if(m_kind == COLUMNAR_COLUMN_LIST)
+    return new ColumnarColumn(m_name, m_child->create_empty_copy());
+  return new ColumnarColumn(m_name, m_format, m_element_size);
+}
+
+void ColumnarColumn::clear()
+{
+  m_length = 0;
+  m_null_count = 0;
+  m_validity.clear();
+  m_data.clear();
+  m_offsets.clear();
+  if(m_kind != COLUMNAR_COLUMN_PRIMITIVE)
+    m_offsets.push_back(0);
+  if(m_child)
+    m_child->clear();
+}
+
+void ColumnarColumn::set_validity(const bool valid)
+{
+  auto byte_idx = static_cast<size_t>(m_length >> 3);
+  if(byte_idx >= m_validity.size())
+    m_validity.push_back(0u);
+  if(valid)
+    m_validity[byte_idx] |= (1u << (m_length & 7));
+  else
+    ++m_null_count;
+  ++m_length;
+}
+
+void ColumnarColumn::append_null()
+{
+  switch(m_kind)
+  {
+    case COLUMNAR_COLUMN_PRIMITIVE:
+      m_data.resize(m_data.size()+m_element_size, 0u);
+      break;
+    default:
+      append_offset(0u);
+      break;
+  }
+  set_validity(false);
+}
+
+void ColumnarColumn::append_primitive(const void* ptr)
+{
+  assert(m_kind == COLUMNAR_COLUMN_PRIMITIVE);
+  auto src = reinterpret_cast<const uint8_t*>(ptr);
+  m_data.insert(m_data.end(), src, src+m_element_size);
+  set_validity(true);
+}
+
+void ColumnarColumn::append_string(const char* ptr, const size_t num_chars)
+{
+  assert(m_kind == COLUMNAR_COLUMN_STRING);
+  append_offset(num_chars);
+  m_data.insert(m_data.end(), ptr, ptr+num_chars);
+  set_validity(true);
+}
+
+void ColumnarColumn::append_primitive_list(const void* ptr, const size_t num_elements)
+{
+  assert(m_kind == COLUMNAR_COLUMN_LIST && m_child->kind() == COLUMNAR_COLUMN_PRIMITIVE);
+  append_offset(num_elements);
+  auto src = reinterpret_cast<const uint8_t*>(ptr);
+  auto& child_data = m_child->m_data;
+  child_data.insert(child_data.end(), src, src+num_elements*m_child->m_element_size);
+  //All list elements are valid - bitmap is still needed as the child is nullable
+  for(auto i=0ull;i<num_elements;++i)
+    m_child->set_validity(true);
+  set_validity(true);
+}
+
+void ColumnarColumn::append_string_list(const std::vector<std::string>& values)
+{
+  assert(m_kind == COLUMNAR_COLUMN_LIST && m_child->kind() == COLUMNAR_COLUMN_STRING);
+  append_offset(values.size());
+  for(const auto& val : values)
+    m_child->append_string(val.c_str(), val.length());
+  set_validity(true);
+}
+
+void ColumnarColumn::get_buffers(std::vector<const void*>& buffers) const
+{
+  buffers.clear();
+  //Arrow allows a NULL validity buffer if null_count == 0
+  buffers.push_back(m_null_count ? reinterpret_cast<const void*>(m_validity.data()) : 0);
+  switch(m_kind)
+  {
+    case COLUMNAR_COLUMN_PRIMITIVE:
+      buffers.push_back(m_data.data());
+      break;
+    case COLUMNAR_COLUMN_STRING:
+      buffers.push_back(m_offsets.data());
+      buffers.push_back(m_data.data());
+      break;
+    case COLUMNAR_COLUMN_LIST:
+      buffers.push_back(m_offsets.data());
+      break;
+  }
+}
+
+//Arrow C data interface export
+//Every ArrowArray node holds a reference to the batch, so consumers may move and release
+//child arrays independently of the parent
+class ColumnarArrayPrivateData
+{
+  public:
+    std::shared_ptr<ColumnarBatch> m_batch;
+    std::vector<const void*> m_buffers;
+    std::vector<ArrowArray*> m_children;
+};
+
+static void release_columnar_array(ArrowArray* array)
+{
+  assert(array && array->release);
+  auto private_data = reinterpret_cast<ColumnarArrayPrivateData*>(array->private_data);
+  for(auto child : private_data->m_children)
+  {
+    if(child->release)
+      child->release(child);
+    delete child;
+  }
+  delete private_data;
+  array->release = 0;
+}
+
+static void fill_arrow_array(ArrowArray* array, const ColumnarColumn& column, const std::shared_ptr<ColumnarBatch>& batch)
+{
+  auto private_data = new ColumnarArrayPrivateData();
+  private_data->m_batch = batch;
+  column.get_buffers(private_data->m_buffers);
+  if(column.child())
+  {
+    auto child = new ArrowArray();
+    fill_arrow_array(child, *(column.child()), batch);
+    private_data->m_children.push_back(child);
+  }
+  array->length = column.length();
+  array->null_count = column.null_count();
+  array->offset = 0;
+  array->n_buffers = private_data->m_buffers.size();
+  array->n_children = private_data->m_children.size();
+  array->buffers = private_data->m_buffers.data();
+  array->children = private_data->m_children.empty() ? 0 : private_data->m_children.data();
+  array->dictionary = 0;
+  array->private_data = reinterpret_cast<void*>(private_data);
+  array->release = release_columnar_array;
+}
+
+class ColumnarSchemaPrivateData
+{
+  public:
+    std::string m_format;
+    std::string m_name;
+    std::vector<ArrowSchema*> m_children;
+};
+
+static void release_columnar_schema(ArrowSchema* schema)
+{
+  assert(schema && schema->release);
+  auto private_data = reinterpret_cast<ColumnarSchemaPrivateData*>(schema->private_data);
+  for(auto child : private_data->m_children)
+  {
+    if(child->release)
+      child->release(child);
+    delete child;
+  }
+  delete private_data;
+  schema->release = 0;
+}
+
+static void fill_arrow_schema(ArrowSchema* schema, const std::string& format, const std::string& name,
+    const bool nullable, ColumnarSchemaPrivateData* private_data)
+{
+  private_data->m_format = format;
+  private_data->m_name = name;
+  schema->format = private_data->m_format.c_str();
+  schema->name = private_data->m_name.c_str();
+  schema->metadata = 0;
+  schema->flags = nullable ? ARROW_FLAG_NULLABLE : 0;
+  schema->n_children = private_data->m_children.size();
+  schema->children = private_data->m_children.empty() ? 0 : private_data->m_children.data();
+  schema->dictionary = 0;
+  schema->private_data = reinterpret_cast<void*>(private_data);
+  schema->release = release_columnar_schema;
+}
+
+static void fill_arrow_schema(ArrowSchema* schema, const ColumnarColumn& column)
+{
+  auto private_data = new ColumnarSchemaPrivateData();
+  if(column.child())
+  {
+    auto child = new ArrowSchema();
+    fill_arrow_schema(child, *(column.child()));
+    private_data->m_children.push_back(child);
+  }
+  fill_arrow_schema(schema, column.format(), column.name(), true, private_data);
+}
+
+//Format string and element size for primitive types
+static bool get_arrow_primitive_format(const std::type_index& type, std::string& format, unsigned& element_size)
+{
+  static const std::unordered_map<std::type_index, std::pair<std::string, unsigned>> type_to_format = {
+    { std::type_index(typeid(int8_t)), { "c", sizeof(int8_t) } },
+    { std::type_index(typeid(uint8_t)), { "C", sizeof(uint8_t) } },
+    { std::type_index(typeid(int16_t)), { "s", sizeof(int16_t) } },
+    { std::type_index(typeid(uint16_t)), { "S", sizeof(uint16_t) } },
+    { std::type_index(typeid(int)), { "i", sizeof(int) } },
+    { std::type_index(typeid(unsigned)), { "I", sizeof(unsigned) } },
+    { std::type_index(typeid(int64_t)), { "l", sizeof(int64_t) } },
+    { std::type_index(typeid(uint64_t)), { "L", sizeof(uint64_t) } },
+    { std::type_index(typeid(float)), { "f", sizeof(float) } },
+    { std::type_index(typeid(double)), { "g", sizeof(double) } }
+  };
+  auto iter = type_to_format.find(type);
+  if(iter == type_to_format.end())
+    return false;
+  format = (*iter).second.first;
+  element_size = (*iter).second.second;
+  return true;
+}
+
+//ColumnarExportOperator functions
+ColumnarExportOperator::ColumnarExportOperator(const VariantQueryConfig& query_config, const VariantArraySchema& schema,
+    const VidMapper& vid_mapper, const int64_t max_num_rows_per_batch)
+  : SingleCellOperatorBase()
+{
+  VERIFY_OR_THROW(max_num_rows_per_batch > 0);
+  m_max_num_rows_per_batch = max_num_rows_per_batch;
+  m_current_batch = std::unique_ptr<ColumnarBatch>(new ColumnarBatch());
+  auto& columns = m_current_batch->m_columns;
+  for(auto name : { "row", "column", "END" })
+  {
+    columns.emplace_back(new ColumnarColumn(name, "l", sizeof(int64_t)));
+    m_column_query_idx.push_back(UNDEFINED_ATTRIBUTE_IDX_VALUE);
+  }
+  //First field is always END - already covered
+  for(auto i=1u;i<query_config.get_num_queried_attributes();++i)
+  {
+    const auto& field_name = query_config.get_query_attribute_name(i);
+    auto schema_idx = query_config.get_schema_idx_for_query_idx(i);
+    auto type = schema.type(schema_idx);
+    //TileDB does not distinguish between char and int8_t fields - flags are int8_t, same as VariantQueryProcessor
+    const auto* vid_field_info = vid_mapper.get_field_info(field_name);
+    if(vid_field_info && vid_field_info->m_bcf_ht_type == BCF_HT_FLAG)
+      type = std::type_index(typeid(int8_t));
+    std::string format;
+    unsigned element_size = 0u;
+    if(query_config.get_known_field_enum_for_query_idx(i) == GVCF_ALT_IDX)
+      columns.emplace_back(new ColumnarColumn(field_name, new ColumnarColumn("item", "u")));
+    else if(type == std::type_index(typeid(char)))
+      columns.emplace_back(new ColumnarColumn(field_name, "u"));
+    else if(get_arrow_primitive_format(type, format, element_size))
+    {
+      if(!schema.is_variable_length_field(schema_idx) && schema.val_num(schema_idx) == 1)
+        columns.emplace_back(new ColumnarColumn(field_name, format, element_size));
+      else
+        columns.emplace_back(new ColumnarColumn(field_name, new ColumnarColumn("item", format, element_size)));
+    }
+    else
+      throw ColumnarExportException(std::string("Unhandled type ")+type.name()+" for field "+field_name);
+    m_column_query_idx.push_back(i);
+  }
+}
+
+void ColumnarExportOperator::operate(VariantCall& call, const VariantQueryConfig& query_config, const VariantArraySchema& schema)
+{
+  auto& columns = m_current_batch->m_columns;
+  int64_t value = call.get_row_idx();
+  columns[0u]->append_primitive(&value);
+  value = call.get_column_begin();
+  columns[1u]->append_primitive(&value);
+  value = call.get_column_end();
+  columns[2u]->append_primitive(&value);
+  for(auto i=3u;i<columns.size();++i)
+  {
+    auto& column = *(columns[i]);
+    const auto& field_ptr = call.get_field(m_column_query_idx[i]);
+    if(field_ptr.get() == 0 || !(field_ptr->is_valid()))
+    {
+      column.append_null();
+      continue;
+    }
+    switch(column.kind())
+    {
+      case COLUMNAR_COLUMN_PRIMITIVE:
+        if(field_ptr->length() > 0u)
+          column.append_primitive(field_ptr->get_raw_pointer());
+        else
+          column.append_null();
+        break;
+      case COLUMNAR_COLUMN_STRING:
+        column.append_string(reinterpret_cast<const char*>(field_ptr->get_raw_pointer()), field_ptr->length());
+        break;
+      case COLUMNAR_COLUMN_LIST:
+        if(column.child()->kind() == COLUMNAR_COLUMN_STRING)
+        {
+          auto ptr = dynamic_cast<const VariantFieldALTData*>(field_ptr.get());
+          assert(ptr);
+          column.append_string_list(ptr->get());
+        }
+        else
+          column.append_primitive_list(field_ptr->get_raw_pointer(), field_ptr->length());
+        break;
+    }
+  }
+  ++(m_current_batch->m_num_rows);
+  if(m_current_batch->m_num_rows >= m_max_num_rows_per_batch)
+    seal_current_batch();
+}
+
+void ColumnarExportOperator::seal_current_batch()
+{
+  auto next_batch = new ColumnarBatch();
+  for(const auto& column : m_current_batch->m_columns)
+    next_batch->m_columns.emplace_back(column->create_empty_copy());
+  m_completed_batches.push_back(std::shared_ptr<ColumnarBatch>(m_current_batch.release()));
+  m_current_batch = std::unique_ptr<ColumnarBatch>(next_batch);
+}
+
+void ColumnarExportOperator::finalize()
+{
+  if(m_current_batch->m_num_rows > 0)
+    seal_current_batch();
+}
+
+void ColumnarExportOperator::export_schema(ArrowSchema* out_schema) const
+{
+  VERIFY_OR_THROW(out_schema);
+  auto private_data = new ColumnarSchemaPrivateData();
+  for(const auto& column : m_current_batch->m_columns)
+  {
+    auto child = new ArrowSchema();
+    fill_arrow_schema(child, *column);
+    private_data->m_children.push_back(child);
+  }
+  //Record batches are exported as non-nullable struct arrays
+  fill_arrow_schema(out_schema, "+s", "", false, private_data);
+}
+
+bool ColumnarExportOperator::export_next_batch(ArrowArray* out_array, ArrowSchema* out_schema)
+{
+  VERIFY_OR_THROW(out_array);
+  if(m_completed_batches.empty())
+    return false;
+  auto batch = m_completed_batches.front();
+  m_completed_batches.pop_front();
+  auto private_data = new ColumnarArrayPrivateData();
+  private_data->m_batch = batch;
+  private_data->m_buffers.push_back(0); //struct validity - no nulls
+  for(const auto& column : batch->m_columns)
+  {
+    auto child = new ArrowArray();
+    fill_arrow_array(child, *column, batch);
+    private_data->m_children.push_back(child);
+  }
+  out_array->length = batch->m_num_rows;
+  out_array->null_count = 0;
+  out_array->offset = 0;
+  out_array->n_buffers = 1;
+  out_array->n_children = private_data->m_children.size();
+  out_array->buffers = private_data->m_buffers.data();
+  out_array->children = private_data->m_children.data();
+  out_array->dictionary = 0;
+  out_array->private_data = reinterpret_cast<void*>(private_data);
+  out_array->release = release_columnar_array;
+  if(out_schema)
+    export_schema(out_schema);
+  return true;
+}
+
+//GenomicsDBColumnarQuery functions
+GenomicsDBColumnarQuery::GenomicsDBColumnarQuery(const std::string& loader_config_file, const std::string& query_config_file,
+    const int my_rank, const int64_t max_num_rows_per_batch, const size_t tiledb_segment_size)
+{
+  m_storage_manager = 0;
+  m_query_processor = 0;
+  m_operator = 0;
+  //Parse loader JSON file
+  //If the loader JSON is not specified, vid_mapping_file and callset_mapping_file must be specified in the query JSON
+  JSONLoaderConfig loader_config;
+  JSONLoaderConfig* loader_config_ptr = 0;
+  if(!(loader_config_file.empty()))
+  {
+    loader_config.read_from_file(loader_config_file, &m_vid_mapper, my_rank);
+    loader_config_ptr = &loader_config;
+  }
+  JSONBasicQueryConfig query_json_config;
+  query_json_config.read_from_file(query_config_file, m_query_config, &m_vid_mapper, my_rank, loader_config_ptr);
+  VariantQueryProcessor::apply_process_wide_settings(query_json_config, my_rank);
+  VariantQueryProcessor::initialize_auto_query_column_ranges(query_json_config, m_query_config, m_vid_mapper, my_rank);
+  m_storage_manager = new VariantStorageManager(query_json_config.get_workspace(my_rank), tiledb_segment_size);
+  m_storage_manager->set_iterator_memory_budget(query_json_config.get_iterator_memory_budget());
+  m_query_processor = new VariantQueryProcessor(m_storage_manager, query_json_config.get_array_name(my_rank), m_vid_mapper);
+  m_query_processor->do_query_bookkeeping(m_query_processor->get_array_schema(), m_query_config, m_vid_mapper, false);
+  m_operator = new ColumnarExportOperator(m_query_config, m_query_processor->get_array_schema(), m_vid_mapper,
+      max_num_rows_per_batch);
+  //With no column intervals, iterate_over_cells scans the whole array
+  m_num_column_intervals = std::max<unsigned>(1u, m_query_config.get_num_column_intervals());
+  m_column_interval_idx = 0u;
+  m_done = false;
+}
+
+bool GenomicsDBColumnarQuery::export_next_batch(ArrowArray* out_array, ArrowSchema* out_schema)
+{
+  //Stops once the operator overflows - a batch was sealed
+  while(!m_done && m_operator->get_num_completed_batches() == 0u)
+  {
+    m_query_processor->iterate_over_cells(m_query_processor->get_array_descriptor(), m_query_config, *m_operator,
+        m_column_interval_idx, &m_scan_state);
+    if(m_scan_state.end())
+    {
+      m_scan_state.reset();
+      ++m_column_interval_idx;
+      if(m_column_interval_idx >= m_num_column_intervals)
+      {
+        m_operator->finalize();
+        m_done = true;
+      }
+    }
+  }
+  return m_operator->export_next_batch(out_array, out_schema);
+}
+
+GenomicsDBColumnarQuery::~GenomicsDBColumnarQuery()
+{
+  //Batches already exported remain valid - they are owned by the consumer
+  //Iterator of an incomplete scan must be freed before the array is closed
+  m_scan_state.discard();
+  if(m_operator)
+    delete m_operator;
+  m_operator = 0;
+  if(m_query_processor)
+  {
+    m_storage_manager->close_array(m_query_processor->get_array_descriptor());
+    delete m_query_processor;
+  }
+  m_query_processor = 0;
+  if(m_storage_manager)
+    delete m_storage_manager;
+  m_storage_manager = 0;
+}
@@ -0,0 +1,331 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genotype_matrix.h"
+#include "json_config.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenotypeMatrixException(#X);
+
+//GenotypeMatrix functions
+GenotypeMatrix::GenotypeMatrix(const uint64_t num_samples, const GenotypeMatrixEncodingEnum encoding,
+    const bool store_GQ_DP)
+{
+  m_num_samples = num_samples;
+  m_encoding = encoding;
+  m_store_GQ_DP = store_GQ_DP;
+  switch(encoding)
+  {
+    case GENOTYPE_MATRIX_ENCODING_2BIT:
+      m_num_bytes_per_site = GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_2BIT>::get_num_bytes_per_site(num_samples);
+      break;
+    case GENOTYPE_MATRIX_ENCODING_8BIT:
+      m_num_bytes_per_site = GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_8BIT>::get_num_bytes_per_site(num_samples);
+      break;
+    default:
+      throw GenotypeMatrixException(std::string("Unknown genotype matrix encoding ")+std::to_string(encoding));
+  }
+}
+
+void GenotypeMatrix::clear()
+{
+  m_site_columns.clear();
+  m_genotypes.clear();
+  m_GQ.clear();
+  m_DP.clear();
+}
+
+uint64_t GenotypeMatrix::add_site(const int64_t column)
+{
+  assert(m_site_columns.empty() || column >= m_site_columns.back());
+  auto site_idx = m_site_columns.size();
+  m_site_columns.push_back(column);
+  //All bits set is the missing value for both encodings
+  m_genotypes.resize(m_genotypes.size()+m_num_bytes_per_site, 0xFFu);
+  if(m_store_GQ_DP)
+  {
+    m_GQ.resize(m_GQ.size()+m_num_samples, bcf_int32_missing);
+    m_DP.resize(m_DP.size()+m_num_samples, bcf_int32_missing);
+  }
+  return site_idx;
+}
+
+uint8_t GenotypeMatrix::get_genotype(const uint64_t site_idx, const uint64_t sample_idx) const
+{
+  VERIFY_OR_THROW(site_idx < get_num_sites() && sample_idx < m_num_samples);
+  auto site_ptr = &(m_genotypes[site_idx*m_num_bytes_per_site]);
+  if(m_encoding == GENOTYPE_MATRIX_ENCODING_2BIT)
+    return GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_2BIT>::get(site_ptr, sample_idx);
+  else
+    return GenotypeMatrixEncodingTraits<GENOTYPE_MATRIX_ENCODING_8BIT>::get(site_ptr, sample_idx);
+}
+
+//GenotypeMatrixOperator functions
+GenotypeMatrixOperator::GenotypeMatrixOperator(const VariantQueryConfig& query_config, GenotypeMatrix& matrix,
+    const unsigned END_query_idx, const unsigned GT_query_idx,
+    const unsigned GQ_query_idx, const unsigned DP_query_idx)
+{
+  m_query_config = &query_config;
+  m_matrix = &matrix;
+  m_END_query_idx = END_query_idx;
+  m_GT_query_idx = GT_query_idx;
+  m_GQ_query_idx = matrix.stores_GQ_DP() ? GQ_query_idx : UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  m_DP_query_idx = matrix.stores_GQ_DP() ? DP_query_idx : UNDEFINED_ATTRIBUTE_IDX_VALUE;
+  VERIFY_OR_THROW(matrix.get_num_samples() == query_config.get_num_rows_to_query());
+  m_sample_states.resize(matrix.get_num_samples());
+  reset(0, INT64_MAX-1);
+}
+
+void GenotypeMatrixOperator::reset(const int64_t begin, const int64_t end)
+{
+  m_interval_begin = begin;
+  m_interval_end = end;
+  m_interval_first_site_idx = m_matrix->get_num_sites();
+  m_num_samples_seen = 0ull;
+  m_current_column = -1ll;
+  m_current_column_has_variant = false;
+  for(auto& state : m_sample_states)
+  {
+    state.m_begin = -1ll;
+    state.m_end = -1ll;
+    state.m_seen = false;
+  }
+}
+
+template<int Encoding>
+void GenotypeMatrixOperator::fill_state(const BufferVariantCell& cell, SampleState& state) const
+{
+  auto GT_ptr = cell.get_field_ptr_for_query_idx<int>(m_GT_query_idx);
+  auto num_alleles = static_cast<unsigned>(std::max(cell.get_field_length(m_GT_query_idx), 0));
+  auto num_non_ref_alleles = 0u;
+  auto is_missing = (num_alleles == 0u);
+  for(auto i=0u;i<num_alleles && !is_missing;++i)
+  {
+    //Covers bcf_int32_missing, bcf_int32_vector_end and missing alleles (-1)
+    is_missing = (GT_ptr[i] < 0);
+    num_non_ref_alleles += (GT_ptr[i] > 0) ? 1u : 0u;
+  }
+  state.m_is_hom_ref = !is_missing && (num_non_ref_alleles == 0u);
+  state.m_code = is_missing ? GenotypeMatrixEncodingTraits<Encoding>::m_missing
+    : GenotypeMatrixEncodingTraits<Encoding>::encode(num_alleles, num_non_ref_alleles);
+  state.m_GQ = (m_GQ_query_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE && cell.get_field_length(m_GQ_query_idx) > 0)
+    ? *(cell.get_field_ptr_for_query_idx<int>(m_GQ_query_idx)) : bcf_int32_missing;
+  state.m_DP = (m_DP_query_idx != UNDEFINED_ATTRIBUTE_IDX_VALUE && cell.get_field_length(m_DP_query_idx) > 0)
+    ? *(cell.get_field_ptr_for_query_idx<int>(m_DP_query_idx)) : bcf_int32_missing;
+}
+
+template<int Encoding>
+void GenotypeMatrixOperator::finalize_current_column()
+{
+  if(!m_current_column_has_variant)
+    return;
+  auto site_idx = m_matrix->add_site(m_current_column);
+  for(auto i=0ull;i<m_sample_states.size();++i)
+  {
+    auto& state = m_sample_states[i];
+    if(state.m_begin == m_current_column)
+      m_matrix->set_genotype<Encoding>(site_idx, i, state.m_code);
+    else
+      //Cells beginning before the site - only hom-ref intervals are informative
+      if(state.m_begin >= 0 && state.m_begin < m_current_column && state.m_end >= m_current_column
+          && state.m_is_hom_ref)
+        m_matrix->set_genotype<Encoding>(site_idx, i, GenotypeMatrixEncodingTraits<Encoding>::m_hom_ref);
+      else
+        continue;
+    if(m_matrix->stores_GQ_DP())
+      m_matrix->set_GQ_DP(site_idx, i, state.m_GQ, state.m_DP);
+  }
+  m_current_column_has_variant = false;
+}
+
+template<int Encoding>
+void GenotypeMatrixOperator::update_emitted_sites(const uint64_t sample_idx)
+{
+  auto& state = m_sample_states[sample_idx];
+  if(!state.m_is_hom_ref)
+    return;
+  auto& site_columns = m_matrix->get_site_columns();
+  for(auto site_idx=m_interval_first_site_idx;site_idx<site_columns.size()
+      && site_columns[site_idx] <= state.m_end;++site_idx)
+  {
+    m_matrix->set_genotype<Encoding>(site_idx, sample_idx, GenotypeMatrixEncodingTraits<Encoding>::m_hom_ref);
+    if(m_matrix->stores_GQ_DP())
+      m_matrix->set_GQ_DP(site_idx, sample_idx, state.m_GQ, state.m_DP);
+  }
+}
+
+template<int Encoding>
+bool GenotypeMatrixOperator::operate(const BufferVariantCell& cell)
+{
+  auto row = cell.get_row();
+  if(!m_query_config->is_queried_array_row_idx(row))
+    return true;
+  auto sample_idx = m_query_config->get_query_row_idx_for_array_row_idx(row);
+  auto& state = m_sample_states[sample_idx];
+  auto column = cell.get_begin_column();
+  auto END_v = *(cell.get_field_ptr_for_query_idx<int64_t>(m_END_query_idx));
+  //Past the queried interval - only samples whose interval overlaps the queried begin are still
+  //unknown. Their END copies lie beyond the interval end when the interval contains the query
+  if(column > m_interval_end)
+  {
+    finalize_current_column<Encoding>();
+    if(!state.m_seen)
+    {
+      state.m_seen = true;
+      ++m_num_samples_seen;
+      //END copy of an interval spanning the whole query
+      if(column > END_v && END_v < m_interval_begin)
+      {
+        fill_state<Encoding>(cell, state);
+        state.m_begin = END_v;
+        state.m_end = column;
+        update_emitted_sites<Encoding>(sample_idx);
+      }
+    }
+    return m_num_samples_seen < m_sample_states.size();
+  }
+  if(column != m_current_column)
+  {
+    finalize_current_column<Encoding>();
+    m_current_column = column;
+  }
+  if(column > END_v)
+  {
+    //END copy - interval begins before the queried begin if the begin cell was not seen
+    if(!state.m_seen && END_v < m_interval_begin)
+    {
+      state.m_seen = true;
+      ++m_num_samples_seen;
+      fill_state<Encoding>(cell, state);
+      state.m_begin = END_v;
+      state.m_end = column;
+      update_emitted_sites<Encoding>(sample_idx);
+    }
+    return true;
+  }
+  if(!state.m_seen)
+  {
+    state.m_seen = true;
+    ++m_num_samples_seen;
+  }
+  fill_state<Encoding>(cell, state);
+  state.m_begin = column;
+  state.m_end = END_v;
+  if(!state.m_is_hom_ref && state.m_code != GenotypeMatrixEncodingTraits<Encoding>::m_missing)
+    m_current_column_has_variant = true;
+  return true;
+}
+
+template<int Encoding>
+void GenotypeMatrixOperator::finalize()
+{
+  finalize_current_column<Encoding>();
+}
+
+//Explicit template instantiation
+template bool GenotypeMatrixOperator::operate<GENOTYPE_MATRIX_ENCODING_2BIT>(const BufferVariantCell& cell);
+template bool GenotypeMatrixOperator::operate<GENOTYPE_MATRIX_ENCODING_8BIT>(const BufferVariantCell& cell);
+template void GenotypeMatrixOperator::finalize<GENOTYPE_MATRIX_ENCODING_2BIT>();
+template void GenotypeMatrixOperator::finalize<GENOTYPE_MATRIX_ENCODING_8BIT>();
+
+//GenomicsDBGenotypeMatrixQuery functions
+GenomicsDBGenotypeMatrixQuery::GenomicsDBGenotypeMatrixQuery(const std::string& loader_config_file,
+    const std::string& query_config_file, const int my_rank, const GenotypeMatrixEncodingEnum encoding,
+    const bool fetch_GQ_DP, const size_t tiledb_segment_size)
+{
+  //Parse loader JSON file
+  //If the loader JSON is not specified, vid_mapping_file and callset_mapping_file must be specified in the query JSON
+  JSONLoaderConfig loader_config;
+  JSONLoaderConfig* loader_config_ptr = 0;
+  if(!(loader_config_file.empty()))
+  {
+    loader_config.read_from_file(loader_config_file, &m_vid_mapper, my_rank);
+    loader_config_ptr = &loader_config;
+  }
+  JSONBasicQueryConfig query_json_config;
+  query_json_config.read_from_file(query_config_file, m_query_config, &m_vid_mapper, my_rank, loader_config_ptr);
+  VariantQueryProcessor::apply_process_wide_settings(query_json_config, my_rank);
+  VariantQueryProcessor::initialize_auto_query_column_ranges(query_json_config, m_query_config, m_vid_mapper, my_rank);
+  //Only GT (and optionally GQ/DP) - END is added by the bookkeeping
+  m_query_config.clear_attributes_to_query();
+  std::vector<std::string> attributes = { "GT" };
+  if(fetch_GQ_DP)
+  {
+    attributes.push_back("GQ");
+    attributes.push_back("DP");
+  }
+  m_query_config.set_attributes_to_query(attributes);
+  m_storage_manager.reset(new VariantStorageManager(query_json_config.get_workspace(my_rank), tiledb_segment_size));
+  m_storage_manager->set_iterator_memory_budget(query_json_config.get_iterator_memory_budget());
+  m_query_processor.reset(new VariantQueryProcessor(m_storage_manager.get(), query_json_config.get_array_name(my_rank),
+        m_vid_mapper));
+  m_query_processor->do_query_bookkeeping(m_query_processor->get_array_schema(), m_query_config, m_vid_mapper, false);
+  m_matrix.reset(new GenotypeMatrix(m_query_config.get_num_rows_to_query(), encoding, fetch_GQ_DP));
+  fill_matrix(*m_storage_manager, m_query_processor->get_array_descriptor(), m_query_config, *m_matrix);
+}
+
+void GenomicsDBGenotypeMatrixQuery::fill_matrix(const VariantStorageManager& storage_manager, const int ad,
+    const VariantQueryConfig& query_config, GenotypeMatrix& matrix)
+{
+  VERIFY_OR_THROW(query_config.is_defined_query_idx_for_known_field_enum(GVCF_END_IDX)
+      && query_config.is_defined_query_idx_for_known_field_enum(GVCF_GT_IDX));
+  VERIFY_OR_THROW(!matrix.stores_GQ_DP() || (query_config.is_defined_query_idx_for_known_field_enum(GVCF_GQ_IDX)
+        && query_config.is_defined_query_idx_for_known_field_enum(GVCF_DP_IDX)));
+  GenotypeMatrixOperator matrix_operator(query_config, matrix,
+      query_config.get_query_idx_for_known_field_enum(GVCF_END_IDX),
+      query_config.get_query_idx_for_known_field_enum(GVCF_GT_IDX),
+      matrix.stores_GQ_DP() ? query_config.get_query_idx_for_known_field_enum(GVCF_GQ_IDX) : UNDEFINED_ATTRIBUTE_IDX_VALUE,
+      matrix.stores_GQ_DP() ? query_config.get_query_idx_for_known_field_enum(GVCF_DP_IDX) : UNDEFINED_ATTRIBUTE_IDX_VALUE);
+  //With no column intervals, the whole array is scanned
+  auto num_intervals = std::max<unsigned>(1u, query_config.get_num_column_intervals());
+  for(auto i=0u;i<num_intervals;++i)
+  {
+    auto begin = (query_config.get_num_column_intervals() > 0u) ? static_cast<int64_t>(query_config.get_column_begin(i)) : 0ll;
+    auto end = (query_config.get_num_column_intervals() > 0u) ? static_cast<int64_t>(query_config.get_column_end(i)) : INT64_MAX-1;
+    if(matrix.get_encoding() == GENOTYPE_MATRIX_ENCODING_2BIT)
+      scan_column_interval<GENOTYPE_MATRIX_ENCODING_2BIT>(storage_manager, ad, query_config, matrix_operator, begin, end);
+    else
+      scan_column_interval<GENOTYPE_MATRIX_ENCODING_8BIT>(storage_manager, ad, query_config, matrix_operator, begin, end);
+  }
+}
+
+template<int Encoding>
+void GenomicsDBGenotypeMatrixQuery::scan_column_interval(const VariantStorageManager& storage_manager, const int ad,
+    const VariantQueryConfig& query_config, GenotypeMatrixOperator& matrix_operator,
+    const int64_t begin, const int64_t end)
+{
+  matrix_operator.reset(begin, end);
+  //END copies beyond the interval are needed. An interval that begins before begin and has not been
+  //seen by the time the scan is past end has its END copy at some column < begin+max interval length.
+  //If the max interval length is unknown, the scan runs till every sample is seen
+  auto scan_end = INT64_MAX;
+  auto max_interval_length = storage_manager.get_max_interval_length(ad);
+  if(max_interval_length >= 0 && max_interval_length < INT64_MAX-begin)
+    scan_end = std::max<int64_t>(end, begin+max_interval_length);
+  std::vector<RowRange> row_ranges;
+  query_config.get_query_row_ranges(row_ranges, MAX_NUM_ROW_RANGES_PER_QUERY_ITERATOR);
+  std::unique_ptr<VariantArrayCellIterator> forward_iter(storage_manager.begin(ad, row_ranges,
+        begin, scan_end, query_config.get_query_attributes_schema_idxs()));
+  for(;!(forward_iter->end());++(*forward_iter))
+    if(!(matrix_operator.operate<Encoding>(**forward_iter)))
+      break;
+  matrix_operator.finalize<Encoding>();
+}
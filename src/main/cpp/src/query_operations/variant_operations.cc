@@ -61,6 +61,112 @@ void* RemappedVariant::put_address(uint64_t input_call_idx, unsigned allele_or_g
   return reinterpret_cast<void*>(field->get_address(allele_or_gt_idx)); //returns pointer to the k-th element
 }
 
+//InternedAlleleDictionary
+InternedAlleleDictionary::InternedAlleleDictionary(const unsigned initial_num_slots)
+{
+  auto num_slots = 8u;
+  while(num_slots < initial_num_slots)
+    num_slots <<= 1u;
+  m_slot_hashes.resize(num_slots, 0ull);
+  m_slot_merged_idx.resize(num_slots, 0u);
+  m_slot_mask = num_slots-1u;
+  for(auto& val : m_SNP_merged_idx)
+    val = 0u;
+}
+
+void InternedAlleleDictionary::clear()
+{
+  for(auto slot_idx : m_used_slots)
+    m_slot_merged_idx[slot_idx] = 0u;
+  m_used_slots.clear();
+  for(auto& val : m_SNP_merged_idx)
+    val = 0u;
+}
+
+//FNV-1a over allele followed by suffix
+uint64_t InternedAlleleDictionary::hash(const std::string& allele, const char* suffix_ptr, const size_t suffix_length)
+{
+  auto hash_value = 14695981039346656037ull;
+  for(auto c : allele)
+    hash_value = (hash_value ^ static_cast<uint8_t>(c))*1099511628211ull;
+  for(auto i=0ull;i<suffix_length;++i)
+    hash_value = (hash_value ^ static_cast<uint8_t>(suffix_ptr[i]))*1099511628211ull;
+  return hash_value;
+}
+
+void InternedAlleleDictionary::grow()
+{
+  auto num_slots = 2u*m_slot_hashes.size();
+  std::vector<uint64_t> old_slot_hashes(std::move(m_slot_hashes));
+  std::vector<unsigned> old_slot_merged_idx(std::move(m_slot_merged_idx));
+  std::vector<unsigned> old_used_slots(std::move(m_used_slots));
+  m_slot_hashes.assign(num_slots, 0ull);
+  m_slot_merged_idx.assign(num_slots, 0u);
+  m_used_slots.clear();
+  m_slot_mask = num_slots-1u;
+  for(auto old_slot_idx : old_used_slots)
+  {
+    auto hash_value = old_slot_hashes[old_slot_idx];
+    auto slot_idx = hash_value & m_slot_mask;
+    while(m_slot_merged_idx[slot_idx])
+      slot_idx = (slot_idx+1u) & m_slot_mask;
+    m_slot_hashes[slot_idx] = hash_value;
+    m_slot_merged_idx[slot_idx] = old_slot_merged_idx[old_slot_idx];
+    m_used_slots.push_back(slot_idx);
+  }
+}
+
+unsigned InternedAlleleDictionary::get_or_insert(const std::string& allele, const char* suffix_ptr, const size_t suffix_length,
+    std::vector<std::string>& merged_alt_alleles, bool& inserted)
+{
+  inserted = false;
+  //SNP fast path
+  if(suffix_length == 0u && allele.length() == 1u)
+  {
+    auto SNP_code = get_SNP_code(allele[0]);
+    if(SNP_code >= 0)
+    {
+      if(m_SNP_merged_idx[SNP_code] == 0u)
+      {
+        merged_alt_alleles.push_back(allele);
+        m_SNP_merged_idx[SNP_code] = merged_alt_alleles.size();
+        inserted = true;
+      }
+      return m_SNP_merged_idx[SNP_code];
+    }
+  }
+  auto hash_value = hash(allele, suffix_ptr, suffix_length);
+  auto slot_idx = hash_value & m_slot_mask;
+  auto total_length = allele.length() + suffix_length;
+  for(;m_slot_merged_idx[slot_idx];slot_idx=(slot_idx+1u) & m_slot_mask)
+  {
+    if(m_slot_hashes[slot_idx] != hash_value)
+      continue;
+    auto merged_allele_idx = m_slot_merged_idx[slot_idx];
+    const auto& merged_allele = merged_alt_alleles[merged_allele_idx-1u];
+    if(merged_allele.length() == total_length
+        && merged_allele.compare(0u, allele.length(), allele) == 0
+        && (suffix_length == 0u || merged_allele.compare(allele.length(), suffix_length, suffix_ptr, suffix_length) == 0))
+      return merged_allele_idx;
+  }
+  //Seen for the first time
+  merged_alt_alleles.emplace_back();
+  auto& merged_allele = merged_alt_alleles.back();
+  merged_allele.reserve(total_length);
+  merged_allele.append(allele);
+  if(suffix_length)
+    merged_allele.append(suffix_ptr, suffix_length);
+  unsigned merged_allele_idx = merged_alt_alleles.size();
+  m_slot_hashes[slot_idx] = hash_value;
+  m_slot_merged_idx[slot_idx] = merged_allele_idx;
+  m_used_slots.push_back(slot_idx);
+  inserted = true;
+  //Keep load factor below 0.5
+  if(2u*m_used_slots.size() > m_slot_hashes.size())
+    grow();
+  return merged_allele_idx;
+}
+
 /*
  * @brief - get the longest reference allele among all variants at this position and store its value in merged_reference_allele
  * For example, if we have the reference alleles T (SNP) and TG (deletion) in two GVCFs at the same location, the reference allele
@@ -134,20 +240,27 @@ void VariantOperations::merge_alt_alleles(const Variant& variant,
     const VariantQueryConfig& query_config,
     const std::string& merged_reference_allele,
     CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists) {
-  // marking non_reference_allele as already seen will ensure it's not included in the middle
-  auto seen_alleles = std::unordered_map<std::string, int>{{g_vcf_NON_REF,-1}};
+  InternedAlleleDictionary allele_dictionary;
+  std::vector<int> input_non_reference_allele_idx;
+  merge_alt_alleles(variant, query_config, merged_reference_allele, alleles_LUT, merged_alt_alleles, NON_REF_exists,
+      allele_dictionary, input_non_reference_allele_idx);
+}
+
+void VariantOperations::merge_alt_alleles(const Variant& variant,
+    const VariantQueryConfig& query_config,
+    const std::string& merged_reference_allele,
+    CombineAllelesLUT& alleles_LUT, std::vector<std::string>& merged_alt_alleles, bool& NON_REF_exists,
+    InternedAlleleDictionary& allele_dictionary, std::vector<int>& input_non_reference_allele_idx) {
+  //NON_REF alleles are never inserted into the dictionary - handled separately below
+  allele_dictionary.clear();
   merged_alt_alleles.clear();
   auto merged_reference_length = merged_reference_allele.length();
   //invalidate all existing mappings in the LUT
   alleles_LUT.reset_luts();
   //vector to store idx mappings for NON_REF allele, update LUT at end as #ALT alleles are not known till end
   //Set everything to -1 (invalid mapping)
-  auto input_non_reference_allele_idx = std::vector<int>(variant.get_num_calls(), -1);
-  auto merged_allele_idx = 1u;	//why 1, ref is index 0, alt begins at 1
+  input_non_reference_allele_idx.assign(variant.get_num_calls(), -1);
   NON_REF_exists = false;       //by default, assume NON_REF does not exist
-  //Get VariantQueryConfig
-  //assert(variant.get_query_config());
-  //const VariantQueryConfig& query_config = *(variant.get_query_config());
   //Iterate over valid calls
   for (auto valid_calls_iter=variant.begin();valid_calls_iter != variant.end();++valid_calls_iter)
   {
@@ -159,18 +272,17 @@ void VariantOperations::merge_alt_alleles(const Variant& variant,
     const auto& curr_reference_length = curr_reference.length();
     const auto& curr_allele_vector = 
       get_known_field<VariantFieldALTData, true>(curr_valid_call, query_config, GVCF_ALT_IDX)->get();
-    auto is_suffix_needed = false;
+    //Suffix of the merged reference appended to alleles of calls with shorter reference
+    const char* suffix_ptr = 0;
     auto suffix_length = 0u;
     if(curr_reference_length < merged_reference_length)
     {
-      is_suffix_needed = true;
+      suffix_ptr = merged_reference_allele.c_str() + curr_reference_length;
       suffix_length = merged_reference_length - curr_reference_length;
     }
     //mapping for reference allele 0 -> 0
     alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, 0, 0);
     auto input_allele_idx = 1u;	//why 1, ref is index 0, alt begins at 1
-    //copy of allele if needed
-    std::string copy_allele;
     for (const auto& allele : curr_allele_vector)
     {
       if(IS_NON_REF_ALLELE(allele))
@@ -180,28 +292,15 @@ void VariantOperations::merge_alt_alleles(const Variant& variant,
       }
       else
       {
-        auto* allele_ptr = &allele;
-        if(is_suffix_needed && !VariantUtils::is_symbolic_allele(allele))
-        {
-          copy_allele = allele;
-          copy_allele.append(merged_reference_allele, curr_reference_length, suffix_length);
-          allele_ptr = &copy_allele; //allele_ptr now points to a copy of var.alt()[l] (+suffix), hence it's safe to move later
-        }
-        const auto& iter_pos = seen_alleles.find(*allele_ptr);
-        if (iter_pos == seen_alleles.end()) { //allele seen for the first time
-          seen_alleles[*allele_ptr] = merged_allele_idx;
-          //always check whether LUT is big enough for alleles_LUT (since the #alleles in the merged variant is unknown)
-          //Most of the time this function will return quickly (just an if condition check)
-          alleles_LUT.resize_luts_if_needed(merged_allele_idx + 1); 
-          alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_allele_idx, merged_allele_idx);
-          if(is_suffix_needed)
-            merged_alt_alleles.push_back(std::move(*allele_ptr)); //allele_ptr points to a copy - use move
-          else
-            merged_alt_alleles.push_back(*allele_ptr);	//allele_ptr points to curr_allele_vector[input_allele_idx] - copy to vector
-          ++merged_allele_idx;
-        }
-        else
-          alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_allele_idx, (*iter_pos).second);
+        auto is_suffix_needed = (suffix_length > 0u && !VariantUtils::is_symbolic_allele(allele));
+        auto inserted = false;
+        auto merged_allele_idx = allele_dictionary.get_or_insert(allele, suffix_ptr, is_suffix_needed ? suffix_length : 0u,
+            merged_alt_alleles, inserted);
+        //always check whether LUT is big enough for alleles_LUT (since the #alleles in the merged variant is unknown)
+        //Most of the time this function will return quickly (just an if condition check)
+        if(inserted)
+          alleles_LUT.resize_luts_if_needed(merged_allele_idx + 1);
+        alleles_LUT.add_input_merged_idx_pair(curr_call_idx_in_variant, input_allele_idx, merged_allele_idx);
       }
       ++input_allele_idx;
     }
@@ -349,7 +448,7 @@ void SingleVariantOperatorBase::operate(Variant& variant, const VariantQueryConf
   //set #rows to number of calls
   m_alleles_LUT.resize_luts_if_needed(variant.get_num_calls(), 10u);    //arbitrary non-0 second arg, will be resized correctly anyway
   VariantOperations::merge_alt_alleles(variant, query_config, m_merged_reference_allele, m_alleles_LUT,
-      m_merged_alt_alleles, m_NON_REF_exists);
+      m_merged_alt_alleles, m_NON_REF_exists, m_allele_dictionary, m_input_non_reference_allele_idx);
   //is pure reference block if REF is 1 char, and ALT contains only <NON_REF>
   m_is_reference_block_only = (m_merged_reference_allele.length() == 1u && m_merged_alt_alleles.size() == 1u &&
       m_merged_alt_alleles[0] == g_vcf_NON_REF);
@@ -581,35 +680,95 @@ ColumnHistogramOperator::ColumnHistogramOperator(uint64_t begin, uint64_t end, u
 
 void ColumnHistogramOperator::operate(VariantCall& call, const VariantQueryConfig& query_config, const VariantArraySchema& schema)
 {
-  auto call_begin = call.get_column_begin();
-  auto bin_idx = call_begin <= m_begin_column ? 0ull
-    : call_begin >= m_end_column ? m_bin_counts_vector.size()-1 
-    : (call_begin - m_begin_column)/m_bin_size;
+  add_cells(call.get_column_begin(), 1ull);
+}
+
+void ColumnHistogramOperator::add_cells(const uint64_t column, const uint64_t num_cells)
+{
+  auto bin_idx = column <= m_begin_column ? 0ull
+    : column >= m_end_column ? m_bin_counts_vector.size()-1 
+    : (column - m_begin_column)/m_bin_size;
   assert(bin_idx < m_bin_counts_vector.size());
-  ++(m_bin_counts_vector[bin_idx]);
+  m_bin_counts_vector[bin_idx] += num_cells;
 }
 
-bool ColumnHistogramOperator::equi_partition_and_print_bins(uint64_t num_bins, std::ostream& fptr) const
+bool ColumnHistogramOperator::can_use_column_cell_histogram(const ColumnCellHistogram& histogram,
+    const VariantQueryConfig& query_config) const
 {
-  if(num_bins >= m_bin_counts_vector.size())
+  return !histogram.empty() && histogram.get_bin_size() <= m_bin_size
+    && query_config.query_all_rows() && !query_config.has_filters()
+    && query_config.get_num_column_intervals() <= 1u;
+}
+
+void ColumnHistogramOperator::add_column_cell_histogram(const ColumnCellHistogram& histogram)
+{
+  auto stored_bin_size = histogram.get_bin_size();
+  for(const auto& bin : histogram.get_bins())
   {
-    std::cerr << "Requested #equi bins is smaller than allocated bin counts vector, returning\n";
-    return false;
+    auto lo = histogram.get_lo(bin.first);
+    auto hi = histogram.get_hi(bin.first);
+    if(hi < m_begin_column || lo > m_end_column)
+      continue;
+    //#cells of the stored bin in [lo, column) - rounding the cumulative count keeps the total exact
+    auto num_cells = bin.second.m_num_cells;
+    auto num_cells_before = [&](const uint64_t column) -> uint64_t {
+      return static_cast<uint64_t>(llround((static_cast<double>(num_cells)*(column-lo))/stored_bin_size));
+    };
+    auto begin = std::max(lo, m_begin_column);
+    auto end = std::min(hi, m_end_column);
+    while(begin <= end)
+    {
+      auto bin_idx = (begin - m_begin_column)/m_bin_size;
+      assert(bin_idx < m_bin_counts_vector.size());
+      auto piece_end = std::min(end, m_begin_column+(bin_idx+1u)*m_bin_size-1u);
+      m_bin_counts_vector[bin_idx] += num_cells_before(piece_end+1u) - num_cells_before(begin);
+      begin = piece_end+1u;
+    }
   }
+}
+
+bool ColumnHistogramOperator::equi_partition_bins(uint64_t num_partitions, std::vector<ColumnRange>& column_ranges,
+    std::vector<uint64_t>& num_cells) const
+{
+  column_ranges.clear();
+  num_cells.clear();
+  if(num_partitions == 0u || num_partitions >= m_bin_counts_vector.size())
+    return false;
   auto total_count = 0ull;
   for(auto val : m_bin_counts_vector)
     total_count += val;
-  auto count_per_bin = ((double)total_count)/num_bins;
-  fptr << "Total "<<total_count<<" #bins "<<num_bins<<" count/bins "<< std::fixed << std::setprecision(1) << count_per_bin <<"\n";
+  auto count_per_bin = ((double)total_count)/num_partitions;
   for(auto i=0ull;i<m_bin_counts_vector.size();)
   {
     auto j = i;
     auto curr_bin_total = 0ull;
     for(;curr_bin_total<count_per_bin && j<m_bin_counts_vector.size();curr_bin_total+=m_bin_counts_vector[j],++j);
-    assert(j > i);
-    fptr << m_begin_column+i*m_bin_size << "," <<m_begin_column+j*m_bin_size-1 <<"," << curr_bin_total << "\n";
+    //Empty array - single bin
+    if(j == i)
+      j = m_bin_counts_vector.size();
+    column_ranges.emplace_back(m_begin_column+i*m_bin_size, m_begin_column+j*m_bin_size-1);
+    num_cells.push_back(curr_bin_total);
     i = j;
   }
+  return true;
+}
+
+bool ColumnHistogramOperator::equi_partition_and_print_bins(uint64_t num_bins, std::ostream& fptr) const
+{
+  std::vector<ColumnRange> column_ranges;
+  std::vector<uint64_t> num_cells;
+  if(!equi_partition_bins(num_bins, column_ranges, num_cells))
+  {
+    std::cerr << "Requested #equi bins is smaller than allocated bin counts vector, returning\n";
+    return false;
+  }
+  auto total_count = 0ull;
+  for(auto val : num_cells)
+    total_count += val;
+  auto count_per_bin = ((double)total_count)/num_bins;
+  fptr << "Total "<<total_count<<" #bins "<<num_bins<<" count/bins "<< std::fixed << std::setprecision(1) << count_per_bin <<"\n";
+  for(auto i=0ull;i<column_ranges.size();++i)
+    fptr << column_ranges[i].first << "," << column_ranges[i].second << "," << num_cells[i] << "\n";
   fptr << "\n";
   return true;
 }
@@ -0,0 +1,231 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "column_partitioner.h"
+#include "json_config.h"
+#include "htslib/hts.h"
+#include "htslib/tbx.h"
+#include "htslib/vcf.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw ColumnPartitionerException(#X);
+
+//Fraction of the total weight spread uniformly over the contigs when density information is present
+#define UNIFORM_WEIGHT_FRACTION 0.01
+
+LoadBalancedColumnPartitioner::LoadBalancedColumnPartitioner(const VidMapper& vid_mapper, const uint64_t bin_size)
+  : m_vid_mapper(&vid_mapper), m_bin_size(bin_size), m_density(bin_size)
+{
+  VERIFY_OR_THROW(m_vid_mapper->is_initialized());
+  VERIFY_OR_THROW(bin_size > 0u);
+}
+
+unsigned LoadBalancedColumnPartitioner::add_density_from_vcf_indexes(const std::vector<std::string>& filenames,
+    const unsigned max_num_files)
+{
+  if(filenames.empty() || max_num_files == 0u)
+    return 0u;
+  auto step = std::max<size_t>(1u, (filenames.size()+max_num_files-1u)/max_num_files);
+  auto num_sampled = 0u;
+  for(auto i=0ull;i<filenames.size() && num_sampled<max_num_files;i+=step)
+    if(add_density_from_vcf_index(filenames[i]))
+      ++num_sampled;
+  return num_sampled;
+}
+
+//Approximate position in the uncompressed stream - BGZF blocks hold 64KiB of data, typically compressed ~4x
+static inline double virtual_offset_to_position(const uint64_t virtual_offset)
+{
+  return static_cast<double>(virtual_offset >> 16) + static_cast<double>(virtual_offset & 0xffffu)/4.0;
+}
+
+bool LoadBalancedColumnPartitioner::add_density_from_vcf_index(const std::string& filename)
+{
+  //Contig name -> index tid: tabix indexes (.vcf.gz) store the names, BCF indexes need the file header
+  std::vector<int> tids(m_vid_mapper->get_num_contigs(), -1);
+  tbx_t* tbx = 0;
+  hts_idx_t* bcf_idx = 0;
+  auto* fptr = hts_open(filename.c_str(), "r");
+  if(fptr == 0)
+    return false;
+  auto is_bcf = (hts_get_format(fptr)->format == bcf);
+  if(is_bcf)
+  {
+    bcf_idx = bcf_index_load(filename.c_str());
+    auto* hdr = bcf_idx ? bcf_hdr_read(fptr) : 0;
+    if(hdr)
+    {
+      for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
+        tids[i] = bcf_hdr_name2id(hdr, m_vid_mapper->get_contig_info(i).m_name.c_str());
+      bcf_hdr_destroy(hdr);
+    }
+    else if(bcf_idx)
+    {
+      hts_idx_destroy(bcf_idx);
+      bcf_idx = 0;
+    }
+  }
+  else
+  {
+    tbx = tbx_index_load(filename.c_str());
+    if(tbx)
+      for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
+        tids[i] = tbx_name2id(tbx, m_vid_mapper->get_contig_info(i).m_name.c_str());
+  }
+  hts_close(fptr);
+  if(tbx == 0 && bcf_idx == 0)
+    return false;
+  //(bin idx, file position of the first record at or after the beginning of the bin)
+  std::vector<std::pair<uint64_t, double>> bin_positions;
+  for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
+  {
+    const auto& contig_info = m_vid_mapper->get_contig_info(i);
+    auto tid = tids[i];
+    if(tid < 0 || contig_info.m_length <= 0)
+      continue;
+    bin_positions.clear();
+    auto contig_end_position = -1.0;
+    auto contig_begin_column = contig_info.m_tiledb_column_offset;
+    auto contig_end_column = contig_info.m_tiledb_column_offset+contig_info.m_length-1;
+    for(auto column=contig_begin_column;column<=contig_end_column;)
+    {
+      auto bin_idx = static_cast<uint64_t>(column)/m_bin_size;
+      auto* itr = is_bcf ? bcf_itr_queryi(bcf_idx, tid, column-contig_begin_column, contig_info.m_length)
+        : tbx_itr_queryi(tbx, tid, column-contig_begin_column, contig_info.m_length);
+      if(itr == 0)
+        break;
+      auto has_data = (itr->n_off > 0);
+      if(has_data)
+      {
+        bin_positions.emplace_back(bin_idx, virtual_offset_to_position(itr->off[0].u));
+        //First query covers the whole contig - the end of its last chunk is the end of the contig's data
+        if(contig_end_position < 0.0)
+          for(auto j=0;j<itr->n_off;++j)
+            contig_end_position = std::max(contig_end_position, virtual_offset_to_position(itr->off[j].v));
+      }
+      hts_itr_destroy(itr);
+      if(!has_data) //no data at or after this column in the contig
+        break;
+      column = (bin_idx+1u)*m_bin_size;
+    }
+    //#bytes in a bin = distance between the positions of consecutive bin boundaries
+    for(auto j=0ull;j<bin_positions.size();++j)
+    {
+      auto next_position = (j+1u < bin_positions.size()) ? bin_positions[j+1u].second : contig_end_position;
+      if(next_position > bin_positions[j].second)
+        m_density.add_bin(bin_positions[j].first, 0ull,
+            static_cast<uint64_t>(next_position-bin_positions[j].second));
+    }
+  }
+  if(tbx)
+    tbx_destroy(tbx);
+  if(bcf_idx)
+    hts_idx_destroy(bcf_idx);
+  return true;
+}
+
+void LoadBalancedColumnPartitioner::add_density_from_histogram(const ColumnCellHistogram& histogram)
+{
+  for(const auto& bin : histogram.get_bins())
+  {
+    auto column = histogram.get_lo(bin.first);
+    m_density.add_bin(column/m_bin_size, 0ull, bin.second.m_num_bytes);
+  }
+}
+
+void LoadBalancedColumnPartitioner::partition(const unsigned num_partitions, std::vector<ColumnRange>& partitions) const
+{
+  VERIFY_OR_THROW(num_partitions > 0u);
+  partitions.clear();
+  //Weight of every bin = density + uniform share proportional to the #columns of contigs in the bin
+  auto total_length = 0ull;
+  for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
+    total_length += std::max<int64_t>(0, m_vid_mapper->get_contig_info(i).m_length);
+  auto total_density = m_density.get_total_num_bytes();
+  auto weight_per_column = (total_density > 0u)
+    ? (UNIFORM_WEIGHT_FRACTION*total_density)/std::max<uint64_t>(1u, total_length) : 1.0;
+  //Weights are scaled so that rounding to integers does not matter
+  auto scale = (total_density > 0u) ? 1024.0 : 1.0;
+  ColumnCellHistogram weights(m_bin_size);
+  for(const auto& bin : m_density.get_bins())
+    weights.add_bin(bin.first, static_cast<uint64_t>(bin.second.m_num_bytes*scale), 0ull);
+  for(auto i=0u;i<m_vid_mapper->get_num_contigs();++i)
+  {
+    const auto& contig_info = m_vid_mapper->get_contig_info(i);
+    if(contig_info.m_length <= 0)
+      continue;
+    auto end_column = contig_info.m_tiledb_column_offset+contig_info.m_length-1;
+    for(auto column=contig_info.m_tiledb_column_offset;column<=end_column;)
+    {
+      auto bin_idx = static_cast<uint64_t>(column)/m_bin_size;
+      auto bin_end = std::min<int64_t>(end_column, weights.get_hi(bin_idx));
+      weights.add_bin(bin_idx, static_cast<uint64_t>((bin_end-column+1)*weight_per_column*scale), 0ull);
+      column = bin_end+1;
+    }
+  }
+  std::vector<uint64_t> counts;
+  if(!weights.equi_partition(num_partitions, partitions, counts))
+  {
+    partitions.assign(1u, ColumnRange(0, INT64_MAX-1));
+    counts.assign(1u, 0ull);
+  }
+  //Heavy bins may produce fewer ranges than requested - halve the heaviest ranges (assuming uniform
+  //density within a range)
+  while(partitions.size() < num_partitions)
+  {
+    auto heaviest_idx = partitions.size();
+    for(auto i=0ull;i<partitions.size();++i)
+      if(partitions[i].second > partitions[i].first
+          && (heaviest_idx == partitions.size() || counts[i] > counts[heaviest_idx]))
+        heaviest_idx = i;
+    if(heaviest_idx == partitions.size())
+      throw ColumnPartitionerException(std::string("Cannot split the column domain into ")
+          +std::to_string(num_partitions)+" partitions");
+    auto& heaviest = partitions[heaviest_idx];
+    auto mid = heaviest.first + (heaviest.second-heaviest.first)/2;
+    ColumnRange second_half(mid+1, heaviest.second);
+    heaviest.second = mid;
+    counts[heaviest_idx] -= counts[heaviest_idx]/2u;
+    partitions.insert(partitions.begin()+heaviest_idx+1u, second_half);
+    counts.insert(counts.begin()+heaviest_idx+1u, counts[heaviest_idx]);
+  }
+  partitions.front().first = 0;
+  partitions.back().second = INT64_MAX-1;
+}
+
+void LoadBalancedColumnPartitioner::initialize_auto_column_partitions(JSONConfigBase& json_config)
+{
+  if(!json_config.needs_auto_column_partitions())
+    return;
+  VERIFY_OR_THROW(!json_config.get_vid_mapping_filename().empty()
+      && "\"column_partitions\" : \"auto\" requires a valid vid_mapping_file");
+  auto row_bounds = json_config.get_row_bounds();
+  FileBasedVidMapper vid_mapper(json_config.get_vid_mapping_filename(), json_config.get_callset_mapping_filename(),
+      row_bounds.first, row_bounds.second, false);
+  LoadBalancedColumnPartitioner partitioner(vid_mapper);
+  std::vector<std::string> filenames;
+  for(auto i=0ll;i<vid_mapper.get_num_files();++i)
+    filenames.push_back(vid_mapper.get_file_info(i).m_name);
+  partitioner.add_density_from_vcf_indexes(filenames);
+  std::vector<ColumnRange> partitions;
+  partitioner.partition(json_config.get_num_auto_column_partitions(), partitions);
+  json_config.set_auto_column_partitions(partitions);
+}
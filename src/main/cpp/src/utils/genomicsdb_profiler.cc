@@ -0,0 +1,327 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genomicsdb_profiler.h"
+#include "timer.h"
+#include <chrono>
+#include <fstream>
+#include <iomanip>
+#include <mutex>
+
+static const char* g_profiler_span_names[] = {
+  "TileDB-iterator-init",
+  "TileDB-iterator-next",
+  "TileDB-to-buffer-cell",
+  "bcf_t-creation",
+  "bcf_t-serialization",
+  "BCF-generator",
+  "Loader-fetch-from-VCF",
+  "Loader-combine-cells",
+  "Loader-flush-output",
+  "Loader-single-thread-phase",
+  "Query-left-sweep",
+  "Query-cell-fill",
+  "Query-operator",
+  "Gather-query",
+  "Gather-serialization",
+  "Gather-MPI-communication",
+  "Gather-deserialization",
+  "Gather-print"
+};
+static_assert(sizeof(g_profiler_span_names)/sizeof(g_profiler_span_names[0]) == PROFILER_NUM_SPANS,
+    "Span names do not match GenomicsDBProfilerSpanEnum");
+
+static const char* g_profiler_counter_names[] = {
+  "TileDB-cells",
+  "BCF-records",
+  "BCF-serialized-bytes",
+  "tile-cache-hits",
+  "tile-cache-misses",
+  "tile-cache-bypasses",
+  "query-cells",
+  "query-left-sweep-cells",
+  "query-valid-cells",
+  "query-attribute-cells-accessed",
+  "query-operator-invocations",
+  "query-filtered-cells",
+  "query-skipped-reference-intervals",
+  "gather-received-bytes"
+};
+static_assert(sizeof(g_profiler_counter_names)/sizeof(g_profiler_counter_names[0]) == PROFILER_NUM_COUNTERS,
+    "Counter names do not match GenomicsDBProfilerCounterEnum");
+
+//Beyond this, trace events are dropped (counted) - totals remain exact
+#define PROFILER_MAX_TRACE_EVENTS_PER_THREAD (1u<<20u)
+
+struct GenomicsDBProfilerTraceEvent
+{
+  unsigned m_span_idx;
+  uint64_t m_begin_ticks;
+  uint64_t m_end_ticks;
+};
+
+struct GenomicsDBProfilerThreadData
+{
+  GenomicsDBProfilerThreadData(const unsigned thread_idx)
+  {
+    m_thread_idx = thread_idx;
+    for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+      m_span_ticks[i] = m_span_counts[i] = 0ull;
+    for(auto i=0u;i<PROFILER_NUM_COUNTERS;++i)
+      m_counters[i] = 0ull;
+    m_num_dropped_trace_events = 0ull;
+  }
+  unsigned m_thread_idx;
+  uint64_t m_span_ticks[PROFILER_NUM_SPANS];
+  uint64_t m_span_counts[PROFILER_NUM_SPANS];
+  uint64_t m_counters[PROFILER_NUM_COUNTERS];
+  std::vector<GenomicsDBProfilerTraceEvent> m_trace_events;
+  uint64_t m_num_dropped_trace_events;
+};
+
+struct GenomicsDBProfilerTimerInfo
+{
+  std::string m_name;
+  double m_wall_clock_time;
+  double m_cpu_time;
+  double m_critical_path_wall_clock_time;
+  double m_critical_path_cpu_time;
+  uint64_t m_num_times_in_critical_path;
+};
+
+//Global state is allocated on the heap and never freed - the report is written by an atexit
+//handler, which may run after static objects are destroyed
+struct GenomicsDBProfilerState
+{
+  std::mutex m_mutex;
+  std::string m_output_prefix;
+  unsigned m_formats;
+  int m_rank;
+  uint64_t m_begin_ticks;
+  std::chrono::steady_clock::time_point m_begin_time;
+  std::vector<GenomicsDBProfilerThreadData*> m_thread_data;
+  std::vector<GenomicsDBProfilerTimerInfo> m_timers;
+};
+static GenomicsDBProfilerState* g_profiler_state = 0;
+static thread_local GenomicsDBProfilerThreadData* g_profiler_thread_data = 0;
+
+std::atomic<bool> GenomicsDBProfiler::m_enabled(false);
+
+static void write_profiler_report_at_exit()
+{
+  GenomicsDBProfiler::write_report();
+}
+
+void GenomicsDBProfiler::enable(const std::string& output_prefix, const std::string& formats, const int rank)
+{
+  static std::mutex enable_mutex;
+  std::lock_guard<std::mutex> lock(enable_mutex);
+  if(is_enabled() || output_prefix.empty())
+    return;
+  auto state = new GenomicsDBProfilerState();
+  state->m_output_prefix = output_prefix;
+  state->m_rank = rank;
+  state->m_formats = 0u;
+  std::stringstream ss(formats);
+  std::string token;
+  while(std::getline(ss, token, ','))
+  {
+    if(token == "json")
+      state->m_formats |= PROFILER_OUTPUT_JSON;
+    else if(token == "csv")
+      state->m_formats |= PROFILER_OUTPUT_CSV;
+    else if(token == "trace")
+      state->m_formats |= PROFILER_OUTPUT_TRACE;
+    else if(!token.empty())
+      std::cerr << "WARNING: unknown profiler output format "<<token<<" ignored\n";
+  }
+  if(state->m_formats == 0u)
+    state->m_formats = PROFILER_OUTPUT_JSON;
+  state->m_begin_time = std::chrono::steady_clock::now();
+  state->m_begin_ticks = get_ticks();
+  g_profiler_state = state;
+  atexit(write_profiler_report_at_exit);
+  m_enabled.store(true);
+}
+
+void GenomicsDBProfiler::enable_from_environment(const int rank)
+{
+  auto output_prefix = getenv(PROFILER_OUTPUT_PREFIX_ENV_VAR);
+  if(output_prefix == 0 || output_prefix[0] == '\0')
+    return;
+  auto formats = getenv(PROFILER_OUTPUT_FORMATS_ENV_VAR);
+  enable(output_prefix, formats ? formats : "json", rank);
+}
+
+static GenomicsDBProfilerThreadData& get_profiler_thread_data()
+{
+  if(g_profiler_thread_data == 0)
+  {
+    assert(g_profiler_state);
+    std::lock_guard<std::mutex> lock(g_profiler_state->m_mutex);
+    g_profiler_thread_data = new GenomicsDBProfilerThreadData(g_profiler_state->m_thread_data.size());
+    g_profiler_state->m_thread_data.push_back(g_profiler_thread_data);
+  }
+  return *g_profiler_thread_data;
+}
+
+void GenomicsDBProfiler::record_span(const unsigned span_idx, const uint64_t begin_ticks, const uint64_t end_ticks)
+{
+  assert(span_idx < PROFILER_NUM_SPANS);
+  auto& thread_data = get_profiler_thread_data();
+  thread_data.m_span_ticks[span_idx] += (end_ticks - begin_ticks);
+  ++(thread_data.m_span_counts[span_idx]);
+  if(g_profiler_state->m_formats & PROFILER_OUTPUT_TRACE)
+  {
+    if(thread_data.m_trace_events.size() < PROFILER_MAX_TRACE_EVENTS_PER_THREAD)
+      thread_data.m_trace_events.push_back({ span_idx, begin_ticks, end_ticks });
+    else
+      ++(thread_data.m_num_dropped_trace_events);
+  }
+}
+
+void GenomicsDBProfiler::add_to_counter(const unsigned counter_idx, const uint64_t val)
+{
+  assert(counter_idx < PROFILER_NUM_COUNTERS);
+  get_profiler_thread_data().m_counters[counter_idx] += val;
+}
+
+void GenomicsDBProfiler::record_timer(const std::string& name, const Timer& timer)
+{
+  if(!is_enabled())
+    return;
+  std::lock_guard<std::mutex> lock(g_profiler_state->m_mutex);
+  //Timer - wall clock in micro-seconds, cpu time in nano-seconds
+  g_profiler_state->m_timers.push_back({ name,
+      timer.get_cumulative_wall_clock_time()/1e6, timer.get_cumulative_cpu_time()/1e9,
+      timer.get_critical_path_wall_clock_time()/1e6, timer.get_critical_path_cpu_time()/1e9,
+      timer.get_num_times_in_critical_path() });
+}
+
+void GenomicsDBProfiler::write_report()
+{
+  if(!is_enabled())
+    return;
+  auto& state = *g_profiler_state;
+  std::lock_guard<std::mutex> lock(state.m_mutex);
+  //Cycle counter to seconds
+  auto end_ticks = get_ticks();
+  auto elapsed_time = std::chrono::duration<double>(std::chrono::steady_clock::now() - state.m_begin_time).count();
+  auto seconds_per_tick = (end_ticks > state.m_begin_ticks) ? elapsed_time/(end_ticks - state.m_begin_ticks) : 0.0;
+  //Totals over all threads
+  std::vector<uint64_t> span_ticks(PROFILER_NUM_SPANS, 0ull);
+  std::vector<uint64_t> span_counts(PROFILER_NUM_SPANS, 0ull);
+  std::vector<uint64_t> counters(PROFILER_NUM_COUNTERS, 0ull);
+  for(auto thread_data : state.m_thread_data)
+  {
+    for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+    {
+      span_ticks[i] += thread_data->m_span_ticks[i];
+      span_counts[i] += thread_data->m_span_counts[i];
+    }
+    for(auto i=0u;i<PROFILER_NUM_COUNTERS;++i)
+      counters[i] += thread_data->m_counters[i];
+  }
+  auto filename_prefix = state.m_output_prefix + ".rank" + std::to_string(state.m_rank);
+  if(state.m_formats & PROFILER_OUTPUT_JSON)
+  {
+    std::ofstream fptr((filename_prefix+".json").c_str());
+    fptr << std::fixed << std::setprecision(6);
+    fptr << "{\n";
+    fptr << "  \"rank\": " << state.m_rank << ",\n";
+    fptr << "  \"elapsed_wall_clock_time_s\": " << elapsed_time << ",\n";
+    fptr << "  \"num_threads\": " << state.m_thread_data.size() << ",\n";
+    fptr << "  \"spans\": {";
+    for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+      fptr << (i ? ",\n" : "\n") << "    \"" << g_profiler_span_names[i] << "\": { \"count\": " << span_counts[i]
+        << ", \"total_time_s\": " << span_ticks[i]*seconds_per_tick << " }";
+    fptr << "\n  },\n";
+    fptr << "  \"counters\": {";
+    for(auto i=0u;i<PROFILER_NUM_COUNTERS;++i)
+      fptr << (i ? ",\n" : "\n") << "    \"" << g_profiler_counter_names[i] << "\": " << counters[i];
+    fptr << "\n  },\n";
+    fptr << "  \"threads\": [";
+    for(auto j=0ull;j<state.m_thread_data.size();++j)
+    {
+      const auto& thread_data = *(state.m_thread_data[j]);
+      fptr << (j ? ",\n" : "\n") << "    { \"thread\": " << thread_data.m_thread_idx << ", \"spans\": {";
+      auto num_printed = 0u;
+      for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+        if(thread_data.m_span_counts[i])
+          fptr << (num_printed++ ? ", " : " ") << "\"" << g_profiler_span_names[i] << "\": { \"count\": "
+            << thread_data.m_span_counts[i] << ", \"total_time_s\": " << thread_data.m_span_ticks[i]*seconds_per_tick << " }";
+      fptr << " }, \"counters\": {";
+      num_printed = 0u;
+      for(auto i=0u;i<PROFILER_NUM_COUNTERS;++i)
+        if(thread_data.m_counters[i])
+          fptr << (num_printed++ ? ", " : " ") << "\"" << g_profiler_counter_names[i] << "\": " << thread_data.m_counters[i];
+      fptr << " }, \"dropped_trace_events\": " << thread_data.m_num_dropped_trace_events << " }";
+    }
+    fptr << "\n  ],\n";
+    fptr << "  \"timers\": [";
+    for(auto j=0ull;j<state.m_timers.size();++j)
+    {
+      const auto& timer_info = state.m_timers[j];
+      fptr << (j ? ",\n" : "\n") << "    { \"name\": \"" << timer_info.m_name << "\""
+        << ", \"wall_clock_time_s\": " << timer_info.m_wall_clock_time
+        << ", \"cpu_time_s\": " << timer_info.m_cpu_time
+        << ", \"critical_path_wall_clock_time_s\": " << timer_info.m_critical_path_wall_clock_time
+        << ", \"critical_path_cpu_time_s\": " << timer_info.m_critical_path_cpu_time
+        << ", \"num_times_in_critical_path\": " << timer_info.m_num_times_in_critical_path << " }";
+    }
+    fptr << "\n  ]\n";
+    fptr << "}\n";
+  }
+  if(state.m_formats & PROFILER_OUTPUT_CSV)
+  {
+    std::ofstream fptr((filename_prefix+".csv").c_str());
+    fptr << std::fixed << std::setprecision(6);
+    fptr << "rank,type,name,thread,count,time_s\n";
+    for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+      fptr << state.m_rank << ",span," << g_profiler_span_names[i] << ",all," << span_counts[i] << ","
+        << span_ticks[i]*seconds_per_tick << "\n";
+    for(auto thread_data : state.m_thread_data)
+      for(auto i=0u;i<PROFILER_NUM_SPANS;++i)
+        if(thread_data->m_span_counts[i])
+          fptr << state.m_rank << ",span," << g_profiler_span_names[i] << "," << thread_data->m_thread_idx << ","
+            << thread_data->m_span_counts[i] << "," << thread_data->m_span_ticks[i]*seconds_per_tick << "\n";
+    for(auto i=0u;i<PROFILER_NUM_COUNTERS;++i)
+      fptr << state.m_rank << ",counter," << g_profiler_counter_names[i] << ",all," << counters[i] << ",\n";
+    for(const auto& timer_info : state.m_timers)
+      fptr << state.m_rank << ",timer," << timer_info.m_name << ",,," << timer_info.m_wall_clock_time << "\n";
+  }
+  if(state.m_formats & PROFILER_OUTPUT_TRACE)
+  {
+    std::ofstream fptr((filename_prefix+".trace.json").c_str());
+    fptr << std::fixed << std::setprecision(3);
+    fptr << "{\"traceEvents\":[";
+    auto num_printed = 0ull;
+    auto microseconds_per_tick = seconds_per_tick*1e6;
+    for(auto thread_data : state.m_thread_data)
+      for(const auto& event : thread_data->m_trace_events)
+        fptr << (num_printed++ ? ",\n" : "\n") << "{\"name\":\"" << g_profiler_span_names[event.m_span_idx]
+          << "\",\"ph\":\"X\",\"pid\":" << state.m_rank << ",\"tid\":" << thread_data->m_thread_idx
+          << ",\"ts\":" << static_cast<int64_t>(event.m_begin_ticks - state.m_begin_ticks)*microseconds_per_tick
+          << ",\"dur\":" << (event.m_end_ticks - event.m_begin_ticks)*microseconds_per_tick << "}";
+    fptr << "\n]}\n";
+  }
+}
@@ -161,3 +161,81 @@ uint64_t UniformHistogram::deserialize(const uint8_t* data, uint64_t offset)
   idx += sizeof(uint64_t);
   return idx;
 }
+
+void ColumnCellHistogram::set_bin_size(const uint64_t bin_size)
+{
+  if(bin_size == 0u)
+    throw HistogramException("Bin size of ColumnCellHistogram must be > 0");
+  if(!empty() && bin_size != m_bin_size)
+    throw HistogramException("Cannot change bin size of a non-empty ColumnCellHistogram");
+  m_bin_size = bin_size;
+}
+
+void ColumnCellHistogram::add_bin(const uint64_t bin_idx, const uint64_t num_cells, const uint64_t num_bytes)
+{
+  auto& counts = m_bins[bin_idx];
+  counts.m_num_cells += num_cells;
+  counts.m_num_bytes += num_bytes;
+}
+
+void ColumnCellHistogram::sum_up_histogram(const ColumnCellHistogram& other)
+{
+  if(other.m_bin_size != m_bin_size)
+    throw HistogramException("To sum up ColumnCellHistogram objects, bin sizes must match");
+  for(const auto& bin : other.m_bins)
+    add_bin(bin.first, bin.second.m_num_cells, bin.second.m_num_bytes);
+}
+
+uint64_t ColumnCellHistogram::get_total_num_cells() const
+{
+  auto total = 0ull;
+  for(const auto& bin : m_bins)
+    total += bin.second.m_num_cells;
+  return total;
+}
+
+uint64_t ColumnCellHistogram::get_total_num_bytes() const
+{
+  auto total = 0ull;
+  for(const auto& bin : m_bins)
+    total += bin.second.m_num_bytes;
+  return total;
+}
+
+bool ColumnCellHistogram::equi_partition(const uint64_t num_partitions, std::vector<ColumnRange>& column_ranges,
+    std::vector<uint64_t>& counts, const bool balance_bytes) const
+{
+  column_ranges.clear();
+  counts.clear();
+  if(num_partitions == 0u || m_bins.empty())
+    return false;
+  auto total = balance_bytes ? get_total_num_bytes() : get_total_num_cells();
+  auto count_per_partition = static_cast<double>(total)/num_partitions;
+  auto curr_begin = static_cast<int64_t>(get_lo((*(m_bins.begin())).first));
+  auto curr_total = 0ull;
+  auto num_bins_left = m_bins.size();
+  for(const auto& bin : m_bins)
+  {
+    curr_total += balance_bytes ? bin.second.m_num_bytes : bin.second.m_num_cells;
+    --num_bins_left;
+    //Close the current range once it is full, the last range takes the remainder
+    if((curr_total >= count_per_partition && column_ranges.size()+1u < num_partitions) || num_bins_left == 0u)
+    {
+      auto curr_end = static_cast<int64_t>(get_hi(bin.first));
+      column_ranges.emplace_back(curr_begin, curr_end);
+      counts.push_back(curr_total);
+      curr_begin = curr_end+1;
+      curr_total = 0ull;
+    }
+  }
+  return true;
+}
+
+void ColumnCellHistogram::print(std::ostream& fptr) const
+{
+  fptr << "ColumnCellHistogram: bin size "<<m_bin_size<<" [\n";
+  for(const auto& bin : m_bins)
+    fptr << get_lo(bin.first) << "," << get_hi(bin.first) << "," << bin.second.m_num_cells << ","
+      << bin.second.m_num_bytes << "\n";
+  fptr << "]\n";
+}
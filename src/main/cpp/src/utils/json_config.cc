@@ -26,6 +26,7 @@
 #endif
 
 #include <zlib.h>
+#include <unistd.h>
 #include "json_config.h"
 
 #define VERIFY_OR_THROW(X) if(!(X)) throw RunConfigException(#X);
@@ -41,6 +42,14 @@ void JSONConfigBase::clear()
   m_sorted_row_partitions.clear();
   m_vid_mapping_file.clear();
   m_callset_mapping_file.clear();
+  m_iterator_memory_budget = 0u;
+  m_profile_output_prefix.clear();
+  m_profile_formats.clear();
+  m_tile_cache_size = -1;
+  m_tile_cache_tile_width = 0;
+  m_ga4gh_paging_cursor_ttl = -1;
+  m_ga4gh_max_num_paging_cursors = -1;
+  m_ga4gh_paging_cursors_max_size = -1;
 }
 
 void JSONConfigBase::extract_contig_interval_from_object(const rapidjson::Value& curr_json_object,
@@ -90,6 +99,68 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
     if(tmp_vid_mapper.is_initialized())
       id_mapper = &tmp_vid_mapper;
   }
+  //Runtime profiler - "profile" : "<output_prefix>" or { "output_prefix" : "..", "formats" : "json,csv,trace" }
+  if(m_json.HasMember("profile"))
+  {
+    const rapidjson::Value& profile_value = m_json["profile"];
+    if(profile_value.IsString())
+    {
+      m_profile_output_prefix = profile_value.GetString();
+      m_profile_formats = "json";
+    }
+    else
+    {
+      VERIFY_OR_THROW(profile_value.IsObject() && profile_value.HasMember("output_prefix")
+          && profile_value["output_prefix"].IsString());
+      m_profile_output_prefix = profile_value["output_prefix"].GetString();
+      m_profile_formats = (profile_value.HasMember("formats") && profile_value["formats"].IsString())
+        ? profile_value["formats"].GetString() : "json";
+    }
+  }
+  //Process wide tile cache - "tile_cache" : <bytes> or { "size" : <bytes>, "tile_width" : <#columns> }
+  if(m_json.HasMember("tile_cache"))
+  {
+    const rapidjson::Value& tile_cache_value = m_json["tile_cache"];
+    if(tile_cache_value.IsObject())
+    {
+      VERIFY_OR_THROW(tile_cache_value.HasMember("size") && tile_cache_value["size"].IsInt64()
+          && tile_cache_value["size"].GetInt64() >= 0);
+      if(tile_cache_value.HasMember("tile_width"))
+      {
+        VERIFY_OR_THROW(tile_cache_value["tile_width"].IsInt64() && tile_cache_value["tile_width"].GetInt64() > 0);
+        m_tile_cache_tile_width = tile_cache_value["tile_width"].GetInt64();
+      }
+      m_tile_cache_size = tile_cache_value["size"].GetInt64();
+    }
+    else
+    {
+      VERIFY_OR_THROW(tile_cache_value.IsInt64() && tile_cache_value.GetInt64() >= 0
+          && "tile_cache must be a non-negative integer or a dictionary");
+      m_tile_cache_size = tile_cache_value.GetInt64();
+    }
+  }
+  //Process wide table of GA4GH paging cursors -
+  //"ga4gh_paging_cursors" : { "ttl" : <seconds>, "max_num_cursors" : <#>, "max_size" : <bytes> }
+  if(m_json.HasMember("ga4gh_paging_cursors"))
+  {
+    const rapidjson::Value& cursors_value = m_json["ga4gh_paging_cursors"];
+    VERIFY_OR_THROW(cursors_value.IsObject() && "ga4gh_paging_cursors must be a dictionary");
+    if(cursors_value.HasMember("ttl"))
+    {
+      VERIFY_OR_THROW(cursors_value["ttl"].IsUint());
+      m_ga4gh_paging_cursor_ttl = cursors_value["ttl"].GetUint();
+    }
+    if(cursors_value.HasMember("max_num_cursors"))
+    {
+      VERIFY_OR_THROW(cursors_value["max_num_cursors"].IsInt64() && cursors_value["max_num_cursors"].GetInt64() > 0);
+      m_ga4gh_max_num_paging_cursors = cursors_value["max_num_cursors"].GetInt64();
+    }
+    if(cursors_value.HasMember("max_size"))
+    {
+      VERIFY_OR_THROW(cursors_value["max_size"].IsInt64() && cursors_value["max_size"].GetInt64() >= 0);
+      m_ga4gh_paging_cursors_max_size = cursors_value["max_size"].GetInt64();
+    }
+  }
   //Workspace
   if(m_json.HasMember("workspace"))
   {
@@ -154,7 +225,10 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
     //This means that rank 0 will have 2 query intervals: [0-5] and [45-45] and rank 1 will have
     //2 intervals [76-76] and [87-87]
     //But you could have a single innermost list - with this option all ranks will query the same list 
-    if(m_json.HasMember("query_column_ranges"))
+    //"query_column_ranges" : "auto" splits the column domain into balanced ranges - one per rank
+    if(m_json.HasMember("query_column_ranges") && m_json["query_column_ranges"].IsString())
+      initialize_auto_query_column_ranges();
+    else if(m_json.HasMember("query_column_ranges"))
     {
       const rapidjson::Value& q1 = m_json["query_column_ranges"];
       VERIFY_OR_THROW(q1.IsArray());
@@ -201,7 +275,9 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
       }
     }
     else
-      if (m_json.HasMember("column_partitions"))
+      if(m_json.HasMember("column_partitions") && m_json["column_partitions"].IsString())
+        initialize_auto_column_partitions();
+      else if (m_json.HasMember("column_partitions"))
       {
         m_column_partitions_specified = true;
         //column_partitions_array itself is an array of the form [ { "begin" : <value> }, { "begin":<value>} ]
@@ -386,6 +462,12 @@ void JSONConfigBase::read_from_file(const std::string& filename, const VidMapper
       m_attributes[i] = std::move(std::string(q2.GetString()));
     }
   }
+  if(m_json.HasMember("iterator_memory_budget"))
+  {
+    const rapidjson::Value& budget = m_json["iterator_memory_budget"];
+    VERIFY_OR_THROW(budget.IsInt64() && budget.GetInt64() >= 0 && "iterator_memory_budget must be a non-negative integer");
+    m_iterator_memory_budget = budget.GetInt64();
+  }
 }
 
 const std::string& JSONConfigBase::get_workspace(const int rank) const
@@ -448,6 +530,168 @@ const std::vector<ColumnRange>& JSONConfigBase::get_query_column_ranges(const in
   return m_column_ranges[fixed_rank];
 }
 
+#define AUTO_COLUMN_PARTITIONS_PATH(workspace, array) ((workspace)+'/'+(array)+".column_partitions.json")
+
+static unsigned get_num_auto_column_partitions(const rapidjson::Document& json)
+{
+  VERIFY_OR_THROW(json.HasMember("num_column_partitions") && json["num_column_partitions"].IsUint()
+      && json["num_column_partitions"].GetUint() > 0u
+      && "\"auto\" column partitioning requires a positive integer \"num_column_partitions\"");
+  return json["num_column_partitions"].GetUint();
+}
+
+//{ "column_partitions" : [ [ begin, end ], .. ] }
+static bool read_auto_column_partitions(const std::string& filename, const unsigned num_partitions,
+    std::vector<ColumnRange>& partitions)
+{
+  std::ifstream ifs(filename.c_str());
+  if(!ifs.is_open())
+    return false;
+  std::string str((std::istreambuf_iterator<char>(ifs)), std::istreambuf_iterator<char>());
+  rapidjson::Document json_doc;
+  json_doc.Parse(str.c_str());
+  if(json_doc.HasParseError() || !json_doc.IsObject() || !json_doc.HasMember("column_partitions")
+      || !json_doc["column_partitions"].IsArray())
+    throw RunConfigException(std::string("Syntax error in column partitions file ")+filename);
+  const auto& partitions_array = json_doc["column_partitions"];
+  //Different #partitions - array(s) must be re-created anyway
+  if(partitions_array.Size() != num_partitions)
+    return false;
+  partitions.resize(num_partitions);
+  for(rapidjson::SizeType i=0u;i<partitions_array.Size();++i)
+  {
+    const auto& curr_partition = partitions_array[i];
+    VERIFY_OR_THROW(curr_partition.IsArray() && curr_partition.Size() == 2u
+        && curr_partition[0u].IsInt64() && curr_partition[1u].IsInt64());
+    partitions[i].first = curr_partition[0u].GetInt64();
+    partitions[i].second = curr_partition[1u].GetInt64();
+  }
+  return true;
+}
+
+static void write_auto_column_partitions(const std::string& workspace, const std::string& filename,
+    const std::vector<ColumnRange>& partitions)
+{
+  //Workspace is created by the loader - partitions are stored once it exists
+  struct stat st;
+  if(stat(workspace.c_str(), &st) < 0 || !S_ISDIR(st.st_mode))
+    return;
+  rapidjson::Document json_doc;
+  json_doc.SetObject();
+  auto& allocator = json_doc.GetAllocator();
+  rapidjson::Value partitions_array(rapidjson::kArrayType);
+  for(const auto& partition : partitions)
+  {
+    rapidjson::Value curr_partition(rapidjson::kArrayType);
+    curr_partition.PushBack(partition.first, allocator);
+    curr_partition.PushBack(partition.second, allocator);
+    partitions_array.PushBack(curr_partition, allocator);
+  }
+  json_doc.AddMember("column_partitions", partitions_array, allocator);
+  rapidjson::StringBuffer buffer;
+  rapidjson::Writer<rapidjson::StringBuffer> writer(buffer);
+  json_doc.Accept(writer);
+  //All ranks write identical contents - rename() ensures readers never see a partial file
+  auto tmp_filename = filename+".tmp."+std::to_string(getpid());
+  auto* fptr = fopen(tmp_filename.c_str(), "w");
+  VERIFY_OR_THROW(fptr);
+  fwrite(reinterpret_cast<const void*>(buffer.GetString()), 1u, strlen(buffer.GetString()), fptr);
+  fclose(fptr);
+  if(rename(tmp_filename.c_str(), filename.c_str()) != 0)
+  {
+    remove(tmp_filename.c_str());
+    throw RunConfigException(std::string("Could not write column partitions file ")+filename);
+  }
+}
+
+void JSONConfigBase::initialize_auto_column_partitions()
+{
+  VERIFY_OR_THROW(std::string(m_json["column_partitions"].GetString()) == "auto"
+      && "\"column_partitions\" must be a list of partitions or \"auto\"");
+  auto num_partitions = get_num_auto_column_partitions(m_json);
+  m_num_auto_column_partitions = num_partitions;
+  VERIFY_OR_THROW(m_workspaces.size() && m_array_names.size()
+      && "\"column_partitions\" : \"auto\" requires top level \"workspace\" and \"array\"");
+  VERIFY_OR_THROW((m_single_workspace_path || m_workspaces.size() == num_partitions)
+      && "#workspaces must be equal to \"num_column_partitions\"");
+  VERIFY_OR_THROW((m_single_array_name || m_array_names.size() == num_partitions)
+      && "#arrays must be equal to \"num_column_partitions\"");
+  m_auto_column_partitions = true;
+  m_column_partitions_specified = true;
+  //Partitions in the same workspace need distinct arrays - <array>_<partition_idx>
+  if(m_single_workspace_path && m_single_array_name && num_partitions > 1u)
+  {
+    auto array_name = m_array_names[0];
+    m_array_names.resize(num_partitions);
+    for(auto i=0u;i<num_partitions;++i)
+      m_array_names[i] = array_name+'_'+std::to_string(i);
+    m_single_array_name = false;
+  }
+  //Partitions stored by a previous load are re-used - incremental loads and queries must see the
+  //same partitions even if the set of input files changes
+  auto recreate_array = m_compute_auto_column_partitions && m_json.HasMember("delete_and_create_tiledb_array")
+    && m_json["delete_and_create_tiledb_array"].IsBool() && m_json["delete_and_create_tiledb_array"].GetBool();
+  std::vector<ColumnRange> partitions;
+  auto found_stored_partitions = false;
+  for(auto i=0ull;i<m_workspaces.size() && !recreate_array && !found_stored_partitions;++i)
+    found_stored_partitions = read_auto_column_partitions(AUTO_COLUMN_PARTITIONS_PATH(m_workspaces[i], m_array_names[0]),
+        num_partitions, partitions);
+  if(found_stored_partitions)
+    set_auto_column_partitions(partitions);
+  //Only the loader creating the array(s) may compute partitions - stored by store_auto_column_partitions()
+  else if(!m_compute_auto_column_partitions)
+    throw RunConfigException(std::string("No column partitions with ")+std::to_string(num_partitions)
+        +" partitions stored in "+AUTO_COLUMN_PARTITIONS_PATH(m_workspaces[0], m_array_names[0])
+        +" - \"column_partitions\" : \"auto\" requires the array(s) to be created by the loader first");
+}
+
+void JSONConfigBase::set_auto_column_partitions(const std::vector<ColumnRange>& partitions)
+{
+  VERIFY_OR_THROW(m_auto_column_partitions && partitions.size() == m_num_auto_column_partitions);
+  m_sorted_column_partitions = partitions;
+  m_column_ranges.resize(partitions.size());
+  for(auto i=0ull;i<partitions.size();++i)
+    m_column_ranges[i].assign(1u, partitions[i]);
+}
+
+void JSONConfigBase::store_auto_column_partitions(const int rank) const
+{
+  if(!m_auto_column_partitions)
+    return;
+  const auto& workspace = get_workspace(rank);
+  write_auto_column_partitions(workspace, AUTO_COLUMN_PARTITIONS_PATH(workspace, m_array_names[0]),
+      m_sorted_column_partitions);
+}
+
+void JSONConfigBase::initialize_auto_query_column_ranges()
+{
+  VERIFY_OR_THROW(std::string(m_json["query_column_ranges"].GetString()) == "auto"
+      && "\"query_column_ranges\" must be a list of ranges or \"auto\"");
+  m_num_auto_column_partitions = get_num_auto_column_partitions(m_json);
+  VERIFY_OR_THROW(m_workspaces.size() && m_array_names.size()
+      && "\"query_column_ranges\" : \"auto\" requires \"workspace\" and \"array\"");
+  m_auto_query_column_ranges = true;
+}
+
+void JSONConfigBase::set_auto_query_column_ranges(const std::vector<ColumnRange>& ranges)
+{
+  VERIFY_OR_THROW(m_auto_query_column_ranges && ranges.size() == m_num_auto_column_partitions);
+  m_column_ranges.resize(ranges.size());
+  for(auto i=0ull;i<ranges.size();++i)
+    m_column_ranges[i].assign(1u, ranges[i]);
+  m_single_query_column_ranges_vector = (ranges.size() == 1u);
+}
+
+void JSONConfigBase::get_workspaces_and_arrays(std::set<std::pair<std::string, std::string>>& workspace_array_pairs) const
+{
+  workspace_array_pairs.clear();
+  if(m_workspaces.empty() || m_array_names.empty())
+    return;
+  for(auto i=0ull;i<std::max(m_workspaces.size(), m_array_names.size());++i)
+    workspace_array_pairs.emplace(m_workspaces[std::min(i, m_workspaces.size()-1u)],
+        m_array_names[std::min(i, m_array_names.size()-1u)]);
+}
+
 void JSONConfigBase::read_and_initialize_vid_and_callset_mapping_if_available(FileBasedVidMapper* id_mapper, const int rank)
 {
   auto& vid_mapping_file = m_vid_mapping_file;
@@ -525,6 +769,13 @@ void JSONBasicQueryConfig::subset_query_column_ranges_based_on_partition(const J
     if (loader_config->is_partitioned_by_column())
     {
       ColumnRange my_rank_loader_column_range = loader_config->get_column_partition(rank);
+      //Balanced ranges are replaced by the partition loaded by this rank
+      if(m_auto_query_column_ranges)
+      {
+        m_column_ranges.assign(1u, std::vector<ColumnRange>(1u, my_rank_loader_column_range));
+        m_single_query_column_ranges_vector = true;
+        return;
+      }
       std::vector<ColumnRange> my_rank_queried_columns;
       for(auto queried_column_range : get_query_column_ranges(rank))
       {
@@ -571,15 +822,23 @@ void JSONBasicQueryConfig::read_from_file(const std::string& filename, VariantQu
   auto& array_name = m_single_array_name ? m_array_names[0] : m_array_names[rank];
   VERIFY_OR_THROW(array_name != "" && "Empty array name");
   //Query columns
-  VERIFY_OR_THROW((m_column_ranges.size() || m_scan_whole_array) && "Query column ranges not specified");
+  VERIFY_OR_THROW((m_column_ranges.size() || m_scan_whole_array || m_auto_query_column_ranges)
+      && "Query column ranges not specified");
   subset_query_column_ranges_based_on_partition(loader_config, rank);
-  if(!m_scan_whole_array)
+  //"auto" ranges are added to query_config once the query processor computes them
+  if(!m_scan_whole_array && !needs_auto_query_column_ranges())
   {
     VERIFY_OR_THROW((m_single_query_column_ranges_vector || static_cast<size_t>(rank) < m_column_ranges.size())
         && "Rank >= query column ranges vector size");
     for(const auto& range : get_query_column_ranges(rank))
       query_config.add_column_interval_to_query(range.first, range.second);
   }
+  //Array row -> query row map, 0 always uses the dense map
+  if(m_json.HasMember("sparse_row_map_ratio"))
+  {
+    VERIFY_OR_THROW(m_json["sparse_row_map_ratio"].IsUint64() && "sparse_row_map_ratio must be a non-negative integer");
+    query_config.set_sparse_row_map_ratio(m_json["sparse_row_map_ratio"].GetUint64());
+  }
   //Query rows
   if(!m_scan_whole_array && m_row_ranges.size())
   {
@@ -597,6 +856,39 @@ void JSONBasicQueryConfig::read_from_file(const std::string& filename, VariantQu
   }
   //Attributes
   query_config.set_attributes_to_query(m_attributes);
+  //Scans skip intervals covered only by reference blocks
+  if(m_json.HasMember("variant_sites_only"))
+  {
+    VERIFY_OR_THROW(m_json["variant_sites_only"].IsBool() && "variant_sites_only must be a boolean");
+    query_config.set_variant_sites_only(m_json["variant_sites_only"].GetBool());
+  }
+  //Filters pushed down to the cells - "GQ>=20 && DP>5" or [ "GQ>=20", "DP>5" ]
+  //Fields used in filters are fetched by the query - like END, they appear in the output even if
+  //they are not listed in query_attributes
+  if(m_json.HasMember("query_filters"))
+  {
+    const rapidjson::Value& filters = m_json["query_filters"];
+    std::vector<std::string> expressions;
+    if(filters.IsString())
+    {
+      std::string str = filters.GetString();
+      size_t begin = 0u;
+      for(auto end=str.find("&&");end!=std::string::npos;begin=end+2u,end=str.find("&&", begin))
+        expressions.push_back(str.substr(begin, end-begin));
+      expressions.push_back(str.substr(begin));
+    }
+    else
+    {
+      VERIFY_OR_THROW(filters.IsArray() && "query_filters must be a string or a list of strings");
+      for(rapidjson::SizeType i=0;i<filters.Size();++i)
+      {
+        VERIFY_OR_THROW(filters[i].IsString() && "query_filters must be a string or a list of strings");
+        expressions.push_back(filters[i].GetString());
+      }
+    }
+    for(const auto& expression : expressions)
+      query_config.add_filter(expression);
+  }
 }
 
 //Loader config functions
@@ -635,6 +927,8 @@ JSONLoaderConfig::JSONLoaderConfig(
   m_fail_if_updating = false;
   m_tiledb_compression_level = Z_DEFAULT_COMPRESSION;
   m_consolidate_tiledb_array_after_load = false;
+  m_use_fragment_consolidation_policy = false;
+  m_consolidate_in_background = false;
 }
 
 void JSONLoaderConfig::read_from_file(const std::string& filename, FileBasedVidMapper* id_mapper, const int rank)
@@ -738,6 +1032,50 @@ void JSONLoaderConfig::read_from_file(const std::string& filename, FileBasedVidM
   m_consolidate_tiledb_array_after_load = false;
   if(m_json.HasMember("consolidate_tiledb_array_after_load") && m_json["consolidate_tiledb_array_after_load"].IsBool())
     m_consolidate_tiledb_array_after_load = m_json["consolidate_tiledb_array_after_load"].GetBool();
+  //size tiered consolidation for incremental loads - every load adds a fragment
+  //"fragment_consolidation" : { "max_fragments": 16, "max_fragments_per_tier": 4, "min_tier_size": <bytes>,
+  //    "tier_size_ratio": 4, "background": false }
+  m_use_fragment_consolidation_policy = false;
+  m_consolidate_in_background = false;
+  if(m_json.HasMember("fragment_consolidation"))
+  {
+    const auto& policy_dict = m_json["fragment_consolidation"];
+    VERIFY_OR_THROW(policy_dict.IsObject());
+    FragmentConsolidationPolicy default_policy;
+    auto max_num_fragments = default_policy.get_max_num_fragments();
+    if(policy_dict.HasMember("max_fragments"))
+    {
+      VERIFY_OR_THROW(policy_dict["max_fragments"].IsUint() && "max_fragments must be a non-negative integer");
+      max_num_fragments = policy_dict["max_fragments"].GetUint();
+    }
+    auto max_num_fragments_per_tier = default_policy.get_max_num_fragments_per_tier();
+    if(policy_dict.HasMember("max_fragments_per_tier"))
+    {
+      VERIFY_OR_THROW(policy_dict["max_fragments_per_tier"].IsUint()
+          && "max_fragments_per_tier must be a non-negative integer");
+      max_num_fragments_per_tier = policy_dict["max_fragments_per_tier"].GetUint();
+    }
+    auto min_tier_size = default_policy.get_min_tier_size();
+    if(policy_dict.HasMember("min_tier_size"))
+    {
+      VERIFY_OR_THROW(policy_dict["min_tier_size"].IsUint64() && "min_tier_size must be a non-negative integer");
+      min_tier_size = policy_dict["min_tier_size"].GetUint64();
+    }
+    auto tier_size_ratio = default_policy.get_tier_size_ratio();
+    if(policy_dict.HasMember("tier_size_ratio"))
+    {
+      VERIFY_OR_THROW(policy_dict["tier_size_ratio"].IsUint() && "tier_size_ratio must be a non-negative integer");
+      tier_size_ratio = policy_dict["tier_size_ratio"].GetUint();
+    }
+    m_fragment_consolidation_policy = FragmentConsolidationPolicy(max_num_fragments, max_num_fragments_per_tier,
+        min_tier_size, tier_size_ratio);
+    m_use_fragment_consolidation_policy = true;
+    if(policy_dict.HasMember("background"))
+    {
+      VERIFY_OR_THROW(policy_dict["background"].IsBool() && "background must be a boolean");
+      m_consolidate_in_background = policy_dict["background"].GetBool();
+    }
+  }
 }
    
 #ifdef HTSDIR
@@ -784,7 +1122,7 @@ void JSONVCFAdapterConfig::read_from_file(const std::string& filename,
   else
     m_vcf_output_filename = "-";        //stdout
   //VCF output could also be specified in column partitions
-  if(m_json.HasMember("column_partitions"))
+  if(m_json.HasMember("column_partitions") && m_json["column_partitions"].IsArray())
   {
     //column_partitions_array is an array of the form [ { "begin" : <value> }, {"begin":<value>} ]
     auto& column_partitions_array = m_json["column_partitions"];
@@ -20,6 +20,7 @@
  * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
 */
 
+#include <algorithm>
 #include <iostream>
 
 #include "libtiledb_variant.h"
@@ -81,23 +82,37 @@ extern "C" void db_query_column(std::string workspace, std::string array_name,
       variant = std::move(Variant(&query_config));
       variant.resize_based_on_query();
     }
-    f.stats.increment_num_queries();
-    qp->gt_get_column(qp->get_array_descriptor(), query_config, query_interval_idx, variant, &f.stats);
+    qp->gt_get_column(qp->get_array_descriptor(), query_config, query_interval_idx, variant);
 }
 
 extern "C" void db_query_column_range(std::string workspace, std::string array_name, 
         uint64_t query_interval_idx, std::vector<Variant>& variants, VariantQueryConfig& query_config,
         const VidMapper& vid_mapper, GA4GHPagingInfo* paging_info) {
+    // With paging, the scan state is kept in a cursor between pages - pages of an expired (or
+    // unknown) cursor are produced by re-scanning from the position in the page token
+    std::shared_ptr<FactoryPagingCursor> cursor;
+    if(paging_info) {
+        auto& cursor_table = GA4GHPagingCursorTable::get_instance();
+        paging_info->deserialize_page_end();
+        if(paging_info->get_cursor_id())
+            cursor = std::dynamic_pointer_cast<FactoryPagingCursor>(cursor_table.acquire(paging_info->get_cursor_id()));
+        if(!cursor || cursor->m_workspace != workspace || cursor->m_array_name != array_name)
+            cursor = std::make_shared<FactoryPagingCursor>(workspace, array_name);
+    }
     // Init Storage Manager object in the Factory class as 
     // both ArrayDescriptor and Query Processor use it 
-    Factory f;
+    Factory local_factory;
+    Factory& f = cursor ? cursor->m_factory : local_factory;
     VariantQueryProcessor *qp = f.getVariantQueryProcessor(workspace, array_name, vid_mapper);
     //Do book-keeping, if not already done
     if(!query_config.is_bookkeeping_done())
         qp->do_query_bookkeeping(qp->get_array_schema(), query_config, vid_mapper, true);
-    qp->gt_get_column_interval(qp->get_array_descriptor(), query_config, query_interval_idx, variants, paging_info, &f.stats);
-    if(paging_info == 0 || paging_info->is_query_completed())
-        f.stats.increment_num_queries();
+    qp->gt_get_column_interval(qp->get_array_descriptor(), query_config, query_interval_idx, variants, paging_info,
+        cursor.get());
+    if(cursor && cursor->is_valid()) {
+        paging_info->set_cursor_id(GA4GHPagingCursorTable::get_instance().insert(cursor));
+        paging_info->serialize_page_end(qp->get_array_schema().array_name());
+    }
 }
 
 extern "C" void db_cleanup() {
@@ -191,3 +206,235 @@ extern "C" void test_C_pointers(Variant& variant)
         }
     }
 }
+
+//VariantQueryService functions
+
+//Query processors initialize static members on first construction
+static std::mutex g_session_creation_mutex;
+
+VariantQueryService::VariantQueryService(const unsigned max_sessions_per_array, const unsigned max_queued_requests,
+    const unsigned num_worker_threads, const size_t segment_size) {
+    auto num_cores = std::max(std::thread::hardware_concurrency(), 1u);
+    m_max_sessions_per_array = max_sessions_per_array ? max_sessions_per_array : num_cores;
+    m_max_pending_requests = m_max_sessions_per_array + max_queued_requests;
+    m_segment_size = segment_size;
+    m_num_pending_requests = 0u;
+    m_num_rejected_requests = 0ull;
+    m_stop_workers = false;
+    auto num_workers = num_worker_threads ? num_worker_threads : num_cores;
+    for(auto i=0u;i<num_workers;++i)
+        m_workers.emplace_back(&VariantQueryService::worker_loop, this);
+}
+
+VariantQueryService::~VariantQueryService() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stop_workers = true;
+    }
+    m_task_available.notify_all();
+    for(auto& worker : m_workers)
+        worker.join();
+    m_workers.clear();
+    m_session_pools.clear();
+}
+
+void VariantQueryService::admit_request() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if(m_num_pending_requests >= m_max_pending_requests) {
+        ++m_num_rejected_requests;
+        throw VariantQueryServiceException("Too many pending requests ("+std::to_string(m_num_pending_requests)
+            +"), request rejected");
+    }
+    ++m_num_pending_requests;
+}
+
+void VariantQueryService::finish_request() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    assert(m_num_pending_requests > 0u);
+    --m_num_pending_requests;
+}
+
+std::unique_ptr<VariantQueryService::Session> VariantQueryService::acquire_session(const std::string& workspace,
+    const std::string& array_name, const VidMapper& vid_mapper) {
+    auto generation = 0ull;
+    {
+        std::unique_lock<std::mutex> lock(m_mutex);
+        auto& pool = m_session_pools[workspace+'/'+array_name];
+        pool.m_session_available.wait(lock, [&pool, this]() {
+            return !pool.m_idle_sessions.empty() || pool.m_num_sessions < m_max_sessions_per_array; });
+        if(!pool.m_idle_sessions.empty()) {
+            auto session = std::move(pool.m_idle_sessions.back());
+            pool.m_idle_sessions.pop_back();
+            return session;
+        }
+        //Reserve a slot, the session is created outside the lock
+        ++pool.m_num_sessions;
+        generation = pool.m_generation;
+    }
+    try {
+        std::unique_ptr<Session> session(new Session());
+        session->m_generation = generation;
+        std::lock_guard<std::mutex> creation_lock(g_session_creation_mutex);
+        session->m_storage_manager.reset(new VariantStorageManager(workspace, m_segment_size));
+        session->m_query_processor.reset(new VariantQueryProcessor(session->m_storage_manager.get(), array_name, vid_mapper));
+        return session;
+    }
+    catch(...) {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& pool = m_session_pools[workspace+'/'+array_name];
+        --pool.m_num_sessions;
+        pool.m_session_available.notify_one();
+        throw;
+    }
+}
+
+void VariantQueryService::release_session(const std::string& workspace, const std::string& array_name,
+    std::unique_ptr<Session> session) {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto& pool = m_session_pools[workspace+'/'+array_name];
+        //Sessions checked out before close_idle_sessions() must not be re-used either
+        if(session->m_generation == pool.m_generation) {
+            pool.m_idle_sessions.push_back(std::move(session));
+            pool.m_session_available.notify_one();
+            return;
+        }
+        --pool.m_num_sessions;
+        pool.m_session_available.notify_one();
+    }
+    //Query processor before storage manager
+    session->m_query_processor.reset();
+}
+
+void VariantQueryService::close_idle_sessions(const std::string& workspace) {
+    std::vector<std::unique_ptr<Session>> closed_sessions;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        auto prefix = workspace+'/';
+        for(auto& key_pool_pair : m_session_pools) {
+            if(key_pool_pair.first.compare(0u, prefix.length(), prefix) != 0)
+                continue;
+            auto& pool = key_pool_pair.second;
+            ++pool.m_generation;
+            pool.m_num_sessions -= pool.m_idle_sessions.size();
+            for(auto& session : pool.m_idle_sessions)
+                closed_sessions.push_back(std::move(session));
+            pool.m_idle_sessions.clear();
+            pool.m_session_available.notify_all();
+        }
+    }
+    //Query processor before storage manager
+    for(auto& session : closed_sessions)
+        session->m_query_processor.reset();
+}
+
+void VariantQueryService::query_column(const std::string& workspace, const std::string& array_name,
+    const uint64_t query_interval_idx, Variant& variant, VariantQueryConfig& query_config,
+    const VidMapper& vid_mapper) {
+    admit_request();
+    std::unique_ptr<Session> session;
+    try {
+        session = acquire_session(workspace, array_name, vid_mapper);
+        auto* qp = session->m_query_processor.get();
+        if(!query_config.is_bookkeeping_done()) {
+            qp->do_query_bookkeeping(qp->get_array_schema(), query_config, vid_mapper, false);
+            variant = std::move(Variant(&query_config));
+            variant.resize_based_on_query();
+        }
+        qp->gt_get_column(qp->get_array_descriptor(), query_config, query_interval_idx, variant);
+    }
+    catch(...) {
+        if(session)
+            release_session(workspace, array_name, std::move(session));
+        finish_request();
+        throw;
+    }
+    release_session(workspace, array_name, std::move(session));
+    finish_request();
+}
+
+void VariantQueryService::query_column_range(const std::string& workspace, const std::string& array_name,
+    const uint64_t query_interval_idx, std::vector<Variant>& variants, VariantQueryConfig& query_config,
+    const VidMapper& vid_mapper, GA4GHPagingInfo* paging_info) {
+    admit_request();
+    std::unique_ptr<Session> session;
+    try {
+        session = acquire_session(workspace, array_name, vid_mapper);
+        auto* qp = session->m_query_processor.get();
+        if(!query_config.is_bookkeeping_done())
+            qp->do_query_bookkeeping(qp->get_array_schema(), query_config, vid_mapper, true);
+        //Sessions return to the pool after every page - pages are produced from the token
+        qp->gt_get_column_interval(qp->get_array_descriptor(), query_config, query_interval_idx, variants, paging_info);
+    }
+    catch(...) {
+        if(session)
+            release_session(workspace, array_name, std::move(session));
+        finish_request();
+        throw;
+    }
+    release_session(workspace, array_name, std::move(session));
+    finish_request();
+}
+
+std::future<VariantQueryResult> VariantQueryService::submit_query(const std::string& workspace,
+    const std::string& array_name, const VariantQueryConfig& query_config, const VidMapper& vid_mapper) {
+    admit_request();
+    auto config_ptr = std::make_shared<VariantQueryConfig>(query_config);
+    auto task = std::make_shared<std::packaged_task<VariantQueryResult()>>(
+        [this, workspace, array_name, config_ptr, &vid_mapper]() {
+            VariantQueryResult result;
+            result.m_query_config = config_ptr;
+            std::unique_ptr<Session> session;
+            try {
+                session = acquire_session(workspace, array_name, vid_mapper);
+                auto* qp = session->m_query_processor.get();
+                if(!config_ptr->is_bookkeeping_done())
+                    qp->do_query_bookkeeping(qp->get_array_schema(), *config_ptr, vid_mapper, true);
+                for(auto i=0u;i<config_ptr->get_num_column_intervals();++i)
+                    qp->gt_get_column_interval(qp->get_array_descriptor(), *config_ptr, i, result.m_variants);
+            }
+            catch(...) {
+                if(session)
+                    release_session(workspace, array_name, std::move(session));
+                finish_request();
+                throw;
+            }
+            release_session(workspace, array_name, std::move(session));
+            finish_request();
+            return result;
+        });
+    auto result_future = task->get_future();
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_tasks.emplace_back([task]() { (*task)(); });
+    }
+    m_task_available.notify_one();
+    return result_future;
+}
+
+void VariantQueryService::worker_loop() {
+    while(true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(m_mutex);
+            m_task_available.wait(lock, [this]() { return m_stop_workers || !m_tasks.empty(); });
+            //Pending requests are completed before the workers exit
+            if(m_tasks.empty())
+                return;
+            task = std::move(m_tasks.front());
+            m_tasks.pop_front();
+        }
+        //Exceptions are stored in the future by packaged_task
+        task();
+    }
+}
+
+unsigned VariantQueryService::get_num_pending_requests() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_pending_requests;
+}
+
+uint64_t VariantQueryService::get_num_rejected_requests() const {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_num_rejected_requests;
+}
@@ -1,18 +1,21 @@
 #include "memory_measure.h"
 
-void read_off_memory_status(statm_t& result, const size_t page_size)
+static bool read_off_memory_status(statm_t& result, const char* statm_path, const size_t page_size,
+    const bool abort_on_error)
 {
-  unsigned long dummy;
-  const char* statm_path = "/proc/self/statm";
-
   FILE *f = fopen(statm_path,"r");
   if(!f){
+    if(!abort_on_error)
+      return false;
     perror(statm_path);
     abort();
   }
   if(7 != fscanf(f,"%ld %ld %ld %ld %ld %ld %ld",
         &result.size,&result.resident,&result.share,&result.text,&result.lib,&result.data,&result.dt))
   {
+    fclose(f);
+    if(!abort_on_error)
+      return false;
     perror(statm_path);
     abort();
   }
@@ -24,4 +27,17 @@ void read_off_memory_status(statm_t& result, const size_t page_size)
   result.data *= page_size;
   result.dt *= page_size;
   fclose(f);
+  return true;
+}
+
+void read_off_memory_status(statm_t& result, const size_t page_size)
+{
+  read_off_memory_status(result, "/proc/self/statm", page_size, true);
+}
+
+bool read_off_process_memory_status(statm_t& result, const pid_t pid, const size_t page_size)
+{
+  char statm_path[64];
+  snprintf(statm_path, sizeof(statm_path), "/proc/%d/statm", static_cast<int>(pid));
+  return read_off_memory_status(result, statm_path, page_size, false);
 }
@@ -33,10 +33,9 @@ GenomicsDBBCFGenerator::GenomicsDBBCFGenerator(const std::string& loader_config_
   : m_buffer_control(GenomicsDBBCFGenerator_NUM_ENTRIES_IN_CIRCULAR_BUFFER),
   m_vcf_adapter(buffer_capacity, false, keep_idx_fields_in_bcf_header),
   m_produce_header_only(produce_header_only)
-#ifdef DO_PROFILING
-    , m_timer()
-#endif
 {
+  //The profiler may be enabled by the JSON configs parsed below, so always read the tick counter here
+  auto constructor_begin_ticks = GenomicsDBProfiler::get_ticks();
   m_done = false;
   //Buffer sizing
   m_buffers.resize(GenomicsDBBCFGenerator_NUM_ENTRIES_IN_CIRCULAR_BUFFER, RWBuffer(buffer_capacity+32768u)); //pad buffer to minimize reallocations
@@ -50,18 +49,17 @@ GenomicsDBBCFGenerator::GenomicsDBBCFGenerator(const std::string& loader_config_
   //Parse query JSON file
   JSONVCFAdapterQueryConfig bcf_scan_config;
   bcf_scan_config.read_from_file(query_config_file, m_query_config, m_vcf_adapter, &m_vid_mapper, output_format, my_rank, buffer_capacity);
+  VariantQueryProcessor::apply_process_wide_settings(static_cast<JSONBasicQueryConfig&>(bcf_scan_config), my_rank);
+  VariantQueryProcessor::initialize_auto_query_column_ranges(static_cast<JSONBasicQueryConfig&>(bcf_scan_config),
+      m_query_config, m_vid_mapper, my_rank);
   //Specified chromosome and start end
   if(chr && strlen(chr) > 0u)
   {
-    ContigInfo contig_info;
-    auto found_contig = m_vid_mapper.get_contig_info(chr, contig_info);
-    if(!found_contig)
-      throw GenomicsDBJNIException(std::string("Could not find TileDB column interval for contig: ")+chr);
-    int64_t column_begin = contig_info.m_tiledb_column_offset + static_cast<int64_t>(start) - 1; //since VCF positions are 1 based
-    int64_t column_end = contig_info.m_tiledb_column_offset + static_cast<int64_t>(end) - 1; //since VCF positions are 1 based
-    m_query_config.set_column_interval_to_query(column_begin, column_end);
+    m_query_config.clear_column_intervals_to_query();
+    add_query_interval(chr, start, end);
   }
   m_storage_manager = new VariantStorageManager(static_cast<JSONBasicQueryConfig&>(bcf_scan_config).get_workspace(my_rank), tiledb_segment_size);
+  m_storage_manager->set_iterator_memory_budget(static_cast<JSONBasicQueryConfig&>(bcf_scan_config).get_iterator_memory_budget());
   m_query_processor = new VariantQueryProcessor(m_storage_manager,
       static_cast<JSONBasicQueryConfig&>(bcf_scan_config).get_array_name(my_rank),
       m_vid_mapper);
@@ -78,9 +76,8 @@ GenomicsDBBCFGenerator::GenomicsDBBCFGenerator(const std::string& loader_config_
     m_query_processor->scan_and_operate(m_query_processor->get_array_descriptor(), m_query_config, *m_combined_bcf_operator, m_query_column_interval_idx,
         true, &m_scan_state);
   }
-#ifdef DO_PROFILING
-  m_timer.stop();
-#endif
+  if(GenomicsDBProfiler::is_enabled())
+    GenomicsDBProfiler::record_span(PROFILER_SPAN_BCF_GENERATOR, constructor_begin_ticks, GenomicsDBProfiler::get_ticks());
 }
 
 GenomicsDBBCFGenerator::~GenomicsDBBCFGenerator()
@@ -95,9 +92,53 @@ GenomicsDBBCFGenerator::~GenomicsDBBCFGenerator()
   if(m_storage_manager)
     delete m_storage_manager;
   m_storage_manager = 0;
-#ifdef DO_PROFILING
-  m_timer.print("GenomicsDBBCFGenerator", std::cerr);
-#endif
+}
+
+void GenomicsDBBCFGenerator::add_query_interval(const char* chr, const int start, const int end)
+{
+  ContigInfo contig_info;
+  auto found_contig = m_vid_mapper.get_contig_info(chr, contig_info);
+  if(!found_contig)
+    throw GenomicsDBJNIException(std::string("Could not find TileDB column interval for contig: ")+chr);
+  int64_t column_begin = contig_info.m_tiledb_column_offset + static_cast<int64_t>(start) - 1; //since VCF positions are 1 based
+  int64_t column_end = contig_info.m_tiledb_column_offset + static_cast<int64_t>(end) - 1; //since VCF positions are 1 based
+  m_query_config.add_column_interval_to_query(column_begin, column_end);
+}
+
+void GenomicsDBBCFGenerator::reset_query_intervals(const std::vector<std::string>& contigs,
+    const std::vector<int>& starts, const std::vector<int>& ends)
+{
+  if(contigs.size() != starts.size() || contigs.size() != ends.size())
+    throw GenomicsDBJNIException("Lengths of contig, start and end vectors do not match");
+  m_query_config.clear_column_intervals_to_query();
+  for(auto i=0ull;i<contigs.size();++i)
+    add_query_interval(contigs[i].c_str(), starts[i], ends[i]);
+  std::vector<ColumnRange> column_intervals(m_query_config.get_num_column_intervals());
+  for(auto i=0u;i<column_intervals.size();++i)
+    column_intervals[i] = m_query_config.get_column_interval(i);
+  reset_query_column_intervals(column_intervals);
+}
+
+void GenomicsDBBCFGenerator::reset_query_column_intervals(const std::vector<ColumnRange>& column_intervals)
+{
+  ProfilerSpan span(PROFILER_SPAN_BCF_GENERATOR);
+  m_query_config.clear_column_intervals_to_query();
+  for(const auto& interval : column_intervals)
+    m_query_config.add_column_interval_to_query(interval.first, interval.second);
+  //Drop the iterator and pending calls of the previous query (if it was not fully consumed)
+  m_scan_state.discard();
+  m_combined_bcf_operator->reset_contig_tracking();
+  //Drop unread data
+  while(m_buffer_control.get_num_entries_with_valid_data() > 0u)
+    reset_read_buffer();
+  m_produce_header_only = false;
+  m_done = false;
+  m_query_column_interval_idx = 0u;
+  //Header followed by the first batch of records, same as the constructor
+  set_write_buffer();
+  m_vcf_adapter.print_header();
+  m_query_processor->scan_and_operate(m_query_processor->get_array_descriptor(), m_query_config, *m_combined_bcf_operator, m_query_column_interval_idx,
+      true, &m_scan_state);
 }
 
 void GenomicsDBBCFGenerator::produce_next_batch()
@@ -129,9 +170,7 @@ void GenomicsDBBCFGenerator::produce_next_batch()
 
 size_t GenomicsDBBCFGenerator::read_and_advance(uint8_t* dst, size_t offset, size_t n)
 {
-#ifdef DO_PROFILING
-  m_timer.start();
-#endif
+  ProfilerSpan span(PROFILER_SPAN_BCF_GENERATOR);
   auto total_bytes_advanced = 0ull;
   if(n == SIZE_MAX)
     produce_next_batch();
@@ -150,9 +189,6 @@ size_t GenomicsDBBCFGenerator::read_and_advance(uint8_t* dst, size_t offset, siz
       if(curr_buffer.m_next_read_idx >= curr_buffer.m_num_valid_bytes)
         produce_next_batch();
     }
-#ifdef DO_PROFILING
-  m_timer.stop();
-#endif
   return total_bytes_advanced;
 }
 
@@ -0,0 +1,365 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#ifdef HTSDIR
+
+#include "packed_reference.h"
+#include "htslib/hts.h"
+#include "htslib/faidx.h"
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw PackedReferenceException(#X);
+
+static const char g_2bit_bases[] = "ACGT";
+
+static inline int get_2bit_code(const char base)
+{
+  switch(base)
+  {
+    case 'A': case 'a': return 0;
+    case 'C': case 'c': return 1;
+    case 'G': case 'g': return 2;
+    case 'T': case 't': return 3;
+    default: return -1;
+  }
+}
+
+static inline uint64_t align_to_8_bytes(const uint64_t offset)
+{
+  return (offset+7ull) & ~(7ull);
+}
+
+template<class T>
+static inline T read_from_mapped_buffer(const uint8_t* ptr, uint64_t& offset, const size_t size)
+{
+  VERIFY_OR_THROW(offset+sizeof(T) <= size && "Truncated packed reference file");
+  T val;
+  memcpy(&val, ptr+offset, sizeof(T));
+  offset += sizeof(T);
+  return val;
+}
+
+PackedReferenceGenome::PackedReferenceGenome()
+{
+  m_last_contig = 0;
+  m_mapped_ptr = 0;
+  m_mapped_size = 0u;
+  m_version = 0u;
+  m_fasta_info.m_size = m_fai_info.m_size = 0u;
+  m_fasta_info.m_mtime = m_fai_info.m_mtime = 0;
+}
+
+bool PackedReferenceGenome::get_source_file_info(const std::string& filename, SourceFileInfo& info)
+{
+  struct stat stat_buffer;
+  if(stat(filename.c_str(), &stat_buffer) != 0)
+    return false;
+  info.m_size = stat_buffer.st_size;
+  info.m_mtime = stat_buffer.st_mtime;
+  return true;
+}
+
+bool PackedReferenceGenome::is_packed_reference_file(const std::string& filename)
+{
+  std::ifstream fptr(filename.c_str(), std::ios::in | std::ios::binary);
+  if(!fptr.is_open())
+    return false;
+  char magic[8];
+  fptr.read(magic, sizeof(magic));
+  return (fptr.gcount() == sizeof(magic) && memcmp(magic, PACKED_REFERENCE_MAGIC, sizeof(magic)) == 0);
+}
+
+bool PackedReferenceGenome::open(const std::string& filename)
+{
+  close();
+  if(!is_packed_reference_file(filename))
+    return false;
+  auto fd = ::open(filename.c_str(), O_RDONLY);
+  if(fd < 0)
+    return false;
+  struct stat stat_buffer;
+  if(fstat(fd, &stat_buffer) != 0)
+  {
+    ::close(fd);
+    return false;
+  }
+  m_mapped_size = stat_buffer.st_size;
+  auto ptr = mmap(0, m_mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+  //Mapping remains valid after the descriptor is closed
+  ::close(fd);
+  if(ptr == MAP_FAILED)
+  {
+    m_mapped_size = 0u;
+    return false;
+  }
+  m_mapped_ptr = reinterpret_cast<const uint8_t*>(ptr);
+  try
+  {
+    parse_header(filename);
+  }
+  catch(...)
+  {
+    //Unusable file is not left open
+    close();
+    throw;
+  }
+  return true;
+}
+
+void PackedReferenceGenome::parse_header(const std::string& filename)
+{
+  //Parse contig table
+  uint64_t offset = 8u;
+  auto version = read_from_mapped_buffer<uint32_t>(m_mapped_ptr, offset, m_mapped_size);
+  if(version == 0u || version > PACKED_REFERENCE_VERSION)
+    throw PackedReferenceException(std::string("Unsupported packed reference version ")+std::to_string(version)
+        +" in file "+filename);
+  m_version = version;
+  auto num_contigs = read_from_mapped_buffer<uint32_t>(m_mapped_ptr, offset, m_mapped_size);
+  if(version >= 2u)
+  {
+    m_fasta_info.m_size = read_from_mapped_buffer<uint64_t>(m_mapped_ptr, offset, m_mapped_size);
+    m_fasta_info.m_mtime = read_from_mapped_buffer<int64_t>(m_mapped_ptr, offset, m_mapped_size);
+    m_fai_info.m_size = read_from_mapped_buffer<uint64_t>(m_mapped_ptr, offset, m_mapped_size);
+    m_fai_info.m_mtime = read_from_mapped_buffer<int64_t>(m_mapped_ptr, offset, m_mapped_size);
+  }
+  m_contigs.resize(num_contigs);
+  for(auto i=0u;i<num_contigs;++i)
+  {
+    auto name_length = read_from_mapped_buffer<uint32_t>(m_mapped_ptr, offset, m_mapped_size);
+    VERIFY_OR_THROW(offset+name_length <= m_mapped_size && "Truncated packed reference file");
+    std::string name(reinterpret_cast<const char*>(m_mapped_ptr+offset), name_length);
+    offset += name_length;
+    auto& contig_info = m_contigs[i];
+    contig_info.m_length = read_from_mapped_buffer<uint64_t>(m_mapped_ptr, offset, m_mapped_size);
+    contig_info.m_data_offset = read_from_mapped_buffer<uint64_t>(m_mapped_ptr, offset, m_mapped_size);
+    contig_info.m_mask_offset = read_from_mapped_buffer<uint64_t>(m_mapped_ptr, offset, m_mapped_size);
+    contig_info.m_bits_per_base = read_from_mapped_buffer<uint32_t>(m_mapped_ptr, offset, m_mapped_size);
+    VERIFY_OR_THROW((contig_info.m_bits_per_base == 2u || contig_info.m_bits_per_base == 4u)
+        && "Invalid #bits per base in packed reference file");
+    VERIFY_OR_THROW(contig_info.m_data_offset + (contig_info.m_length*contig_info.m_bits_per_base+7u)/8u <= m_mapped_size
+        && "Truncated packed reference file");
+    VERIFY_OR_THROW((contig_info.m_mask_offset == 0u || contig_info.m_mask_offset + (contig_info.m_length+7u)/8u <= m_mapped_size)
+        && "Truncated packed reference file");
+    m_contig_name_to_idx[name] = i;
+  }
+}
+
+bool PackedReferenceGenome::matches_source(const std::string& fasta_filename, std::string& mismatch_reason) const
+{
+  assert(m_mapped_ptr);
+  if(m_version < 2u)
+  {
+    mismatch_reason = "packed file version "+std::to_string(m_version)+" does not record its source files";
+    return false;
+  }
+  SourceFileInfo fasta_info, fai_info;
+  if(!get_source_file_info(fasta_filename, fasta_info) || !get_source_file_info(fasta_filename+".fai", fai_info))
+  {
+    mismatch_reason = "FASTA file or its .fai index does not exist";
+    return false;
+  }
+  if(fasta_info.m_size != m_fasta_info.m_size || fasta_info.m_mtime != m_fasta_info.m_mtime
+      || fai_info.m_size != m_fai_info.m_size || fai_info.m_mtime != m_fai_info.m_mtime)
+  {
+    mismatch_reason = "FASTA file or its .fai index was modified after the packed file was created";
+    return false;
+  }
+  //Contig lengths from the .fai index - cheap, sequences are not read
+  auto* faidx = fai_load(fasta_filename.c_str());
+  if(faidx == 0)
+  {
+    mismatch_reason = "could not load the FASTA index";
+    return false;
+  }
+  auto num_contigs = faidx_nseq(faidx);
+  auto match = (static_cast<size_t>(num_contigs) == m_contigs.size());
+  for(auto i=0;match && i<num_contigs;++i)
+  {
+    auto* contig_name = faidx_iseq(faidx, i);
+    auto iter = m_contig_name_to_idx.find(contig_name);
+    match = (iter != m_contig_name_to_idx.end()
+        && m_contigs[(*iter).second].m_length == static_cast<uint64_t>(faidx_seq_len(faidx, contig_name)));
+  }
+  fai_destroy(faidx);
+  if(!match)
+    mismatch_reason = "contig names or lengths differ from the FASTA index";
+  return match;
+}
+
+void PackedReferenceGenome::close()
+{
+  if(m_mapped_ptr)
+    munmap(const_cast<uint8_t*>(m_mapped_ptr), m_mapped_size);
+  m_mapped_ptr = 0;
+  m_mapped_size = 0u;
+  m_contigs.clear();
+  m_contig_name_to_idx.clear();
+  m_last_contig_name.clear();
+  m_last_contig = 0;
+  m_version = 0u;
+}
+
+char PackedReferenceGenome::get_reference_base_at_position(const char* contig, int pos)
+{
+  assert(m_mapped_ptr);
+  if(m_last_contig == 0 || strcmp(m_last_contig_name.c_str(), contig) != 0)
+  {
+    auto iter = m_contig_name_to_idx.find(contig);
+    if(iter == m_contig_name_to_idx.end())
+      throw PackedReferenceException(std::string("Unknown contig ")+contig+" in packed reference");
+    m_last_contig = &(m_contigs[(*iter).second]);
+    m_last_contig_name = contig;
+  }
+  const auto& contig_info = *m_last_contig;
+  if(pos < 0 || static_cast<uint64_t>(pos) >= contig_info.m_length)
+    return 'N';
+  char base = 0;
+  if(contig_info.m_bits_per_base == 2u)
+  {
+    auto byte = m_mapped_ptr[contig_info.m_data_offset + (pos >> 2)];
+    base = g_2bit_bases[(byte >> ((pos & 3) << 1)) & 3];
+  }
+  else
+  {
+    auto byte = m_mapped_ptr[contig_info.m_data_offset + (pos >> 1)];
+    base = seq_nt16_str[(byte >> ((pos & 1) << 2)) & 15];
+  }
+  //Soft masked
+  if(contig_info.m_mask_offset && (m_mapped_ptr[contig_info.m_mask_offset + (pos >> 3)] & (1u << (pos & 7))))
+    base = tolower(base);
+  return base;
+}
+
+void PackedReferenceGenome::create(const std::string& fasta_filename, const std::string& output_filename)
+{
+  auto* faidx = fai_load(fasta_filename.c_str());
+  if(faidx == 0)
+    throw PackedReferenceException(std::string("Could not load FASTA index for ")+fasta_filename);
+  std::ofstream fptr(output_filename.c_str(), std::ios::out | std::ios::binary | std::ios::trunc);
+  if(!fptr.is_open())
+  {
+    fai_destroy(faidx);
+    throw PackedReferenceException(std::string("Could not open output file ")+output_filename);
+  }
+  //fai_load() creates the index if it does not exist - so source file info is obtained after the load
+  SourceFileInfo fasta_info, fai_info;
+  if(!get_source_file_info(fasta_filename, fasta_info) || !get_source_file_info(fasta_filename+".fai", fai_info))
+  {
+    fai_destroy(faidx);
+    throw PackedReferenceException(std::string("Could not stat FASTA file or its .fai index for ")+fasta_filename);
+  }
+  auto num_contigs = faidx_nseq(faidx);
+  //Header size is known upfront - contig info is re-written after data offsets are determined
+  uint64_t header_size = 8u + 2u*sizeof(uint32_t) + 4u*sizeof(uint64_t);
+  for(auto i=0;i<num_contigs;++i)
+    header_size += sizeof(uint32_t) + strlen(faidx_iseq(faidx, i)) + 3u*sizeof(uint64_t) + sizeof(uint32_t);
+  std::vector<PackedContigInfo> contigs(num_contigs);
+  std::vector<uint8_t> buffer;
+  std::vector<uint8_t> mask;
+  uint64_t curr_offset = align_to_8_bytes(header_size);
+  fptr.seekp(curr_offset);
+  for(auto i=0;i<num_contigs;++i)
+  {
+    auto* contig_name = faidx_iseq(faidx, i);
+    int length = 0;
+    auto seq_length = faidx_seq_len(faidx, contig_name);
+    auto* seq = (seq_length > 0) ? faidx_fetch_seq(faidx, contig_name, 0, seq_length-1, &length) : strdup("");
+    if(seq == 0 || length < 0)
+    {
+      fai_destroy(faidx);
+      throw PackedReferenceException(std::string("Could not read contig ")+contig_name+" from "+fasta_filename);
+    }
+    auto& contig_info = contigs[i];
+    contig_info.m_length = length;
+    contig_info.m_bits_per_base = 2u;
+    auto has_lower_case = false;
+    for(auto j=0;j<length;++j)
+    {
+      if(get_2bit_code(seq[j]) < 0)
+        contig_info.m_bits_per_base = 4u;
+      has_lower_case = has_lower_case || islower(seq[j]);
+    }
+    //Data
+    buffer.assign((static_cast<uint64_t>(length)*contig_info.m_bits_per_base+7u)/8u, 0u);
+    if(contig_info.m_bits_per_base == 2u)
+      for(auto j=0;j<length;++j)
+        buffer[j >> 2] |= (get_2bit_code(seq[j]) << ((j & 3) << 1));
+    else
+      for(auto j=0;j<length;++j)
+        buffer[j >> 1] |= (seq_nt16_table[static_cast<uint8_t>(seq[j])] << ((j & 1) << 2));
+    contig_info.m_data_offset = curr_offset;
+    fptr.write(reinterpret_cast<const char*>(buffer.data()), buffer.size());
+    curr_offset += buffer.size();
+    //Soft mask
+    contig_info.m_mask_offset = 0u;
+    if(has_lower_case)
+    {
+      mask.assign((static_cast<uint64_t>(length)+7u)/8u, 0u);
+      for(auto j=0;j<length;++j)
+        if(islower(seq[j]))
+          mask[j >> 3] |= (1u << (j & 7));
+      contig_info.m_mask_offset = curr_offset;
+      fptr.write(reinterpret_cast<const char*>(mask.data()), mask.size());
+      curr_offset += mask.size();
+    }
+    free(seq);
+    //Pad to 8 bytes
+    auto aligned_offset = align_to_8_bytes(curr_offset);
+    for(;curr_offset<aligned_offset;++curr_offset)
+      fptr.put(0);
+  }
+  //Header
+  fptr.seekp(0);
+  fptr.write(PACKED_REFERENCE_MAGIC, 8u);
+  uint32_t val32 = PACKED_REFERENCE_VERSION;
+  fptr.write(reinterpret_cast<const char*>(&val32), sizeof(val32));
+  val32 = num_contigs;
+  fptr.write(reinterpret_cast<const char*>(&val32), sizeof(val32));
+  for(const auto* info : { &fasta_info, &fai_info })
+  {
+    fptr.write(reinterpret_cast<const char*>(&(info->m_size)), sizeof(uint64_t));
+    fptr.write(reinterpret_cast<const char*>(&(info->m_mtime)), sizeof(int64_t));
+  }
+  for(auto i=0;i<num_contigs;++i)
+  {
+    auto* contig_name = faidx_iseq(faidx, i);
+    val32 = strlen(contig_name);
+    fptr.write(reinterpret_cast<const char*>(&val32), sizeof(val32));
+    fptr.write(contig_name, val32);
+    const auto& contig_info = contigs[i];
+    fptr.write(reinterpret_cast<const char*>(&(contig_info.m_length)), sizeof(uint64_t));
+    fptr.write(reinterpret_cast<const char*>(&(contig_info.m_data_offset)), sizeof(uint64_t));
+    fptr.write(reinterpret_cast<const char*>(&(contig_info.m_mask_offset)), sizeof(uint64_t));
+    val32 = contig_info.m_bits_per_base;
+    fptr.write(reinterpret_cast<const char*>(&val32), sizeof(val32));
+  }
+  fai_destroy(faidx);
+  VERIFY_OR_THROW(fptr.good() && "Error while writing packed reference file");
+  fptr.close();
+}
+
+#endif //ifdef HTSDIR
@@ -72,12 +72,15 @@ void VCFBufferReader::read_and_advance()
   m_is_record_valid = false;
   if(BufferReaderBase::contains_unread_data())
   {
-    auto new_offset = bcf_deserialize(m_line, &(BufferReaderBase::m_buffer[0]), BufferReaderBase::m_offset, BufferReaderBase::m_num_valid_bytes_in_buffer,
+    auto new_offset = bcf_deserialize(m_line, get_read_buffer_pointer(), BufferReaderBase::m_offset, BufferReaderBase::m_num_valid_bytes_in_buffer,
         m_is_bcf ? 1 : 0, m_hdr);
     //Parsed or made progress
     assert(new_offset > BufferReaderBase::m_offset);
     BufferReaderBase::m_offset = new_offset;
     m_is_record_valid = true;
+    //m_line holds its own copy of the record - caller owned memory is no longer needed once fully consumed
+    if(!BufferReaderBase::contains_unread_data())
+      release_external_buffer();
   }
 }
 
@@ -28,6 +28,30 @@
 //ReferenceGenomeInfo functions
 void ReferenceGenomeInfo::initialize(const std::string& reference_genome)
 {
+  //Packed file specified explicitly
+  if(m_packed_reference.open(reference_genome))
+    return;
+  //Packed file next to the FASTA is used only if it was created from the current FASTA file
+  //An unreadable packed file (e.g. written by a newer version) falls back to the FASTA file
+  std::string mismatch_reason;
+  auto is_packed_file_open = false;
+  try
+  {
+    is_packed_file_open = m_packed_reference.open(reference_genome+PACKED_REFERENCE_DEFAULT_SUFFIX);
+  }
+  catch(const PackedReferenceException& e)
+  {
+    mismatch_reason = e.what();
+  }
+  if(is_packed_file_open)
+  {
+    if(m_packed_reference.matches_source(reference_genome, mismatch_reason))
+      return;
+    m_packed_reference.close();
+  }
+  if(!mismatch_reason.empty())
+    std::cerr << "WARNING: ignoring packed reference " << reference_genome << PACKED_REFERENCE_DEFAULT_SUFFIX
+      << " - " << mismatch_reason << ". Re-create it with create_packed_reference\n";
   m_reference_faidx = fai_load(reference_genome.c_str());
   assert(m_reference_faidx);
   m_reference_last_seq_read = "";
@@ -37,6 +61,8 @@ void ReferenceGenomeInfo::initialize(const std::string& reference_genome)
 
 char ReferenceGenomeInfo::get_reference_base_at_position(const char* contig, int pos)
 {
+  if(m_packed_reference.is_open())
+    return m_packed_reference.get_reference_base_at_position(contig, pos);
   //See if pos is within the last buffer read
   if(strcmp(m_reference_last_seq_read.c_str(), contig) == 0 && m_reference_last_read_pos <= pos)
   {
@@ -210,9 +236,6 @@ VCFAdapter::~VCFAdapter()
   if(m_open_output && m_output_fptr)
     bcf_close(m_output_fptr);
   m_output_fptr = 0;
-#ifdef DO_PROFILING
-  m_vcf_serialization_timer.print("bcf_t serialization", std::cerr);
-#endif
 }
 
 void VCFAdapter::clear()
@@ -379,9 +402,7 @@ void VCFSerializedBufferAdapter::print_header()
 
 void VCFSerializedBufferAdapter::handoff_output_bcf_line(bcf1_t*& line, const size_t bcf_record_size)
 {
-#ifdef DO_PROFILING
-  m_vcf_serialization_timer.start();
-#endif
+  ProfilerSpan span(PROFILER_SPAN_BCF_T_SERIALIZATION);
   assert(m_rw_buffer);
   auto offset = bcf_serialize(line, &(m_rw_buffer->m_buffer[0]), m_rw_buffer->m_num_valid_bytes, m_rw_buffer->m_buffer.size(),
        m_is_bcf ? 1u : 0u, m_template_vcf_hdr, &m_hts_string);
@@ -392,10 +413,8 @@ void VCFSerializedBufferAdapter::handoff_output_bcf_line(bcf1_t*& line, const si
     offset = bcf_serialize(line, &(m_rw_buffer->m_buffer[0]), m_rw_buffer->m_num_valid_bytes, m_rw_buffer->m_buffer.size(),
        m_is_bcf ? 1u : 0u, m_template_vcf_hdr, &m_hts_string);
   }
+  GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_BCF_SERIALIZED_BYTES, offset - m_rw_buffer->m_num_valid_bytes);
   m_rw_buffer->m_num_valid_bytes = offset;
-#ifdef DO_PROFILING
-  m_vcf_serialization_timer.stop();
-#endif
 }
 
 #endif //ifdef HTSDIR
@@ -0,0 +1,129 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+package com.intel.genomicsdb;
+
+import java.io.Closeable;
+import java.io.IOException;
+
+/**
+ * Runs a GenomicsDB query and returns the variant calls as columnar record batches
+ * through the <a href="https://arrow.apache.org/docs/format/CDataInterface.html">Arrow C data interface</a>.
+ * Each batch is a struct array with one child per column: row, column, END (int64)
+ * followed by the queried fields. Buffers are handed off without copies or parsing.
+ * The caller allocates the ArrowArray/ArrowSchema structs, for example with
+ * org.apache.arrow.c.ArrowArray.allocateNew(allocator), and passes their memory addresses.
+ * Ownership of exported batches moves to the caller - Arrow's importers release them
+ */
+public class GenomicsDBColumnarReader implements Closeable
+{
+    static
+    {
+        try
+        {
+            boolean loaded = GenomicsDBUtils.loadLibrary();
+            if(!loaded)
+                throw new GenomicsDBException("Could not load genomicsdb native library");
+        }
+        catch(UnsatisfiedLinkError ule)
+        {
+            throw new GenomicsDBException("Could not load genomicsdb native library");
+        }
+    }
+
+    private native long jniColumnarQueryInit(String loaderJSONFile, String queryJSONFile,
+            int rank, long maxNumRowsPerBatch, long segmentSize);
+
+    private native long jniColumnarQueryClose(long handle);
+
+    private native boolean jniColumnarQueryExportNextBatch(long handle, long arrowArrayAddress,
+            long arrowSchemaAddress);
+
+    private native void jniColumnarQueryExportSchema(long handle, long arrowSchemaAddress);
+
+    //"Pointer" to native query object
+    private long mColumnarQueryHandle = 0;
+
+    /**
+     * Constructor - batches are produced on demand by exportNextBatch()
+     * @param loaderJSONFile GenomicsDB loader JSON configuration file
+     * @param queryJSONFile GenomicsDB query JSON configuration file
+     */
+    public GenomicsDBColumnarReader(final String loaderJSONFile, final String queryJSONFile)
+    {
+        this(loaderJSONFile, queryJSONFile, 0, 1048576, 10485760);
+    }
+
+    /**
+     * Constructor - batches are produced on demand by exportNextBatch()
+     * @param loaderJSONFile GenomicsDB loader JSON configuration file
+     * @param queryJSONFile GenomicsDB query JSON configuration file
+     * @param rank rank of this object if launched from within an MPI context (not used)
+     * @param maxNumRowsPerBatch maximum number of rows (variant calls) in a record batch
+     * @param segmentSize buffer to be used for querying TileDB
+     */
+    public GenomicsDBColumnarReader(final String loaderJSONFile, final String queryJSONFile,
+            final int rank, final long maxNumRowsPerBatch, final long segmentSize)
+    {
+        mColumnarQueryHandle = jniColumnarQueryInit(loaderJSONFile, queryJSONFile, rank,
+          maxNumRowsPerBatch, segmentSize);
+    }
+
+    /**
+     * Scans the array till the next record batch is filled and moves it into the caller
+     * allocated C structs
+     * @param arrowArrayAddress memory address of an ArrowArray struct
+     * @param arrowSchemaAddress memory address of an ArrowSchema struct, 0 if the schema is not needed
+     * @return false if all batches have been exported
+     * @throws IOException if the reader is closed
+     */
+    public boolean exportNextBatch(final long arrowArrayAddress, final long arrowSchemaAddress)
+      throws IOException
+    {
+        if(mColumnarQueryHandle == 0)
+            throw new IOException("GenomicsDBColumnarReader is closed");
+        return jniColumnarQueryExportNextBatch(mColumnarQueryHandle, arrowArrayAddress,
+          arrowSchemaAddress);
+    }
+
+    /**
+     * Describes the record batches in the caller allocated ArrowSchema struct
+     * @param arrowSchemaAddress memory address of an ArrowSchema struct
+     * @throws IOException if the reader is closed
+     */
+    public void exportSchema(final long arrowSchemaAddress) throws IOException
+    {
+        if(mColumnarQueryHandle == 0)
+            throw new IOException("GenomicsDBColumnarReader is closed");
+        jniColumnarQueryExportSchema(mColumnarQueryHandle, arrowSchemaAddress);
+    }
+
+    /**
+     * Frees the native query object and batches which have not been exported.
+     * Exported batches remain valid until released by their consumer
+     */
+    @Override
+    public void close()
+    {
+        mColumnarQueryHandle = jniColumnarQueryClose(mColumnarQueryHandle);
+    }
+}
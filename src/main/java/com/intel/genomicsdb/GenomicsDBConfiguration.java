@@ -46,6 +46,7 @@ public class GenomicsDBConfiguration extends Configuration implements Serializab
   public static final String QUERYJSON = "genomicsdb.input.queryjsonfile";
   public static final String MPIHOSTFILE = "genomicsdb.input.mpi.hostfile";
   public static final String PARTITION_STRATEGY = "genomicsdb.partition.strategy";
+  public static final String NUM_SPLITS = "genomicsdb.input.splits.num";
 
   private Boolean produceCombinedVCF = false;
   private Boolean produceTileDBArray = false;
@@ -105,6 +106,19 @@ public class GenomicsDBConfiguration extends Configuration implements Serializab
     return this;
   }
 
+  /**
+   * Number of input splits to produce. Splits are aligned to the density
+   * of cells in the array so that each split has roughly the same amount
+   * of work. Defaults to the number of hosts
+   *
+   * @param numSplits  Number of splits
+   * @return  GenomicsDBConfiguration object
+   */
+  public GenomicsDBConfiguration setNumSplits(int numSplits) {
+    setInt(NUM_SPLITS, numSplits);
+    return this;
+  }
+
   List<String> getHosts() {
     return hosts;
   }
@@ -34,7 +34,9 @@ import htsjdk.variant.bcf2.BCF2Codec;
 
 import java.io.File;
 import java.io.FileWriter;
+import java.io.FilterInputStream;
 import java.io.IOException;
+import java.io.InputStream;
 import java.util.ArrayList;
 import java.util.List;
 
@@ -51,6 +53,8 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
     protected FeatureCodecHeader mFCHeader;
     private VCFHeader mVCFHeader = null;
     private ArrayList<String> mSequenceNames;
+    //Native query state re-used across queries - see GenomicsDBQueryStream.requery()
+    private GenomicsDBQueryStream mSessionStream = null;
 
     /**
      * Constructor
@@ -193,16 +197,42 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
         mLoaderJSONFile = loaderJSONFile;
         mQueryJSONFile = queryJSONFile;
         //Read header
-        GenomicsDBQueryStream gdbStream = new GenomicsDBQueryStream(loaderJSONFile, queryJSONFile,
+        //The header only stream is kept open as the session for subsequent queries
+        mSessionStream = new GenomicsDBQueryStream(loaderJSONFile, queryJSONFile,
                 mCodec instanceof BCF2Codec, true);
-        SOURCE source = codec.makeSourceFromStream(gdbStream);
+        SOURCE source = codec.makeSourceFromStream(mSessionStream);
         mFCHeader = codec.readHeader(source);
         //Store sequence names
         mVCFHeader = (VCFHeader)(mFCHeader.getHeaderValue());
         mSequenceNames = new ArrayList<String>(mVCFHeader.getContigLines().size());
         for(final VCFContigHeaderLine contigHeaderLine : mVCFHeader.getContigLines())
             mSequenceNames.add(contigHeaderLine.getID());
-        gdbStream.close();
+    }
+
+    /**
+     * Returns a stream over the specified intervals. If no iterator is currently using the
+     * session, the native query state of the session is re-used. Otherwise, a new stream is
+     * initialized from the JSON files
+     * @param intervals intervals to query, empty list for all positions
+     * @return stream over combined gVCF records
+     * @throws IOException when data cannot be read from the stream
+     */
+    private InputStream getQueryStream(final List<ChromosomeInterval> intervals)
+      throws IOException
+    {
+        boolean readAsBCF = mCodec instanceof BCF2Codec;
+        if(mSessionStream != null && !mSessionStream.isSessionBusy())
+            return mSessionStream.requery(intervals);
+        if(intervals.size() == 0)
+            return new GenomicsDBQueryStream(mLoaderJSONFile, mQueryJSONFile, readAsBCF);
+        if(intervals.size() == 1)
+            return new GenomicsDBQueryStream(mLoaderJSONFile, mQueryJSONFile,
+                intervals.get(0).getContig(), intervals.get(0).getStart(), intervals.get(0).getEnd(),
+                readAsBCF);
+        //Multiple intervals - header only stream followed by requery
+        GenomicsDBQueryStream session = new GenomicsDBQueryStream(mLoaderJSONFile, mQueryJSONFile,
+            readAsBCF, true);
+        return new SessionOwningQueryStream(session, session.requery(intervals));
     }
 
     /**
@@ -223,8 +253,16 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
         return mSequenceNames;
     }
 
+    /**
+     * Iterators returned by this reader that are still open keep the native session alive
+     * till they are closed
+     * @throws IOException when the session cannot be closed
+     */
     public void close() throws IOException
     {
+        if(mSessionStream != null)
+            mSessionStream.close();
+        mSessionStream = null;
     }
 
     /**
@@ -234,7 +272,7 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
      */
     public CloseableTribbleIterator<T> iterator() throws IOException
     {
-        return new GenomicsDBFeatureIterator(mLoaderJSONFile, mQueryJSONFile, mCodec);
+        return new GenomicsDBFeatureIterator(getQueryStream(new ArrayList<ChromosomeInterval>()), mCodec);
     }
 
     /**
@@ -248,8 +286,85 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
     public CloseableTribbleIterator<T> query(final String chr, final int start, final int end)
       throws IOException
     {
-        return new GenomicsDBFeatureIterator(mLoaderJSONFile, mQueryJSONFile,
-          mCodec, chr, start, end);
+        List<ChromosomeInterval> intervals = new ArrayList<ChromosomeInterval>(1);
+        intervals.add(new ChromosomeInterval(chr, start, end));
+        return query(intervals);
+    }
+
+    /**
+     * Return an iterator over {@link htsjdk.variant.variantcontext.VariantContext}
+     * objects for the specified TileDB array and queried intervals. All intervals
+     * are handled by a single native query - records are returned in the order of
+     * TileDB columns (contig order in the vid mapping)
+     * @param intervals list of intervals, positions are 1-based and inclusive
+     * @return iterator over {@link htsjdk.variant.variantcontext.VariantContext} objects
+     * @throws IOException when data cannot be read from the stream
+     */
+    public CloseableTribbleIterator<T> query(final List<ChromosomeInterval> intervals)
+      throws IOException
+    {
+        return new GenomicsDBFeatureIterator(getQueryStream(intervals), mCodec);
+    }
+
+    /**
+     * Return an iterator over {@link htsjdk.variant.variantcontext.VariantContext}
+     * objects for a range of TileDB columns - used by input splits which are computed
+     * on column ranges, see {@link GenomicsDBInputFormat}
+     * @param columnBegin begin column (inclusive)
+     * @param columnEnd end column (inclusive)
+     * @return iterator over {@link htsjdk.variant.variantcontext.VariantContext} objects
+     * @throws IOException when data cannot be read from the stream
+     */
+    public CloseableTribbleIterator<T> queryColumns(final long columnBegin, final long columnEnd)
+      throws IOException
+    {
+        return queryColumns(new long[] { columnBegin }, new long[] { columnEnd });
+    }
+
+    /**
+     * Return an iterator over {@link htsjdk.variant.variantcontext.VariantContext}
+     * objects for a set of TileDB column ranges. The ranges replace the column intervals
+     * of the query JSON
+     * @param begins begin columns (inclusive)
+     * @param ends end columns (inclusive)
+     * @return iterator over {@link htsjdk.variant.variantcontext.VariantContext} objects
+     * @throws IOException when data cannot be read from the stream
+     */
+    public CloseableTribbleIterator<T> queryColumns(final long[] begins, final long[] ends)
+      throws IOException
+    {
+        InputStream stream = null;
+        if(mSessionStream != null && !mSessionStream.isSessionBusy())
+            stream = mSessionStream.requeryColumns(begins, ends);
+        else
+        {
+            GenomicsDBQueryStream session = new GenomicsDBQueryStream(mLoaderJSONFile, mQueryJSONFile,
+                mCodec instanceof BCF2Codec, true);
+            stream = new SessionOwningQueryStream(session, session.requeryColumns(begins, ends));
+        }
+        return new GenomicsDBFeatureIterator(stream, mCodec);
+    }
+
+    /**
+     * Stream obtained from requery() on a private session - closing it closes the session too
+     */
+    private static class SessionOwningQueryStream extends FilterInputStream
+    {
+        private GenomicsDBQueryStream mSession;
+
+        SessionOwningQueryStream(final GenomicsDBQueryStream session,
+            final GenomicsDBQueryStream stream)
+        {
+            super(stream);
+            mSession = session;
+        }
+
+        @Override
+        public void close() throws IOException
+        {
+            super.close();
+            mSession.close();
+        }
     }
 
     /**
@@ -260,44 +375,24 @@ public class GenomicsDBFeatureReader<T extends Feature, SOURCE> implements Featu
     class GenomicsDBFeatureIterator implements CloseableTribbleIterator<T>
     {
         private FeatureCodec<T, SOURCE> mCodec = null;
-        private GenomicsDBQueryStream mStream = null;
+        private InputStream mStream = null;
         private SOURCE mSource = null;
         private GenomicsDBTimer mTimer = null;
         private boolean mClosedBefore = false;
 
         /**
          * Constructor
-         * @param loaderJSONFile GenomicsDB loader JSON configuration file
-         * @param queryJSONFile GenomicsDB query JSON configuration file
+         * @param stream stream over combined gVCF records, beginning with the header
          * @param codec FeatureCodec, currently only {@link htsjdk.variant.bcf2.BCF2Codec}
          *              and {@link htsjdk.variant.vcf.VCFCodec} are tested
          * @throws IOException when data cannot be read from the stream 
          */
-        public GenomicsDBFeatureIterator(final String loaderJSONFile, final String queryJSONFile,
+        public GenomicsDBFeatureIterator(final InputStream stream,
                 final FeatureCodec<T, SOURCE> codec) throws IOException
-        {
-            this(loaderJSONFile, queryJSONFile, codec, "", 0, 0);
-        }
-
-        /**
-         * Constructor
-         * @param loaderJSONFile GenomicsDB loader JSON configuration file
-         * @param queryJSONFile GenomicsDB query JSON configuration file
-         * @param codec FeatureCodec, currently only {@link htsjdk.variant.bcf2.BCF2Codec}
-         *              and {@link htsjdk.variant.vcf.VCFCodec} are tested
-         * @param chr contig name
-         * @param start start position (1-based)
-         * @param end end position, inclusive (1-based)
-         * @throws IOException when data cannot be read from the stream 
-         */
-        public GenomicsDBFeatureIterator(final String loaderJSONFile, final String queryJSONFile,
-                final FeatureCodec<T, SOURCE> codec,
-                final String chr, final int start, final int end) throws IOException
         {
             mCodec = codec;
             boolean readAsBCF = mCodec instanceof BCF2Codec;
-            mStream = new GenomicsDBQueryStream(loaderJSONFile, queryJSONFile, chr, start, end,
-                    readAsBCF);
+            mStream = stream;
             if(readAsBCF) //BCF2 codec provides size of header
                 mStream.skip(mFCHeader.getHeaderEnd());
             mSource = codec.makeSourceFromStream(mStream);
@@ -0,0 +1,189 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+package com.intel.genomicsdb;
+
+import java.io.Closeable;
+import java.io.IOException;
+
+/**
+ * Runs a GT only GenomicsDB query and returns a dense genotype matrix - one entry per
+ * (site, sample). Only END, GT and optionally GQ/DP are read from the array and no
+ * VariantContext objects are built. Sites are columns where at least one queried sample
+ * has a non-reference genotype. Samples inside reference blocks are reported as hom-ref,
+ * samples with no data or spanned by another variant as missing.
+ * The matrix is site major:
+ * <ul>
+ * <li>ENCODING_2BIT - (numSamples+3)/4 bytes per site, sample i in bits 2*(i%4) and 2*(i%4)+1
+ * of byte i/4. 0: hom-ref, 1: het, 2: hom-alt, 3: missing</li>
+ * <li>ENCODING_8BIT - numSamples bytes per site, number of non-reference alleles, 255: missing</li>
+ * </ul>
+ */
+public class GenomicsDBGenotypeMatrixReader implements Closeable
+{
+    static
+    {
+        try
+        {
+            boolean loaded = GenomicsDBUtils.loadLibrary();
+            if(!loaded)
+                throw new GenomicsDBException("Could not load genomicsdb native library");
+        }
+        catch(UnsatisfiedLinkError ule)
+        {
+            throw new GenomicsDBException("Could not load genomicsdb native library");
+        }
+    }
+
+    public static final int ENCODING_2BIT = 0;
+    public static final int ENCODING_8BIT = 1;
+
+    private native long jniGenotypeMatrixQueryInit(String loaderJSONFile, String queryJSONFile,
+            int rank, int encoding, boolean fetchGQDP, long segmentSize);
+
+    private native long jniGenotypeMatrixQueryClose(long handle);
+
+    private native long jniGenotypeMatrixQueryGetNumSites(long handle);
+
+    private native long jniGenotypeMatrixQueryGetNumSamples(long handle);
+
+    private native long[] jniGenotypeMatrixQueryGetSampleRows(long handle);
+
+    private native long[] jniGenotypeMatrixQueryGetSiteColumns(long handle);
+
+    private native byte[] jniGenotypeMatrixQueryGetGenotypes(long handle);
+
+    private native int[] jniGenotypeMatrixQueryGetGQ(long handle);
+
+    private native int[] jniGenotypeMatrixQueryGetDP(long handle);
+
+    //"Pointer" to native query object
+    private long mGenotypeMatrixQueryHandle = 0;
+
+    /**
+     * Constructor - runs the query, 2 bit encoding without GQ/DP
+     * @param loaderJSONFile GenomicsDB loader JSON configuration file
+     * @param queryJSONFile GenomicsDB query JSON configuration file
+     */
+    public GenomicsDBGenotypeMatrixReader(final String loaderJSONFile, final String queryJSONFile)
+    {
+        this(loaderJSONFile, queryJSONFile, 0, ENCODING_2BIT, false, 10485760);
+    }
+
+    /**
+     * Constructor - runs the query
+     * @param loaderJSONFile GenomicsDB loader JSON configuration file
+     * @param queryJSONFile GenomicsDB query JSON configuration file, the attributes list is ignored
+     * @param rank rank of this object if launched from within an MPI context (not used)
+     * @param encoding ENCODING_2BIT or ENCODING_8BIT
+     * @param fetchGQDP if true, GQ and DP matrices are also filled
+     * @param segmentSize buffer to be used for querying TileDB
+     * @throws GenomicsDBException if the configuration is invalid or the query fails
+     */
+    public GenomicsDBGenotypeMatrixReader(final String loaderJSONFile, final String queryJSONFile,
+            final int rank, final int encoding, final boolean fetchGQDP, final long segmentSize)
+    {
+        mGenotypeMatrixQueryHandle = jniGenotypeMatrixQueryInit(loaderJSONFile, queryJSONFile, rank,
+          encoding, fetchGQDP, segmentSize);
+    }
+
+    private void checkOpen() throws IOException
+    {
+        if(mGenotypeMatrixQueryHandle == 0)
+            throw new IOException("GenomicsDBGenotypeMatrixReader is closed");
+    }
+
+    /**
+     * @return number of sites (rows of the matrix)
+     */
+    public long getNumSites()
+    {
+        return jniGenotypeMatrixQueryGetNumSites(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return number of samples (columns of the matrix)
+     */
+    public long getNumSamples()
+    {
+        return jniGenotypeMatrixQueryGetNumSamples(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return TileDB row index of each sample
+     * @throws IOException if the reader is closed
+     */
+    public long[] getSampleRows() throws IOException
+    {
+        checkOpen();
+        return jniGenotypeMatrixQueryGetSampleRows(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return TileDB column (flattened genomic position) of each site
+     * @throws IOException if the reader is closed
+     */
+    public long[] getSiteColumns() throws IOException
+    {
+        checkOpen();
+        return jniGenotypeMatrixQueryGetSiteColumns(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return packed genotype matrix, site major
+     * @throws IOException if the reader is closed
+     */
+    public byte[] getGenotypes() throws IOException
+    {
+        checkOpen();
+        return jniGenotypeMatrixQueryGetGenotypes(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return GQ matrix (numSites*numSamples, site major), empty if GQ/DP were not fetched
+     * @throws IOException if the reader is closed
+     */
+    public int[] getGQ() throws IOException
+    {
+        checkOpen();
+        return jniGenotypeMatrixQueryGetGQ(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * @return DP matrix (numSites*numSamples, site major), empty if GQ/DP were not fetched
+     * @throws IOException if the reader is closed
+     */
+    public int[] getDP() throws IOException
+    {
+        checkOpen();
+        return jniGenotypeMatrixQueryGetDP(mGenotypeMatrixQueryHandle);
+    }
+
+    /**
+     * Frees the native query object
+     */
+    @Override
+    public void close()
+    {
+        mGenotypeMatrixQueryHandle = jniGenotypeMatrixQueryClose(mGenotypeMatrixQueryHandle);
+    }
+}
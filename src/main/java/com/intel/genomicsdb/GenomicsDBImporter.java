@@ -48,6 +48,7 @@ import java.io.FileNotFoundException;
 import java.io.File;
 import java.io.PrintWriter;
 import java.io.StringWriter;
+import java.nio.ByteBuffer;
 import java.util.*;
 
 import static com.googlecode.protobuf.format.JsonFormat.printToString;
@@ -136,14 +137,14 @@ public class GenomicsDBImporter
    * @param streamName name of the stream
    * @param isBCF use BCF format to pass data to C++ layer
    * @param bufferCapacity in bytes
-   * @param buffer initialization buffer containing the VCF/BCF header
+   * @param buffer direct buffer containing the VCF/BCF header
    * @param numValidBytesInBuffer num valid bytes in the buffer (length of the header)
    */
   private native void jniAddBufferStream(long genomicsDBImporterHandle,
                                          String streamName,
                                          boolean isBCF,
                                          long bufferCapacity,
-                                         byte[] buffer,
+                                         ByteBuffer buffer,
                                          long numValidBytesInBuffer);
   /**
    * Setup loader after all the buffer streams are added
@@ -159,17 +160,19 @@ public class GenomicsDBImporter
                                                final String callsetMappingJSON,
                                                boolean usingVidMappingProtoBuf);
   /**
+   * Zero-copy - the native layer parses records directly from the memory of the direct buffer. The buffer must not be modified
+   * till the stream is returned as exhausted by jniImportBatch
    * @param handle "pointer" returned by jniInitializeGenomicsDBImporterObject
    * @param streamIdx stream index
    * @param partitionIdx partition index (unused now)
-   * @param buffer buffer containing data
+   * @param buffer direct buffer containing data
    * @param numValidBytesInBuffer num valid bytes in the buffer
    */
-  private native void jniWriteDataToBufferStream(long handle,
-                                                 int streamIdx,
-                                                 int partitionIdx,
-                                                 byte[] buffer,
-                                                 long numValidBytesInBuffer);
+  private native void jniWriteDataToDirectBufferStream(long handle,
+                                                       int streamIdx,
+                                                       int partitionIdx,
+                                                       ByteBuffer buffer,
+                                                       long numValidBytesInBuffer);
   /**
    * Import the next batch of data into TileDB/GenomicsDB
    * @param genomicsDBImporterHandle "pointer" returned by jniInitializeGenomicsDBImporterObject
@@ -1287,7 +1290,7 @@ public class GenomicsDBImporter
           }
         }
         SilentByteBufferStream currStream = currWrapper.mStream;
-        jniWriteDataToBufferStream(mGenomicsDBImporterObjectHandle, bufferStreamIdx,
+        jniWriteDataToDirectBufferStream(mGenomicsDBImporterObjectHandle, bufferStreamIdx,
           0, currStream.getBuffer(), currStream.getNumValidBytes());
       }
       mDone = jniImportBatch(mGenomicsDBImporterObjectHandle, mExhaustedBufferStreamIdentifiers);
@@ -29,8 +29,13 @@ import org.apache.hadoop.conf.Configurable;
 import org.apache.hadoop.conf.Configuration;
 import org.apache.hadoop.mapreduce.*;
 import org.apache.log4j.Logger;
+import org.json.simple.JSONArray;
+import org.json.simple.JSONObject;
+import org.json.simple.parser.JSONParser;
+import org.json.simple.parser.ParseException;
 
 import java.io.FileNotFoundException;
+import java.io.FileReader;
 import java.io.IOException;
 import java.util.ArrayList;
 import java.util.List;
@@ -64,16 +69,129 @@ public class GenomicsDBInputFormat<VCONTEXT extends Feature, SOURCE>
       configuration.get(GenomicsDBConfiguration.MPIHOSTFILE));
 
     List<String> hosts = genomicsDBConfiguration.getHosts();
+    int numSplits = configuration.getInt(GenomicsDBConfiguration.NUM_SPLITS, hosts.size());
 
-    ArrayList<InputSplit> inputSplits = new ArrayList<>(hosts.size());
-    for (int i = 0; i < hosts.size(); ++i) {
-      GenomicsDBInputSplit split = new GenomicsDBInputSplit();
-      inputSplits.add(split);
+    // Column ranges with roughly equal number of cells - each split gets
+    // a similar amount of work irrespective of how variants are distributed
+    // along the genome
+    List<long[]> partitions = null;
+    if (numSplits > 1) {
+      try {
+        partitions = GenomicsDBUtils.getColumnPartitionsByDensity(
+          configuration.get(GenomicsDBConfiguration.LOADERJSON),
+          configuration.get(GenomicsDBConfiguration.QUERYJSON), numSplits);
+      } catch (RuntimeException e) {
+        logger.warn("Could not compute density based splits, falling back to one split per host: "
+          + e.getMessage());
+        partitions = null;
+      }
+    }
+
+    ArrayList<InputSplit> inputSplits;
+    if (partitions == null || partitions.isEmpty()) {
+      inputSplits = new ArrayList<>(hosts.size());
+      for (int i = 0; i < hosts.size(); ++i) {
+        GenomicsDBInputSplit split = new GenomicsDBInputSplit();
+        inputSplits.add(split);
+      }
+      return inputSplits;
+    }
+
+    long[] loaderPartitionBegins = getLoaderPartitionBegins(
+      configuration.get(GenomicsDBConfiguration.LOADERJSON));
+    inputSplits = new ArrayList<>(partitions.size());
+    for (int splitIdx = 0; splitIdx < partitions.size(); ++splitIdx) {
+      long[] partition = partitions.get(splitIdx);
+      int numRanges = (partition.length-1)/2;
+      long[] columnBegins = new long[numRanges];
+      long[] columnEnds = new long[numRanges];
+      for (int i = 0; i < numRanges; ++i) {
+        columnBegins[i] = partition[1+2*i];
+        columnEnds[i] = partition[2+2*i];
+      }
+      String host = getPreferredHost(columnBegins, columnEnds, loaderPartitionBegins, hosts,
+        splitIdx, partitions.size());
+      inputSplits.add(new GenomicsDBInputSplit(columnBegins, columnEnds, partition[0], host));
     }
 
     return inputSplits;
   }
 
+  /**
+   * Column at which each column partition of the loader begins, in the
+   * order of the partitions. The i-th partition is loaded by MPI rank i,
+   * i.e. the i-th line of the host file
+   *
+   * @param loaderJson  Path of the loader JSON file
+   * @return  Begin column of each partition, null if the loader JSON does
+   *          not list the partitions explicitly
+   */
+  long[] getLoaderPartitionBegins(String loaderJson) {
+    if (loaderJson == null || loaderJson.isEmpty())
+      return null;
+    try {
+      JSONObject topObj = (JSONObject) new JSONParser().parse(new FileReader(loaderJson));
+      Object partitionsObj = topObj.get("column_partitions");
+      if (!(partitionsObj instanceof JSONArray))
+        return null;
+      JSONArray partitionsArray = (JSONArray) partitionsObj;
+      long[] begins = new long[partitionsArray.size()];
+      for (int i = 0; i < begins.length; ++i) {
+        Object begin = ((JSONObject) partitionsArray.get(i)).get("begin");
+        if (!(begin instanceof Long))
+          return null;
+        begins[i] = (Long) begin;
+      }
+      return begins;
+    } catch (IOException | ParseException | ClassCastException e) {
+      logger.warn("Could not read column partitions from " + loaderJson + ": " + e.getMessage());
+      return null;
+    }
+  }
+
+  /**
+   * Host holding most of the columns of a split. Falls back to spreading
+   * the splits over the hosts in column order when the loader partitions
+   * are not known
+   *
+   * @param columnBegins  First column of each range of the split
+   * @param columnEnds  Last column of each range of the split (inclusive)
+   * @param loaderPartitionBegins  Begin column of each loader partition, may be null
+   * @param hosts  Hosts from the host file, one per partition
+   * @param splitIdx  Index of the split
+   * @param numSplits  Total number of splits
+   * @return  Preferred host, null if there are no hosts
+   */
+  static String getPreferredHost(long[] columnBegins, long[] columnEnds, long[] loaderPartitionBegins,
+    List<String> hosts, int splitIdx, int numSplits) {
+    if (hosts == null || hosts.isEmpty())
+      return null;
+    if (loaderPartitionBegins == null || loaderPartitionBegins.length == 0)
+      return hosts.get((int) (((long) splitIdx * hosts.size()) / numSplits));
+    int bestPartitionIdx = -1;
+    long bestOverlap = -1;
+    for (int p = 0; p < loaderPartitionBegins.length; ++p) {
+      long partitionBegin = loaderPartitionBegins[p];
+      // A partition extends up to the next higher begin column
+      long partitionEnd = Long.MAX_VALUE;
+      for (long otherBegin : loaderPartitionBegins)
+        if (otherBegin > partitionBegin && otherBegin-1 < partitionEnd)
+          partitionEnd = otherBegin-1;
+      long overlap = 0;
+      for (int i = 0; i < columnBegins.length; ++i) {
+        long begin = Math.max(columnBegins[i], partitionBegin);
+        long end = Math.min(columnEnds[i], partitionEnd);
+        if (begin <= end)
+          overlap += end-begin+1;
+      }
+      if (overlap > bestOverlap) {
+        bestOverlap = overlap;
+        bestPartitionIdx = p;
+      }
+    }
+    return hosts.get(bestPartitionIdx % hosts.size());
+  }
+
   public RecordReader<String, VCONTEXT>
     createRecordReader(InputSplit inputSplit, TaskAttemptContext taskAttemptContext)
       throws IOException, InterruptedException {
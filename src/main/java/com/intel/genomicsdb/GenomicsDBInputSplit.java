@@ -38,6 +38,10 @@ public class GenomicsDBInputSplit extends InputSplit implements Writable {
   // per split
   String[] hosts;
   long length = 0;
+  // Column ranges [columnBegins[i], columnEnds[i]] of the array covered
+  // by this split - null if the split covers the full query
+  long[] columnBegins = null;
+  long[] columnEnds = null;
 
   Logger logger = Logger.getLogger(GenomicsDBInputSplit.class);
 
@@ -51,13 +55,81 @@ public class GenomicsDBInputSplit extends InputSplit implements Writable {
     this.length = length;
   }
 
+  /**
+   * Split covering a set of column ranges of the array
+   *
+   * @param columnBegins  First column of each range
+   * @param columnEnds  Last column of each range (inclusive)
+   * @param length  Number of cells in the ranges
+   */
+  public GenomicsDBInputSplit(long[] columnBegins, long[] columnEnds, long length) {
+    assert columnBegins.length == columnEnds.length;
+    this.columnBegins = columnBegins;
+    this.columnEnds = columnEnds;
+    this.length = length;
+  }
+
+  /**
+   * Split covering a set of column ranges of the array, preferably
+   * processed on the host holding most of those columns
+   *
+   * @param columnBegins  First column of each range
+   * @param columnEnds  Last column of each range (inclusive)
+   * @param length  Number of cells in the ranges
+   * @param host  Preferred host for this split
+   */
+  public GenomicsDBInputSplit(long[] columnBegins, long[] columnEnds, long length, String host) {
+    this(columnBegins, columnEnds, length);
+    if (host != null)
+      this.hosts = new String[] { host };
+  }
+
+  public boolean hasColumnRanges() {
+    return columnBegins != null && columnBegins.length > 0;
+  }
+
+  public long[] getColumnBegins() {
+    return columnBegins;
+  }
+
+  public long[] getColumnEnds() {
+    return columnEnds;
+  }
+
   public void write(DataOutput dataOutput) throws IOException {
     dataOutput.writeLong(this.length);
+    int numRanges = hasColumnRanges() ? columnBegins.length : 0;
+    dataOutput.writeInt(numRanges);
+    for (int i = 0; i < numRanges; ++i) {
+      dataOutput.writeLong(columnBegins[i]);
+      dataOutput.writeLong(columnEnds[i]);
+    }
+    int numHosts = (hosts == null) ? 0 : hosts.length;
+    dataOutput.writeInt(numHosts);
+    for (int i = 0; i < numHosts; ++i)
+      dataOutput.writeUTF(hosts[i]);
   }
 
   public void readFields(DataInput dataInput) throws IOException {
     hosts = null;
+    columnBegins = null;
+    columnEnds = null;
     length = dataInput.readLong();
+    int numRanges = dataInput.readInt();
+    if (numRanges > 0) {
+      columnBegins = new long[numRanges];
+      columnEnds = new long[numRanges];
+      for (int i = 0; i < numRanges; ++i) {
+        columnBegins[i] = dataInput.readLong();
+        columnEnds[i] = dataInput.readLong();
+      }
+    }
+    int numHosts = dataInput.readInt();
+    if (numHosts > 0) {
+      hosts = new String[numHosts];
+      for (int i = 0; i < numHosts; ++i)
+        hosts[i] = dataInput.readUTF();
+    }
   }
 
   public long getLength() throws IOException, InterruptedException {
@@ -71,6 +143,8 @@ public class GenomicsDBInputSplit extends InputSplit implements Writable {
    *                   in GenomicsDBConfiguration or hadoopConfiguration in SparkContext
    */
   public String[] getLocations() throws IOException, InterruptedException {
+    if (hosts != null && hosts.length > 0)
+      return hosts;
     hosts = new String[1];
     hosts[0] = InetAddress.getLocalHost().getHostName();
     return hosts;
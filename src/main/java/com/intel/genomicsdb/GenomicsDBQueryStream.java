@@ -24,6 +24,7 @@ package com.intel.genomicsdb;
 
 import java.io.InputStream;
 import java.io.IOException;
+import java.util.List;
 
 /**
  * Provides a java.io.InputStream interface for the GenomicsDB combine gVCF operation.
@@ -71,12 +72,24 @@ public class GenomicsDBQueryStream extends InputStream
 
     private native long jniGenomicsDBSkip(long handle, long n);
 
+    private native void jniGenomicsDBResetQuery(long handle, String[] chrs, int[] starts, int[] ends);
+
+    private native void jniGenomicsDBResetQueryColumns(long handle, long[] columnBegins, long[] columnEnds);
+
     private String mLoaderJSONFile;
     private String mQueryJSONFile;
 
     //"Pointer" to TileDB/GenomicsDB read state object
     private long mGenomicsDBReadStateHandle = 0;
 
+    //Set for streams returned by requery() - the native state is owned by the session stream
+    private GenomicsDBQueryStream mSession = null;
+    //#streams returned by requery() that are still open - they share the native read state
+    private int mNumOpenRequeryStreams = 0;
+    //close() was invoked on the session while requery() streams were open - the native read state
+    //is released when the last of them is closed
+    private boolean mCloseRequested = false;
+
     /**
      * Constructor
      * @param loaderJSONFile GenomicsDB loader JSON configuration file
@@ -236,16 +249,119 @@ public class GenomicsDBQueryStream extends InputStream
           useMissingValuesOnlyNotVectorEnd, keepIDXFieldsInHeader);
     }
 
+    /**
+     * Constructor for streams returned by requery() - shares the native read state of the session
+     * @param session stream which owns the native read state
+     */
+    private GenomicsDBQueryStream(final GenomicsDBQueryStream session)
+    {
+        mLoaderJSONFile = session.mLoaderJSONFile;
+        mQueryJSONFile = session.mQueryJSONFile;
+        mGenomicsDBReadStateHandle = session.mGenomicsDBReadStateHandle;
+        mSession = session;
+    }
+
+    /**
+     * Re-uses the native read state of this stream (opened TileDB array, parsed JSON configs,
+     * combine operator) to query a new set of intervals. Avoids the initialization cost
+     * incurred by constructing a new stream for every query. The returned stream begins with the
+     * VCF/BCF header, just like a newly constructed stream. Closing the returned stream does not
+     * release the native state - close this stream for that. At most one stream obtained from
+     * requery() may be open at any time
+     * @param intervals intervals to query (1-based, inclusive), empty list to scan all positions
+     * @return stream over the combined records in the intervals
+     * @throws IOException if this stream is closed or a previous requery() stream is still open
+     */
+    public GenomicsDBQueryStream requery(final List<? extends ChromosomeInterval> intervals) throws IOException
+    {
+        checkSessionAvailable();
+        String[] chrs = new String[intervals.size()];
+        int[] starts = new int[intervals.size()];
+        int[] ends = new int[intervals.size()];
+        for(int i=0;i<intervals.size();++i)
+        {
+            chrs[i] = intervals.get(i).getContig();
+            starts[i] = intervals.get(i).getStart();
+            ends[i] = intervals.get(i).getEnd();
+        }
+        jniGenomicsDBResetQuery(mGenomicsDBReadStateHandle, chrs, starts, ends);
+        ++mNumOpenRequeryStreams;
+        return new GenomicsDBQueryStream(this);
+    }
+
+    /**
+     * Same as requery(List), but the intervals are TileDB column ranges (inclusive)
+     * @param columnBegins begin columns of intervals
+     * @param columnEnds end columns of intervals
+     * @return stream over the combined records in the intervals
+     * @throws IOException if this stream is closed or a previous requery() stream is still open
+     */
+    public GenomicsDBQueryStream requeryColumns(final long[] columnBegins, final long[] columnEnds)
+      throws IOException
+    {
+        checkSessionAvailable();
+        if(columnBegins.length != columnEnds.length)
+            throw new IOException("Lengths of column begin and end arrays do not match");
+        jniGenomicsDBResetQueryColumns(mGenomicsDBReadStateHandle, columnBegins, columnEnds);
+        ++mNumOpenRequeryStreams;
+        return new GenomicsDBQueryStream(this);
+    }
+
+    private void checkSessionAvailable() throws IOException
+    {
+        if(mSession != null)
+            throw new IOException("requery() must be invoked on the session stream");
+        if(mGenomicsDBReadStateHandle == 0 || mCloseRequested)
+            throw new IOException("GenomicsDBQueryStream is closed");
+        if(mNumOpenRequeryStreams > 0)
+            throw new IOException("Stream obtained from a previous requery() call is still open");
+    }
+
+    /**
+     * @return true if a stream obtained from requery() is open
+     */
+    public boolean isSessionBusy()
+    {
+        return mNumOpenRequeryStreams > 0;
+    }
+
     @Override
     public int available() throws IOException
     {
         return (int)jniGenomicsDBGetNumBytesAvailable(mGenomicsDBReadStateHandle);
     }
 
+    /**
+     * Closing the session stream while streams returned by requery() are open only marks it closed -
+     * the native read state is released once the last of those streams is closed
+     */
     @Override
     public void close() throws IOException
     {
-        mGenomicsDBReadStateHandle = jniGenomicsDBClose(mGenomicsDBReadStateHandle);
+        if(mSession != null)
+        {
+            if(mGenomicsDBReadStateHandle != 0)
+                mSession.requeryStreamClosed();
+            mGenomicsDBReadStateHandle = 0;
+        }
+        else if(mNumOpenRequeryStreams > 0)
+            mCloseRequested = true;
+        else
+            releaseReadState();
+    }
+
+    private void requeryStreamClosed()
+    {
+        --mNumOpenRequeryStreams;
+        if(mNumOpenRequeryStreams == 0 && mCloseRequested)
+            releaseReadState();
+    }
+
+    private void releaseReadState()
+    {
+        if(mGenomicsDBReadStateHandle != 0)
+            mGenomicsDBReadStateHandle = jniGenomicsDBClose(mGenomicsDBReadStateHandle);
+        mCloseRequested = false;
     }
 
     @Override
@@ -50,7 +50,13 @@ public class GenomicsDBRecordReader<VCONTEXT extends Feature, SOURCE>
 
   public void initialize(InputSplit inputSplit, TaskAttemptContext taskAttemptContext)
     throws IOException, InterruptedException {
-    initialize();
+    if (inputSplit instanceof GenomicsDBInputSplit
+        && ((GenomicsDBInputSplit) inputSplit).hasColumnRanges()) {
+      GenomicsDBInputSplit split = (GenomicsDBInputSplit) inputSplit;
+      this.iterator = featureReader.queryColumns(split.getColumnBegins(), split.getColumnEnds());
+    }
+    else
+      initialize();
   }
 
   private void initialize() throws IOException {
@@ -80,6 +86,7 @@ public class GenomicsDBRecordReader<VCONTEXT extends Feature, SOURCE>
 
   public void close() throws IOException {
     this.iterator.close();
+    this.featureReader.close();
   }
 
   public Boolean hasNext() {
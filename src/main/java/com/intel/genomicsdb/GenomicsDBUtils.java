@@ -28,6 +28,8 @@ import java.io.OutputStream;
 import java.io.IOException;
 import java.io.FileNotFoundException;
 import java.io.FileOutputStream;
+import java.util.ArrayList;
+import java.util.List;
 
 /**
  * Utility Java functions for GenomicsDB
@@ -39,6 +41,42 @@ public class GenomicsDBUtils
 
     private static native int jniGenomicsDBOneTimeInitialize();
 
+    private static native long[] jniGetColumnPartitionsByDensity(String loaderJSONFile,
+            String queryJSONFile, int rank, int numPartitions, long segmentSize);
+
+    /**
+     * Splits the queried column range of the array into partitions with roughly equal
+     * number of cells. Scans the END attribute of all queried cells - meant to be
+     * invoked once per job, for example while computing input splits.
+     * Partitions are restricted to the queried column intervals, so a partition may consist
+     * of several column ranges and partitions lying entirely between intervals are dropped
+     * @param loaderJSONFile GenomicsDB loader JSON configuration file (empty string if none)
+     * @param queryJSONFile GenomicsDB query JSON configuration file
+     * @param numPartitions maximum number of partitions
+     * @return list of {#cells, begin 0, end 0 (inclusive), begin 1, end 1, ...} for each partition
+     * @throws GenomicsDBException if the partitions cannot be computed
+     */
+    public static List<long[]> getColumnPartitionsByDensity(final String loaderJSONFile,
+            final String queryJSONFile, final int numPartitions)
+    {
+        if(!loadLibrary())
+            throw new GenomicsDBException("Could not load genomicsdb native library");
+        long[] encoded = jniGetColumnPartitionsByDensity(loaderJSONFile == null ? "" : loaderJSONFile,
+                queryJSONFile, 0, numPartitions, 10485760);
+        List<long[]> partitions = new ArrayList<long[]>();
+        //Each partition is encoded as #cells, #ranges, begin 0, end 0, ...
+        for(int i=0;i+1<encoded.length;)
+        {
+            int numRanges = (int)encoded[i+1];
+            long[] partition = new long[1+2*numRanges];
+            partition[0] = encoded[i];
+            System.arraycopy(encoded, i+2, partition, 1, 2*numRanges);
+            partitions.add(partition);
+            i += 2+2*numRanges;
+        }
+        return partitions;
+    }
+
     public static synchronized boolean loadLibrary()
     {
         if(mIsLibraryLoaded)
@@ -2,16 +2,19 @@ package com.intel.genomicsdb;
 
 import java.io.IOException;
 import java.io.OutputStream;
+import java.nio.ByteBuffer;
 
 /**
  * Buffer stream implementation - it's silent in the sense that when the buffer is full,
  * it doesn't raise an exception but just marks a a flag as full. It's up to the caller
  * to check the flag and retry later
  * Why? Most likely, it's faster to check a flag rather than throw and catch an exception
+ * The buffer is a direct ByteBuffer so that the native layer can parse records in place
+ * without copying the contents of the buffer
  */
 class SilentByteBufferStream extends OutputStream
 {
-  private byte mBuffer[] = null;
+  private ByteBuffer mBuffer = null;
   private long mNumValidBytes = 0;
   private long mMarker = 0;
   private boolean mOverflow = false;
@@ -21,7 +24,7 @@ class SilentByteBufferStream extends OutputStream
    */
   public SilentByteBufferStream()
   {
-    mBuffer = new byte[(int)GenomicsDBImporter.mDefaultBufferCapacity];
+    mBuffer = ByteBuffer.allocateDirect((int)GenomicsDBImporter.mDefaultBufferCapacity);
   }
 
   /**
@@ -30,7 +33,7 @@ class SilentByteBufferStream extends OutputStream
    */
   public SilentByteBufferStream(final long capacity)
   {
-    mBuffer = new byte[(int)capacity];
+    mBuffer = ByteBuffer.allocateDirect((int)capacity);
   }
 
   @Override
@@ -48,11 +51,12 @@ class SilentByteBufferStream extends OutputStream
   {
     if(mOverflow)
       return;
-    if(len+mNumValidBytes > mBuffer.length)
+    if(len+mNumValidBytes > mBuffer.capacity())
       mOverflow = true;
     else
     {
-      System.arraycopy(b, off, mBuffer, (int)mNumValidBytes, len);
+      mBuffer.position((int)mNumValidBytes);
+      mBuffer.put(b, off, len);
       mNumValidBytes += len;
     }
   }
@@ -68,11 +72,11 @@ class SilentByteBufferStream extends OutputStream
   {
     if(mOverflow)
       return;
-    if(mNumValidBytes+1>mBuffer.length)
+    if(mNumValidBytes+1>mBuffer.capacity())
       mOverflow = true;
     else
     {
-      mBuffer[(int)mNumValidBytes] = (byte)b;
+      mBuffer.put((int)mNumValidBytes, (byte)b);
       ++mNumValidBytes;
     }
   }
@@ -83,7 +87,7 @@ class SilentByteBufferStream extends OutputStream
    */
   public int size()
   {
-    return mBuffer.length;
+    return mBuffer.capacity();
   }
 
   /**
@@ -92,8 +96,10 @@ class SilentByteBufferStream extends OutputStream
    */
   public void resize(final long newSize)
   {
-    byte tmp[] = new byte[(int)newSize];
-    System.arraycopy(mBuffer, 0, tmp, 0, mBuffer.length);
+    ByteBuffer tmp = ByteBuffer.allocateDirect((int)newSize);
+    mBuffer.position(0);
+    mBuffer.limit(Math.min(mBuffer.capacity(), (int)newSize));
+    tmp.put(mBuffer);
     mBuffer = tmp; //hopefully Java GC does its job
   }
 
@@ -154,10 +160,11 @@ class SilentByteBufferStream extends OutputStream
   }
 
   /**
-   * Get byte buffer for this stream
-   * @return byte buffer for this stream
+   * Get byte buffer for this stream - the native layer reads directly from this buffer,
+   * so its contents must not be modified till the stream is reported as exhausted
+   * @return direct byte buffer for this stream
    */
-  public byte[] getBuffer()
+  public ByteBuffer getBuffer()
   {
     return mBuffer;
   }
@@ -0,0 +1,45 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_intel_genomicsdb_GenomicsDBColumnarReader */
+
+#ifndef _Included_com_intel_genomicsdb_GenomicsDBColumnarReader
+#define _Included_com_intel_genomicsdb_GenomicsDBColumnarReader
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBColumnarReader
+ * Method:    jniColumnarQueryInit
+ * Signature: (Ljava/lang/String;Ljava/lang/String;IJJ)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryInit
+  (JNIEnv *, jobject, jstring, jstring, jint, jlong, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBColumnarReader
+ * Method:    jniColumnarQueryClose
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryClose
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBColumnarReader
+ * Method:    jniColumnarQueryExportNextBatch
+ * Signature: (JJJ)Z
+ */
+JNIEXPORT jboolean JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryExportNextBatch
+  (JNIEnv *, jobject, jlong, jlong, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBColumnarReader
+ * Method:    jniColumnarQueryExportSchema
+ * Signature: (JJ)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryExportSchema
+  (JNIEnv *, jobject, jlong, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
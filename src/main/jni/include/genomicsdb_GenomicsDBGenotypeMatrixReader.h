@@ -0,0 +1,85 @@
+/* DO NOT EDIT THIS FILE - it is machine generated */
+#include <jni.h>
+/* Header for class com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader */
+
+#ifndef _Included_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+#define _Included_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+#ifdef __cplusplus
+extern "C" {
+#endif
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryInit
+ * Signature: (Ljava/lang/String;Ljava/lang/String;IIZJ)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryInit
+  (JNIEnv *, jobject, jstring, jstring, jint, jint, jboolean, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryClose
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryClose
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetNumSites
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetNumSites
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetNumSamples
+ * Signature: (J)J
+ */
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetNumSamples
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetSampleRows
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetSampleRows
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetSiteColumns
+ * Signature: (J)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetSiteColumns
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetGenotypes
+ * Signature: (J)[B
+ */
+JNIEXPORT jbyteArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetGenotypes
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetGQ
+ * Signature: (J)[I
+ */
+JNIEXPORT jintArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetGQ
+  (JNIEnv *, jobject, jlong);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader
+ * Method:    jniGenotypeMatrixQueryGetDP
+ * Signature: (J)[I
+ */
+JNIEXPORT jintArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetDP
+  (JNIEnv *, jobject, jlong);
+
+#ifdef __cplusplus
+}
+#endif
+#endif
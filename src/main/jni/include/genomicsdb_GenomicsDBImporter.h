@@ -46,10 +46,10 @@ JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBImporter_jniCopyCall
 /*
  * Class:     com_intel_genomicsdb_GenomicsDBImporter
  * Method:    jniAddBufferStream
- * Signature: (JLjava/lang/String;ZJ[BJ)V
+ * Signature: (JLjava/lang/String;ZJLjava/nio/ByteBuffer;J)V
  */
 JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBImporter_jniAddBufferStream
-  (JNIEnv *, jobject, jlong, jstring, jboolean, jlong, jbyteArray, jlong);
+  (JNIEnv *, jobject, jlong, jstring, jboolean, jlong, jobject, jlong);
 
 /*
  * Class:     com_intel_genomicsdb_GenomicsDBImporter
@@ -61,11 +61,11 @@ JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBImporter_jniSetupGen
 
 /*
  * Class:     com_intel_genomicsdb_GenomicsDBImporter
- * Method:    jniWriteDataToBufferStream
- * Signature: (JII[BJ)V
+ * Method:    jniWriteDataToDirectBufferStream
+ * Signature: (JIILjava/nio/ByteBuffer;J)V
  */
-JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBImporter_jniWriteDataToBufferStream
-  (JNIEnv *, jobject, jlong, jint, jint, jbyteArray, jlong);
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBImporter_jniWriteDataToDirectBufferStream
+  (JNIEnv *, jobject, jlong, jint, jint, jobject, jlong);
 
 /*
  * Class:     com_intel_genomicsdb_GenomicsDBImporter
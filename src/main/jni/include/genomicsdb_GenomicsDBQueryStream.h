@@ -57,6 +57,22 @@ JNIEXPORT jint JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomi
 JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomicsDBSkip
   (JNIEnv *, jobject, jlong, jlong);
 
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBQueryStream
+ * Method:    jniGenomicsDBResetQuery
+ * Signature: (J[Ljava/lang/String;[I[I)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomicsDBResetQuery
+  (JNIEnv *, jobject, jlong, jobjectArray, jintArray, jintArray);
+
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBQueryStream
+ * Method:    jniGenomicsDBResetQueryColumns
+ * Signature: (J[J[J)V
+ */
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomicsDBResetQueryColumns
+  (JNIEnv *, jobject, jlong, jlongArray, jlongArray);
+
 #ifdef __cplusplus
 }
 #endif
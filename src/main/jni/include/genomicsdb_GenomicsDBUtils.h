@@ -15,6 +15,14 @@ extern "C" {
 JNIEXPORT jint JNICALL Java_com_intel_genomicsdb_GenomicsDBUtils_jniGenomicsDBOneTimeInitialize
   (JNIEnv *, jclass);
 
+/*
+ * Class:     com_intel_genomicsdb_GenomicsDBUtils
+ * Method:    jniGetColumnPartitionsByDensity
+ * Signature: (Ljava/lang/String;Ljava/lang/String;IIJ)[J
+ */
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBUtils_jniGetColumnPartitionsByDensity
+  (JNIEnv *, jclass, jstring, jstring, jint, jint, jlong);
+
 #ifdef __cplusplus
 }
 #endif
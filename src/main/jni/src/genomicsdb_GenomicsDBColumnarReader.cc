@@ -0,0 +1,75 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genomicsdb_GenomicsDBColumnarReader.h"
+#include "columnar_export.h"
+#include "genomicsdb_jni_exception.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenomicsDBJNIException(#X);
+#define GET_COLUMNAR_QUERY_FROM_HANDLE(X) (reinterpret_cast<GenomicsDBColumnarQuery*>(static_cast<std::uintptr_t>(X)))
+#define GET_POINTER_FROM_ADDRESS(T, X) (reinterpret_cast<T*>(static_cast<std::uintptr_t>(X)))
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryInit
+  (JNIEnv* env, jobject curr_obj, jstring loader_configuration_file, jstring query_configuration_file,
+   jint rank, jlong max_num_rows_per_batch, jlong segment_size)
+{
+  //Java string to char*
+  auto loader_configuration_file_cstr = env->GetStringUTFChars(loader_configuration_file, NULL);
+  VERIFY_OR_THROW(loader_configuration_file_cstr);
+  auto query_configuration_file_cstr = env->GetStringUTFChars(query_configuration_file, NULL);
+  VERIFY_OR_THROW(query_configuration_file_cstr);
+  //Create object - batches are produced on demand by export_next_batch()
+  auto columnar_query_obj = new GenomicsDBColumnarQuery(loader_configuration_file_cstr, query_configuration_file_cstr,
+      rank, max_num_rows_per_batch, segment_size);
+  //Cleanup
+  env->ReleaseStringUTFChars(loader_configuration_file, loader_configuration_file_cstr);
+  env->ReleaseStringUTFChars(query_configuration_file, query_configuration_file_cstr);
+  //Cast pointer to 64-bit int and return to Java
+  return static_cast<jlong>(reinterpret_cast<std::uintptr_t>(columnar_query_obj));
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryClose
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto columnar_query_obj = GET_COLUMNAR_QUERY_FROM_HANDLE(handle);
+  if(columnar_query_obj) //not NULL
+    delete columnar_query_obj;
+  return 0;
+}
+
+JNIEXPORT jboolean JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryExportNextBatch
+  (JNIEnv* env, jobject curr_obj, jlong handle, jlong arrow_array_address, jlong arrow_schema_address)
+{
+  auto columnar_query_obj = GET_COLUMNAR_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(columnar_query_obj && arrow_array_address);
+  //Structs are allocated by the consumer (for example org.apache.arrow.c.ArrowArray/ArrowSchema)
+  return columnar_query_obj->export_next_batch(GET_POINTER_FROM_ADDRESS(ArrowArray, arrow_array_address),
+      GET_POINTER_FROM_ADDRESS(ArrowSchema, arrow_schema_address));
+}
+
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBColumnarReader_jniColumnarQueryExportSchema
+  (JNIEnv* env, jobject curr_obj, jlong handle, jlong arrow_schema_address)
+{
+  auto columnar_query_obj = GET_COLUMNAR_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(columnar_query_obj && arrow_schema_address);
+  columnar_query_obj->export_schema(GET_POINTER_FROM_ADDRESS(ArrowSchema, arrow_schema_address));
+}
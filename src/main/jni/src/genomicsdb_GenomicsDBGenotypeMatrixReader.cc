@@ -0,0 +1,157 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include "genomicsdb_GenomicsDBGenotypeMatrixReader.h"
+#include "genotype_matrix.h"
+#include "genomicsdb_jni_exception.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenomicsDBJNIException(#X);
+#define GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(X) (reinterpret_cast<GenomicsDBGenotypeMatrixQuery*>(static_cast<std::uintptr_t>(X)))
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryInit
+  (JNIEnv* env, jobject curr_obj, jstring loader_configuration_file, jstring query_configuration_file,
+   jint rank, jint encoding, jboolean fetch_GQ_DP, jlong segment_size)
+{
+  //Java string to char*
+  auto loader_configuration_file_cstr = env->GetStringUTFChars(loader_configuration_file, NULL);
+  VERIFY_OR_THROW(loader_configuration_file_cstr);
+  auto query_configuration_file_cstr = env->GetStringUTFChars(query_configuration_file, NULL);
+  VERIFY_OR_THROW(query_configuration_file_cstr);
+  std::string loader_configuration_file_str = loader_configuration_file_cstr;
+  std::string query_configuration_file_str = query_configuration_file_cstr;
+  env->ReleaseStringUTFChars(loader_configuration_file, loader_configuration_file_cstr);
+  env->ReleaseStringUTFChars(query_configuration_file, query_configuration_file_cstr);
+  //C++ exceptions must not cross the JNI boundary - raise GenomicsDBException in the JVM instead
+  GenomicsDBGenotypeMatrixQuery* genotype_matrix_query_obj = 0;
+  try
+  {
+    if(encoding != GENOTYPE_MATRIX_ENCODING_2BIT && encoding != GENOTYPE_MATRIX_ENCODING_8BIT)
+      throw GenotypeMatrixException(std::string("Unknown genotype matrix encoding ")+std::to_string(encoding));
+    //Create object - runs the query
+    genotype_matrix_query_obj = new GenomicsDBGenotypeMatrixQuery(loader_configuration_file_str,
+        query_configuration_file_str, rank, static_cast<GenotypeMatrixEncodingEnum>(encoding), fetch_GQ_DP,
+        segment_size);
+  }
+  catch(const std::exception& e)
+  {
+    auto exception_class = env->FindClass("com/intel/genomicsdb/GenomicsDBException");
+    if(exception_class)
+      env->ThrowNew(exception_class, e.what());
+    return 0;
+  }
+  //Cast pointer to 64-bit int and return to Java
+  return static_cast<jlong>(reinterpret_cast<std::uintptr_t>(genotype_matrix_query_obj));
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryClose
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  if(genotype_matrix_query_obj) //not NULL
+    delete genotype_matrix_query_obj;
+  return 0;
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetNumSites
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  return (genotype_matrix_query_obj) ? genotype_matrix_query_obj->get_matrix().get_num_sites() : 0;
+}
+
+JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetNumSamples
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  return (genotype_matrix_query_obj) ? genotype_matrix_query_obj->get_matrix().get_num_samples() : 0;
+}
+
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetSampleRows
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(genotype_matrix_query_obj);
+  auto num_samples = genotype_matrix_query_obj->get_matrix().get_num_samples();
+  std::vector<jlong> rows(num_samples);
+  for(auto i=0ull;i<num_samples;++i)
+    rows[i] = genotype_matrix_query_obj->get_array_row_idx_for_sample(i);
+  auto java_result = env->NewLongArray(num_samples);
+  VERIFY_OR_THROW(java_result);
+  if(num_samples > 0u)
+    env->SetLongArrayRegion(java_result, 0, num_samples, &(rows[0]));
+  return java_result;
+}
+
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetSiteColumns
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(genotype_matrix_query_obj);
+  auto& site_columns = genotype_matrix_query_obj->get_matrix().get_site_columns();
+  auto java_result = env->NewLongArray(site_columns.size());
+  VERIFY_OR_THROW(java_result);
+  if(site_columns.size() > 0u)
+    env->SetLongArrayRegion(java_result, 0, site_columns.size(), reinterpret_cast<const jlong*>(&(site_columns[0])));
+  return java_result;
+}
+
+JNIEXPORT jbyteArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetGenotypes
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(genotype_matrix_query_obj);
+  auto& genotypes = genotype_matrix_query_obj->get_matrix().get_genotypes();
+  //Java arrays are indexed by jsize
+  VERIFY_OR_THROW(genotypes.size() <= static_cast<size_t>(INT32_MAX)
+      && "Genotype matrix too large for a Java array - split the query into smaller column intervals");
+  auto java_result = env->NewByteArray(genotypes.size());
+  VERIFY_OR_THROW(java_result);
+  if(genotypes.size() > 0u)
+    env->SetByteArrayRegion(java_result, 0, genotypes.size(), reinterpret_cast<const jbyte*>(&(genotypes[0])));
+  return java_result;
+}
+
+static jintArray copy_int_vector_to_java(JNIEnv* env, const std::vector<int>& values)
+{
+  VERIFY_OR_THROW(values.size() <= static_cast<size_t>(INT32_MAX));
+  auto java_result = env->NewIntArray(values.size());
+  VERIFY_OR_THROW(java_result);
+  if(values.size() > 0u)
+    env->SetIntArrayRegion(java_result, 0, values.size(), reinterpret_cast<const jint*>(&(values[0])));
+  return java_result;
+}
+
+JNIEXPORT jintArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetGQ
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(genotype_matrix_query_obj);
+  return copy_int_vector_to_java(env, genotype_matrix_query_obj->get_matrix().get_GQ());
+}
+
+JNIEXPORT jintArray JNICALL Java_com_intel_genomicsdb_GenomicsDBGenotypeMatrixReader_jniGenotypeMatrixQueryGetDP
+  (JNIEnv* env, jobject curr_obj, jlong handle)
+{
+  auto genotype_matrix_query_obj = GET_GENOTYPE_MATRIX_QUERY_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(genotype_matrix_query_obj);
+  return copy_int_vector_to_java(env, genotype_matrix_query_obj->get_matrix().get_DP());
+}
@@ -102,16 +102,15 @@ Java_com_intel_genomicsdb_GenomicsDBImporter_jniAddBufferStream(
   jstring stream_name,
   jboolean is_bcf,
   jlong buffer_capacity,
-  jbyteArray buffer,
+  jobject buffer,
   jlong num_valid_bytes_in_buffer) {
 
   //Java string to char*
   auto stream_name_cstr = env->GetStringUTFChars(stream_name, NULL);
   VERIFY_OR_THROW(stream_name_cstr);
-  jboolean is_copy = JNI_FALSE;
-  //Since this function is called once per stream, performance
-  //is less of a concern
-  auto native_buffer_ptr = env->GetByteArrayElements(buffer, &is_copy);
+  //Direct buffer - no copy made by the JVM
+  auto native_buffer_ptr = env->GetDirectBufferAddress(buffer);
+  VERIFY_OR_THROW(native_buffer_ptr && "Buffer stream must be backed by a direct ByteBuffer");
   //Call importer function
   auto importer = GET_GENOMICSDB_IMPORTER_FROM_HANDLE(handle);
   importer->add_buffer_stream(
@@ -124,7 +123,6 @@ Java_com_intel_genomicsdb_GenomicsDBImporter_jniAddBufferStream(
     num_valid_bytes_in_buffer);
   //Cleanup
   env->ReleaseStringUTFChars(stream_name, stream_name_cstr);
-  env->ReleaseByteArrayElements(buffer, native_buffer_ptr, 0);
 }
 
 JNIEXPORT jlong JNICALL
@@ -150,29 +148,29 @@ Java_com_intel_genomicsdb_GenomicsDBImporter_jniSetupGenomicsDBLoader(
 }
 
 JNIEXPORT void JNICALL
-Java_com_intel_genomicsdb_GenomicsDBImporter_jniWriteDataToBufferStream(
+Java_com_intel_genomicsdb_GenomicsDBImporter_jniWriteDataToDirectBufferStream(
   JNIEnv* env,
   jobject obj,
   jlong handle,
   jint buffer_stream_idx,
   jint partition_idx,
-  jbyteArray buffer,
+  jobject buffer,
   jlong num_valid_bytes_in_buffer) {
 
   auto importer = GET_GENOMICSDB_IMPORTER_FROM_HANDLE(handle);
   assert(importer);
   if(importer->is_done())
     return;
-  jboolean is_copy = JNI_FALSE;
-  //TODO: Possible performance issues since copy is made
-  auto native_buffer_ptr =
-      env->GetByteArrayElements(buffer, &is_copy);
-  importer->write_data_to_buffer_stream(
+  //No copy - records are parsed directly from the memory of the direct ByteBuffer
+  //The Java layer does not touch the buffer till the stream is reported as exhausted
+  auto native_buffer_ptr = env->GetDirectBufferAddress(buffer);
+  VERIFY_OR_THROW(native_buffer_ptr || num_valid_bytes_in_buffer == 0);
+  VERIFY_OR_THROW(native_buffer_ptr == 0
+      || env->GetDirectBufferCapacity(buffer) >= num_valid_bytes_in_buffer);
+  importer->use_external_buffer_for_buffer_stream(
     buffer_stream_idx, partition_idx,
     reinterpret_cast<uint8_t*>(native_buffer_ptr),
     num_valid_bytes_in_buffer);
-  //Cleanup
-  env->ReleaseByteArrayElements(buffer, native_buffer_ptr, 0);
 }
 
 JNIEXPORT jboolean JNICALL
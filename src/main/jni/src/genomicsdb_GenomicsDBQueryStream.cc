@@ -109,3 +109,50 @@ JNIEXPORT jlong JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenom
   auto bcf_reader_obj = GET_BCF_READER_FROM_HANDLE(handle);
   return (bcf_reader_obj) ? bcf_reader_obj->read_and_advance(0, 0, n) : 0;
 }
+
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomicsDBResetQuery
+  (JNIEnv* env, jobject curr_obj, jlong handle, jobjectArray chrs, jintArray starts, jintArray ends)
+{
+  auto bcf_reader_obj = GET_BCF_READER_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(bcf_reader_obj);
+  auto num_intervals = env->GetArrayLength(chrs);
+  VERIFY_OR_THROW(env->GetArrayLength(starts) == num_intervals && env->GetArrayLength(ends) == num_intervals);
+  std::vector<std::string> contigs(num_intervals);
+  for(auto i=0;i<num_intervals;++i)
+  {
+    auto chr = static_cast<jstring>(env->GetObjectArrayElement(chrs, i));
+    auto chr_cstr = env->GetStringUTFChars(chr, NULL);
+    VERIFY_OR_THROW(chr_cstr);
+    contigs[i] = chr_cstr;
+    env->ReleaseStringUTFChars(chr, chr_cstr);
+    env->DeleteLocalRef(chr);
+  }
+  std::vector<int> start_positions(num_intervals);
+  std::vector<int> end_positions(num_intervals);
+  if(num_intervals > 0)
+  {
+    env->GetIntArrayRegion(starts, 0, num_intervals, reinterpret_cast<jint*>(&(start_positions[0])));
+    env->GetIntArrayRegion(ends, 0, num_intervals, reinterpret_cast<jint*>(&(end_positions[0])));
+  }
+  bcf_reader_obj->reset_query_intervals(contigs, start_positions, end_positions);
+}
+
+JNIEXPORT void JNICALL Java_com_intel_genomicsdb_GenomicsDBQueryStream_jniGenomicsDBResetQueryColumns
+  (JNIEnv* env, jobject curr_obj, jlong handle, jlongArray column_begins, jlongArray column_ends)
+{
+  auto bcf_reader_obj = GET_BCF_READER_FROM_HANDLE(handle);
+  VERIFY_OR_THROW(bcf_reader_obj);
+  auto num_intervals = env->GetArrayLength(column_begins);
+  VERIFY_OR_THROW(env->GetArrayLength(column_ends) == num_intervals);
+  std::vector<jlong> begins(num_intervals);
+  std::vector<jlong> ends(num_intervals);
+  if(num_intervals > 0)
+  {
+    env->GetLongArrayRegion(column_begins, 0, num_intervals, &(begins[0]));
+    env->GetLongArrayRegion(column_ends, 0, num_intervals, &(ends[0]));
+  }
+  std::vector<ColumnRange> column_intervals(num_intervals);
+  for(auto i=0;i<num_intervals;++i)
+    column_intervals[i] = ColumnRange(begins[i], ends[i]);
+  bcf_reader_obj->reset_query_column_intervals(column_intervals);
+}
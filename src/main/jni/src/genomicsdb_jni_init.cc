@@ -22,6 +22,12 @@
 
 #include "jni_mpi_init.h"
 #include "genomicsdb_GenomicsDBUtils.h"
+#include "genomicsdb_jni_exception.h"
+#include "json_config.h"
+#include "query_variants.h"
+#include "variant_operations.h"
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw GenomicsDBJNIException(#X);
 
 JNIMpiInit g_jni_mpi_init;
 
@@ -31,3 +37,142 @@ JNIEXPORT jint JNICALL Java_com_intel_genomicsdb_GenomicsDBUtils_jniGenomicsDBOn
   g_jni_mpi_init.initialize();
   return 0;
 }
+
+//Partitions are returned as #cells, #ranges followed by the begin, end pairs of the ranges
+static void get_column_partitions_by_density(const std::string& loader_configuration_file,
+    const std::string& query_configuration_file, const int rank, const int num_partitions,
+    const size_t segment_size, std::vector<jlong>& result)
+{
+  VERIFY_OR_THROW(num_partitions > 0);
+  FileBasedVidMapper vid_mapper;
+  JSONLoaderConfig loader_config;
+  JSONLoaderConfig* loader_config_ptr = 0;
+  if(!(loader_configuration_file.empty()))
+  {
+    loader_config.read_from_file(loader_configuration_file, &vid_mapper, rank);
+    loader_config_ptr = &loader_config;
+  }
+  VariantQueryConfig query_config;
+  JSONBasicQueryConfig query_json_config;
+  query_json_config.read_from_file(query_configuration_file, query_config, &vid_mapper, rank, loader_config_ptr);
+  VariantQueryProcessor::apply_process_wide_settings(query_json_config, rank);
+  VariantQueryProcessor::initialize_auto_query_column_ranges(query_json_config, query_config, vid_mapper, rank);
+  //Only cell begin positions are needed - END is always queried
+  query_config.clear_attributes_to_query();
+  query_config.set_attributes_to_query(std::vector<std::string>{ "END" });
+  //Column range over which the histogram is computed - queried intervals or all contigs
+  int64_t begin_column = 0;
+  int64_t end_column = 0;
+  //Queried intervals, sorted by begin
+  std::vector<ColumnRange> query_intervals;
+  for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+    query_intervals.emplace_back(query_config.get_column_begin(i), query_config.get_column_end(i));
+  std::sort(query_intervals.begin(), query_intervals.end());
+  if(!query_intervals.empty())
+  {
+    begin_column = query_intervals.front().first;
+    for(const auto& interval : query_intervals)
+      end_column = std::max<int64_t>(end_column, interval.second);
+  }
+  else
+    for(auto i=0u;i<vid_mapper.get_num_contigs();++i)
+    {
+      const auto& contig_info = vid_mapper.get_contig_info(i);
+      end_column = std::max<int64_t>(end_column, contig_info.m_tiledb_column_offset+contig_info.m_length-1);
+    }
+  end_column = std::max<int64_t>(begin_column, end_column);
+  //~256 bins per partition is fine grained enough to balance partitions
+  auto bin_size = std::max<uint64_t>(1ull, (end_column-begin_column+1)/(256ull*num_partitions));
+  ColumnHistogramOperator histogram_op(begin_column, end_column, bin_size);
+  {
+    VariantStorageManager storage_manager(query_json_config.get_workspace(rank), segment_size);
+    storage_manager.set_iterator_memory_budget(query_json_config.get_iterator_memory_budget());
+    VariantQueryProcessor query_processor(&storage_manager, query_json_config.get_array_name(rank), vid_mapper);
+    //Histogram maintained by the loader in the array metadata avoids a full scan if it is fine grained enough
+    const auto& stored_histogram = storage_manager.get_column_histogram(query_processor.get_array_descriptor());
+    if(histogram_op.can_use_column_cell_histogram(stored_histogram, query_config))
+      histogram_op.add_column_cell_histogram(stored_histogram);
+    else
+    {
+      query_processor.do_query_bookkeeping(query_processor.get_array_schema(), query_config, vid_mapper, false);
+      auto num_intervals = std::max<unsigned>(1u, query_config.get_num_column_intervals());
+      for(auto i=0u;i<num_intervals;++i)
+        query_processor.iterate_over_cells(query_processor.get_array_descriptor(), query_config, histogram_op, i);
+    }
+    storage_manager.close_array(query_processor.get_array_descriptor());
+  }
+  std::vector<ColumnRange> column_ranges;
+  std::vector<uint64_t> num_cells;
+  if(!histogram_op.equi_partition_bins(num_partitions, column_ranges, num_cells))
+  {
+    //Fewer bins than partitions - single partition
+    column_ranges.assign(1u, ColumnRange(begin_column, end_column));
+    num_cells.assign(1u, 0ull);
+    for(auto val : histogram_op.get_bin_counts())
+      num_cells[0] += val;
+  }
+  //First and last bins also count cells outside [begin_column, end_column] when scanning the whole array
+  if(query_intervals.empty())
+  {
+    column_ranges.front().first = 0;
+    column_ranges.back().second = INT64_MAX-1;
+    query_intervals.emplace_back(0, INT64_MAX-1);
+  }
+  //Partitions cover gaps between queried intervals - each partition is restricted to the parts
+  //of the queried intervals it contains, so that the partitions together return exactly the
+  //same data as the query
+  result.clear();
+  for(auto i=0ull;i<column_ranges.size();++i)
+  {
+    auto header_idx = result.size();
+    result.push_back(num_cells[i]);
+    result.push_back(0);
+    for(const auto& interval : query_intervals)
+    {
+      auto begin = std::max<int64_t>(column_ranges[i].first, interval.first);
+      auto end = std::min<int64_t>(column_ranges[i].second, interval.second);
+      if(begin > end)
+        continue;
+      result.push_back(begin);
+      result.push_back(end);
+      ++(result[header_idx+1u]);
+    }
+    //Partition lies entirely in a gap
+    if(result[header_idx+1u] == 0)
+      result.resize(header_idx);
+  }
+}
+
+JNIEXPORT jlongArray JNICALL Java_com_intel_genomicsdb_GenomicsDBUtils_jniGetColumnPartitionsByDensity
+  (JNIEnv* env, jclass obj, jstring loader_configuration_file, jstring query_configuration_file,
+   jint rank, jint num_partitions, jlong segment_size)
+{
+  //Java string to char*
+  auto loader_configuration_file_cstr = env->GetStringUTFChars(loader_configuration_file, NULL);
+  VERIFY_OR_THROW(loader_configuration_file_cstr);
+  auto query_configuration_file_cstr = env->GetStringUTFChars(query_configuration_file, NULL);
+  VERIFY_OR_THROW(query_configuration_file_cstr);
+  std::string loader_configuration_file_str = loader_configuration_file_cstr;
+  std::string query_configuration_file_str = query_configuration_file_cstr;
+  env->ReleaseStringUTFChars(loader_configuration_file, loader_configuration_file_cstr);
+  env->ReleaseStringUTFChars(query_configuration_file, query_configuration_file_cstr);
+  std::vector<jlong> result;
+  //C++ exceptions must not cross the JNI boundary - raise GenomicsDBException in the JVM instead
+  try
+  {
+    get_column_partitions_by_density(loader_configuration_file_str, query_configuration_file_str,
+        rank, num_partitions, segment_size, result);
+  }
+  catch(const std::exception& e)
+  {
+    auto exception_class = env->FindClass("com/intel/genomicsdb/GenomicsDBException");
+    if(exception_class)
+      env->ThrowNew(exception_class, e.what());
+    return 0;
+  }
+  auto java_result = env->NewLongArray(result.size());
+  VERIFY_OR_THROW(java_result);
+  if(!result.empty())
+    env->SetLongArrayRegion(java_result, 0, result.size(), &(result[0]));
+  return java_result;
+}
@@ -0,0 +1,118 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+package com.intel.genomicsdb;
+
+import htsjdk.tribble.CloseableTribbleIterator;
+import htsjdk.tribble.readers.LineIterator;
+import htsjdk.variant.variantcontext.VariantContext;
+import htsjdk.variant.vcf.VCFCodec;
+import org.apache.commons.io.FileUtils;
+import org.testng.Assert;
+import org.testng.annotations.AfterClass;
+import org.testng.annotations.BeforeClass;
+import org.testng.annotations.Test;
+
+import java.io.File;
+import java.io.IOException;
+
+public final class GenomicsDBFeatureReaderSpec {
+
+  private static final File WORKSPACE = new File("__feature_reader_workspace");
+  private static final String TILEDB_ARRAYNAME = "feature_reader_test_array";
+  private static final File VID_JSON_FILE = new File("feature_reader_vidmap.json");
+  private static final File CALLSET_JSON_FILE = new File("feature_reader_callsetmap.json");
+
+  @BeforeClass
+  public void importArray() throws IOException {
+    GenomicsDBTestUtils.importTestArray(WORKSPACE, TILEDB_ARRAYNAME, VID_JSON_FILE, CALLSET_JSON_FILE);
+  }
+
+  private GenomicsDBFeatureReader<VariantContext, LineIterator> createReader() throws IOException {
+    return new GenomicsDBFeatureReader<>(VID_JSON_FILE.getAbsolutePath(),
+      CALLSET_JSON_FILE.getAbsolutePath(), WORKSPACE.getAbsolutePath(), TILEDB_ARRAYNAME,
+      GenomicsDBTestUtils.REFERENCE_GENOME, GenomicsDBTestUtils.TEMPLATE_VCF_HEADER, new VCFCodec());
+  }
+
+  private static int countRecords(CloseableTribbleIterator<VariantContext> iterator) {
+    int numRecords = 0;
+    while (iterator.hasNext()) {
+      iterator.next();
+      ++numRecords;
+    }
+    iterator.close();
+    return numRecords;
+  }
+
+  @Test(testName = "iterator obtained from the reader session outlives reader close")
+  public void testReaderCloseWithOpenRequeryStream() throws IOException {
+    GenomicsDBFeatureReader<VariantContext, LineIterator> expectedReader = createReader();
+    int expectedNumRecords = countRecords(expectedReader.query("1", 1, 249250619));
+    expectedReader.close();
+    Assert.assertTrue(expectedNumRecords > 0);
+
+    GenomicsDBFeatureReader<VariantContext, LineIterator> reader = createReader();
+    //Re-uses the native session of the reader
+    CloseableTribbleIterator<VariantContext> iterator = reader.query("1", 1, 249250619);
+    reader.close();
+    Assert.assertEquals(countRecords(iterator), expectedNumRecords);
+  }
+
+  @Test(testName = "session stream rejects requery after close")
+  public void testSessionClosedWhileRequeryStreamOpen() throws IOException {
+    GenomicsDBQueryStream session = new GenomicsDBQueryStream("", createQueryJSON(), false, true);
+    GenomicsDBQueryStream stream = session.requeryColumns(new long[] { 0 }, new long[] { 1000000000 });
+    session.close();
+    try {
+      session.requeryColumns(new long[] { 0 }, new long[] { 1000000000 });
+      Assert.fail("requery on a closed session must fail");
+    } catch (IOException e) {
+      //expected
+    }
+    //Native state is still valid
+    Assert.assertTrue(stream.read(new byte[1024], 0, 1024) > 0);
+    stream.close();
+  }
+
+  private String createQueryJSON() throws IOException {
+    File queryJSONFile = File.createTempFile("feature_reader_query", ".json");
+    queryJSONFile.deleteOnExit();
+    String queryJSON = "{\n"
+      + "\"scan_full\": true,\n"
+      + "\"workspace\": \"" + WORKSPACE.getAbsolutePath() + "\",\n"
+      + "\"array\": \"" + TILEDB_ARRAYNAME + "\",\n"
+      + "\"vid_mapping_file\": \"" + VID_JSON_FILE.getAbsolutePath() + "\",\n"
+      + "\"callset_mapping_file\": \"" + CALLSET_JSON_FILE.getAbsolutePath() + "\",\n"
+      + "\"reference_genome\": \"" + GenomicsDBTestUtils.REFERENCE_GENOME + "\",\n"
+      + "\"vcf_header_filename\": \"" + GenomicsDBTestUtils.TEMPLATE_VCF_HEADER + "\"\n"
+      + "}\n";
+    FileUtils.writeStringToFile(queryJSONFile, queryJSON);
+    return queryJSONFile.getAbsolutePath();
+  }
+
+  @AfterClass
+  public void deleteWorkspace() throws IOException {
+    FileUtils.deleteDirectory(WORKSPACE);
+    FileUtils.deleteQuietly(VID_JSON_FILE);
+    FileUtils.deleteQuietly(CALLSET_JSON_FILE);
+  }
+}
@@ -0,0 +1,152 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+package com.intel.genomicsdb;
+
+import htsjdk.variant.variantcontext.VariantContext;
+import org.apache.commons.io.FileUtils;
+import org.apache.hadoop.conf.Configuration;
+import org.apache.hadoop.mapreduce.InputSplit;
+import org.apache.hadoop.mapreduce.RecordReader;
+import org.testng.Assert;
+import org.testng.annotations.AfterClass;
+import org.testng.annotations.BeforeClass;
+import org.testng.annotations.Test;
+
+import java.io.File;
+import java.io.IOException;
+import java.util.Arrays;
+import java.util.List;
+
+public final class GenomicsDBInputFormatSpec {
+
+  private static final File WORKSPACE = new File("__input_format_workspace");
+  private static final String TILEDB_ARRAYNAME = "input_format_test_array";
+  private static final File VID_JSON_FILE = new File("input_format_vidmap.json");
+  private static final File CALLSET_JSON_FILE = new File("input_format_callsetmap.json");
+  private static final File HOST_FILE = new File("input_format_hosts");
+  private static final int NUM_SPLITS = 4;
+
+  @BeforeClass
+  public void importArray() throws IOException {
+    GenomicsDBTestUtils.importTestArray(WORKSPACE, TILEDB_ARRAYNAME, VID_JSON_FILE, CALLSET_JSON_FILE);
+    FileUtils.writeStringToFile(HOST_FILE, "localhost\n");
+  }
+
+  // The test VCFs have a single variant at column 8029499 (1:8029500)
+  private File createQueryJSON(final String columnRanges) throws IOException {
+    File queryJSONFile = File.createTempFile("input_format_query", ".json");
+    queryJSONFile.deleteOnExit();
+    String queryJSON = "{\n"
+      + "\"query_column_ranges\": [ " + columnRanges + " ],\n"
+      + "\"workspace\": \"" + WORKSPACE.getAbsolutePath() + "\",\n"
+      + "\"array\": \"" + TILEDB_ARRAYNAME + "\",\n"
+      + "\"vid_mapping_file\": \"" + VID_JSON_FILE.getAbsolutePath() + "\",\n"
+      + "\"callset_mapping_file\": \"" + CALLSET_JSON_FILE.getAbsolutePath() + "\",\n"
+      + "\"reference_genome\": \"" + new File(GenomicsDBTestUtils.REFERENCE_GENOME).getAbsolutePath() + "\",\n"
+      + "\"vcf_header_filename\": \"" + new File(GenomicsDBTestUtils.TEMPLATE_VCF_HEADER).getAbsolutePath() + "\"\n"
+      + "}\n";
+    FileUtils.writeStringToFile(queryJSONFile, queryJSON);
+    return queryJSONFile;
+  }
+
+  private static boolean isInsideIntervals(final long begin, final long end, final long[][] intervals) {
+    for (long[] interval : intervals)
+      if (begin >= interval[0] && end <= interval[1])
+        return true;
+    return false;
+  }
+
+  // Returns the number of records produced by all splits
+  @SuppressWarnings("unchecked")
+  private int checkSplits(final long[][] intervals) throws IOException, InterruptedException {
+    StringBuilder columnRanges = new StringBuilder("[ ");
+    for (int i = 0; i < intervals.length; ++i)
+      columnRanges.append(i > 0 ? ", " : "").append("[").append(intervals[i][0]).append(", ")
+        .append(intervals[i][1]).append("]");
+    columnRanges.append(" ]");
+    File queryJSONFile = createQueryJSON(columnRanges.toString());
+    Configuration configuration = new Configuration();
+    configuration.set(GenomicsDBConfiguration.LOADERJSON, "");
+    configuration.set(GenomicsDBConfiguration.QUERYJSON, queryJSONFile.getAbsolutePath());
+    configuration.set(GenomicsDBConfiguration.MPIHOSTFILE, HOST_FILE.getAbsolutePath());
+    configuration.setInt(GenomicsDBConfiguration.NUM_SPLITS, NUM_SPLITS);
+    GenomicsDBInputFormat<VariantContext, Object> inputFormat = new GenomicsDBInputFormat<>();
+    inputFormat.setConf(configuration);
+    List<InputSplit> splits = inputFormat.getSplits(null);
+    Assert.assertFalse(splits.isEmpty());
+    int numRecords = 0;
+    for (InputSplit inputSplit : splits) {
+      GenomicsDBInputSplit split = (GenomicsDBInputSplit) inputSplit;
+      Assert.assertTrue(split.hasColumnRanges());
+      Assert.assertEquals(split.getLocations(), new String[] { "localhost" });
+      // Splits never extend into the gaps between the queried intervals
+      for (int i = 0; i < split.getColumnBegins().length; ++i)
+        Assert.assertTrue(isInsideIntervals(split.getColumnBegins()[i], split.getColumnEnds()[i], intervals));
+      RecordReader<String, VariantContext> recordReader = inputFormat.createRecordReader(split, null);
+      recordReader.initialize(split, null);
+      while (recordReader.nextKeyValue()) {
+        VariantContext variant = recordReader.getCurrentValue();
+        Assert.assertTrue(isInsideIntervals(variant.getStart()-1, variant.getStart()-1, intervals));
+        ++numRecords;
+      }
+      recordReader.close();
+    }
+    return numRecords;
+  }
+
+  @Test(testName = "density based splits are restricted to the queried intervals")
+  public void testSplitsExcludeGapsBetweenIntervals() throws IOException, InterruptedException {
+    // Variant lies in the gap between the intervals
+    Assert.assertEquals(checkSplits(new long[][] { { 0, 1000 }, { 9000000, 9100000 } }), 0);
+    // Variant lies in the second interval
+    Assert.assertTrue(checkSplits(new long[][] { { 0, 1000 }, { 8029000, 8030000 } }) > 0);
+  }
+
+  @Test(testName = "density based splits prefer the host holding their columns")
+  public void testPreferredHosts() {
+    List<String> hosts = Arrays.asList("host0", "host1", "host2");
+    long[] loaderPartitionBegins = new long[] { 0, 1000, 5000 };
+    // Mostly inside the second partition
+    Assert.assertEquals(GenomicsDBInputFormat.getPreferredHost(new long[] { 900, 2000 },
+      new long[] { 1100, 4000 }, loaderPartitionBegins, hosts, 0, 4), "host1");
+    // Last partition extends to the end of the array
+    Assert.assertEquals(GenomicsDBInputFormat.getPreferredHost(new long[] { 4990 },
+      new long[] { 1000000 }, loaderPartitionBegins, hosts, 0, 4), "host2");
+    // Partitions listed out of column order still map rank i to host i
+    Assert.assertEquals(GenomicsDBInputFormat.getPreferredHost(new long[] { 10 },
+      new long[] { 20 }, new long[] { 5000, 0, 1000 }, hosts, 3, 4), "host1");
+    // Without loader partitions, splits are spread over the hosts in order
+    String[] expected = new String[] { "host0", "host0", "host1", "host2" };
+    for (int i = 0; i < expected.length; ++i)
+      Assert.assertEquals(GenomicsDBInputFormat.getPreferredHost(new long[] { i },
+        new long[] { i }, null, hosts, i, expected.length), expected[i]);
+  }
+
+  @AfterClass
+  public void deleteWorkspace() throws IOException {
+    FileUtils.deleteDirectory(WORKSPACE);
+    FileUtils.deleteQuietly(VID_JSON_FILE);
+    FileUtils.deleteQuietly(CALLSET_JSON_FILE);
+    FileUtils.deleteQuietly(HOST_FILE);
+  }
+}
@@ -27,11 +27,17 @@ import htsjdk.tribble.FeatureReader;
 import htsjdk.variant.variantcontext.VariantContext;
 import htsjdk.variant.vcf.VCFCodec;
 import htsjdk.variant.vcf.VCFHeader;
+import htsjdk.variant.vcf.VCFHeaderLine;
+import htsjdk.variant.vcf.VCFUtils;
 import org.testng.annotations.DataProvider;
 
 import java.io.File;
+import java.io.IOException;
+import java.util.ArrayList;
 import java.util.HashMap;
+import java.util.List;
 import java.util.Map;
+import java.util.Set;
 
 public final class GenomicsDBTestUtils {
 
@@ -62,4 +68,30 @@ public final class GenomicsDBTestUtils {
 
     return new Object[][] {{ sampleToReaderMap }};
   }
+
+  public static final String REFERENCE_GENOME = "tests/inputs/chr1_10MB.fasta.gz";
+  public static final String TEMPLATE_VCF_HEADER = "tests/inputs/template_vcf_header.vcf";
+
+  /**
+   * Imports t6, t7 and t8 into a new array and writes the vid and callset mapping files
+   * needed to query it
+   */
+  @SuppressWarnings("unchecked")
+  public static void importTestArray(final File workspace, final String arrayName,
+      final File vidMappingFile, final File callsetMappingFile) throws IOException {
+    Map<String, FeatureReader<VariantContext>> sampleToReaderMap =
+      (Map<String, FeatureReader<VariantContext>>) vcfFiles()[0][0];
+    List<VCFHeader> headers = new ArrayList<>();
+    for (FeatureReader<VariantContext> reader : sampleToReaderMap.values())
+      headers.add((VCFHeader) reader.getHeader());
+    Set<VCFHeaderLine> mergedHeader = VCFUtils.smartMergeHeaders(headers, true);
+    GenomicsDBCallsetsMapProto.CallsetMappingPB callsetMappingPB =
+      GenomicsDBImporter.generateSortedCallSetMap(sampleToReaderMap, true, false);
+    GenomicsDBImporter importer = new GenomicsDBImporter(sampleToReaderMap, mergedHeader,
+      new ChromosomeInterval("1", 1, 249250619), workspace.getAbsolutePath(), arrayName,
+      1024L, 10000000L);
+    importer.importBatch();
+    GenomicsDBImporter.writeVidMapJSONFile(vidMappingFile.getAbsolutePath(), mergedHeader);
+    GenomicsDBImporter.writeCallsetMapJSONFile(callsetMappingFile.getAbsolutePath(), callsetMappingPB);
+  }
 }
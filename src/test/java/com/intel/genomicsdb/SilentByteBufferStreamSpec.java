@@ -0,0 +1,71 @@
+/*
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of
+ * this software and associated documentation files (the "Software"), to deal in
+ * the Software without restriction, including without limitation the rights to
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of
+ * the Software, and to permit persons to whom the Software is furnished to do so,
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+ */
+
+package com.intel.genomicsdb;
+
+import org.testng.Assert;
+import org.testng.annotations.Test;
+
+import java.io.IOException;
+import java.nio.ByteBuffer;
+
+public final class SilentByteBufferStreamSpec {
+
+  @Test(testName = "buffer streams hand direct buffers to the native layer")
+  public void testDirectBuffer() throws IOException {
+    SilentByteBufferStream stream = new SilentByteBufferStream(4);
+    Assert.assertTrue(stream.getBuffer().isDirect());
+    stream.write(new byte[] { 1, 2, 3 });
+    Assert.assertEquals(stream.getNumValidBytes(), 3);
+    Assert.assertFalse(stream.overflow());
+  }
+
+  @Test(testName = "buffer streams overflow silently and keep their contents")
+  public void testOverflow() throws IOException {
+    SilentByteBufferStream stream = new SilentByteBufferStream(4);
+    stream.write(new byte[] { 1, 2, 3 });
+    stream.write(new byte[] { 4, 5 });
+    Assert.assertTrue(stream.overflow());
+    Assert.assertEquals(stream.getNumValidBytes(), 3);
+    stream.write(6);
+    Assert.assertEquals(stream.getNumValidBytes(), 3);
+    ByteBuffer buffer = stream.getBuffer();
+    for (int i = 0; i < 3; ++i)
+      Assert.assertEquals(buffer.get(i), (byte) (i + 1));
+  }
+
+  @Test(testName = "resized buffer streams stay direct and keep their contents")
+  public void testResize() throws IOException {
+    SilentByteBufferStream stream = new SilentByteBufferStream(4);
+    stream.write(new byte[] { 1, 2, 3, 4 });
+    stream.resize(2 * stream.size() + 1);
+    Assert.assertEquals(stream.size(), 9);
+    Assert.assertTrue(stream.getBuffer().isDirect());
+    stream.setOverflow(false);
+    stream.write(new byte[] { 5, 6, 7, 8, 9 });
+    Assert.assertFalse(stream.overflow());
+    Assert.assertEquals(stream.getNumValidBytes(), 9);
+    ByteBuffer buffer = stream.getBuffer();
+    for (int i = 0; i < 9; ++i)
+      Assert.assertEquals(buffer.get(i), (byte) (i + 1));
+  }
+}
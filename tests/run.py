@@ -27,6 +27,7 @@ import hashlib
 import os
 import sys
 import shutil
+import struct
 from collections import OrderedDict
 
 query_json_template_string="""
@@ -48,12 +49,24 @@ def create_query_json(ws_dir, test_name, query_param_dict):
     test_dict["workspace"] = ws_dir
     test_dict["array"] = test_name
     test_dict["query_column_ranges"] = [ [ query_param_dict["query_column_ranges"] ] ]
+    if("query_row_ranges" in query_param_dict):
+        test_dict["query_row_ranges"] = [ query_param_dict["query_row_ranges"] ];
+    if("sparse_row_map_ratio" in query_param_dict):
+        test_dict["sparse_row_map_ratio"] = query_param_dict["sparse_row_map_ratio"];
     if("vid_mapping_file" in query_param_dict):
         test_dict["vid_mapping_file"] = query_param_dict["vid_mapping_file"];
     if("callset_mapping_file" in query_param_dict):
         test_dict["callset_mapping_file"] = query_param_dict["callset_mapping_file"];
     if("query_attributes" in query_param_dict):
         test_dict["query_attributes"] = query_param_dict["query_attributes"];
+    if("tile_cache" in query_param_dict):
+        test_dict["tile_cache"] = query_param_dict["tile_cache"];
+    if("variant_sites_only" in query_param_dict):
+        test_dict["variant_sites_only"] = query_param_dict["variant_sites_only"];
+    if("query_filters" in query_param_dict):
+        test_dict["query_filters"] = query_param_dict["query_filters"];
+    if("iterator_memory_budget" in query_param_dict):
+        test_dict["iterator_memory_budget"] = query_param_dict["iterator_memory_budget"];
     return test_dict;
 
 
@@ -85,8 +98,14 @@ def create_loader_json(ws_dir, test_name, test_params_dict):
     test_dict=json.loads(loader_json_template_string);
     if('column_partitions' in test_params_dict):
         test_dict['column_partitions'] = test_params_dict['column_partitions'];
-    test_dict["column_partitions"][0]["workspace"] = ws_dir;
-    test_dict["column_partitions"][0]["array"] = test_name;
+    if('num_auto_column_partitions' in test_params_dict):
+        test_dict['column_partitions'] = "auto";
+        test_dict['num_column_partitions'] = test_params_dict['num_auto_column_partitions'];
+        test_dict['workspace'] = ws_dir;
+        test_dict['array'] = test_name;
+    else:
+        test_dict["column_partitions"][0]["workspace"] = ws_dir;
+        test_dict["column_partitions"][0]["array"] = test_name;
     test_dict["callset_mapping_file"] = test_params_dict['callset_mapping_file'];
     if('vid_mapping_file' in test_params_dict):
         test_dict['vid_mapping_file'] = test_params_dict['vid_mapping_file'];
@@ -106,6 +125,86 @@ def print_diff(golden_output, test_output):
     print(test_output);
     print("=======END=======");
 
+#Calls of all query intervals as (row, interval, fields) tuples
+def get_flattened_calls(calls_dict):
+    return [ (call['row'], call['interval'], call['fields']) for interval_dict in calls_dict['variant_calls']
+        if 'variant_calls' in interval_dict for call in interval_dict['variant_calls'] ];
+
+#Floats may be printed with different precisions
+def json_values_match(x, y):
+    if(isinstance(x, float) or isinstance(y, float)):
+        return abs(x-y) <= 1e-4*max(1.0, abs(x), abs(y));
+    if(isinstance(x, (list, tuple)) and isinstance(y, (list, tuple))):
+        return len(x) == len(y) and all([ json_values_match(a, b) for a, b in zip(x, y) ]);
+    if(isinstance(x, dict) and isinstance(y, dict)):
+        return sorted(x.keys()) == sorted(y.keys()) and all([ json_values_match(x[key], y[key]) for key in x ]);
+    return x == y;
+
+#Two character operators must be matched first
+query_filter_operators = [ ('>=', lambda x,y: x >= y), ('<=', lambda x,y: x <= y), ('==', lambda x,y: x == y),
+        ('!=', lambda x,y: x != y), ('>', lambda x,y: x > y), ('<', lambda x,y: x < y) ];
+
+#Numeric filters compare the first element of the field, missing fields never pass
+def passes_query_filters(call_fields, query_filters):
+    filter_list = query_filters if isinstance(query_filters, list) else query_filters.split('&&');
+    for expression in filter_list:
+        for op_string, op in query_filter_operators:
+            if(expression.find(op_string) != -1):
+                field_name, value = [ token.strip() for token in expression.split(op_string, 1) ];
+                break;
+        if(field_name not in call_fields or not op(call_fields[field_name][0], float(value))):
+            return False;
+    return True;
+
+#Expected output derived from the golden output of the unrestricted query
+def get_derived_golden_output(query_type, golden_output, query_param_dict):
+    #Variant sites only scans drop records covered only by reference blocks - records with real ALT alleles
+    #or spanning deletions remain
+    if(query_type.find('vcf') != -1 and "variant_sites_only" in query_param_dict
+            and query_param_dict["variant_sites_only"]):
+        return ''.join([ line for line in golden_output.splitlines(True) if line.startswith('#')
+            or line.split('\t')[4] != '<NON_REF>' ]);
+    #Filtered calls are dropped - printed calls are compared as JSON objects
+    if(query_type == 'calls' and "query_filters" in query_param_dict):
+        golden_dict = json.loads(golden_output);
+        for interval_dict in golden_dict['variant_calls']:
+            if('variant_calls' in interval_dict):
+                interval_dict['variant_calls'] = [ call for call in interval_dict['variant_calls']
+                    if passes_query_filters(call['fields'], query_param_dict["query_filters"]) ];
+        return golden_dict;
+    return golden_output;
+
+#Genotype matrix code of a call - (#alleles, #non-ref alleles) encoded as in genotype_matrix.h
+def get_genotype_matrix_code(GT, encoding_bits):
+    missing = 3 if encoding_bits == 2 else 255;
+    if(not GT or any([ not isinstance(allele, int) or allele < 0 for allele in GT ])):
+        return missing;
+    num_non_ref_alleles = len([ allele for allele in GT if allele > 0 ]);
+    if(encoding_bits == 8):
+        return min(num_non_ref_alleles, 254);
+    return 0 if num_non_ref_alleles == 0 else (2 if num_non_ref_alleles == len(GT) else 1);
+
+#Sites are columns where some call begins with a non-ref GT. At a site, a sample's own call gives its
+#code, a hom-ref call spanning the site gives hom-ref and every other sample is missing
+def get_golden_genotype_matrix(calls_dict, encoding_bits, sample_rows):
+    missing = 3 if encoding_bits == 2 else 255;
+    sites = [];
+    for interval_dict in calls_dict['variant_calls']:
+        begin, end = interval_dict['query_interval'];
+        calls = interval_dict.get('variant_calls', []);
+        site_columns = sorted(set([ call['interval'][0] for call in calls if begin <= call['interval'][0] <= end
+            and get_genotype_matrix_code(call['fields'].get('GT'), encoding_bits) not in (0, missing) ]));
+        for column in site_columns:
+            codes = [ missing ]*len(sample_rows);
+            for call in calls:
+                code = get_genotype_matrix_code(call['fields'].get('GT'), encoding_bits);
+                if(call['interval'][0] == column):
+                    codes[sample_rows.index(call['row'])] = code;
+                elif(call['interval'][0] < column and call['interval'][1] >= column and code == 0):
+                    codes[sample_rows.index(call['row'])] = 0;
+            sites.append([ column, codes ]);
+    return sites;
+
 def cleanup_and_exit(tmpdir, exit_code):
     if(exit_code == 0):
         shutil.rmtree(tmpdir, ignore_errors=True)
@@ -132,6 +231,26 @@ def main():
     loader_tests = [
             { "name" : "t0_1_2", 'golden_output' : 'golden_outputs/t0_1_2_loading',
                 'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                #Paged queries resumed from cursors, block serialization round trips
+                #Calls exported as columnar batches of these sizes must match the golden calls
+                'columnar_batch_sizes': [ 1, 2, 1048576 ],
+                #Streaming gather - (#MPI processes, gt_mpi_gather args), root skips the query
+                #Merged ALT alleles must match those of the original unordered_map based merge at every site
+                'check_merge_alt_alleles': True,
+                'check_column_histogram': True,
+                #Genotype matrices of both encodings must match the GT values of the golden calls
+                'check_genotype_matrix': True,
+                #Concurrent VariantQueryService requests must match the serial query
+                'check_variant_query_service': True,
+                'streaming_gather_params': [ (2, '--streaming-gather-chunk-size 1 -p 1'),
+                    (3, '--streaming-gather-chunk-size 1 -p 2'),
+                    (3, '--streaming-gather-chunk-size 1048576 --compress-serialized-variants') ],
+                'equivalent_driver_args': [ '-p 1', '-p 2', '-p 3',
+                    '--test-block-serialization 1', '--test-block-serialization 2:zlib',
+                    '--test-block-serialization 1024:zlib' ],
+                #Row subset queried with the dense (ratio 0) and the sparse (ratio 1) row maps
+                'row_map_query_params': { "query_column_ranges" : [0, 1000000000],
+                    "query_row_ranges": [ [0, 0], [2, 2] ] },
                 "query_params": [
                     { "query_column_ranges" : [0, 1000000000], "golden_output": {
                         "calls"      : "golden_outputs/t0_1_2_calls_at_0",
@@ -157,6 +276,49 @@ def main():
                         "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
                         "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
                         "java_vcf"   : "golden_outputs/java_t0_1_2_vcf_at_12150",
+                        } },
+                    #Tile cache on - narrow tiles so that queries span several cached tiles
+                    { "query_column_ranges" : [0, 1000000000],
+                        "tile_cache": { "size": 16777216, "tile_width": 1000 }, "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_0",
+                        "java_vcf"   : "golden_outputs/java_t0_1_2_vcf_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000],
+                        "tile_cache": { "size": 16777216, "tile_width": 1000 }, "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_12150",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_12150",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
+                        "java_vcf"   : "golden_outputs/java_t0_1_2_vcf_at_12150",
+                        } },
+                    #Variant sites only - scans skip reference blocks, cell iteration is unaffected
+                    { "query_column_ranges" : [0, 1000000000], "variant_sites_only": True, "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        }, "derived_golden_output": {
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000], "variant_sites_only": True,
+                        "derived_golden_output": {
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
+                        } },
+                    #Filters pushed down to the cells - calls that fail a filter are not printed
+                    { "query_column_ranges" : [0, 1000000000], "query_filters": "GQ>=20",
+                        "derived_golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        } },
+                    { "query_column_ranges" : [0, 1000000000], "query_filters": [ "GQ<20", "DP_FORMAT>2" ],
+                        "derived_golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000], "query_filters": "DP_FORMAT>=2 && GQ!=0",
+                        "derived_golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_12150",
                         } }
                     ]
             },
@@ -185,15 +347,34 @@ def main():
                     { "query_column_ranges" : [12202, 1000000000], "golden_output": {
                         "vcf"        : "golden_outputs/t0_overlapping_at_12202",
                         }
+                    },
+                    { "query_column_ranges" : [12202, 1000000000], "variant_sites_only": True,
+                        "derived_golden_output": {
+                        "vcf"        : "golden_outputs/t0_overlapping_at_12202",
+                        }
                     }
                 ]
             },
+            #The reference block of HG01958 spans the variants of HG00141 - variant sites only scans must
+            #still report HG01958 as hom-ref at those sites, like the unrestricted query
+            { "name" : "t0_overlapping_t1",
+                'callset_mapping_file': 'inputs/callsets/t0_overlapping_t1.json',
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "variant_sites_only": True,
+                        "unrestricted_derived_output": [ "vcf", "batched_vcf" ] }
+                ]
+            },
             { "name" : "t0_overlapping_at_12202", 'golden_output': 'golden_outputs/t0_overlapping_at_12202',
                 'callset_mapping_file': 'inputs/callsets/t0_overlapping.json',
                 'column_partitions': [ {"begin": 12202, "workspace":"", "array": "" }]
             },
             { "name" : "t6_7_8", 'golden_output' : 'golden_outputs/t6_7_8_loading',
                 'callset_mapping_file': 'inputs/callsets/t6_7_8.json',
+                'columnar_batch_sizes': [ 3, 1048576 ],
+                'streaming_gather_params': [ (3, '--streaming-gather-chunk-size 64 -p 3') ],
+                'check_merge_alt_alleles': True,
+                'check_column_histogram': True,
+                'check_genotype_matrix': True,
                 "query_params": [
                     { "query_column_ranges" : [0, 1000000000], "golden_output": {
                         "calls"      : "golden_outputs/t6_7_8_calls_at_0",
@@ -251,6 +432,19 @@ def main():
                         } }
                     ]
             },
+            #Tiny direct buffers - every record overflows and grows the buffer or waits for the next batch
+            { "name" : "java_buffer_stream_t0_1_2_small_buffers", 'golden_output' : 'golden_outputs/t0_1_2_loading',
+                'callset_mapping_file': 'inputs/callsets/t0_1_2_buffer.json',
+                'stream_name_to_filename_mapping': 'inputs/callsets/t0_1_2_buffer_mapping.json',
+                'buffer_capacity': 16,
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    ]
+            },
             { "name" : "java_buffer_stream_multi_contig_t0_1_2", 'golden_output' : 'golden_outputs/t0_1_2_loading',
                 'callset_mapping_file': 'inputs/callsets/t0_1_2_buffer.json',
                 'stream_name_to_filename_mapping': 'inputs/callsets/t0_1_2_buffer_mapping.json',
@@ -349,6 +543,37 @@ def main():
                         } },
                     ]
             },
+            { "name" : "t0_1_2_auto_partitions", 'golden_output' : 'golden_outputs/t0_1_2_loading',
+                'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                'num_auto_column_partitions': 1,
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    ]
+            },
+            #Writer buffers smaller than a cell - buffers are re-split after every flush and grown for
+            #oversize cells. Queries split a small iterator budget among the attributes
+            { "name" : "t0_1_2_tiny_buffers", 'golden_output' : 'golden_outputs/t0_1_2_loading',
+                'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+                'segment_size': 4,
+                "query_params": [
+                    { "query_column_ranges" : [0, 1000000000], "iterator_memory_budget": 2048, "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_0",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_0",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_0",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_0",
+                        } },
+                    { "query_column_ranges" : [12150, 1000000000], "iterator_memory_budget": 2048, "golden_output": {
+                        "calls"      : "golden_outputs/t0_1_2_calls_at_12150",
+                        "variants"   : "golden_outputs/t0_1_2_variants_at_12150",
+                        "vcf"        : "golden_outputs/t0_1_2_vcf_at_12150",
+                        "batched_vcf": "golden_outputs/t0_1_2_vcf_at_12150",
+                        } },
+                    ]
+            },
             { "name" : "t0_1_2_as_array", 'golden_output' : 'golden_outputs/t0_1_2_loading',
                 'callset_mapping_file': 'inputs/callsets/t0_1_2_as_array.json',
                 "vid_mapping_file": "inputs/vid_as_array.json",
@@ -360,7 +585,7 @@ def main():
         if(test_name == "t0_1_2"):
             test_loader_dict["compress_tiledb_array"] = True;
         loader_json_filename = tmpdir+os.path.sep+test_name+'.json'
-        test_loader_dict['segment_size'] = load_segment_size;
+        test_loader_dict['segment_size'] = test_params_dict.get('segment_size', load_segment_size);
         with open(loader_json_filename, 'wb') as fptr:
             json.dump(test_loader_dict, fptr, indent=4, separators=(',', ': '));
             fptr.close();
@@ -372,9 +597,11 @@ def main():
                     +test_params_dict['stream_name_to_filename_mapping']
                     +' 1024 0 0 100 true ',
                     shell=True, stdout=subprocess.PIPE);
-        elif(test_name == 'java_buffer_stream_t0_1_2'):
+        elif(test_name.find('java_buffer_stream_t0_1_2') == 0):
+            buffer_capacity_argument = ' '+str(test_params_dict['buffer_capacity']) if 'buffer_capacity' in test_params_dict \
+                    else '';
             pid = subprocess.Popen('java -ea TestBufferStreamGenomicsDBImporter '+loader_json_filename
-                    +' '+test_params_dict['stream_name_to_filename_mapping'],
+                    +' '+test_params_dict['stream_name_to_filename_mapping']+buffer_capacity_argument,
                     shell=True, stdout=subprocess.PIPE);
         elif(test_name.find('java_genomicsdb_importer_from_vcfs') != -1):
             arg_list = ' -L '+test_params_dict['chromosome_interval'] + ' -w ' + ws_dir + ' -A '+test_name \
@@ -400,6 +627,95 @@ def main():
                 sys.stderr.write('Loader stdout mismatch for test: '+test_name+'\n');
                 print_diff(golden_stdout, stdout_string);
                 cleanup_and_exit(tmpdir, -1);
+        #Queries must re-use the partitions stored by the loader, even though the loader JSON passed
+        #with -l has delete_and_create_tiledb_array set
+        if('num_auto_column_partitions' in test_params_dict):
+            column_partitions_filename = ws_dir+os.path.sep+test_name+'.column_partitions.json';
+            if(not os.path.isfile(column_partitions_filename)):
+                sys.stderr.write('Column partitions not stored by loader test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            stored_partitions, stored_partitions_md5sum = get_file_content_and_md5sum(column_partitions_filename);
+            stored_partitions_mtime = os.path.getmtime(column_partitions_filename);
+        #Multi-page GA4GH queries (resumed from paging cursors) and variants read back from serialized blocks
+        #must match the variants of an unpaged query
+        if('equivalent_driver_args' in test_params_dict):
+            vid_mapping_file = test_params_dict['vid_mapping_file'] if 'vid_mapping_file' in test_params_dict \
+                    else 'inputs/vid.json';
+            driver_query_cmd = exe_path+os.path.sep+'example_libtiledb_variant_driver -V '+vid_mapping_file \
+                    +' '+ws_dir+' '+test_name+' 0 1000000000';
+            pid = subprocess.Popen(driver_query_cmd, shell=True, stdout=subprocess.PIPE);
+            unpaged_stdout_string = pid.communicate()[0]
+            if(pid.returncode != 0 or len(unpaged_stdout_string) == 0):
+                sys.stderr.write('Unpaged GA4GH query failed in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            for driver_args in test_params_dict['equivalent_driver_args']:
+                pid = subprocess.Popen(driver_query_cmd+' '+driver_args, shell=True, stdout=subprocess.PIPE);
+                stdout_string = pid.communicate()[0]
+                if(pid.returncode != 0 or stdout_string != unpaged_stdout_string):
+                    sys.stderr.write('GA4GH query with arguments "'+driver_args
+                            +'" does not match the unpaged query in test: '+test_name+'\n');
+                    print_diff(unpaged_stdout_string, stdout_string);
+                    cleanup_and_exit(tmpdir, -1);
+        #Queries over a subset of rows must not depend on the array row -> query row map used
+        if('row_map_query_params' in test_params_dict):
+            for query_type,cmd_line_param in [ ('calls','--print-calls'), ('variants',''), ('vcf','--produce-Broad-GVCF') ]:
+                row_map_stdout_strings = [];
+                for sparse_row_map_ratio in [ 0, 1 ]:
+                    row_map_query_param_dict = dict(test_params_dict['row_map_query_params']);
+                    row_map_query_param_dict["sparse_row_map_ratio"] = sparse_row_map_ratio;
+                    test_query_dict = create_query_json(ws_dir, test_name, row_map_query_param_dict);
+                    if(query_type == 'vcf'):
+                        test_query_dict['query_attributes'] = vcf_query_attributes_order;
+                    query_json_filename = tmpdir+os.path.sep+test_name+'_row_map_'+str(sparse_row_map_ratio)+'_'+query_type+'.json'
+                    with open(query_json_filename, 'wb') as fptr:
+                        json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                        fptr.close();
+                    pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -l '+loader_json_filename+' -j '
+                        +query_json_filename+' '+cmd_line_param)%(segment_size), shell=True,
+                        stdout=subprocess.PIPE);
+                    stdout_string = pid.communicate()[0]
+                    if(pid.returncode != 0 or len(stdout_string) == 0):
+                        sys.stderr.write('Query test: '+test_name+'-'+query_type+' with sparse_row_map_ratio '
+                                +str(sparse_row_map_ratio)+' failed\n');
+                        cleanup_and_exit(tmpdir, -1);
+                    row_map_stdout_strings.append(stdout_string);
+                if(row_map_stdout_strings[0] != row_map_stdout_strings[1]):
+                    sys.stderr.write('Sparse and dense row maps differ in query test: '+test_name+'-'+query_type+'\n');
+                    print_diff(row_map_stdout_strings[0], row_map_stdout_strings[1]);
+                    cleanup_and_exit(tmpdir, -1);
+        if('check_merge_alt_alleles' in test_params_dict and test_params_dict['check_merge_alt_alleles']):
+            test_query_dict = create_query_json(ws_dir, test_name, { "query_column_ranges" : [0, 1000000000] });
+            query_json_filename = tmpdir+os.path.sep+test_name+'_merge_alt_alleles.json'
+            with open(query_json_filename, 'wb') as fptr:
+                json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            retcode = subprocess.call((exe_path+os.path.sep+'test_merge_alt_alleles -s %d -l '+loader_json_filename
+                +' -j '+query_json_filename)%(segment_size), shell=True);
+            if(retcode != 0):
+                sys.stderr.write('merge_alt_alleles check failed in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+        if('check_column_histogram' in test_params_dict and test_params_dict['check_column_histogram']):
+            test_query_dict = create_query_json(ws_dir, test_name, { "query_column_ranges" : [0, 1000000000] });
+            query_json_filename = tmpdir+os.path.sep+test_name+'_column_histogram.json'
+            with open(query_json_filename, 'wb') as fptr:
+                json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            retcode = subprocess.call((exe_path+os.path.sep+'test_column_histogram -s %d -l '+loader_json_filename
+                +' -j '+query_json_filename)%(segment_size), shell=True);
+            if(retcode != 0):
+                sys.stderr.write('Column histogram metadata and scan mismatch in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+        if('check_variant_query_service' in test_params_dict and test_params_dict['check_variant_query_service']):
+            test_query_dict = create_query_json(ws_dir, test_name, { "query_column_ranges" : [0, 1000000000] });
+            query_json_filename = tmpdir+os.path.sep+test_name+'_variant_query_service.json'
+            with open(query_json_filename, 'wb') as fptr:
+                json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            retcode = subprocess.call((exe_path+os.path.sep+'test_variant_query_service -n 16 -s %d -l '+loader_json_filename
+                +' -j '+query_json_filename)%(segment_size), shell=True);
+            if(retcode != 0):
+                sys.stderr.write('VariantQueryService check failed in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
         if('query_params' in test_params_dict):
             for query_param_dict in test_params_dict['query_params']:
                 test_query_dict = create_query_json(ws_dir, test_name, query_param_dict)
@@ -434,10 +750,10 @@ def main():
                         loader_argument = ' -l '+loader_json_filename;
                         if("query_without_loader" in query_param_dict and query_param_dict["query_without_loader"]):
                             loader_argument = ''
-                        pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d'+loader_argument
+                        query_cmd = (exe_path+os.path.sep+'gt_mpi_gather -s %d'+loader_argument
                             + ' -j '
-                            +query_json_filename+' '+cmd_line_param)%(segment_size), shell=True,
-                            stdout=subprocess.PIPE);
+                            +query_json_filename+' '+cmd_line_param)%(segment_size);
+                        pid = subprocess.Popen(query_cmd, shell=True, stdout=subprocess.PIPE);
                     stdout_string = pid.communicate()[0]
                     if(pid.returncode != 0):
                         sys.stderr.write('Query test: '+test_name+'-'+query_type+' failed\n');
@@ -449,6 +765,281 @@ def main():
                             sys.stderr.write('Mismatch in query test: '+test_name+'-'+query_type+'\n');
                             print_diff(golden_stdout, stdout_string);
                             cleanup_and_exit(tmpdir, -1);
+                        if(query_type == 'calls' and 'columnar_batch_sizes' in test_params_dict):
+                            golden_calls = get_flattened_calls(json.loads(golden_stdout));
+                            for batch_size in test_params_dict['columnar_batch_sizes']:
+                                pid = subprocess.Popen((exe_path+os.path.sep+'test_columnar_export -s %d -b %d'+loader_argument
+                                    +' -j '+query_json_filename)%(segment_size, batch_size), shell=True,
+                                    stdout=subprocess.PIPE);
+                                columnar_stdout_string = pid.communicate()[0]
+                                if(pid.returncode != 0 or not json_values_match(golden_calls,
+                                        [ (call['row'], call['interval'], call['fields'])
+                                            for call in json.loads(columnar_stdout_string)['columnar_calls'] ])):
+                                    sys.stderr.write('Columnar batches of size '+str(batch_size)
+                                            +' do not match the golden calls in query test: '+test_name+'\n');
+                                    print_diff(golden_stdout, columnar_stdout_string);
+                                    cleanup_and_exit(tmpdir, -1);
+                        #GT only fast path - the attributes of the query JSON are ignored
+                        if(query_type == 'calls' and 'check_genotype_matrix' in test_params_dict
+                                and test_params_dict['check_genotype_matrix']):
+                            for encoding_bits in [ 2, 8 ]:
+                                pid = subprocess.Popen((exe_path+os.path.sep+'test_genotype_matrix -s %d -e %d'+loader_argument
+                                    +' -j '+query_json_filename)%(segment_size, encoding_bits), shell=True,
+                                    stdout=subprocess.PIPE);
+                                matrix_stdout_string = pid.communicate()[0]
+                                if(pid.returncode != 0):
+                                    sys.stderr.write('Genotype matrix query with '+str(encoding_bits)
+                                            +' bit encoding failed in query test: '+test_name+'\n');
+                                    cleanup_and_exit(tmpdir, -1);
+                                matrix_dict = json.loads(matrix_stdout_string);
+                                if(matrix_dict['sites'] != get_golden_genotype_matrix(json.loads(golden_stdout),
+                                        encoding_bits, matrix_dict['sample_rows'])):
+                                    sys.stderr.write('Genotype matrix with '+str(encoding_bits)
+                                            +' bit encoding does not match the golden calls in query test: '+test_name+'\n');
+                                    print_diff(golden_stdout, matrix_stdout_string);
+                                    cleanup_and_exit(tmpdir, -1);
+                        if(query_type == 'variants' and 'streaming_gather_params' in test_params_dict):
+                            golden_variants = json.loads(golden_stdout)['variants'];
+                            #No loader JSON - it has a single partition, not one per rank
+                            streaming_query_dict = dict(test_query_dict);
+                            streaming_query_dict['vid_mapping_file'] = test_params_dict.get('vid_mapping_file', 'inputs/vid.json');
+                            streaming_query_dict['callset_mapping_file'] = test_params_dict['callset_mapping_file'];
+                            streaming_query_json_filename = tmpdir+os.path.sep+test_name+'_streaming_gather.json'
+                            with open(streaming_query_json_filename, 'wb') as fptr:
+                                json.dump(streaming_query_dict, fptr, indent=4, separators=(',', ': '));
+                                fptr.close();
+                            for num_processes,driver_args in test_params_dict['streaming_gather_params']:
+                                pid = subprocess.Popen(('mpirun -np %d '+exe_path+os.path.sep+'gt_mpi_gather -s %d -j '
+                                    +streaming_query_json_filename+' --skip-query-on-root '+driver_args)%(num_processes, segment_size),
+                                    shell=True, stdout=subprocess.PIPE);
+                                streaming_stdout_string = pid.communicate()[0]
+                                #Every non-root rank returns all variants of the queried interval, in rank order
+                                if(pid.returncode != 0 or json.loads(streaming_stdout_string)['variants']
+                                        != golden_variants*(num_processes-1)):
+                                    sys.stderr.write('Streaming gather with '+str(num_processes)+' processes and arguments "'
+                                            +driver_args+'" does not match the golden variants in query test: '+test_name+'\n');
+                                    print_diff(golden_stdout, streaming_stdout_string);
+                                    cleanup_and_exit(tmpdir, -1);
+                    if('derived_golden_output' in query_param_dict and query_type in query_param_dict['derived_golden_output']):
+                        golden_stdout, golden_md5sum = get_file_content_and_md5sum(
+                                query_param_dict['derived_golden_output'][query_type]);
+                        expected_stdout = get_derived_golden_output(query_type, golden_stdout, query_param_dict);
+                        if((json.loads(stdout_string) if isinstance(expected_stdout, dict) else stdout_string)
+                                != expected_stdout):
+                            sys.stderr.write('Mismatch in query test: '+test_name+'-'+query_type+'\n');
+                            print_diff(expected_stdout, stdout_string);
+                            cleanup_and_exit(tmpdir, -1);
+                    #Expected output derived from the same query without variant_sites_only
+                    if('unrestricted_derived_output' in query_param_dict
+                            and query_type in query_param_dict['unrestricted_derived_output']):
+                        unrestricted_query_dict = dict(test_query_dict);
+                        del unrestricted_query_dict['variant_sites_only'];
+                        unrestricted_query_json_filename = tmpdir+os.path.sep+test_name+'_'+query_type+'_unrestricted.json'
+                        with open(unrestricted_query_json_filename, 'wb') as fptr:
+                            json.dump(unrestricted_query_dict, fptr, indent=4, separators=(',', ': '));
+                            fptr.close();
+                        pid = subprocess.Popen(query_cmd.replace(query_json_filename, unrestricted_query_json_filename),
+                                shell=True, stdout=subprocess.PIPE);
+                        unrestricted_stdout_string = pid.communicate()[0]
+                        if(pid.returncode != 0):
+                            sys.stderr.write('Unrestricted query test: '+test_name+'-'+query_type+' failed\n');
+                            cleanup_and_exit(tmpdir, -1);
+                        expected_stdout = get_derived_golden_output(query_type, unrestricted_stdout_string, query_param_dict);
+                        if(stdout_string != expected_stdout):
+                            sys.stderr.write('Mismatch with the unrestricted query in query test: '+test_name+'-'+query_type+'\n');
+                            print_diff(expected_stdout, stdout_string);
+                            cleanup_and_exit(tmpdir, -1);
+        if('num_auto_column_partitions' in test_params_dict):
+            partitions, partitions_md5sum = get_file_content_and_md5sum(column_partitions_filename);
+            if(partitions_md5sum != stored_partitions_md5sum
+                    or os.path.getmtime(column_partitions_filename) != stored_partitions_mtime):
+                sys.stderr.write('Column partitions rewritten by queries in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            #Without the stored partitions, queries must fail instead of computing new partitions
+            os.rename(column_partitions_filename, column_partitions_filename+'.bak');
+            with open(os.devnull, 'wb') as devnull:
+                retcode = subprocess.call(exe_path+os.path.sep+'gt_mpi_gather -l '+loader_json_filename+' -j '
+                        +tmpdir+os.path.sep+test_name+'_variants.json', shell=True, stdout=devnull, stderr=devnull);
+            os.rename(column_partitions_filename+'.bak', column_partitions_filename);
+            if(retcode == 0):
+                sys.stderr.write('Query without stored column partitions succeeded in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+    #"column_partitions" : "auto" with 2 partitions - each rank loads its own array <array>_<rank>. The stored
+    #partitions must tile the column domain and the calls of both partitions must be those of t0_1_2
+    test_name = 't0_1_2_auto_2_partitions';
+    test_loader_dict = create_loader_json(ws_dir, test_name, { 'callset_mapping_file': 'inputs/callsets/t0_1_2.json',
+        'num_auto_column_partitions': 2 });
+    test_loader_dict['segment_size'] = load_segment_size;
+    test_loader_dict['produce_combined_vcf'] = False;
+    loader_json_filename = tmpdir+os.path.sep+test_name+'.json'
+    with open(loader_json_filename, 'wb') as fptr:
+        json.dump(test_loader_dict, fptr, indent=4, separators=(',', ': '));
+        fptr.close();
+    for rank in range(2):
+        with open(os.devnull, 'wb') as devnull:
+            retcode = subprocess.call(exe_path+os.path.sep+'vcf2tiledb -r '+str(rank)+' '+loader_json_filename,
+                    shell=True, stdout=devnull);
+        if(retcode != 0):
+            sys.stderr.write('Load of partition '+str(rank)+' failed in test: '+test_name+'\n');
+            cleanup_and_exit(tmpdir, -1);
+    column_partitions_filename = ws_dir+os.path.sep+test_name+'_0.column_partitions.json';
+    if(not os.path.isfile(column_partitions_filename)):
+        sys.stderr.write('Column partitions not stored by loader test: '+test_name+'\n');
+        cleanup_and_exit(tmpdir, -1);
+    with open(column_partitions_filename, 'rb') as fptr:
+        partitions = json.load(fptr)['column_partitions'];
+        fptr.close();
+    if(len(partitions) != 2 or partitions[0][0] != 0 or partitions[0][1]+1 != partitions[1][0]
+            or partitions[1][1] != 2**63-2):
+        sys.stderr.write('Stored column partitions '+str(partitions)+' do not tile the column domain in test: '
+                +test_name+'\n');
+        cleanup_and_exit(tmpdir, -1);
+    #Workspace and arrays of each rank come from the loader JSON
+    test_query_dict = create_query_json(ws_dir, test_name, { "query_column_ranges" : [0, 1000000000] });
+    del test_query_dict['workspace'];
+    del test_query_dict['array'];
+    query_json_filename = tmpdir+os.path.sep+test_name+'_calls.json'
+    with open(query_json_filename, 'wb') as fptr:
+        json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+        fptr.close();
+    partitioned_calls = set();
+    for rank in range(2):
+        pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -r %d -l '+loader_json_filename+' -j '
+            +query_json_filename+' --print-calls')%(segment_size, rank), shell=True, stdout=subprocess.PIPE);
+        stdout_string = pid.communicate()[0]
+        if(pid.returncode != 0):
+            sys.stderr.write('Query of partition '+str(rank)+' failed in test: '+test_name+'\n');
+            cleanup_and_exit(tmpdir, -1);
+        #Intervals spanning the partition boundary are returned by both partitions
+        partitioned_calls.update([ json.dumps(call, sort_keys=True)
+            for call in get_flattened_calls(json.loads(stdout_string)) ]);
+    golden_stdout, golden_md5sum = get_file_content_and_md5sum('golden_outputs/t0_1_2_calls_at_0');
+    golden_calls = set([ json.dumps(call, sort_keys=True) for call in get_flattened_calls(json.loads(golden_stdout)) ]);
+    if(partitioned_calls != golden_calls):
+        sys.stderr.write('Calls of the auto column partitions do not match the golden calls in test: '+test_name+'\n');
+        print_diff(golden_stdout, '\n'.join(sorted(partitioned_calls)));
+        cleanup_and_exit(tmpdir, -1);
+    #Incremental loads of t0_1_2, one sample per load - the policy consolidates the array once it holds
+    #more than max_fragments fragments. Background consolidations must be done when vcf2tiledb exits
+    for consolidate_in_background in [ False, True ]:
+        test_name = 't0_1_2_incremental'+('_background' if consolidate_in_background else '');
+        test_loader_dict = create_loader_json(ws_dir, test_name, { 'callset_mapping_file': 'inputs/callsets/t0_1_2.json' });
+        test_loader_dict['segment_size'] = load_segment_size;
+        test_loader_dict['produce_combined_vcf'] = False;
+        test_loader_dict['fragment_consolidation'] = { "max_fragments": 2, "background": consolidate_in_background };
+        loader_json_filename = tmpdir+os.path.sep+test_name+'.json'
+        array_dir = ws_dir+os.path.sep+test_name;
+        for row_idx, expected_num_fragments in [ (0, 1), (1, 2), (2, 1) ]:
+            test_loader_dict['delete_and_create_tiledb_array'] = (row_idx == 0);
+            test_loader_dict['lb_callset_row_idx'] = row_idx;
+            test_loader_dict['ub_callset_row_idx'] = row_idx;
+            with open(loader_json_filename, 'wb') as fptr:
+                json.dump(test_loader_dict, fptr, indent=4, separators=(',', ': '));
+                fptr.close();
+            with open(os.devnull, 'wb') as devnull:
+                retcode = subprocess.call(exe_path+os.path.sep+'vcf2tiledb '+loader_json_filename, shell=True,
+                        stdout=devnull);
+            if(retcode != 0):
+                sys.stderr.write('Incremental load of row '+str(row_idx)+' failed in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            with open(array_dir+os.path.sep+'genomicsdb_meta.json', 'rb') as fptr:
+                metadata_dict = json.load(fptr);
+                fptr.close();
+            num_fragment_dirs = len([ entry for entry in os.listdir(array_dir)
+                if entry.startswith('__') and os.path.isdir(array_dir+os.path.sep+entry) ]);
+            if(len(metadata_dict['fragments']) != expected_num_fragments or num_fragment_dirs != expected_num_fragments):
+                sys.stderr.write('Expected '+str(expected_num_fragments)+' fragment(s) after loading row '+str(row_idx)
+                        +', found '+str(len(metadata_dict['fragments']))+' in the metadata and '+str(num_fragment_dirs)
+                        +' on disk in test: '+test_name+'\n');
+                cleanup_and_exit(tmpdir, -1);
+            #Two small fragments are below the thresholds of the default policy
+            if(expected_num_fragments == 2):
+                pid = subprocess.Popen(exe_path+os.path.sep+'consolidate_tiledb_array '+ws_dir+' '+test_name+' --if-needed',
+                        shell=True, stderr=subprocess.PIPE);
+                stderr_string = pid.communicate()[1]
+                if(pid.returncode != 0 or stderr_string.find('Consolidation not needed') == -1):
+                    sys.stderr.write('consolidate_tiledb_array --if-needed consolidated 2 fragments in test: '+test_name+'\n');
+                    cleanup_and_exit(tmpdir, -1);
+        #The incrementally loaded array holds the same calls as t0_1_2
+        test_query_dict = create_query_json(ws_dir, test_name, { "query_column_ranges" : [0, 1000000000],
+            "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/t0_1_2.json" });
+        query_json_filename = tmpdir+os.path.sep+test_name+'_calls.json'
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename+' --print-calls')%(segment_size),
+                shell=True, stdout=subprocess.PIPE);
+        stdout_string = pid.communicate()[0]
+        golden_stdout, golden_md5sum = get_file_content_and_md5sum('golden_outputs/t0_1_2_calls_at_0');
+        if(pid.returncode != 0 or golden_md5sum != str(hashlib.md5(stdout_string).hexdigest())):
+            sys.stderr.write('Mismatch in query test: '+test_name+'-calls\n');
+            print_diff(golden_stdout, stdout_string);
+            cleanup_and_exit(tmpdir, -1);
+    #Policy values of the wrong type are rejected
+    test_loader_dict['fragment_consolidation'] = { "max_fragments": "2" };
+    with open(loader_json_filename, 'wb') as fptr:
+        json.dump(test_loader_dict, fptr, indent=4, separators=(',', ': '));
+        fptr.close();
+    with open(os.devnull, 'wb') as devnull:
+        retcode = subprocess.call(exe_path+os.path.sep+'vcf2tiledb '+loader_json_filename, shell=True,
+                stdout=devnull, stderr=devnull);
+    if(retcode == 0):
+        sys.stderr.write('Load with a string valued max_fragments succeeded\n');
+        cleanup_and_exit(tmpdir, -1);
+    #Packed reference created by create_packed_reference, picked up next to the FASTA or named explicitly,
+    #must produce the same combined VCF as the FASTA file
+    reference_dir = tmpdir+os.path.sep+'reference';
+    os.mkdir(reference_dir);
+    for suffix in [ '', '.fai', '.gzi' ]:
+        shutil.copy2('inputs/chr1_10MB.fasta.gz'+suffix, reference_dir);
+    reference_filename = reference_dir+os.path.sep+'chr1_10MB.fasta.gz';
+    packed_reference_filename = reference_filename+'.gdbref';
+    retcode = subprocess.call(exe_path+os.path.sep+'create_packed_reference '+reference_filename, shell=True);
+    if(retcode != 0 or not os.path.isfile(packed_reference_filename)):
+        sys.stderr.write('create_packed_reference failed\n');
+        cleanup_and_exit(tmpdir, -1);
+    with open(packed_reference_filename, 'rb') as fptr:
+        magic = fptr.read(8);
+        fptr.close();
+    if(magic != b'GDBPKREF'):
+        sys.stderr.write('create_packed_reference did not produce a packed reference file\n');
+        cleanup_and_exit(tmpdir, -1);
+    golden_stdout, golden_md5sum = get_file_content_and_md5sum('golden_outputs/t0_1_2_vcf_at_0');
+    def run_packed_reference_query(reference_genome):
+        test_query_dict = create_query_json(ws_dir, 't0_1_2', { "query_column_ranges" : [0, 1000000000],
+            "vid_mapping_file": "inputs/vid.json", "callset_mapping_file": "inputs/callsets/t0_1_2.json",
+            "query_attributes": vcf_query_attributes_order });
+        test_query_dict['reference_genome'] = reference_genome;
+        query_json_filename = tmpdir+os.path.sep+'packed_reference_vcf.json'
+        with open(query_json_filename, 'wb') as fptr:
+            json.dump(test_query_dict, fptr, indent=4, separators=(',', ': '));
+            fptr.close();
+        with open(os.devnull, 'wb') as devnull:
+            pid = subprocess.Popen((exe_path+os.path.sep+'gt_mpi_gather -s %d -j '+query_json_filename
+                +' --produce-Broad-GVCF')%(segment_size), shell=True, stdout=subprocess.PIPE, stderr=devnull);
+            stdout_string = pid.communicate()[0]
+        return (pid.returncode, stdout_string);
+    for description, reference_genome in [ ('next to the FASTA file', reference_filename),
+            ('named explicitly', packed_reference_filename) ]:
+        returncode, stdout_string = run_packed_reference_query(reference_genome);
+        if(returncode != 0 or golden_md5sum != str(hashlib.md5(stdout_string).hexdigest())):
+            sys.stderr.write('Mismatch in combined VCF with the packed reference '+description+'\n');
+            print_diff(golden_stdout, stdout_string);
+            cleanup_and_exit(tmpdir, -1);
+    #Unsupported version - the packed file next to the FASTA is ignored, an explicitly named one is an error
+    with open(packed_reference_filename, 'r+b') as fptr:
+        fptr.seek(8);
+        fptr.write(struct.pack('<I', 1000));
+        fptr.close();
+    returncode, stdout_string = run_packed_reference_query(reference_filename);
+    if(returncode != 0 or golden_md5sum != str(hashlib.md5(stdout_string).hexdigest())):
+        sys.stderr.write('Packed reference with an unsupported version next to the FASTA file was not ignored\n');
+        print_diff(golden_stdout, stdout_string);
+        cleanup_and_exit(tmpdir, -1);
+    returncode, stdout_string = run_packed_reference_query(packed_reference_filename);
+    if(returncode == 0):
+        sys.stderr.write('Query with an explicitly named packed reference of an unsupported version succeeded\n');
+        cleanup_and_exit(tmpdir, -1);
     coverage_file='coverage.info'
     subprocess.call('lcov --directory '+gcda_prefix_dir+' --capture --output-file '+coverage_file, shell=True);
     #Remove protocol buffer generated files from the coverage information
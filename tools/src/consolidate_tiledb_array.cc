@@ -3,11 +3,19 @@
 
 int main(int argc, char** argv)
 {
-  if(argc < 3)
+  if(argc < 3 || (argc > 3 && std::string(argv[3]) != "--if-needed"))
   {
-    std::cerr << "Needs 2 arguments <workspace_directory> <array_name>\n";
+    std::cerr << "Needs 2 arguments <workspace_directory> <array_name> [--if-needed]\n"
+      << "\t--if-needed: consolidate only if the default size tiered policy asks for it\n";
     exit(-1);
   }
-  VCF2TileDBLoader::consolidate_tiledb_array(argv[1], argv[2]);
+  if(argc > 3)
+  {
+    FragmentConsolidationPolicy policy;
+    auto consolidated = VCF2TileDBLoader::consolidate_tiledb_array(argv[1], argv[2], &policy);
+    std::cerr << (consolidated ? "Consolidated array " : "Consolidation not needed for array ") << argv[2] << "\n";
+  }
+  else
+    VCF2TileDBLoader::consolidate_tiledb_array(argv[1], argv[2]);
   return 0;
 }
@@ -0,0 +1,21 @@
+#include <iostream>
+#include "packed_reference.h"
+
+int main(int argc, char** argv)
+{
+#ifdef HTSDIR
+  if(argc < 2)
+  {
+    std::cerr << "Needs 1 or 2 arguments <reference_fasta> [<output_packed_reference>]\n";
+    std::cerr << "Default output file is <reference_fasta>" << PACKED_REFERENCE_DEFAULT_SUFFIX
+      << " - picked up automatically when <reference_fasta> is used as the reference genome\n";
+    exit(-1);
+  }
+  std::string output_filename = (argc >= 3) ? argv[2] : std::string(argv[1])+PACKED_REFERENCE_DEFAULT_SUFFIX;
+  PackedReferenceGenome::create(argv[1], output_filename);
+  return 0;
+#else
+  std::cerr << "Cannot create packed reference without htslib. Re-compile with HTSDIR variable set\n";
+  return -1;
+#endif
+}
@@ -0,0 +1,754 @@
+/**
+ * The MIT License (MIT)
+ * Copyright (c) 2016 Intel Corporation
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy of 
+ * this software and associated documentation files (the "Software"), to deal in 
+ * the Software without restriction, including without limitation the rights to 
+ * use, copy, modify, merge, publish, distribute, sublicense, and/or sell copies of 
+ * the Software, and to permit persons to whom the Software is furnished to do so, 
+ * subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all 
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY, FITNESS 
+ * FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE AUTHORS OR 
+ * COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER LIABILITY, WHETHER 
+ * IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM, OUT OF OR IN 
+ * CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE SOFTWARE.
+*/
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <random>
+#include <algorithm>
+#include <exception>
+#include <getopt.h>
+#include <errno.h>
+#include <string.h>
+#include <sys/stat.h>
+#include "htslib/bgzf.h"
+#include "htslib/tbx.h"
+
+/*
+ * Generates a synthetic cohort of single sample gVCFs for scale testing along with the reference
+ * genome, vid mapping, callset mapping and VCF header files needed to load and query them.
+ * A catalogue of polymorphic sites (SNVs, insertions and overlapping deletions, possibly multi-allelic)
+ * is shared by all samples - each sample carries a site with the site's allele frequency and the
+ * gaps between variants are filled with reference blocks of random length.
+ */
+
+class SyntheticGVCFException : public std::exception {
+  public:
+    SyntheticGVCFException(const std::string m="") : msg_("SyntheticGVCFException : "+m) { ; }
+    ~SyntheticGVCFException() { ; }
+    // ACCESSORS
+    /** Returns the exception message. */
+    const char* what() const noexcept { return msg_.c_str(); }
+  private:
+    std::string msg_;
+};
+
+#define VERIFY_OR_THROW(X) if(!(X)) throw SyntheticGVCFException(#X);
+
+enum SyntheticFormatFieldsEnum
+{
+  SYNTHETIC_FORMAT_GT=0u,
+  SYNTHETIC_FORMAT_AD,
+  SYNTHETIC_FORMAT_DP,
+  SYNTHETIC_FORMAT_GQ,
+  SYNTHETIC_FORMAT_MIN_DP,
+  SYNTHETIC_FORMAT_PL,
+  SYNTHETIC_FORMAT_SB,
+  SYNTHETIC_NUM_FORMAT_FIELDS
+};
+
+static const char* g_synthetic_format_field_names[] = { "GT", "AD", "DP", "GQ", "MIN_DP", "PL", "SB" };
+
+class SyntheticGVCFParameters
+{
+  public:
+    SyntheticGVCFParameters()
+    {
+      m_num_samples = 1000u;
+      m_contigs = { { "1", 1000000ll } };
+      m_site_density = 0.001;
+      m_max_alt_alleles = 3u;
+      m_multi_allelic_fraction = 0.1;
+      m_deletion_fraction = 0.1;
+      m_insertion_fraction = 0.05;
+      m_max_indel_length = 10u;
+      m_mean_reference_block_length = 500.0;
+      m_max_allele_frequency = 0.5;
+      m_format_fields = std::vector<bool>(SYNTHETIC_NUM_FORMAT_FIELDS, true);
+      m_format_fields[SYNTHETIC_FORMAT_SB] = false;
+      m_seed = 0u;
+      m_num_column_partitions = 1u;
+    }
+    std::string m_output_directory;
+    uint64_t m_num_samples;
+    std::vector<std::pair<std::string, int64_t>> m_contigs;
+    //Fraction of positions that are polymorphic in the cohort
+    double m_site_density;
+    unsigned m_max_alt_alleles;
+    double m_multi_allelic_fraction;
+    double m_deletion_fraction;
+    double m_insertion_fraction;
+    unsigned m_max_indel_length;
+    double m_mean_reference_block_length;
+    double m_max_allele_frequency;
+    std::vector<bool> m_format_fields;
+    unsigned m_seed;
+    //If set, loader and query JSON files are produced as well
+    std::string m_workspace;
+    std::string m_array;
+    unsigned m_num_column_partitions;
+};
+
+struct SyntheticSite
+{
+  int64_t m_position;   //1-based
+  std::string m_ref;
+  std::vector<std::string> m_alts;
+  double m_allele_frequency;
+};
+
+class SyntheticCohortGenerator
+{
+  public:
+    SyntheticCohortGenerator(const SyntheticGVCFParameters& params)
+      : m_params(params)
+    {
+      VERIFY_OR_THROW(!m_params.m_output_directory.empty());
+      VERIFY_OR_THROW(m_params.m_num_samples > 0u);
+      VERIFY_OR_THROW(m_params.m_max_alt_alleles > 0u && m_params.m_max_alt_alleles <= 3u);
+      VERIFY_OR_THROW(m_params.m_mean_reference_block_length >= 1.0);
+      VERIFY_OR_THROW(m_params.m_num_column_partitions > 0u);
+    }
+    void generate()
+    {
+      if(mkdir(m_params.m_output_directory.c_str(), 0755) != 0 && errno != EEXIST)
+        throw SyntheticGVCFException(std::string("Could not create output directory ")+m_params.m_output_directory
+            +" : "+strerror(errno));
+      generate_reference();
+      generate_sites();
+      write_reference();
+      write_vcf_header();
+      write_vid_mapping();
+      write_callset_mapping();
+      if(!m_params.m_workspace.empty() && !m_params.m_array.empty())
+        write_loader_and_query_json();
+      //Exceptions must not escape the parallel region - the first one is re-thrown after the loop
+      std::exception_ptr first_exception;
+#pragma omp parallel for schedule(dynamic)
+      for(auto i=0ll;i<static_cast<int64_t>(m_params.m_num_samples);++i)
+      {
+        try
+        {
+          write_sample_gvcf(i);
+        }
+        catch(...)
+        {
+#pragma omp critical
+          if(!first_exception)
+            first_exception = std::current_exception();
+        }
+      }
+      if(first_exception)
+        std::rethrow_exception(first_exception);
+    }
+  private:
+    std::string get_path(const std::string& filename) const { return m_params.m_output_directory + "/" + filename; }
+    std::string get_sample_name(const uint64_t sample_idx) const { return std::string("sample_")+std::to_string(sample_idx); }
+    std::string get_sample_filename(const uint64_t sample_idx) const
+    {
+      return get_path(get_sample_name(sample_idx)+".g.vcf.gz");
+    }
+    void generate_reference()
+    {
+      std::mt19937_64 generator(m_params.m_seed);
+      m_reference.resize(m_params.m_contigs.size());
+      for(auto i=0u;i<m_params.m_contigs.size();++i)
+      {
+        VERIFY_OR_THROW(m_params.m_contigs[i].second > 0);
+        auto& seq = m_reference[i];
+        seq.resize(m_params.m_contigs[i].second);
+        for(auto& base : seq)
+          base = "ACGT"[generator() & 3u];
+      }
+    }
+    std::string random_bases(std::mt19937_64& generator, const unsigned length) const
+    {
+      std::string result(length, 'A');
+      for(auto& base : result)
+        base = "ACGT"[generator() & 3u];
+      return result;
+    }
+    void generate_sites()
+    {
+      std::mt19937_64 generator(m_params.m_seed+1u);
+      std::exponential_distribution<double> gap_distribution(m_params.m_site_density);
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      std::uniform_int_distribution<unsigned> indel_length_distribution(1u, m_params.m_max_indel_length);
+      m_sites.resize(m_params.m_contigs.size());
+      for(auto i=0u;i<m_params.m_contigs.size();++i)
+      {
+        const auto& seq = m_reference[i];
+        auto contig_length = static_cast<int64_t>(seq.size());
+        int64_t position = 1;
+        while(true)
+        {
+          position += 1 + static_cast<int64_t>(gap_distribution(generator));
+          if(position + static_cast<int64_t>(m_params.m_max_indel_length) + 1 >= contig_length)
+            break;
+          SyntheticSite site;
+          site.m_position = position;
+          //Rare variants dominate, as in real cohorts
+          auto u = uniform(generator);
+          site.m_allele_frequency = std::max(u*u*u*m_params.m_max_allele_frequency, 1.0/m_params.m_num_samples);
+          auto num_alts = (uniform(generator) < m_params.m_multi_allelic_fraction) ? m_params.m_max_alt_alleles : 1u;
+          auto type = uniform(generator);
+          auto ref_base = seq[position-1];
+          if(type < m_params.m_deletion_fraction)
+          {
+            //Deletions of different lengths at the same position - the longest determines REF
+            std::vector<unsigned> lengths;
+            for(auto j=0u;j<num_alts;++j)
+              lengths.push_back(indel_length_distribution(generator));
+            std::sort(lengths.begin(), lengths.end());
+            lengths.erase(std::unique(lengths.begin(), lengths.end()), lengths.end());
+            site.m_ref = seq.substr(position-1, lengths.back()+1u);
+            for(auto length : lengths)
+              site.m_alts.push_back(site.m_ref.substr(0u, site.m_ref.length()-length));
+          }
+          else if(type < m_params.m_deletion_fraction + m_params.m_insertion_fraction)
+          {
+            site.m_ref = std::string(1u, ref_base);
+            for(auto j=0u;j<num_alts;++j)
+            {
+              auto alt = site.m_ref + random_bases(generator, indel_length_distribution(generator));
+              if(std::find(site.m_alts.begin(), site.m_alts.end(), alt) == site.m_alts.end())
+                site.m_alts.push_back(alt);
+            }
+          }
+          else
+          {
+            site.m_ref = std::string(1u, ref_base);
+            for(auto base : std::string("ACGT"))
+              if(base != ref_base && site.m_alts.size() < num_alts)
+                site.m_alts.push_back(std::string(1u, base));
+            std::shuffle(site.m_alts.begin(), site.m_alts.end(), generator);
+          }
+          m_sites[i].push_back(site);
+        }
+      }
+    }
+    void write_reference() const
+    {
+      //FASTA with a faidx index so that no external tools are needed
+      std::ofstream fasta(get_path("reference.fa").c_str());
+      std::ofstream fai(get_path("reference.fa.fai").c_str());
+      VERIFY_OR_THROW(fasta.is_open() && fai.is_open());
+      const int64_t line_length = 60;
+      int64_t offset = 0;
+      for(auto i=0u;i<m_params.m_contigs.size();++i)
+      {
+        const auto& name = m_params.m_contigs[i].first;
+        const auto& seq = m_reference[i];
+        auto length = static_cast<int64_t>(seq.size());
+        fasta << ">" << name << "\n";
+        offset += name.length() + 2u;
+        fai << name << "\t" << length << "\t" << offset << "\t" << line_length << "\t" << line_length+1 << "\n";
+        for(int64_t j=0;j<length;j+=line_length)
+          fasta.write(&(seq[j]), std::min(line_length, length-j)) << "\n";
+        offset += length + (length+line_length-1)/line_length;
+      }
+    }
+    void write_vcf_header() const
+    {
+      std::ofstream fptr(get_path("template_vcf_header.vcf").c_str());
+      VERIFY_OR_THROW(fptr.is_open());
+      fptr << get_vcf_header_lines();
+      fptr << "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\n";
+    }
+    std::string get_vcf_header_lines() const
+    {
+      std::stringstream ss;
+      ss << "##fileformat=VCFv4.1\n"
+        << "##FILTER=<ID=PASS,Description=\"All filters passed\">\n"
+        << "##FILTER=<ID=LowQual,Description=\"Low quality\">\n"
+        << "##ALT=<ID=NON_REF,Description=\"Represents any possible alternative allele at this location\">\n"
+        << "##FORMAT=<ID=AD,Number=R,Type=Integer,Description=\"Allelic depths for the ref and alt alleles in the order listed\">\n"
+        << "##FORMAT=<ID=DP,Number=1,Type=Integer,Description=\"Approximate read depth\">\n"
+        << "##FORMAT=<ID=GQ,Number=1,Type=Integer,Description=\"Genotype Quality\">\n"
+        << "##FORMAT=<ID=GT,Number=1,Type=String,Description=\"Genotype\">\n"
+        << "##FORMAT=<ID=MIN_DP,Number=1,Type=Integer,Description=\"Minimum DP observed within the GVCF block\">\n"
+        << "##FORMAT=<ID=PL,Number=G,Type=Integer,Description=\"Normalized, Phred-scaled likelihoods for genotypes\">\n"
+        << "##FORMAT=<ID=SB,Number=4,Type=Integer,Description=\"Per-sample component statistics for strand bias\">\n"
+        << "##INFO=<ID=BaseQRankSum,Number=1,Type=Float,Description=\"Z-score from Wilcoxon rank sum test of Alt Vs. Ref base qualities\">\n"
+        << "##INFO=<ID=ClippingRankSum,Number=1,Type=Float,Description=\"Z-score From Wilcoxon rank sum test of Alt vs. Ref number of hard clipped bases\">\n"
+        << "##INFO=<ID=DP,Number=1,Type=Integer,Description=\"Approximate read depth\">\n"
+        << "##INFO=<ID=END,Number=1,Type=Integer,Description=\"Stop position of the interval\">\n"
+        << "##INFO=<ID=MQ,Number=1,Type=Float,Description=\"RMS Mapping Quality\">\n"
+        << "##INFO=<ID=MQ0,Number=1,Type=Integer,Description=\"Total Mapping Quality Zero Reads\">\n"
+        << "##INFO=<ID=MQRankSum,Number=1,Type=Float,Description=\"Z-score From Wilcoxon rank sum test of Alt vs. Ref read mapping qualities\">\n"
+        << "##INFO=<ID=ReadPosRankSum,Number=1,Type=Float,Description=\"Z-score from Wilcoxon rank sum test of Alt vs. Ref read position bias\">\n";
+      for(const auto& contig : m_params.m_contigs)
+        ss << "##contig=<ID=" << contig.first << ",length=" << contig.second << ">\n";
+      return ss.str();
+    }
+    void write_vid_mapping() const
+    {
+      std::ofstream fptr(get_path("vid.json").c_str());
+      VERIFY_OR_THROW(fptr.is_open());
+      fptr << "{\n    \"fields\" : {\n"
+        << "        \"PASS\":{ \"type\":\"int\" },\n"
+        << "        \"LowQual\":{ \"type\":\"int\" },\n"
+        << "        \"END\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"int\" },\n"
+        << "        \"BaseQRankSum\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"float\" },\n"
+        << "        \"ClippingRankSum\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"float\" },\n"
+        << "        \"MQRankSum\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"float\" },\n"
+        << "        \"ReadPosRankSum\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"float\" },\n"
+        << "        \"MQ\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"float\" },\n"
+        << "        \"MQ0\":{ \"vcf_field_class\":[\"INFO\"], \"type\":\"int\" },\n"
+        << "        \"DP\":{ \"vcf_field_class\":[\"INFO\",\"FORMAT\"], \"type\":\"int\" },\n"
+        << "        \"GQ\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\" },\n"
+        << "        \"SB\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\", \"length\":4 },\n"
+        << "        \"AD\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\", \"length\":\"R\" },\n"
+        << "        \"PL\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\", \"length\":\"G\" },\n"
+        << "        \"MIN_DP\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\" },\n"
+        << "        \"GT\":{ \"vcf_field_class\":[\"FORMAT\"], \"type\":\"int\", \"length\":\"P\" }\n"
+        << "    },\n    \"contigs\" : {";
+      int64_t offset = 0;
+      for(auto i=0u;i<m_params.m_contigs.size();++i)
+      {
+        fptr << (i ? ",\n" : "\n") << "        \"" << m_params.m_contigs[i].first << "\": { \"length\": "
+          << m_params.m_contigs[i].second << ", \"tiledb_column_offset\": " << offset << " }";
+        offset += m_params.m_contigs[i].second;
+      }
+      fptr << "\n    }\n}\n";
+    }
+    void write_callset_mapping() const
+    {
+      std::ofstream fptr(get_path("callset.json").c_str());
+      VERIFY_OR_THROW(fptr.is_open());
+      fptr << "{\n    \"callsets\" : {";
+      for(auto i=0ull;i<m_params.m_num_samples;++i)
+        fptr << (i ? ",\n" : "\n") << "        \"" << get_sample_name(i) << "\": { \"row_idx\": " << i
+          << ", \"idx_in_file\": 0, \"filename\": \"" << get_sample_filename(i) << "\" }";
+      fptr << "\n    }\n}\n";
+    }
+    void write_loader_and_query_json() const
+    {
+      int64_t total_length = 0;
+      for(const auto& contig : m_params.m_contigs)
+        total_length += contig.second;
+      std::ofstream loader_fptr(get_path("loader.json").c_str());
+      VERIFY_OR_THROW(loader_fptr.is_open());
+      loader_fptr << "{\n    \"row_based_partitioning\" : false,\n    \"column_partitions\" : [";
+      auto partition_size = (total_length + m_params.m_num_column_partitions - 1)/m_params.m_num_column_partitions;
+      for(auto i=0u;i<m_params.m_num_column_partitions;++i)
+        loader_fptr << (i ? ",\n" : "\n") << "        { \"begin\": " << i*partition_size << ", \"workspace\": \""
+          << m_params.m_workspace << "\", \"array\": \"" << m_params.m_array
+          << (m_params.m_num_column_partitions > 1u ? std::to_string(i) : std::string("")) << "\" }";
+      loader_fptr << "\n    ],\n"
+        << "    \"callset_mapping_file\" : \"" << get_path("callset.json") << "\",\n"
+        << "    \"vid_mapping_file\" : \"" << get_path("vid.json") << "\",\n"
+        << "    \"vcf_header_filename\" : \"" << get_path("template_vcf_header.vcf") << "\",\n"
+        << "    \"reference_genome\" : \"" << get_path("reference.fa") << "\",\n"
+        << "    \"size_per_column_partition\" : 16384,\n"
+        << "    \"treat_deletions_as_intervals\" : true,\n"
+        << "    \"num_parallel_vcf_files\" : 1,\n"
+        << "    \"do_ping_pong_buffering\" : true,\n"
+        << "    \"offload_vcf_output_processing\" : true,\n"
+        << "    \"produce_combined_vcf\" : false,\n"
+        << "    \"produce_tiledb_array\" : true,\n"
+        << "    \"delete_and_create_tiledb_array\" : true,\n"
+        << "    \"compress_tiledb_array\" : true,\n"
+        << "    \"segment_size\" : 10485760,\n"
+        << "    \"num_cells_per_tile\" : 1000\n}\n";
+      std::ofstream query_fptr(get_path("query.json").c_str());
+      VERIFY_OR_THROW(query_fptr.is_open());
+      query_fptr << "{\n    \"workspace\" : \"" << m_params.m_workspace << "\",\n"
+        << "    \"array\" : \"" << m_params.m_array << (m_params.m_num_column_partitions > 1u ? "0" : "") << "\",\n"
+        << "    \"query_column_ranges\" : [ [ [ 0, " << std::min(partition_size, total_length)-1 << " ] ] ],\n"
+        << "    \"query_row_ranges\" : [ [ [ 0, " << m_params.m_num_samples-1u << " ] ] ],\n"
+        << "    \"vid_mapping_file\" : \"" << get_path("vid.json") << "\",\n"
+        << "    \"callset_mapping_file\" : \"" << get_path("callset.json") << "\",\n"
+        << "    \"vcf_header_filename\" : \"" << get_path("template_vcf_header.vcf") << "\",\n"
+        << "    \"reference_genome\" : \"" << get_path("reference.fa") << "\",\n"
+        << "    \"query_attributes\" : [ \"REF\", \"ALT\", \"BaseQRankSum\", \"MQ\", \"MQ0\", \"ClippingRankSum\", \"MQRankSum\", "
+        << "\"ReadPosRankSum\", \"DP\", \"GT\", \"GQ\", \"SB\", \"AD\", \"PL\", \"MIN_DP\" ]\n}\n";
+    }
+    //Genotype quality bands of GATK gVCF blocks
+    int get_reference_block_GQ(std::mt19937_64& generator) const
+    {
+      static const int band_begin[] = { 0, 5, 20, 60 };
+      static const int band_end[] = { 5, 20, 60, 100 };
+      auto u = generator() % 100u;
+      auto band = (u < 5u) ? 0u : (u < 15u) ? 1u : (u < 35u) ? 2u : 3u;
+      return band_begin[band] + static_cast<int>(generator() % (band_end[band]-band_begin[band]));
+    }
+    void append_format(std::string& line, const std::vector<std::string>& values) const
+    {
+      auto first = true;
+      line += '\t';
+      for(auto i=0u;i<SYNTHETIC_NUM_FORMAT_FIELDS;++i)
+        if(!values[i].empty())
+        {
+          if(!first)
+            line += ':';
+          line += g_synthetic_format_field_names[i];
+          first = false;
+        }
+      first = true;
+      line += '\t';
+      for(auto i=0u;i<SYNTHETIC_NUM_FORMAT_FIELDS;++i)
+        if(!values[i].empty())
+        {
+          if(!first)
+            line += ':';
+          line += values[i];
+          first = false;
+        }
+      line += '\n';
+    }
+    void append_reference_block(std::string& line, std::mt19937_64& generator, const std::string& contig,
+        const std::string& seq, const int64_t begin, const int64_t end) const
+    {
+      auto GQ = get_reference_block_GQ(generator);
+      auto DP = 10 + static_cast<int>(generator() % 50u);
+      line += contig + '\t' + std::to_string(begin) + "\t.\t" + seq[begin-1] + "\t<NON_REF>\t.\t.\tEND="
+        + std::to_string(end);
+      std::vector<std::string> values(SYNTHETIC_NUM_FORMAT_FIELDS);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_GT])
+        values[SYNTHETIC_FORMAT_GT] = "0/0";
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_DP])
+        values[SYNTHETIC_FORMAT_DP] = std::to_string(DP);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_GQ])
+        values[SYNTHETIC_FORMAT_GQ] = std::to_string(GQ);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_MIN_DP])
+        values[SYNTHETIC_FORMAT_MIN_DP] = std::to_string(DP - static_cast<int>(generator() % (DP/2+1)));
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_PL])
+        values[SYNTHETIC_FORMAT_PL] = "0," + std::to_string(GQ) + "," + std::to_string(std::min(10*GQ+100, 2000));
+      append_format(line, values);
+    }
+    void append_variant(std::string& line, std::mt19937_64& generator, const std::string& contig,
+        const SyntheticSite& site) const
+    {
+      //Sample carries one ALT allele, two for multi-allelic sites occasionally
+      auto num_alts = 1u;
+      if(site.m_alts.size() > 1u && (generator() % 4u) == 0u)
+        num_alts = 2u;
+      std::vector<unsigned> alt_idxs;
+      while(alt_idxs.size() < num_alts)
+      {
+        auto idx = static_cast<unsigned>(generator() % site.m_alts.size());
+        if(std::find(alt_idxs.begin(), alt_idxs.end(), idx) == alt_idxs.end())
+          alt_idxs.push_back(idx);
+      }
+      std::sort(alt_idxs.begin(), alt_idxs.end());
+      //Deletion alleles must share the REF of the site, the shortest REF that covers the chosen alleles is used
+      auto ref = site.m_ref;
+      if(ref.length() > 1u && site.m_alts[0].length() < ref.length())
+      {
+        auto max_deletion_length = 0u;
+        for(auto idx : alt_idxs)
+          max_deletion_length = std::max<unsigned>(max_deletion_length, ref.length()-site.m_alts[idx].length());
+        ref = ref.substr(0u, max_deletion_length+1u);
+      }
+      std::string alt_list;
+      for(auto idx : alt_idxs)
+      {
+        auto alt = site.m_alts[idx];
+        if(alt.length() < site.m_ref.length())   //deletion - trim to the shortened REF
+          alt = alt.substr(0u, alt.length() - (site.m_ref.length() - ref.length()));
+        alt_list += alt + ",";
+      }
+      alt_list += "<NON_REF>";
+      //REF + ALTs + NON_REF
+      auto num_alleles = num_alts + 2u;
+      auto is_hom = (num_alts == 1u) && (generator() % 3u == 0u);
+      auto GT_0 = is_hom ? 1u : (num_alts == 2u ? 1u : 0u);
+      auto GT_1 = (num_alts == 2u) ? 2u : 1u;
+      std::uniform_real_distribution<double> rank_sum(-3.0, 3.0);
+      char info[256];
+      snprintf(info, sizeof(info), "BaseQRankSum=%.3f;ClippingRankSum=%.3f;MQ=%.2f;MQ0=0;MQRankSum=%.3f;ReadPosRankSum=%.3f",
+          rank_sum(generator), rank_sum(generator), 50.0 + (generator() % 1000u)/100.0, rank_sum(generator),
+          rank_sum(generator));
+      auto QUAL = 30 + static_cast<int>(generator() % 2000u);
+      line += contig + '\t' + std::to_string(site.m_position) + "\t.\t" + ref + '\t' + alt_list + '\t'
+        + std::to_string(QUAL) + ".00\t.\t" + info;
+      std::vector<std::string> values(SYNTHETIC_NUM_FORMAT_FIELDS);
+      std::vector<int> AD(num_alleles, 0);
+      auto DP = 0;
+      for(auto i=0u;i<num_alleles-1u;++i)
+      {
+        auto is_called = (i == GT_0 || i == GT_1);
+        AD[i] = is_called ? 5 + static_cast<int>(generator() % 40u) : static_cast<int>(generator() % 3u);
+        DP += AD[i];
+      }
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_GT])
+        values[SYNTHETIC_FORMAT_GT] = std::to_string(GT_0) + "/" + std::to_string(GT_1);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_AD])
+        values[SYNTHETIC_FORMAT_AD] = join(AD);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_DP])
+        values[SYNTHETIC_FORMAT_DP] = std::to_string(DP);
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_GQ])
+        values[SYNTHETIC_FORMAT_GQ] = std::to_string(std::min(99, 10 + static_cast<int>(generator() % 90u)));
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_PL])
+      {
+        //Genotype order as defined in the VCF spec - (j,k) with j <= k at index k*(k+1)/2+j
+        std::vector<int> PL((num_alleles*(num_alleles+1u))/2u);
+        for(auto k=0u;k<num_alleles;++k)
+          for(auto j=0u;j<=k;++j)
+            PL[(k*(k+1u))/2u+j] = (j == GT_0 && k == GT_1) ? 0 : 10 + static_cast<int>(generator() % 2000u);
+        values[SYNTHETIC_FORMAT_PL] = join(PL);
+      }
+      if(m_params.m_format_fields[SYNTHETIC_FORMAT_SB])
+      {
+        std::vector<int> SB(4u);
+        for(auto& val : SB)
+          val = static_cast<int>(generator() % 30u);
+        values[SYNTHETIC_FORMAT_SB] = join(SB);
+      }
+      append_format(line, values);
+    }
+    static std::string join(const std::vector<int>& values)
+    {
+      std::string result;
+      for(auto i=0u;i<values.size();++i)
+      {
+        if(i)
+          result += ',';
+        result += std::to_string(values[i]);
+      }
+      return result;
+    }
+    void flush_buffer(BGZF* fptr, std::string& buffer, const std::string& filename) const
+    {
+      if(buffer.empty())
+        return;
+      if(bgzf_write(fptr, buffer.c_str(), buffer.length()) != static_cast<ssize_t>(buffer.length()))
+        throw SyntheticGVCFException(std::string("Error while writing to ")+filename);
+      buffer.clear();
+    }
+    void write_sample_gvcf(const uint64_t sample_idx) const
+    {
+      //Deterministic irrespective of the number of threads
+      std::mt19937_64 generator(m_params.m_seed*0x9E3779B97F4A7C15ull + sample_idx + 2u);
+      std::uniform_real_distribution<double> uniform(0.0, 1.0);
+      std::exponential_distribution<double> block_length_distribution(1.0/m_params.m_mean_reference_block_length);
+      auto filename = get_sample_filename(sample_idx);
+      auto fptr = bgzf_open(filename.c_str(), "w");
+      if(fptr == 0)
+        throw SyntheticGVCFException(std::string("Could not open ")+filename);
+      std::string buffer = get_vcf_header_lines();
+      buffer += "#CHROM\tPOS\tID\tREF\tALT\tQUAL\tFILTER\tINFO\tFORMAT\t" + get_sample_name(sample_idx) + "\n";
+      for(auto i=0u;i<m_params.m_contigs.size();++i)
+      {
+        const auto& contig = m_params.m_contigs[i].first;
+        const auto& seq = m_reference[i];
+        auto contig_length = static_cast<int64_t>(seq.size());
+        int64_t next_position = 1;
+        auto site_iter = m_sites[i].begin();
+        while(next_position <= contig_length)
+        {
+          //Next site carried by this sample which does not overlap the previous record
+          while(site_iter != m_sites[i].end() && ((*site_iter).m_position < next_position
+                || uniform(generator) >= (*site_iter).m_allele_frequency))
+            ++site_iter;
+          auto block_end = (site_iter == m_sites[i].end()) ? contig_length : (*site_iter).m_position-1;
+          //Reference blocks of random length till the next variant
+          while(next_position <= block_end)
+          {
+            auto block_length = 1 + static_cast<int64_t>(block_length_distribution(generator));
+            auto end = std::min(next_position+block_length-1, block_end);
+            append_reference_block(buffer, generator, contig, seq, next_position, end);
+            next_position = end+1;
+          }
+          if(site_iter != m_sites[i].end())
+          {
+            auto line_begin = buffer.length();
+            append_variant(buffer, generator, contig, *site_iter);
+            //REF length of the record just written
+            auto ref_begin = buffer.find('\t', buffer.find('\t', buffer.find('\t', line_begin)+1u)+1u)+1u;
+            auto ref_length = buffer.find('\t', ref_begin) - ref_begin;
+            next_position = (*site_iter).m_position + ref_length;
+            ++site_iter;
+          }
+          if(buffer.length() >= 1048576u)
+            flush_buffer(fptr, buffer, filename);
+        }
+      }
+      flush_buffer(fptr, buffer, filename);
+      if(bgzf_close(fptr) != 0)
+        throw SyntheticGVCFException(std::string("Error while closing ")+filename);
+      if(tbx_index_build(filename.c_str(), 0, &tbx_conf_vcf) != 0)
+        throw SyntheticGVCFException(std::string("Could not build tabix index for ")+filename);
+    }
+    const SyntheticGVCFParameters& m_params;
+    std::vector<std::string> m_reference;
+    std::vector<std::vector<SyntheticSite>> m_sites;
+};
+
+void parse_contigs(const char* str, std::vector<std::pair<std::string, int64_t>>& contigs)
+{
+  contigs.clear();
+  std::stringstream ss(str);
+  std::string token;
+  while(std::getline(ss, token, ','))
+  {
+    auto colon_pos = token.rfind(':');
+    if(colon_pos == std::string::npos || colon_pos == 0u)
+      throw SyntheticGVCFException(std::string("Contig must be specified as <name>:<length> : ")+token);
+    contigs.emplace_back(token.substr(0u, colon_pos), strtoll(token.c_str()+colon_pos+1u, 0, 10));
+  }
+}
+
+void parse_format_fields(const char* str, std::vector<bool>& format_fields)
+{
+  format_fields = std::vector<bool>(SYNTHETIC_NUM_FORMAT_FIELDS, false);
+  std::stringstream ss(str);
+  std::string token;
+  while(std::getline(ss, token, ','))
+  {
+    auto found = false;
+    for(auto i=0u;i<SYNTHETIC_NUM_FORMAT_FIELDS;++i)
+      if(token == g_synthetic_format_field_names[i])
+      {
+        format_fields[i] = true;
+        found = true;
+      }
+    if(!found)
+      throw SyntheticGVCFException(std::string("Unknown FORMAT field : ")+token);
+  }
+}
+
+enum GenerateSyntheticGVCFsArgsEnum
+{
+  ARGS_IDX_NUM_SAMPLES=1000,
+  ARGS_IDX_CONTIGS,
+  ARGS_IDX_SITE_DENSITY,
+  ARGS_IDX_MAX_ALT_ALLELES,
+  ARGS_IDX_MULTI_ALLELIC_FRACTION,
+  ARGS_IDX_DELETION_FRACTION,
+  ARGS_IDX_INSERTION_FRACTION,
+  ARGS_IDX_MAX_INDEL_LENGTH,
+  ARGS_IDX_MEAN_REFERENCE_BLOCK_LENGTH,
+  ARGS_IDX_MAX_ALLELE_FREQUENCY,
+  ARGS_IDX_FORMAT_FIELDS,
+  ARGS_IDX_SEED,
+  ARGS_IDX_WORKSPACE,
+  ARGS_IDX_ARRAY,
+  ARGS_IDX_NUM_COLUMN_PARTITIONS
+};
+
+int main(int argc, char** argv)
+{
+  static struct option long_options[] =
+  {
+    {"output-directory",1,0,'o'},
+    {"num-samples",1,0,ARGS_IDX_NUM_SAMPLES},
+    {"contigs",1,0,ARGS_IDX_CONTIGS},
+    {"site-density",1,0,ARGS_IDX_SITE_DENSITY},
+    {"max-alt-alleles",1,0,ARGS_IDX_MAX_ALT_ALLELES},
+    {"multi-allelic-fraction",1,0,ARGS_IDX_MULTI_ALLELIC_FRACTION},
+    {"deletion-fraction",1,0,ARGS_IDX_DELETION_FRACTION},
+    {"insertion-fraction",1,0,ARGS_IDX_INSERTION_FRACTION},
+    {"max-indel-length",1,0,ARGS_IDX_MAX_INDEL_LENGTH},
+    {"mean-reference-block-length",1,0,ARGS_IDX_MEAN_REFERENCE_BLOCK_LENGTH},
+    {"max-allele-frequency",1,0,ARGS_IDX_MAX_ALLELE_FREQUENCY},
+    {"format-fields",1,0,ARGS_IDX_FORMAT_FIELDS},
+    {"seed",1,0,ARGS_IDX_SEED},
+    {"workspace",1,0,ARGS_IDX_WORKSPACE},
+    {"array",1,0,ARGS_IDX_ARRAY},
+    {"num-column-partitions",1,0,ARGS_IDX_NUM_COLUMN_PARTITIONS},
+    {0,0,0,0},
+  };
+  SyntheticGVCFParameters params;
+  int c;
+  try
+  {
+    while((c=getopt_long(argc, argv, "o:", long_options, NULL)) >= 0)
+    {
+      switch(c)
+      {
+        case 'o':
+          params.m_output_directory = optarg;
+          break;
+        case ARGS_IDX_NUM_SAMPLES:
+          params.m_num_samples = strtoull(optarg, 0, 10);
+          break;
+        case ARGS_IDX_CONTIGS:
+          parse_contigs(optarg, params.m_contigs);
+          break;
+        case ARGS_IDX_SITE_DENSITY:
+          params.m_site_density = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_MAX_ALT_ALLELES:
+          params.m_max_alt_alleles = strtoul(optarg, 0, 10);
+          break;
+        case ARGS_IDX_MULTI_ALLELIC_FRACTION:
+          params.m_multi_allelic_fraction = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_DELETION_FRACTION:
+          params.m_deletion_fraction = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_INSERTION_FRACTION:
+          params.m_insertion_fraction = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_MAX_INDEL_LENGTH:
+          params.m_max_indel_length = strtoul(optarg, 0, 10);
+          break;
+        case ARGS_IDX_MEAN_REFERENCE_BLOCK_LENGTH:
+          params.m_mean_reference_block_length = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_MAX_ALLELE_FREQUENCY:
+          params.m_max_allele_frequency = strtod(optarg, 0);
+          break;
+        case ARGS_IDX_FORMAT_FIELDS:
+          parse_format_fields(optarg, params.m_format_fields);
+          break;
+        case ARGS_IDX_SEED:
+          params.m_seed = strtoul(optarg, 0, 10);
+          break;
+        case ARGS_IDX_WORKSPACE:
+          params.m_workspace = optarg;
+          break;
+        case ARGS_IDX_ARRAY:
+          params.m_array = optarg;
+          break;
+        case ARGS_IDX_NUM_COLUMN_PARTITIONS:
+          params.m_num_column_partitions = strtoul(optarg, 0, 10);
+          break;
+        default:
+          std::cerr << "Unknown command line argument\n";
+          return -1;
+      }
+    }
+    if(params.m_output_directory.empty())
+    {
+      std::cerr << "Usage: "<<argv[0]<<" -o <output_directory> [ --num-samples <n> ] [ --contigs <name:length,..> ]\n"
+        << "\t[ --site-density <fraction> ] [ --max-alt-alleles <1-3> ] [ --multi-allelic-fraction <fraction> ]\n"
+        << "\t[ --deletion-fraction <fraction> ] [ --insertion-fraction <fraction> ] [ --max-indel-length <n> ]\n"
+        << "\t[ --mean-reference-block-length <n> ] [ --max-allele-frequency <fraction> ]\n"
+        << "\t[ --format-fields <GT,AD,DP,GQ,MIN_DP,PL,SB> ] [ --seed <n> ]\n"
+        << "\t[ --workspace <path> --array <name> [ --num-column-partitions <n> ] ]\n";
+      return -1;
+    }
+    SyntheticCohortGenerator generator(params);
+    generator.generate();
+  }
+  catch(const std::exception& e)
+  {
+    std::cerr << e.what() << "\n";
+    return -1;
+  }
+  return 0;
+}
@@ -25,6 +25,7 @@
 #include <getopt.h>
 #include <mpi.h>
 #include "libtiledb_variant.h"
+#include "variant_block_serialization.h"
 #include "json_config.h"
 #include "timer.h"
 #include "broad_combined_gvcf.h"
@@ -45,7 +46,9 @@ enum ArgsEnum
   ARGS_IDX_PRODUCE_HISTOGRAM,
   ARGS_IDX_PRINT_CALLS,
   ARGS_IDX_PRINT_CSV,
-  ARGS_IDX_VERSION
+  ARGS_IDX_VERSION,
+  ARGS_IDX_STREAMING_GATHER_CHUNK_SIZE,
+  ARGS_IDX_COMPRESS_SERIALIZED_VARIANTS
 };
 
 enum CommandsEnum
@@ -58,27 +61,8 @@ enum CommandsEnum
 };
 
 #define MegaByte (1024*1024)
-
-#ifdef DO_PROFILING
-enum TimerTypesEnum
-{
-  TIMER_TILEDB_QUERY_RANGE_IDX=0u,
-  TIMER_BINARY_SERIALIZATION_IDX,
-  TIMER_MPI_GATHER_IDX,
-  TIMER_ROOT_BINARY_DESERIALIZATION_IDX,
-  TIMER_JSON_PRINTING_IDX,
-  TIMER_NUM_TIMERS
-};
-
-auto g_timer_names = std::vector<std::string>
-{
-  "TileDB-query",
-  "Binary-serialization",
-  "MPI-gather",
-  "Binary-deserialization",
-  "JSON-printing"
-};
-#endif
+//Tag used for chunks of serialized variants sent to root in the streaming gather mode
+#define STREAMING_GATHER_MPI_TAG 1000
 
 #ifdef NDEBUG
 #define ASSERT(X) if(!(X)) { std::cerr << "Assertion failed - exiting\n"; exit(-1); }
@@ -88,19 +72,11 @@ auto g_timer_names = std::vector<std::string>
 
 //id_mapper could be NULL - use for contig/callset name mapping only if non-NULL
 void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const VidMapper& id_mapper,
-    const std::string& output_format, const bool is_partitioned_by_column, int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root)
+    const std::string& output_format, const bool is_partitioned_by_column, int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root,
+    const VariantBlockCompressionEnum compression)
 {
   //Check if id_mapper is initialized before using it
   //if(id_mapper.is_initialized())
-  GTProfileStats* stats_ptr = 0;
-#ifdef DO_PROFILING
-  //Performance measurements
-  Timer timer;
-  std::vector<double> timings(2u*TIMER_NUM_TIMERS, 0);  //[cpu-time,wall-clock time]
-  ASSERT(g_timer_names.size() == TIMER_NUM_TIMERS);
-  GTProfileStats stats;
-  stats_ptr = &stats;
-#endif
   //Variants vector
   std::vector<Variant> variants;
   uint64_t num_column_intervals = query_config.get_num_column_intervals();
@@ -109,24 +85,15 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
   //Perform query if not root or !skip_query_on_root
   if(my_world_mpi_rank != 0 || !skip_query_on_root)
   {
-#ifdef DO_PROFILING
-    timer.start();
-#endif
+    ProfilerSpan span(PROFILER_SPAN_GATHER_QUERY);
     for(auto i=0u;i<query_config.get_num_column_intervals();++i) {
-      qp.gt_get_column_interval(qp.get_array_descriptor(), query_config, i, variants, 0, stats_ptr);
+      qp.gt_get_column_interval(qp.get_array_descriptor(), query_config, i, variants);
       query_column_lengths[i] = variants.size();
       queried_column_positions[i * 2] = query_config.get_column_begin(i);
       queried_column_positions[i * 2 + 1] = query_config.get_column_end(i);
     }
-
-#ifdef DO_PROFILING
-    timer.stop();
-    timer.get_last_interval_times(timings, TIMER_TILEDB_QUERY_RANGE_IDX);
-#endif
   }
-#ifdef DO_PROFILING
-  timer.start();
-#endif
+  auto span_begin_ticks = GenomicsDBProfiler::begin_span();
 #if VERBOSE>0
   std::cerr << "[Rank "<< my_world_mpi_rank << " ]: Completed query, obtained "<<variants.size()<<" variants\n";
 #endif
@@ -134,22 +101,14 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
   std::vector<uint8_t> serialized_buffer;
   serialized_buffer.resize(1000000u);       //1MB, arbitrary value - will be resized if necessary by serialization functions
   uint64_t serialized_length = 0ull;
-  for(const auto& variant : variants)
-    variant.binary_serialize(serialized_buffer, serialized_length);
+  VariantBlockSerializer serializer(compression);
+  serializer.serialize(variants, serialized_buffer, serialized_length);
 #if VERBOSE>0
   std::cerr << "[Rank "<< my_world_mpi_rank << " ]: Completed serialization, serialized data size "
     << std::fixed << std::setprecision(3) << ((double)serialized_length)/MegaByte  << " MBs\n";
 #endif
-#ifdef DO_PROFILING
-  timer.stop();
-  timer.get_last_interval_times(timings, TIMER_BINARY_SERIALIZATION_IDX);
-  //Gather profiling data at root
-  auto num_timing_values_per_mpi_process = 2*(TIMER_BINARY_SERIALIZATION_IDX+1);
-  std::vector<double> gathered_timings(num_mpi_processes*num_timing_values_per_mpi_process);
-  ASSERT(MPI_Gather(&(timings[0]), num_timing_values_per_mpi_process, MPI_DOUBLE,
-        &(gathered_timings[0]), num_timing_values_per_mpi_process, MPI_DOUBLE, 0, MPI_COMM_WORLD) == MPI_SUCCESS);
-  timer.start();
-#endif
+  GenomicsDBProfiler::end_span(PROFILER_SPAN_GATHER_SERIALIZATION, span_begin_ticks);
+  span_begin_ticks = GenomicsDBProfiler::begin_span();
   //Gather all serialized lengths (in bytes) at root
   std::vector<uint64_t> lengths_vector(num_mpi_processes, 0ull); 
   ASSERT(MPI_Gather(&serialized_length, 1, MPI_UNSIGNED_LONG_LONG, &(lengths_vector[0]), 1, MPI_UNSIGNED_LONG_LONG, 0, MPI_COMM_WORLD) == MPI_SUCCESS);
@@ -255,54 +214,169 @@ void run_range_query(const VariantQueryProcessor& qp, const VariantQueryConfig&
   if(my_world_mpi_rank == 0)
     std::cerr << "Completed MPI_Gather\n";
 #endif
-#ifdef DO_PROFILING
-  timer.stop();
-  timer.get_last_interval_times(timings, TIMER_MPI_GATHER_IDX);
-  timer.start();
-#endif
+  GenomicsDBProfiler::end_span(PROFILER_SPAN_GATHER_MPI, span_begin_ticks);
   //Deserialize at root
   if(my_world_mpi_rank == 0)
   {
+    GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_GATHER_RECEIVED_BYTES, total_serialized_size);
+    span_begin_ticks = GenomicsDBProfiler::begin_span();
     variants.clear();
+    VariantBlockDeserializer deserializer(qp, query_config);
     uint64_t offset = 0ull;
+    //One block per rank
     while(offset < total_serialized_size)
     {
-      variants.emplace_back();
-      auto& variant = variants.back();
-      qp.binary_deserialize(variant, query_config, receive_buffer, offset);
+      auto first_idx = variants.size();
+      variants.resize(first_idx + deserializer.begin_block(receive_buffer, offset));
+      for(auto i=first_idx;i<variants.size();++i)
+        deserializer.next(variants[i]);
     }
 #if VERBOSE>0
     std::cerr << "Completed binary deserialization at root\n";
 #endif
-#ifdef DO_PROFILING
-    timer.stop();
-    timer.get_last_interval_times(timings, TIMER_ROOT_BINARY_DESERIALIZATION_IDX);
-    timer.start();
-#endif
+    GenomicsDBProfiler::end_span(PROFILER_SPAN_GATHER_DESERIALIZATION, span_begin_ticks);
+    ProfilerSpan span(PROFILER_SPAN_GATHER_PRINT);
     print_variants(variants, output_format, query_config, std::cout, is_partitioned_by_column, &id_mapper,
       gathered_query_column_lengths, gathered_num_column_intervals, gathered_queried_column_positions);
-#ifdef DO_PROFILING
-    timer.stop();
-    timer.get_last_interval_times(timings, TIMER_JSON_PRINTING_IDX);
-    std::cerr << "Root received "<< std::fixed << std::setprecision(3) << (((double)total_serialized_size)/MegaByte)
-      << " MBs of variant data in binary format\n";
-    for(auto i=0u;i<TIMER_NUM_TIMERS;++i)
+  }
+}
+
+/*
+ * Scans a column interval one page of at most page_size variants at a time. The cursor keeps the scan
+ * position between pages, so only a single page of variants is held in memory
+ */
+template<class PageHandler>
+void scan_column_interval_in_pages(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config,
+    const unsigned column_interval_idx, const unsigned page_size, PageHandler handle_page)
+{
+  GA4GHPagingInfo paging_info;
+  paging_info.set_page_size(page_size);
+  GA4GHPagingCursor cursor;
+  std::vector<Variant> variants;
+  do
+  {
+    variants.clear();
+    {
+      ProfilerSpan span(PROFILER_SPAN_GATHER_QUERY);
+      qp.gt_get_column_interval(qp.get_array_descriptor(), query_config, column_interval_idx, variants, &paging_info,
+          &cursor);
+    }
+    handle_page(variants);
+  } while(!(paging_info.is_query_completed()));
+}
+
+/*
+ * Streaming alternative to run_range_query() - instead of gathering all serialized variants at root
+ * in a single collective, every non-root rank sends chunks of ~chunk_size bytes to root using non-blocking
+ * point-to-point messages. Variants are produced in pages of page_size variants and
+ * serialized as each page is scanned. At most 2 chunks are in flight per rank (double buffering), so memory on
+ * the non-root ranks is bounded by one page of variants plus 2 chunks. Root prints
+ * the output of each rank in rank order as chunks arrive, holding only one chunk at a time - the total
+ * result size is no longer limited by the 32-bit counts of MPI_Gatherv.
+ * Only the default JSON output format can be printed incrementally
+ */
+void run_range_query_streaming(const VariantQueryProcessor& qp, const VariantQueryConfig& query_config, const VidMapper& id_mapper,
+    int num_mpi_processes, int my_world_mpi_rank, bool skip_query_on_root, const uint64_t chunk_size,
+    const unsigned page_size, const VariantBlockCompressionEnum compression)
+{
+  if(my_world_mpi_rank != 0)
+  {
+    //Double buffering - one buffer is filled while the other is in flight
+    std::vector<uint8_t> send_buffers[2];
+    MPI_Request send_requests[2] = { MPI_REQUEST_NULL, MPI_REQUEST_NULL };
+    auto curr_buffer_idx = 0u;
+    uint64_t serialized_length = 0ull;
+    auto total_serialized_size = 0ull;
+    for(auto& buffer : send_buffers)
+      buffer.resize(chunk_size+1u);     //will be resized if necessary by serialization functions
+    VariantBlockSerializer serializer(compression);
+    auto send_chunk = [&]() {
+      ASSERT(serialized_length < static_cast<uint64_t>(INT_MAX)); //single chunk must fit in a 32-bit count
+      ProfilerSpan span(PROFILER_SPAN_GATHER_MPI);
+      ASSERT(MPI_Isend(&(send_buffers[curr_buffer_idx][0]), serialized_length, MPI_UNSIGNED_CHAR, 0,
+            STREAMING_GATHER_MPI_TAG, MPI_COMM_WORLD, &(send_requests[curr_buffer_idx])) == MPI_SUCCESS);
+      total_serialized_size += serialized_length;
+      //Wait for the previous chunk from the other buffer to complete before re-using it
+      curr_buffer_idx ^= 1u;
+      ASSERT(MPI_Wait(&(send_requests[curr_buffer_idx]), MPI_STATUS_IGNORE) == MPI_SUCCESS);
+      serialized_length = 0ull;
+    };
+    for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+      scan_column_interval_in_pages(qp, query_config, i, page_size,
+          [&](const std::vector<Variant>& variants) {
+            if(variants.empty())
+              return;
+            {
+              ProfilerSpan span(PROFILER_SPAN_GATHER_SERIALIZATION);
+              serializer.serialize(variants, send_buffers[curr_buffer_idx], serialized_length);
+            }
+            if(serialized_length >= chunk_size)
+              send_chunk();
+          });
+    if(serialized_length > 0ull)
+      send_chunk();
+    //Empty message marks the end of this rank's data
+    send_chunk();
+    ASSERT(MPI_Waitall(2, send_requests, MPI_STATUSES_IGNORE) == MPI_SUCCESS);
+#if VERBOSE>0
+    std::cerr << "[Rank "<< my_world_mpi_rank << " ]: Completed streaming, sent "
+      << std::fixed << std::setprecision(3) << ((double)total_serialized_size)/MegaByte  << " MBs\n";
+#endif
+  }
+  else
+  {
+    std::string indent_unit = "    ";
+    auto indent_prefix = indent_unit + indent_unit;
+    auto num_printed_variants = 0ull;
+    auto print_variant = [&](const Variant& variant) {
+      ProfilerSpan span(PROFILER_SPAN_GATHER_PRINT);
+      if(num_printed_variants > 0ull)
+        std::cout << ",\n";
+      variant.print(std::cout, &query_config, indent_prefix, &id_mapper);
+      ++num_printed_variants;
+    };
+    std::cout << std::fixed << std::setprecision(6);
+    std::cout << "{\n" << indent_unit << "\"variants\": [\n";
+    //Variants at root are printed directly
+    if(!skip_query_on_root)
+      for(auto i=0u;i<query_config.get_num_column_intervals();++i)
+        scan_column_interval_in_pages(qp, query_config, i, page_size,
+            [&](const std::vector<Variant>& variants) {
+              for(const auto& variant : variants)
+                print_variant(variant);
+            });
+    //Process ranks in order so that the output is identical to the gather mode
+    std::vector<uint8_t> receive_buffer(1u);
+    VariantBlockDeserializer deserializer(qp, query_config);
+    Variant variant;
+    for(auto rank=1;rank<num_mpi_processes;++rank)
     {
-      std::cerr << g_timer_names[i];
-      if(i >= TIMER_MPI_GATHER_IDX) //only root info
-        std::cerr << std::fixed << std::setprecision(3) << "," << timings[2*i] << ",," << timings[2*i+1u] << "\n";
-      else
+      while(true)
       {
-        assert(2*i+1 < static_cast<unsigned>(num_timing_values_per_mpi_process));
-        for(auto j=0u;j<gathered_timings.size();j+=num_timing_values_per_mpi_process)
-          std::cerr << std::fixed << std::setprecision(3) << "," << gathered_timings[j + 2*i];
-        std::cerr << ",";
-        for(auto j=0u;j<gathered_timings.size();j+=num_timing_values_per_mpi_process)
-          std::cerr << std::fixed << std::setprecision(3) << "," << gathered_timings[j + 2*i + 1];
-        std::cerr << "\n";
+        MPI_Status status;
+        int count = 0;
+        {
+          ProfilerSpan span(PROFILER_SPAN_GATHER_MPI);
+          ASSERT(MPI_Probe(rank, STREAMING_GATHER_MPI_TAG, MPI_COMM_WORLD, &status) == MPI_SUCCESS);
+          ASSERT(MPI_Get_count(&status, MPI_UNSIGNED_CHAR, &count) == MPI_SUCCESS);
+          receive_buffer.resize(std::max(count, 1));
+          ASSERT(MPI_Recv(&(receive_buffer[0]), count, MPI_UNSIGNED_CHAR, rank, STREAMING_GATHER_MPI_TAG,
+                MPI_COMM_WORLD, MPI_STATUS_IGNORE) == MPI_SUCCESS);
+        }
+        if(count == 0)  //end of data from this rank
+          break;
+        GenomicsDBProfiler::increment_counter(PROFILER_COUNTER_GATHER_RECEIVED_BYTES, count);
+        uint64_t offset = 0ull;
+        while(offset < static_cast<uint64_t>(count))
+        {
+          deserializer.begin_block(&(receive_buffer[0]), count, offset);
+          while(deserializer.next(variant))
+            print_variant(variant);
+        }
       }
     }
-#endif
+    std::cout << "\n" << indent_unit << "]\n";
+    std::cout << "}\n";
   }
 }
 
@@ -383,7 +457,12 @@ void produce_column_histogram(const VariantQueryProcessor& qp, const VariantQuer
     const std::vector<uint64_t>& num_equi_load_bins)
 {
   ColumnHistogramOperator histogram_op(0, 4000000000ull, bin_size);
-  qp.iterate_over_cells(qp.get_array_descriptor(), query_config, histogram_op, 0u);
+  //Histogram maintained by the loader in the array metadata avoids a full scan if it is fine grained enough
+  const auto& stored_histogram = qp.get_storage_manager()->get_column_histogram(qp.get_array_descriptor());
+  if(histogram_op.can_use_column_cell_histogram(stored_histogram, query_config))
+    histogram_op.add_column_cell_histogram(stored_histogram);
+  else
+    qp.iterate_over_cells(qp.get_array_descriptor(), query_config, histogram_op, 0u);
   for(auto val : num_equi_load_bins)
     histogram_op.equi_partition_and_print_bins(val);
 }
@@ -428,6 +507,8 @@ int main(int argc, char *argv[]) {
     {"print-csv",0,0,ARGS_IDX_PRINT_CSV},
     {"array",1,0,'A'},
     {"version",0,0,ARGS_IDX_VERSION},
+    {"streaming-gather-chunk-size",1,0,ARGS_IDX_STREAMING_GATHER_CHUNK_SIZE},
+    {"compress-serialized-variants",0,0,ARGS_IDX_COMPRESS_SERIALIZED_VARIANTS},
     {0,0,0,0},
   };
   int c;
@@ -441,13 +522,16 @@ int main(int argc, char *argv[]) {
   auto print_version_only = false;
   unsigned command_idx = COMMAND_RANGE_QUERY;
   size_t segment_size = 10u*1024u*1024u; //in bytes = 10MB
+  size_t iterator_memory_budget = 0u; //0 - segment_size per buffer
+  uint64_t streaming_gather_chunk_size = 0u; //0 - gather everything at root in one collective
+  auto serialization_compression = VARIANT_BLOCK_COMPRESSION_NONE;
   while((c=getopt_long(argc, argv, "j:l:w:A:p:O:s:r:", long_options, NULL)) >= 0)
   {
     switch(c)
     {
       case 'p':
         page_size = strtoull(optarg, 0, 10);
-        std::cerr << "WARNING: page size is ignored except for scan now\n";
+        std::cerr << "WARNING: page size is ignored except for scan and streaming gather now\n";
         break;
       case 'r':
         my_world_mpi_rank = strtoull(optarg, 0, 10);
@@ -485,6 +569,12 @@ int main(int argc, char *argv[]) {
       case 'l':
         loader_json_config_file = std::move(std::string(optarg));
         break;
+      case ARGS_IDX_STREAMING_GATHER_CHUNK_SIZE:
+        streaming_gather_chunk_size = strtoull(optarg, 0, 10);
+        break;
+      case ARGS_IDX_COMPRESS_SERIALIZED_VARIANTS:
+        serialization_compression = VARIANT_BLOCK_COMPRESSION_ZLIB;
+        break;
       case ARGS_IDX_VERSION:
         std::cout << GENOMICSDB_VERSION <<"\n";
         print_version_only = true;
@@ -536,8 +626,12 @@ int main(int argc, char *argv[]) {
           break;
       }
       ASSERT(json_config_ptr);
+      VariantQueryProcessor::apply_process_wide_settings(*json_config_ptr, my_world_mpi_rank);
+      VariantQueryProcessor::initialize_auto_query_column_ranges(*json_config_ptr, query_config, id_mapper,
+          my_world_mpi_rank);
       workspace = json_config_ptr->get_workspace(my_world_mpi_rank);
       array_name = json_config_ptr->get_array_name(my_world_mpi_rank);
+      iterator_memory_budget = json_config_ptr->get_iterator_memory_budget();
     }
     else
     {
@@ -580,6 +674,7 @@ int main(int argc, char *argv[]) {
 #endif
     /*Create storage manager*/
     VariantStorageManager sm(workspace, segment_size);
+    sm.set_iterator_memory_budget(iterator_memory_budget);
     /*Create query processor*/
     VariantQueryProcessor qp(&sm, array_name, id_mapper);
     auto require_alleles = ((command_idx == COMMAND_RANGE_QUERY)
@@ -588,9 +683,21 @@ int main(int argc, char *argv[]) {
     switch(command_idx)
     {
       case COMMAND_RANGE_QUERY:
+        if(streaming_gather_chunk_size > 0u)
+        {
+          if(output_format == "Cotton-JSON" || output_format == "Positions-JSON")
+            std::cerr << "WARNING: output format "<<output_format<<" cannot be streamed, gathering all variants at root\n";
+          else
+          {
+            run_range_query_streaming(qp, query_config, static_cast<const VidMapper&>(id_mapper),
+                num_mpi_processes, my_world_mpi_rank, skip_query_on_root, streaming_gather_chunk_size,
+                page_size ? page_size : DEFAULT_NUM_VARIANTS_PER_BLOCK, serialization_compression);
+            break;
+          }
+        }
         run_range_query(qp, query_config, static_cast<const VidMapper&>(id_mapper), output_format,
             (loader_json_config_file.empty() || loader_config.is_partitioned_by_column()),
-            num_mpi_processes, my_world_mpi_rank, skip_query_on_root);
+            num_mpi_processes, my_world_mpi_rank, skip_query_on_root, serialization_compression);
         break;
       case COMMAND_PRODUCE_BROAD_GVCF:
 #if defined(HTSDIR)
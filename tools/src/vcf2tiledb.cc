@@ -22,6 +22,7 @@
 
 #include "vcf2binary.h"
 #include "tiledb_loader.h"
+#include "fragment_consolidation_scheduler.h"
 #include <mpi.h>
 #include <getopt.h>
 
@@ -70,6 +71,7 @@ int main(int argc, char** argv)
   std::string split_output_filename;
   auto split_callset_mapping_file = false;
   auto print_version_only = false;
+  auto returnval = 0;
   while((c=getopt_long(argc, argv, "T:r:", long_options, NULL)) >= 0)
   {
     switch(c)
@@ -156,6 +158,15 @@ int main(int argc, char** argv)
 #ifdef HTSDIR
       loader.read_all();
 #endif
+      //Background consolidations must be done before MPI_Finalize, a failed consolidation fails the load
+      auto& scheduler = FragmentConsolidationScheduler::get_instance();
+      scheduler.wait();
+      if(scheduler.get_num_failed_consolidations() > 0u)
+      {
+        std::cerr << "Background consolidation failed for " << scheduler.get_num_failed_consolidations()
+          << " array(s)\n";
+        returnval = -1;
+      }
     }
 #ifdef USE_GPERFTOOLS
     ProfilerStop();
@@ -163,5 +174,5 @@ int main(int argc, char** argv)
   }
   //finalize
   MPI_Finalize();
-  return 0;
+  return returnval;
 }